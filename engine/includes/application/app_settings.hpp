@@ -30,6 +30,8 @@ SOFTWARE.
 #pragma once
 
 #include <application/window.hpp>
+#include <filesystem>
+#include <graphics/device/graphics_device.hpp>
 
 namespace moka
 {
@@ -43,6 +45,26 @@ namespace moka
          */
         window_settings window;
 
+        /**
+         * \brief The graphics api the application renders with. The null backend runs everything but the driver.
+         */
+        graphics_backend graphics = graphics_backend::opengl;
+
+        /**
+         * \brief If set, every resource and command of the application is captured to a command trace at this path.
+         */
+        std::filesystem::path capture_path;
+
+        /**
+         * \brief If true, rendering commands are executed on a dedicated render thread while the next frame is recorded.
+         */
+        bool render_thread = false;
+
+        /**
+         * \brief The number of frames that can be recorded before the render thread has executed the oldest one.
+         */
+        size_t frames_in_flight = 2;
+
         app_settings();
     };
 } // namespace moka
@@ -141,8 +141,14 @@ namespace moka
     };
 
     inline logger::logger(const char* name, const log_level level)
-        : logger_(spdlog::stdout_color_mt(name))
+        : logger_(spdlog::get(name))
     {
+        // objects of the same kind share their named logger, so a second importer or device doesn't throw
+        if (!logger_)
+        {
+            logger_ = spdlog::stdout_color_mt(name);
+        }
+
         switch (level)
         {
         case log_level::debug:
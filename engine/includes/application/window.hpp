@@ -53,6 +53,8 @@ namespace moka
         glm::ivec2 resolution = {1280, 720};
         glm::ivec2 position = {200, 200};
         bool fullscreen = false;
+        bool headless = false; /**< Render offscreen through an EGL surfaceless context instead of opening a window. */
+        bool null_context = false; /**< Create neither a window nor a graphics context, for use with graphics_backend::null. */
     };
 
     /**
@@ -103,6 +105,17 @@ namespace moka
          */
         void set_current_context(context_handle handle);
 
+        /**
+         * \brief Make the window's main context current on the calling thread.
+         * The context can only be current on one thread at a time, so release it on the other thread first.
+         */
+        void acquire_context() const;
+
+        /**
+         * \brief Release the window's main context from the calling thread, so that another thread can acquire it.
+         */
+        void release_context() const;
+
         /**
          * \brief Get the aspect ratio of this window's size.
          * \return The width of the window divided by the height of the window.
@@ -127,8 +140,17 @@ namespace moka
          */
         rectangle get_viewport() const;
 
+        /**
+         * \brief Get the OpenGL name of the frame buffer that the default frame buffer renders into.
+         * \return 0 for an on-screen window, or the offscreen frame buffer object of a headless window.
+         */
+        uint32_t get_default_frame_buffer() const;
+
     private:
         class impl;
+        class sdl_impl;
+        class headless_impl;
+        class null_impl;
         std::unique_ptr<impl> impl_;
     };
 } // namespace moka
@@ -0,0 +1,106 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/command/draw_command.hpp>
+#include <graphics/command/set_material_properties_command.hpp>
+#include <vector>
+
+namespace moka
+{
+    class material;
+    class material_cache;
+
+    /**
+     * \brief The run of draws a backend holds back so that it can issue them as one multi-draw call.
+     * A draw joins the run while it reads the same vertex array as the first draw, and its material binds the same
+     * program, pipeline state and parameter values. Primitives that were given separate but identical materials still
+     * share a call. The backend binds the first draw's material when the run starts, so a parameter write to that
+     * material doesn't end the run, it only stops the draws after it from joining.
+     */
+    class draw_batch final
+    {
+        std::vector<draw_command> draws_;
+
+        bool material_changed_ = false;
+
+    public:
+        using const_iterator = std::vector<draw_command>::const_iterator;
+
+        /**
+         * \brief Can a draw join the run, or must the run be issued first?
+         * \param cmd The draw.
+         * \param materials The materials the draws are executed with.
+         * \return True if the run is empty or the draw can share its call. Otherwise, false.
+         */
+        bool accepts(const draw_command& cmd, const material_cache& materials) const;
+
+        /**
+         * \brief Add a draw to the run.
+         * \param cmd The draw to add.
+         */
+        void add(const draw_command& cmd);
+
+        /**
+         * \brief Note a parameter write before it is applied to its material.
+         * If it changes a value of the run's material, the draws that follow can't join the run.
+         * \param cmd The parameter write.
+         * \param material The material it writes to.
+         */
+        void write_parameters(set_material_parameters_command& cmd, const material& material);
+
+        /**
+         * \brief Remove every draw from the run.
+         */
+        void clear();
+
+        /**
+         * \brief Is the run empty?
+         * \return True if the run has no draws. Otherwise, false.
+         */
+        bool empty() const;
+
+        /**
+         * \brief Get the number of draws in the run.
+         * \return The number of draws in the run.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Get the first draw of the run, whose vertex array and material the run is issued with.
+         * \return The first draw of the run.
+         */
+        const draw_command& front() const;
+
+        const_iterator begin() const;
+
+        const_iterator end() const;
+    };
+} // namespace moka
@@ -30,11 +30,18 @@ SOFTWARE.
 #pragma once
 
 #include <GL/glew.h>
+#include <array>
+#include <chrono>
+#include <deque>
 #include <application/logger.hpp>
 #include <application/window.hpp>
+#include <graphics/api/draw_batch.hpp>
+#include <graphics/api/gl_state_cache.hpp>
 #include <graphics/api/graphics_api.hpp>
+#include <graphics/api/handle_pool.hpp>
 #include <graphics/buffer/buffer_usage.hpp>
 #include <graphics/buffer/index_buffer_handle.hpp>
+#include <graphics/buffer/stream_buffer.hpp>
 #include <graphics/buffer/vertex_buffer_handle.hpp>
 #include <graphics/buffer/vertex_layout.hpp>
 #include <graphics/command/draw_command.hpp>
@@ -65,6 +72,78 @@ namespace moka
         index_type type = index_type::uint16;
     };
 
+    /**
+     * \brief Contains the active uniforms of a program, reflected when its link status is first checked
+     */
+    struct program_metadata final
+    {
+        std::unordered_map<std::string, GLint> uniforms;
+        GLuint vertex_shader = 0;   /**< The vertex shader, kept to report compile errors when the link is checked. */
+        GLuint fragment_shader = 0; /**< The fragment shader, kept to report compile errors when the link is checked. */
+        bool linked = false;        /**< True once the link status has been checked and the program reflected. */
+    };
+
+    /**
+     * \brief The layout of one draw in a GL_DRAW_INDIRECT_BUFFER, as read by glMultiDrawElementsIndirect
+     */
+    struct draw_indirect_command final
+    {
+        uint32_t count;
+        uint32_t instance_count;
+        uint32_t first_index;
+        int32_t base_vertex;
+        uint32_t base_instance;
+    };
+
+    /**
+     * \brief The timestamp queries that bracket one scope opened by a gpu_timer_command
+     */
+    struct gpu_timer_queries final
+    {
+        std::string name;
+        size_t depth = 0;
+        GLuint begin = 0;
+        GLuint end = 0;
+    };
+
+    /**
+     * \brief A pixel buffer that image data is staged in on its way to or from the device
+     */
+    struct staging_buffer final
+    {
+        GLuint name = 0;
+        size_t size = 0;
+        GLsync fence = nullptr; /**< Signalled once the copies reading from the buffer have finished. */
+        bool in_use = false;
+    };
+
+    /**
+     * \brief The images of a texture that are waiting to be copied from a staging buffer
+     */
+    struct texture_upload final
+    {
+        texture_handle texture;
+        size_t staging_buffer = 0;
+        std::vector<image_metadata> images;
+        std::vector<size_t> offsets; /**< The offset of each image in the staging buffer. */
+        size_t next_image = 0;
+        bool generate_mipmaps = false;
+    };
+
+    /**
+     * \brief A read_pixels_command whose pixels are being copied to a pixel pack buffer
+     */
+    struct pending_readback final
+    {
+        uint64_t tag = 0;
+        int width = 0;
+        int height = 0;
+        host_format format = host_format::rgba;
+        pixel_type pixel = pixel_type::uint8;
+        size_t buffer = 0;      /**< The index of the pixel pack buffer. */
+        GLsync fence = nullptr; /**< Signalled once the pixels have been written to the buffer. */
+    };
+
     /**
      * \brief Contains data that describes the contents of a framebuffer
      */
@@ -73,6 +152,17 @@ namespace moka
         std::vector<GLuint> attachments;
     };
 
+    /**
+     * \brief An OpenGL object and the metadata the backend keeps about it.
+     * \tparam T The type of metadata.
+     */
+    template <typename T>
+    struct gl_object final
+    {
+        GLuint name = 0; /**< The OpenGL name of the object. */
+        T metadata{};    /**< The metadata of the object. */
+    };
+
     /**
      * \brief Graphics device forward declaration
      */
@@ -87,10 +177,14 @@ namespace moka
         window& window_;
         graphics_device& device_;
 
+        GLuint default_frame_buffer_ = 0; /**< The frame buffer that frame buffer id 0 binds, non-zero for a headless window. */
+
         static logger log_;
 
         GLuint vao_ = 0;
 
+        std::unordered_map<uint64_t, GLuint> vertex_arrays_;
+
         static void GLAPIENTRY message_callback(
             GLenum source,
             GLenum type,
@@ -100,37 +194,151 @@ namespace moka
             const GLchar* message,
             const void* user_param);
 
-        std::unordered_map<uint16_t, vertex_metadata> vertex_buffer_data_;
-        std::unordered_map<uint16_t, texture_metadata> texture_data_;
-        std::unordered_map<uint16_t, index_metadata> index_buffer_data_;
-        std::unordered_map<uint16_t, frame_buffer_metadata> frame_buffer_data_;
+        using vertex_buffer_pool = handle_pool<vertex_buffer_handle, gl_object<vertex_metadata>>;
+        using index_buffer_pool = handle_pool<index_buffer_handle, gl_object<index_metadata>>;
 
-        draw_command previous_command_;
+        vertex_buffer_pool vertex_buffers_;
+        handle_pool<texture_handle, gl_object<texture_metadata>> textures_;
+        index_buffer_pool index_buffers_;
+        handle_pool<frame_buffer_handle, gl_object<frame_buffer_metadata>> frame_buffers_;
+        handle_pool<program_handle, gl_object<program_metadata>> programs_;
+        handle_pool<shader_handle, gl_object<shader_type>> shaders_;
+        handle_pool<uniform_buffer_handle, gl_object<uniform_block>> uniform_buffers_;
 
-        static void reset_gl_state();
+        template <typename Handle, typename T>
+        static gl_object<T>* find(handle_pool<Handle, gl_object<T>>& pool, Handle handle, const char* caller);
 
-        void visit(clear_command& cmd) override;
+        void erase_vertex_arrays(vertex_buffer_handle vertex_buffer);
 
-        void visit(draw_command& cmd) override;
+        void erase_vertex_arrays(index_buffer_handle index_buffer);
 
-        void visit(viewport_command& cmd) override;
+        gl_state_cache state_;
 
-        void visit(scissor_command& cmd) override;
+        uint16_t pipeline_state_ = std::numeric_limits<uint16_t>::max();
 
-        void visit(fill_vertex_buffer_command& cmd) override;
+        void apply(const pipeline_state& pipeline_state);
 
-        void visit(fill_index_buffer_command& cmd) override;
+        GLuint get_vertex_array(
+            vertex_buffer_handle vertex_buffer, index_buffer_handle index_buffer, vertex_buffer_handle instance_buffer);
 
-        void visit(frame_buffer_command& cmd) override;
+        GLuint stream_buffer_ = 0;
 
-        void visit(frame_buffer_texture_command& cmd) override;
+        std::byte* stream_memory_ = nullptr;
 
-        void visit(generate_mipmaps_command& cmd) override;
+        size_t stream_frame_ = 0;
 
-        void visit(set_material_parameters_command& cmd) override;
+        std::array<GLsync, stream_allocator::frame_count> stream_fences_{};
+
+        std::unordered_map<uint64_t, GLuint> stream_vertex_arrays_;
+
+        void make_stream_buffer();
+
+        void advance_stream_buffer();
+
+        size_t get_stream_base() const;
+
+        GLuint get_stream_vertex_array(vertex_buffer_handle vertex_buffer, vertex_buffer_handle instance_buffer);
+
+        void specify_vertex_attributes(vertex_buffer_handle vertex_buffer, size_t base, GLuint buffer = 0);
+
+        state_change_stats frame_state_stats_;
+
+        draw_batch draw_batch_;
+
+        GLuint indirect_buffer_ = 0;
+
+        std::byte* indirect_memory_ = nullptr;
+
+        size_t indirect_cursor_ = 0;
+
+        static constexpr size_t indirect_commands_per_frame = 4096; /**< The draws each frame's part of the indirect ring holds. */
+
+        std::vector<draw_indirect_command> indirect_commands_;
+
+        void make_indirect_buffer();
+
+        std::vector<GLsizei> multi_draw_counts_;
+        std::vector<const void*> multi_draw_offsets_;
+        std::vector<GLint> multi_draw_base_vertices_;
+
+        draw_stats draw_stats_;
+
+        draw_stats frame_draw_stats_;
+
+        void begin_batch(const draw_command& cmd);
+
+        void flush_draws();
+
+        void draw(const draw_command& cmd);
+
+        void multi_draw();
+
+        std::vector<gpu_timer_queries> timer_scopes_;
+
+        std::vector<size_t> open_timer_scopes_;
+
+        std::deque<std::vector<gpu_timer_queries>> pending_timer_frames_;
+
+        std::vector<GLuint> free_timer_queries_;
+
+        std::vector<gpu_timer_result> gpu_timers_;
+
+        static constexpr size_t max_pending_timer_frames = 8; /**< Older frames are dropped if the GPU falls this far behind. */
+
+        GLuint make_timer_query();
+
+        void resolve_gpu_timers();
+
+        std::vector<staging_buffer> staging_buffers_;
+
+        std::deque<texture_upload> texture_uploads_;
+
+        size_t texture_upload_budget_ = 16 * 1024 * 1024;
+
+        texture_upload_stats upload_stats_;
+
+        texture_upload_stats frame_upload_stats_;
+
+        std::vector<staging_buffer> readback_buffers_;
+
+        std::deque<pending_readback> pending_readbacks_;
+
+        std::vector<readback_result> readbacks_;
+
+        void resolve_readbacks(bool wait);
+
+        size_t acquire_staging_buffer(std::vector<staging_buffer>& pool, GLenum target, GLenum usage, size_t size);
+
+        void upload_next_image(texture_upload& upload);
+
+        bool is_uploading(texture_handle texture) const;
+
+        void finish_texture_upload(texture_handle texture);
+
+        void stream_texture_uploads();
+
+        void reset_gl_state();
 
         static void check_errors(const char* caller);
 
+        void reflect_uniforms(GLuint program, program_metadata& metadata);
+
+        std::vector<program_handle> pending_programs_;
+
+        std::chrono::steady_clock::time_point compile_start_;
+
+        std::chrono::steady_clock::time_point compile_end_;
+
+        size_t compiled_programs_ = 0;
+
+        void resolve_program(gl_object<program_metadata>& program);
+
+        void resolve_pending_programs();
+
+        static void bind_uniform_blocks(GLuint program);
+
+        void warn_unused_parameter(const material& material, const std::string& name);
+
     public:
         /**
          * \brief Create a new gl_graphics_api object
@@ -162,6 +370,46 @@ namespace moka
          */
         shader_handle make_shader(shader_type type, const std::string& source) override;
 
+        /**
+         * \brief Find the location of an active uniform in a program. Programs are reflected the first time their link status is
+         * checked, so this only waits for the driver if the program is still being linked.
+         * \param program The program to search.
+         * \param name The name of the uniform.
+         * \return The location of the uniform, or -1 if the program has no active uniform with this name.
+         */
+        int32_t find_uniform(program_handle program, const std::string& name) override;
+
+        /**
+         * \brief Get a string identifying the driver and the device it runs on. Program binaries are only valid for the
+         * driver that produced them.
+         * \return The driver identifier, or an empty string if this api can't retrieve program binaries.
+         */
+        std::string get_driver_id() const override;
+
+        /**
+         * \brief Retrieve the binary of a linked program, so that it can be loaded again without compiling it.
+         * \param program The program whose binary you want.
+         * \param binary The binary of the program.
+         * \return True if the binary was retrieved. Otherwise, false.
+         */
+        bool get_program_binary(program_handle program, program_binary& binary) override;
+
+        /**
+         * \brief Check whether a program has finished linking. Without KHR_parallel_shader_compile the driver can't be asked
+         * without waiting, so only programs that resolve_pending_programs has already resolved count as linked.
+         * \param program The program to check.
+         * \return True if the program has been linked, even if linking failed. False if it is still being linked.
+         */
+        bool is_program_linked(program_handle program) override;
+
+        /**
+         * \brief Create a shader program from a binary previously retrieved with get_program_binary.
+         * \param binary The binary of the program.
+         * \return A new program_handle representing a program on the device, or an invalid handle if the driver rejected
+         * the binary.
+         */
+        program_handle make_program(const program_binary& binary) override;
+
         /**
          * \brief Create a new vertex buffer.
          * \param vertices The host memory buffer that will be used as vertex data.
@@ -184,6 +432,14 @@ namespace moka
         index_buffer_handle make_index_buffer(
             const void* indices, size_t size, index_type type, buffer_usage use) override;
 
+        /**
+         * \brief Create a new uniform buffer.
+         * \param block The uniform block that the buffer holds. Filling the buffer binds it to the block's binding point.
+         * \param size The size of the uniform buffer.
+         * \return A new uniform_buffer_handle representing a uniform buffer on the device.
+         */
+        uniform_buffer_handle make_uniform_buffer(uniform_block block, size_t size) override;
+
         /**
          * \brief Create a new texture.
          * \param data The host memory buffer that will be used as texture data.
@@ -201,12 +457,57 @@ namespace moka
          */
         frame_buffer_handle make_frame_buffer(render_texture_data* render_textures, size_t render_texture_count) override;
 
+        /**
+         * \brief Get the number of state changes that were issued and elided during the last complete frame.
+         * \return The state change stats of the last frame.
+         */
+        state_change_stats get_state_change_stats() const override;
+
+        /**
+         * \brief Get the number of draws executed, and the draw calls issued for them, during the last complete frame.
+         * \return The draw stats of the last frame.
+         */
+        draw_stats get_draw_stats() const override;
+
+        /**
+         * \brief Get the GPU timer scopes of the most recent frame whose results became available during the last swap.
+         * Results are never waited for, so this is empty when no frame finished on the GPU in time.
+         * \return The scopes of that frame, in the order they were opened.
+         */
+        std::vector<gpu_timer_result> get_gpu_timers() const override;
+
+        /**
+         * \brief Set the number of bytes of streamed texture data that may be uploaded each frame. At least one image is
+         * uploaded every frame, even if it's larger than the budget.
+         * \param bytes The upload budget of a frame.
+         */
+        void set_texture_upload_budget(size_t bytes) override;
+
+        /**
+         * \brief Get the pixel data uploaded to textures during the last complete frame.
+         * \return The texture upload stats of the last frame.
+         */
+        texture_upload_stats get_texture_upload_stats() const override;
+
+        /**
+         * \brief Take the pixels of every read_pixels_command that has completed since the last call.
+         * \param wait True to wait for the readbacks that are still in flight. Otherwise, they're left for a later call.
+         * \return The completed readbacks, in the order their commands were executed.
+         */
+        std::vector<readback_result> take_readbacks(bool wait) override;
+
         /**
          * \brief Submit a command_list to execute on the device.
          * \param commands The command_list you wish to run.
          */
         void submit(command_list&& commands) override;
 
+        /**
+         * \brief Submit a command_bundle to execute on the device. The bundle is left intact so that it can be submitted again.
+         * \param bundle The command_bundle you wish to run.
+         */
+        void submit(command_bundle& bundle) override;
+
         /**
          * \brief Submit a command_list to execute on the device. The main framebuffer will be swapped after executing, advancing a frame.
          * \param commands The command_list you wish to run.
@@ -218,5 +519,113 @@ namespace moka
          * \param handle The host frame buffer that will be destroyed.
          */
         void destroy(frame_buffer_handle handle) override;
+
+        /**
+         * \brief Destroy a program. Handles to it become stale.
+         * \param handle The program that will be destroyed.
+         */
+        void destroy(program_handle handle) override;
+
+        /**
+         * \brief Destroy a shader. Handles to it become stale.
+         * \param handle The shader that will be destroyed.
+         */
+        void destroy(shader_handle handle) override;
+
+        /**
+         * \brief Destroy a vertex buffer. Handles to it, and the vertex arrays that read from it, become stale.
+         * \param handle The vertex buffer that will be destroyed.
+         */
+        void destroy(vertex_buffer_handle handle) override;
+
+        /**
+         * \brief Destroy an index buffer. Handles to it, and the vertex arrays that read from it, become stale.
+         * \param handle The index buffer that will be destroyed.
+         */
+        void destroy(index_buffer_handle handle) override;
+
+        /**
+         * \brief Execute a clear_command.
+         * \param cmd The command to execute.
+         */
+        void visit(clear_command& cmd) override;
+
+        /**
+         * \brief Execute a draw_command.
+         * \param cmd The command to execute.
+         */
+        void visit(draw_command& cmd) override;
+
+        /**
+         * \brief Execute a viewport_command.
+         * \param cmd The command to execute.
+         */
+        void visit(viewport_command& cmd) override;
+
+        /**
+         * \brief Execute a scissor_command.
+         * \param cmd The command to execute.
+         */
+        void visit(scissor_command& cmd) override;
+
+        /**
+         * \brief Execute a fill_vertex_buffer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(fill_vertex_buffer_command& cmd) override;
+
+        /**
+         * \brief Execute a fill_index_buffer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(fill_index_buffer_command& cmd) override;
+
+        /**
+         * \brief Execute a fill_uniform_buffer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(fill_uniform_buffer_command& cmd) override;
+
+        /**
+         * \brief Execute a fill_stream_buffer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(fill_stream_buffer_command& cmd) override;
+
+        /**
+         * \brief Execute a gpu_timer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(gpu_timer_command& cmd) override;
+
+        /**
+         * \brief Execute a read_pixels_command.
+         * \param cmd The command to execute.
+         */
+        void visit(read_pixels_command& cmd) override;
+
+        /**
+         * \brief Execute a frame_buffer_command.
+         * \param cmd The command to execute.
+         */
+        void visit(frame_buffer_command& cmd) override;
+
+        /**
+         * \brief Execute a frame_buffer_texture_command.
+         * \param cmd The command to execute.
+         */
+        void visit(frame_buffer_texture_command& cmd) override;
+
+        /**
+         * \brief Execute a generate_mipmaps_command.
+         * \param cmd The command to execute.
+         */
+        void visit(generate_mipmaps_command& cmd) override;
+
+        /**
+         * \brief Execute a set_material_parameters_command.
+         * \param cmd The command to execute.
+         */
+        void visit(set_material_parameters_command& cmd) override;
     };
 } // namespace moka
@@ -0,0 +1,212 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <GL/glew.h>
+#include <array>
+#include <cstdint>
+#include <graphics/api/graphics_api.hpp>
+
+namespace moka
+{
+    /**
+     * \brief A shadow copy of the OpenGL state that the gl_graphics_api changes.
+     * Every state change is compared against the shadow copy, and only changes that differ from it reach the driver.
+     * State starts out unknown, so the first change of each kind is always issued. Any code that changes this state
+     * without going through the cache must call invalidate afterwards.
+     */
+    class gl_state_cache final
+    {
+    public:
+        /**
+         * \brief The capabilities that can be enabled through the cache.
+         */
+        enum class capability : uint8_t
+        {
+            blend,        //!< GL_BLEND
+            cull_face,    //!< GL_CULL_FACE
+            depth_test,   //!< GL_DEPTH_TEST
+            scissor_test, //!< GL_SCISSOR_TEST
+            count         //!< The number of capabilities.
+        };
+
+        /**
+         * \brief The number of texture units whose bindings are shadowed. Units beyond this are always issued.
+         */
+        static constexpr size_t max_texture_units = 32;
+
+    private:
+        /**
+         * \brief The texture targets whose bindings are shadowed. Other targets are always issued.
+         */
+        enum class texture_slot : uint8_t
+        {
+            texture_2d,
+            texture_cube_map,
+            count
+        };
+
+        static constexpr GLuint unknown = ~GLuint{0};
+
+        std::array<int8_t, static_cast<size_t>(capability::count)> capabilities_{};
+        GLenum blend_equation_ = unknown;
+        GLenum blend_source_ = unknown;
+        GLenum blend_destination_ = unknown;
+        GLenum polygon_faces_ = unknown;
+        GLenum polygon_mode_ = unknown;
+        GLenum cull_faces_ = unknown;
+        GLuint program_ = unknown;
+        GLuint vertex_array_ = unknown;
+        GLuint array_buffer_ = unknown;
+        GLuint element_array_buffer_ = unknown;
+        GLuint frame_buffer_ = unknown;
+        GLuint active_texture_unit_ = unknown;
+        std::array<std::array<GLuint, static_cast<size_t>(texture_slot::count)>, max_texture_units> textures_{};
+
+        state_change_stats stats_;
+
+        template <typename T>
+        bool update(T& shadow, T value);
+
+    public:
+        /**
+         * \brief Create a new gl_state_cache object. All state is unknown.
+         */
+        gl_state_cache();
+
+        /**
+         * \brief Forget all shadowed state, so that the next change of each kind reaches the driver.
+         */
+        void invalidate();
+
+        /**
+         * \brief Enable or disable a capability.
+         * \param cap The capability to change.
+         * \param enabled True to enable the capability. Otherwise, false.
+         */
+        void set_enabled(capability cap, bool enabled);
+
+        /**
+         * \brief Set the blend equation.
+         * \param equation The blend equation.
+         */
+        void set_blend_equation(GLenum equation);
+
+        /**
+         * \brief Set the blend function.
+         * \param source The source factor.
+         * \param destination The destination factor.
+         */
+        void set_blend_function(GLenum source, GLenum destination);
+
+        /**
+         * \brief Set the polygon rasterization mode.
+         * \param faces The faces the mode applies to.
+         * \param mode The rasterization mode.
+         */
+        void set_polygon_mode(GLenum faces, GLenum mode);
+
+        /**
+         * \brief Set the faces that are culled.
+         * \param faces The faces to cull.
+         */
+        void set_cull_face(GLenum faces);
+
+        /**
+         * \brief Bind a shader program.
+         * \param program The program to bind.
+         */
+        void use_program(GLuint program);
+
+        /**
+         * \brief Bind a vertex array object. The element array buffer binding is part of the vertex array, so it's forgotten.
+         * \param vertex_array The vertex array to bind.
+         */
+        void bind_vertex_array(GLuint vertex_array);
+
+        /**
+         * \brief Bind a buffer.
+         * \param target The buffer target. Only GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER are shadowed.
+         * \param buffer The buffer to bind.
+         */
+        void bind_buffer(GLenum target, GLuint buffer);
+
+        /**
+         * \brief Bind a frame buffer to GL_FRAMEBUFFER.
+         * \param frame_buffer The frame buffer to bind.
+         */
+        void bind_frame_buffer(GLuint frame_buffer);
+
+        /**
+         * \brief Bind a texture to a texture unit.
+         * \param unit The texture unit to bind to.
+         * \param target The texture target. Only GL_TEXTURE_2D and GL_TEXTURE_CUBE_MAP are shadowed.
+         * \param texture The texture to bind.
+         */
+        void bind_texture(GLuint unit, GLenum target, GLuint texture);
+
+        /**
+         * \brief Forget any binding of a deleted frame buffer, because OpenGL reverts bindings of deleted objects to 0.
+         * \param frame_buffer The deleted frame buffer.
+         */
+        void frame_buffer_deleted(GLuint frame_buffer);
+
+        /**
+         * \brief Forget a deleted program if it's in use. A deleted program stays in use until another replaces it, so
+         * a new program that reuses its name must still be issued.
+         * \param program The deleted program.
+         */
+        void program_deleted(GLuint program);
+
+        /**
+         * \brief Forget any binding of a deleted vertex array, because OpenGL reverts bindings of deleted objects to 0.
+         * \param vertex_array The deleted vertex array.
+         */
+        void vertex_array_deleted(GLuint vertex_array);
+
+        /**
+         * \brief Forget any binding of a deleted buffer, because OpenGL reverts bindings of deleted objects to 0.
+         * \param buffer The deleted buffer.
+         */
+        void buffer_deleted(GLuint buffer);
+
+        /**
+         * \brief Get the number of state changes issued and elided since the stats were last reset.
+         * \return The state change stats.
+         */
+        const state_change_stats& get_stats() const;
+
+        /**
+         * \brief Reset the state change stats.
+         */
+        void reset_stats();
+    };
+} // namespace moka
@@ -31,20 +31,26 @@ SOFTWARE.
 
 #include "graphics/buffer/frame_buffer_handle.hpp"
 #include "graphics/material/material_parameter.hpp"
+#include <array>
 #include <asset_importer/texture_importer.hpp>
 #include <graphics/buffer/buffer_usage.hpp>
 #include <graphics/buffer/index_buffer_handle.hpp>
+#include <graphics/buffer/uniform_buffer_handle.hpp>
 #include <graphics/buffer/vertex_buffer_handle.hpp>
 #include <graphics/buffer/vertex_layout.hpp>
+#include <graphics/command/graphics_command.hpp>
 #include <graphics/device/graphics_visitor.hpp>
 #include <graphics/program.hpp>
 #include <graphics/shader.hpp>
 #include <graphics/texture_handle.hpp>
+#include <string>
+#include <vector>
 
 namespace moka
 {
     class vertex_layout;
     class command_list;
+    class command_bundle;
 
     /**
      * \brief
@@ -103,6 +109,16 @@ namespace moka
         triangle_fan
     };
 
+    /**
+     * \brief The uniform blocks that programs can share. Each block has a fixed binding point, and programs declare it
+     * in GLSL as a std140 block with the matching name.
+     */
+    enum class uniform_block : uint8_t
+    {
+        frame, //!< frame_block, data that is constant for a whole frame
+        view   //!< view_block, data that is constant for every draw of a view
+    };
+
     enum class toggle : uint8_t
     {
         enable,
@@ -167,6 +183,92 @@ namespace moka
 
     struct draw_call;
 
+    /**
+     * \brief The number of render state changes issued and elided by a graphics_api.
+     */
+    struct state_change_stats final
+    {
+        size_t calls_issued = 0; /**< The number of state changes that reached the driver. */
+        size_t calls_elided = 0; /**< The number of state changes that were skipped because the state was already set. */
+    };
+
+    /**
+     * \brief The number of draws executed by a graphics_api, and the number of draw calls it needed to issue them.
+     */
+    struct draw_stats final
+    {
+        size_t draws = 0;      /**< The number of draw commands executed. */
+        size_t draw_calls = 0; /**< The number of draw calls that reached the driver. Batched draws share one call. */
+    };
+
+    /**
+     * \brief The GPU time spent inside a scope opened by a gpu_timer_command.
+     */
+    struct gpu_timer_result final
+    {
+        std::string name;        /**< The name of the scope. */
+        size_t depth = 0;        /**< The number of scopes this scope was nested in. */
+        double milliseconds = 0; /**< The GPU time between the start and the end of the scope. */
+    };
+
+    /**
+     * \brief The pixel data uploaded to textures by a graphics_api during one frame.
+     */
+    struct texture_upload_stats final
+    {
+        size_t bytes_uploaded = 0;   /**< The number of bytes copied to textures during the frame. */
+        size_t textures_pending = 0; /**< The number of textures still waiting for their pixels at the end of the frame. */
+    };
+
+    /**
+     * \brief The pixels read back by a read_pixels_command.
+     */
+    struct readback_result final
+    {
+        uint64_t tag = 0;                       /**< The tag of the read_pixels_command. */
+        int width = 0;                          /**< The width of the rectangle that was read. */
+        int height = 0;                         /**< The height of the rectangle that was read. */
+        host_format format = host_format::rgba; /**< The channels of each pixel. */
+        pixel_type pixel = pixel_type::uint8;   /**< The type of each channel. */
+        std::vector<uint8_t> pixels;            /**< The rows of pixels from bottom to top, each padded to 4 bytes. */
+    };
+
+    /**
+     * \brief The number of command types a null_graphics_api counts.
+     */
+    constexpr size_t null_command_type_count = static_cast<size_t>(command_type::read_pixels) + 1;
+
+    /**
+     * \brief The calls received by a null_graphics_api during one frame.
+     */
+    struct null_call_stats final
+    {
+        std::array<size_t, null_command_type_count> commands{}; /**< The number of commands executed, indexed by command_type. */
+        size_t invalid_commands = 0;    /**< The number of commands that failed validation and were dropped. */
+        size_t submits = 0;             /**< The number of command lists and bundles submitted. */
+        size_t resources_created = 0;   /**< The number of resources created. */
+        size_t resources_destroyed = 0; /**< The number of resources destroyed. */
+    };
+
+    /**
+     * \brief A command executed by a null_graphics_api while it was recording.
+     */
+    struct null_call final
+    {
+        size_t frame = 0;                        /**< The frame the command was executed in. */
+        command_type type = command_type::clear; /**< The type of the command. */
+        bool valid = true;                       /**< False if the command failed validation. */
+    };
+
+    /**
+     * \brief A linked program in the driver's own binary format.
+     */
+    struct program_binary final
+    {
+        uint32_t format = 0;       /**< The driver specific format of the binary. */
+        std::vector<uint8_t> data; /**< The binary itself. */
+    };
+
     /**
      * \brief render_context abstracts the native rendering API.
      */
@@ -191,6 +293,12 @@ namespace moka
          */
         virtual void submit(command_list&& commands) = 0;
 
+        /**
+         * \brief Submit a command_bundle to execute on the device. The bundle is left intact so that it can be submitted again.
+         * \param bundle The command_bundle you wish to run.
+         */
+        virtual void submit(command_bundle& bundle) = 0;
+
         /**
          * \brief Submit a command_list to execute on the device. The main framebuffer will be swapped after executing, advancing a frame.
          * \param commands The command_list you wish to run.
@@ -223,6 +331,45 @@ namespace moka
          */
         virtual shader_handle make_shader(shader_type type, const std::string& source) = 0;
 
+        /**
+         * \brief Find the location of an active uniform in a program. Programs are reflected the first time their link status is
+         * checked, so this only waits for the driver if the program is still being linked.
+         * \param program The program to search.
+         * \param name The name of the uniform.
+         * \return The location of the uniform, or -1 if the program has no active uniform with this name.
+         */
+        virtual int32_t find_uniform(program_handle program, const std::string& name) = 0;
+
+        /**
+         * \brief Get a string identifying the driver and the device it runs on. Program binaries are only valid for the
+         * driver that produced them.
+         * \return The driver identifier, or an empty string if this api can't retrieve program binaries.
+         */
+        virtual std::string get_driver_id() const = 0;
+
+        /**
+         * \brief Retrieve the binary of a linked program, so that it can be loaded again without compiling it.
+         * \param program The program whose binary you want.
+         * \param binary The binary of the program.
+         * \return True if the binary was retrieved. Otherwise, false.
+         */
+        virtual bool get_program_binary(program_handle program, program_binary& binary) = 0;
+
+        /**
+         * \brief Check whether a program has finished linking, without waiting for the driver to finish.
+         * \param program The program to check.
+         * \return True if the program has been linked, even if linking failed. False if it is still being linked.
+         */
+        virtual bool is_program_linked(program_handle program) = 0;
+
+        /**
+         * \brief Create a shader program from a binary previously retrieved with get_program_binary.
+         * \param binary The binary of the program.
+         * \return A new program_handle representing a program on the device, or an invalid handle if the driver rejected
+         * the binary.
+         */
+        virtual program_handle make_program(const program_binary& binary) = 0;
+
         /**
          * \brief Create a new vertex buffer.
          * \param vertices The host memory buffer that will be used as vertex data.
@@ -245,6 +392,14 @@ namespace moka
         virtual index_buffer_handle make_index_buffer(
             const void* indices, size_t size, index_type type, buffer_usage use) = 0;
 
+        /**
+         * \brief Create a new uniform buffer.
+         * \param block The uniform block that the buffer holds. Filling the buffer binds it to the block's binding point.
+         * \param size The size of the uniform buffer.
+         * \return A new uniform_buffer_handle representing a uniform buffer on the device.
+         */
+        virtual uniform_buffer_handle make_uniform_buffer(uniform_block block, size_t size) = 0;
+
         /**
          * \brief Create a new texture.
          * \param data The host memory buffer that will be used as texture data.
@@ -260,5 +415,68 @@ namespace moka
          * \param handle The host frame buffer that will be destroyed.
          */
         virtual void destroy(frame_buffer_handle handle) = 0;
+
+        /**
+         * \brief Destroy a program. Handles to it become stale.
+         * \param handle The program that will be destroyed.
+         */
+        virtual void destroy(program_handle handle) = 0;
+
+        /**
+         * \brief Destroy a shader. Handles to it become stale.
+         * \param handle The shader that will be destroyed.
+         */
+        virtual void destroy(shader_handle handle) = 0;
+
+        /**
+         * \brief Destroy a vertex buffer. Handles to it become stale.
+         * \param handle The vertex buffer that will be destroyed.
+         */
+        virtual void destroy(vertex_buffer_handle handle) = 0;
+
+        /**
+         * \brief Destroy an index buffer. Handles to it become stale.
+         * \param handle The index buffer that will be destroyed.
+         */
+        virtual void destroy(index_buffer_handle handle) = 0;
+
+        /**
+         * \brief Get the number of state changes that were issued and elided during the last complete frame.
+         * \return The state change stats of the last frame.
+         */
+        virtual state_change_stats get_state_change_stats() const = 0;
+
+        /**
+         * \brief Get the number of draws executed, and the draw calls issued for them, during the last complete frame.
+         * \return The draw stats of the last frame.
+         */
+        virtual draw_stats get_draw_stats() const = 0;
+
+        /**
+         * \brief Get the GPU timer scopes of the most recent frame whose results became available during the last swap.
+         * Results are never waited for, so this is empty when no frame finished on the GPU in time.
+         * \return The scopes of that frame, in the order they were opened.
+         */
+        virtual std::vector<gpu_timer_result> get_gpu_timers() const = 0;
+
+        /**
+         * \brief Set the number of bytes of streamed texture data that may be uploaded each frame. At least one image is
+         * uploaded every frame, even if it's larger than the budget.
+         * \param bytes The upload budget of a frame.
+         */
+        virtual void set_texture_upload_budget(size_t bytes) = 0;
+
+        /**
+         * \brief Get the pixel data uploaded to textures during the last complete frame.
+         * \return The texture upload stats of the last frame.
+         */
+        virtual texture_upload_stats get_texture_upload_stats() const = 0;
+
+        /**
+         * \brief Take the pixels of every read_pixels_command that has completed since the last call.
+         * \param wait True to wait for the readbacks that are still in flight. Otherwise, they're left for a later call.
+         * \return The completed readbacks, in the order their commands were executed.
+         */
+        virtual std::vector<readback_result> take_readbacks(bool wait) = 0;
     };
 } // namespace moka
@@ -0,0 +1,216 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief A dense pool of objects addressed by generational handles.
+     * A handle's id packs the index of its slot into the low index_bits bits and the generation of the slot into the
+     * rest. Releasing a slot bumps its generation, so handles to objects that have been released are detected instead
+     * of silently aliasing whatever reuses the slot. Lookups are a bounds check, a generation compare and an array
+     * index.
+     * \tparam Handle The handle type. Must have a uint32_t id that defaults to std::numeric_limits<uint32_t>::max().
+     * \tparam T The type of object stored in the pool.
+     */
+    template <typename Handle, typename T>
+    class handle_pool final
+    {
+    public:
+        static constexpr uint32_t index_bits = 20; /**< The number of bits of an id that hold the slot index. */
+
+        static constexpr uint32_t index_mask = (uint32_t{1} << index_bits) - 1; /**< Masks the slot index of an id. */
+
+        /**
+         * \brief The largest generation a slot can reach before it wraps back to 1. The all-ones generation is
+         * reserved so that no live handle is equal to the invalid handle, and generation 0 is skipped so that no live
+         * handle has an id of 0.
+         */
+        static constexpr uint32_t max_generation = (uint32_t{1} << (32 - index_bits)) - 2;
+
+        /**
+         * \brief The largest number of slots the pool can hold. The all-ones index is reserved for the invalid handle.
+         */
+        static constexpr uint32_t max_size = index_mask;
+
+    private:
+        struct slot final
+        {
+            T value{};
+            uint32_t generation = 1;
+            bool alive = false;
+        };
+
+        std::vector<slot> slots_;
+        std::vector<uint32_t> free_;
+        size_t size_ = 0;
+
+        static constexpr uint32_t generation(const Handle handle)
+        {
+            return handle.id >> index_bits;
+        }
+
+        const slot* find(const Handle handle) const
+        {
+            const auto index = handle_pool::index(handle);
+
+            if (index >= slots_.size())
+            {
+                return nullptr;
+            }
+
+            const auto& slot = slots_[index];
+
+            return slot.alive && slot.generation == generation(handle) ? &slot : nullptr;
+        }
+
+    public:
+        /**
+         * \brief Get the slot index of a handle. The index can be used to key data that lives alongside the pool.
+         * \param handle The handle.
+         * \return The slot index of the handle. The invalid handle has an index of index_mask.
+         */
+        static constexpr uint32_t index(const Handle handle)
+        {
+            return handle.id & index_mask;
+        }
+
+        /**
+         * \brief Add an object to the pool, reusing the slot of a released object if there is one.
+         * \param value The object to add.
+         * \return A handle to the object, or the invalid handle if the pool is full.
+         */
+        Handle allocate(T&& value)
+        {
+            uint32_t index;
+
+            if (!free_.empty())
+            {
+                index = free_.back();
+                free_.pop_back();
+            }
+            else if (slots_.size() < max_size)
+            {
+                index = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+            else
+            {
+                return Handle{};
+            }
+
+            auto& slot = slots_[index];
+            slot.value = std::move(value);
+            slot.alive = true;
+
+            ++size_;
+
+            Handle result;
+            result.id = slot.generation << index_bits | index;
+            return result;
+        }
+
+        /**
+         * \brief Remove an object from the pool. Handles to it become stale.
+         * \param handle The handle of the object to remove.
+         * \return True if the handle referred to a live object. Otherwise, false.
+         */
+        bool release(const Handle handle)
+        {
+            if (!find(handle))
+            {
+                return false;
+            }
+
+            const auto index = handle_pool::index(handle);
+
+            auto& slot = slots_[index];
+            slot.value = T{};
+            slot.alive = false;
+            slot.generation = slot.generation == max_generation ? 1 : slot.generation + 1;
+
+            free_.emplace_back(index);
+
+            --size_;
+
+            return true;
+        }
+
+        /**
+         * \brief Get the object a handle refers to.
+         * \param handle The handle of the object.
+         * \return A pointer to the object, or nullptr if the handle is invalid or stale.
+         */
+        T* get(const Handle handle)
+        {
+            return const_cast<T*>(static_cast<const handle_pool&>(*this).get(handle));
+        }
+
+        /**
+         * \brief Get the object a handle refers to.
+         * \param handle The handle of the object.
+         * \return A pointer to the object, or nullptr if the handle is invalid or stale.
+         */
+        const T* get(const Handle handle) const
+        {
+            const auto* slot = find(handle);
+            return slot ? &slot->value : nullptr;
+        }
+
+        /**
+         * \brief Call a function on every live object in the pool.
+         * \param function The function to call with each object.
+         */
+        template <typename Function>
+        void for_each(Function&& function)
+        {
+            for (auto& slot : slots_)
+            {
+                if (slot.alive)
+                {
+                    function(slot.value);
+                }
+            }
+        }
+
+        /**
+         * \brief Get the number of live objects in the pool.
+         * \return The number of live objects in the pool.
+         */
+        size_t size() const
+        {
+            return size_;
+        }
+    };
+} // namespace moka
@@ -0,0 +1,446 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <application/logger.hpp>
+#include <graphics/api/draw_batch.hpp>
+#include <graphics/api/graphics_api.hpp>
+#include <graphics/api/handle_pool.hpp>
+#include <graphics/buffer/vertex_layout.hpp>
+#include <graphics/device/graphics_device.hpp>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief The size of a buffer handed out by a null_graphics_api, kept to validate the commands that fill and draw it
+     */
+    struct null_buffer final
+    {
+        size_t size = 0;
+        vertex_layout layout; /**< The layout of a vertex buffer, to work out how many vertices it holds. */
+
+        /**
+         * \brief Get the number of vertices that fit in a vertex buffer, according to its layout.
+         * \return The number of vertices every attribute of the buffer can be read for.
+         */
+        size_t vertex_capacity() const;
+    };
+
+    /**
+     * \brief A graphics_api that talks to no device at all.
+     * Resources are handed out as generational handles backed by nothing, and every command is validated against them
+     * and counted, but never executed. Material parameters are still written to the device's material cache, and read
+     * pixels are delivered as zeros, so that code driving the device behaves exactly as it would with a real backend.
+     * Draws are batched by the same rules as the GL backend, so the draw calls it reports are the ones GL would issue.
+     * This measures the CPU cost of recording and submitting frames without any driver work.
+     */
+    class null_graphics_api final : public graphics_api
+    {
+        graphics_device& device_;
+
+        static logger log_;
+
+        handle_pool<vertex_buffer_handle, null_buffer> vertex_buffers_;
+        handle_pool<index_buffer_handle, null_buffer> index_buffers_;
+        handle_pool<uniform_buffer_handle, null_buffer> uniform_buffers_;
+        handle_pool<texture_handle, null_buffer> textures_;
+        handle_pool<frame_buffer_handle, null_buffer> frame_buffers_;
+        handle_pool<shader_handle, null_buffer> shaders_;
+        handle_pool<program_handle, null_buffer> programs_;
+
+        size_t frame_ = 0;
+        size_t open_timer_scopes_ = 0;
+
+        null_call_stats stats_;
+        null_call_stats frame_stats_;
+
+        uint32_t bound_pipeline_state_ = std::numeric_limits<uint32_t>::max();
+        uint32_t bound_program_ = std::numeric_limits<uint32_t>::max();
+        std::vector<uint32_t> bound_textures_;
+        state_change_stats state_stats_;
+        state_change_stats frame_state_stats_;
+
+        draw_batch batch_;
+        size_t draw_calls_ = 0;
+        size_t frame_draw_calls_ = 0;
+
+        bool recording_ = false;
+        std::vector<null_call> recorded_;
+
+        std::vector<readback_result> readbacks_;
+
+        /**
+         * \brief Count a command, and record it if recording is enabled.
+         * \param type The type of the command.
+         * \param valid True if the command passed validation.
+         */
+        void count(command_type type, bool valid);
+
+        /**
+         * \brief Issue the pending run of draws, counting it as one draw call.
+         */
+        void end_batch();
+
+        /**
+         * \brief Count a state change, eliding it if the object is already bound.
+         * \param bound The object that is bound.
+         * \param object The object to bind.
+         */
+        void bind(uint32_t& bound, uint32_t object);
+
+        /**
+         * \brief Bind the pipeline state, program and textures of a material.
+         * \param material The material to bind.
+         */
+        void bind(const material& material);
+
+        /**
+         * \brief Check that a handle refers to a live resource, logging an error if it doesn't.
+         * \param pool The pool the handle was allocated from.
+         * \param handle The handle to check.
+         * \param caller The name of the calling function, for the error message.
+         * \return True if the handle refers to a live resource. Otherwise, false.
+         */
+        template <typename Handle>
+        static bool is_live(const handle_pool<Handle, null_buffer>& pool, Handle handle, const char* caller);
+
+        /**
+         * \brief Release a handle, logging an error if it was already stale.
+         * \param pool The pool the handle was allocated from.
+         * \param handle The handle to release.
+         * \param caller The name of the calling function, for the error message.
+         */
+        template <typename Handle>
+        void release(handle_pool<Handle, null_buffer>& pool, Handle handle, const char* caller);
+
+    public:
+        /**
+         * \brief Create a new null_graphics_api object
+         * \param device The graphics_device object that owns this api object
+         */
+        explicit null_graphics_api(graphics_device& device);
+
+        null_graphics_api(const null_graphics_api& null_graphics_api) = delete;
+        null_graphics_api(null_graphics_api&& null_graphics_api) = delete;
+        null_graphics_api& operator=(const null_graphics_api& null_graphics_api) = delete;
+        null_graphics_api& operator=(null_graphics_api&& null_graphics_api) = delete;
+
+        virtual ~null_graphics_api() = default;
+
+        /**
+         * \brief Get the calls received during the last complete frame.
+         * \return The call stats of the last frame.
+         */
+        null_call_stats get_call_stats() const;
+
+        /**
+         * \brief Start or stop recording every command this api executes.
+         * \param enabled True to record commands. Otherwise, false.
+         */
+        void set_recording(bool enabled);
+
+        /**
+         * \brief Take the commands recorded since the last call.
+         * \return The recorded commands, in the order they were executed.
+         */
+        std::vector<null_call> take_recorded_calls();
+
+        /**
+         * \brief Create a program handle from two live shaders.
+         * \param vertex_handle The vertex shader of the program.
+         * \param fragment_handle The fragment shader of the program.
+         * \return A new program_handle, or an invalid handle if either shader is invalid or stale.
+         */
+        program_handle make_program(const shader_handle& vertex_handle, const shader_handle& fragment_handle) override;
+
+        /**
+         * \brief Create a shader handle. The source is never compiled.
+         * \param type The type of shader you want to create.
+         * \param source The source code of the shader you want to create.
+         * \return A new shader_handle.
+         */
+        shader_handle make_shader(shader_type type, const std::string& source) override;
+
+        /**
+         * \brief Find the location of a uniform. Programs have no uniforms, so this only validates the program.
+         * \param program The program to search.
+         * \param name The name of the uniform.
+         * \return -1.
+         */
+        int32_t find_uniform(program_handle program, const std::string& name) override;
+
+        /**
+         * \brief Get a string identifying the driver. There is no driver, so program binaries are never cached.
+         * \return An empty string.
+         */
+        std::string get_driver_id() const override;
+
+        /**
+         * \brief Retrieve the binary of a program. There is no driver to produce one.
+         * \param program The program whose binary you want.
+         * \param binary Left untouched.
+         * \return False.
+         */
+        bool get_program_binary(program_handle program, program_binary& binary) override;
+
+        /**
+         * \brief Check whether a program has finished linking. Programs are linked as soon as they are created.
+         * \param program The program to check.
+         * \return True.
+         */
+        bool is_program_linked(program_handle program) override;
+
+        /**
+         * \brief Create a program from a binary. There is no driver to accept one.
+         * \param binary The binary of the program.
+         * \return An invalid handle.
+         */
+        program_handle make_program(const program_binary& binary) override;
+
+        /**
+         * \brief Create a vertex buffer handle of the given size. The vertices are never read.
+         * \param vertices The host memory buffer that will be used as vertex data.
+         * \param size The size of the host vertex buffer.
+         * \param layout The layout of the vertex data.
+         * \param use A buffer usage hint.
+         * \return A new vertex_buffer_handle.
+         */
+        vertex_buffer_handle make_vertex_buffer(
+            const void* vertices, size_t size, vertex_layout&& layout, buffer_usage use) override;
+
+        /**
+         * \brief Create an index buffer handle of the given size. The indices are never read.
+         * \param indices The host memory buffer that will be used as index data.
+         * \param size The size of the host index buffer.
+         * \param type The layout of the index data.
+         * \param use A buffer usage hint.
+         * \return A new index_buffer_handle.
+         */
+        index_buffer_handle make_index_buffer(
+            const void* indices, size_t size, index_type type, buffer_usage use) override;
+
+        /**
+         * \brief Create a uniform buffer handle of the given size.
+         * \param block The uniform block that the buffer holds.
+         * \param size The size of the uniform buffer.
+         * \return A new uniform_buffer_handle.
+         */
+        uniform_buffer_handle make_uniform_buffer(uniform_block block, size_t size) override;
+
+        /**
+         * \brief Create a texture handle. The pixels are never read.
+         * \param data The host memory buffer that will be used as texture data.
+         * \param metadata Metadata describing the texture data.
+         * \param free_host_data Ignored, the graphics_device frees the host data.
+         * \return A new texture_handle.
+         */
+        texture_handle make_texture(const void** data, texture_metadata&& metadata, bool free_host_data) override;
+
+        /**
+         * \brief Create a frame buffer handle.
+         * \param render_textures An array of render_texture_data.
+         * \param render_texture_count Size of the render_textures array.
+         * \return A new frame_buffer_handle.
+         */
+        frame_buffer_handle make_frame_buffer(render_texture_data* render_textures, size_t render_texture_count) override;
+
+        /**
+         * \brief Get the state changes of the last frame. Draws bind their material's pipeline state, program and textures,
+         * and a bind is elided when the same object is still bound, as a backend that shadows its state would. Each
+         * pipeline state, program and texture unit counts as one call.
+         * \return The state changes of the last frame.
+         */
+        state_change_stats get_state_change_stats() const override;
+
+        /**
+         * \brief Get the number of draws executed during the last complete frame. No draw call ever reaches a driver.
+         * \return The draw stats of the last frame.
+         */
+        draw_stats get_draw_stats() const override;
+
+        /**
+         * \brief Get the GPU timer scopes of the last frame. Scopes are validated, but there is no GPU to time.
+         * \return An empty vector.
+         */
+        std::vector<gpu_timer_result> get_gpu_timers() const override;
+
+        /**
+         * \brief Set the upload budget of a frame. Textures are never uploaded, so this does nothing.
+         * \param bytes The upload budget of a frame.
+         */
+        void set_texture_upload_budget(size_t bytes) override;
+
+        /**
+         * \brief Get the texture upload stats of the last frame. Textures are never uploaded.
+         * \return Empty stats.
+         */
+        texture_upload_stats get_texture_upload_stats() const override;
+
+        /**
+         * \brief Take the pixels of every read_pixels_command executed since the last call. Their pixels are zero.
+         * \param wait Ignored, readbacks complete as soon as their command is executed.
+         * \return The readbacks, in the order their commands were executed.
+         */
+        std::vector<readback_result> take_readbacks(bool wait) override;
+
+        /**
+         * \brief Validate and count the commands of a command_list.
+         * \param commands The command_list you wish to run.
+         */
+        void submit(command_list&& commands) override;
+
+        /**
+         * \brief Validate and count the commands of a command_bundle. The bundle is left intact.
+         * \param bundle The command_bundle you wish to run.
+         */
+        void submit(command_bundle& bundle) override;
+
+        /**
+         * \brief Validate and count the commands of a command_list, then advance a frame.
+         * \param commands The command_list you wish to run.
+         */
+        void submit_and_swap(command_list&& commands) override;
+
+        /**
+         * \brief Release a frame buffer handle. Handles to it become stale.
+         * \param handle The frame buffer that will be released.
+         */
+        void destroy(frame_buffer_handle handle) override;
+
+        /**
+         * \brief Release a program handle. Handles to it become stale.
+         * \param handle The program that will be released.
+         */
+        void destroy(program_handle handle) override;
+
+        /**
+         * \brief Release a shader handle. Handles to it become stale.
+         * \param handle The shader that will be released.
+         */
+        void destroy(shader_handle handle) override;
+
+        /**
+         * \brief Release a vertex buffer handle. Handles to it become stale.
+         * \param handle The vertex buffer that will be released.
+         */
+        void destroy(vertex_buffer_handle handle) override;
+
+        /**
+         * \brief Release a index buffer handle. Handles to it become stale.
+         * \param handle The index buffer that will be released.
+         */
+        void destroy(index_buffer_handle handle) override;
+
+        /**
+         * \brief Validate and count a clear_command.
+         * \param cmd The command to validate.
+         */
+        void visit(clear_command& cmd) override;
+
+        /**
+         * \brief Validate and count a draw_command.
+         * \param cmd The command to validate.
+         */
+        void visit(draw_command& cmd) override;
+
+        /**
+         * \brief Validate and count a viewport_command.
+         * \param cmd The command to validate.
+         */
+        void visit(viewport_command& cmd) override;
+
+        /**
+         * \brief Validate and count a scissor_command.
+         * \param cmd The command to validate.
+         */
+        void visit(scissor_command& cmd) override;
+
+        /**
+         * \brief Validate and count a fill_vertex_buffer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(fill_vertex_buffer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a fill_index_buffer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(fill_index_buffer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a fill_uniform_buffer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(fill_uniform_buffer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a fill_stream_buffer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(fill_stream_buffer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a gpu_timer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(gpu_timer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a read_pixels_command.
+         * \param cmd The command to validate.
+         */
+        void visit(read_pixels_command& cmd) override;
+
+        /**
+         * \brief Validate and count a frame_buffer_command.
+         * \param cmd The command to validate.
+         */
+        void visit(frame_buffer_command& cmd) override;
+
+        /**
+         * \brief Validate and count a frame_buffer_texture_command.
+         * \param cmd The command to validate.
+         */
+        void visit(frame_buffer_texture_command& cmd) override;
+
+        /**
+         * \brief Validate and count a generate_mipmaps_command.
+         * \param cmd The command to validate.
+         */
+        void visit(generate_mipmaps_command& cmd) override;
+
+        /**
+         * \brief Validate and count a set_material_parameters_command.
+         * \param cmd The command to validate.
+         */
+        void visit(set_material_parameters_command& cmd) override;
+    };
+} // namespace moka
@@ -57,11 +57,11 @@ namespace moka
     };
 
     /**
-     * \brief A handle to a frame buffer object on the device.
+     * \brief A handle to a frame buffer object on the device. A handle with an id of 0 refers to the default frame buffer.
      */
     struct frame_buffer_handle final
     {
-        uint16_t id = std::numeric_limits<uint16_t>::max();
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const frame_buffer_handle& rhs) const;
 
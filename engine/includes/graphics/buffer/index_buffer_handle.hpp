@@ -29,6 +29,7 @@ SOFTWARE.
 */
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <limits>
 
@@ -50,12 +51,35 @@ namespace moka
         float32
     };
 
+    /**
+     * \brief Get the size of an index in bytes.
+     * \param type The type of index.
+     * \return The size of an index in bytes.
+     */
+    constexpr size_t index_size(const index_type type)
+    {
+        switch (type)
+        {
+        case index_type::int8:
+        case index_type::uint8:
+            return 1;
+        case index_type::int16:
+        case index_type::uint16:
+            return 2;
+        case index_type::int64:
+        case index_type::uint64:
+            return 8;
+        default:
+            return 4;
+        }
+    }
+
     /**
      * \brief A handle to a index buffer object on the device.
      */
     struct index_buffer_handle final
     {
-        uint16_t id = std::numeric_limits<uint16_t>::max();
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const index_buffer_handle& rhs) const;
 
@@ -0,0 +1,100 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace moka
+{
+    /**
+     * \brief A range of the stream buffer, allocated for one frame. Its offset is relative to the part of the stream
+     * buffer that belongs to the frame it was allocated in, so it's only valid for the commands of that frame.
+     */
+    struct stream_range
+    {
+        uint32_t offset = std::numeric_limits<uint32_t>::max(); /**< The offset of the range, in bytes. */
+        uint32_t size = 0;                                      /**< The size of the range, in bytes. */
+
+        /**
+         * \brief Does this range refer to stream buffer memory?
+         * \return True if the range was allocated successfully. Otherwise, false.
+         */
+        bool is_valid() const;
+    };
+
+    /**
+     * \brief Hands out ranges of the stream buffer to the commands of one frame. Allocation is lock-free, so command
+     * lists can be recorded on different threads at the same time.
+     */
+    class stream_allocator final
+    {
+        std::atomic<size_t> head_;
+        size_t capacity_;
+
+    public:
+        static constexpr size_t default_capacity = 4 * 1024 * 1024; /**< The size of the stream buffer available to each frame. */
+
+        static constexpr size_t frame_count = 3; /**< The number of frames the device may still be reading from the stream buffer. */
+
+        /**
+         * \brief Create a new stream_allocator object.
+         * \param capacity The number of bytes available to each frame.
+         */
+        explicit stream_allocator(size_t capacity = default_capacity);
+
+        /**
+         * \brief Allocate a range of the stream buffer.
+         * \param size The size of the range in bytes.
+         * \param alignment The required alignment of the range. Doesn't need to be a power of two, so vertex ranges can be aligned to their stride.
+         * \return The new range, or an invalid range if this frame's part of the stream buffer is full.
+         */
+        stream_range allocate(size_t size, size_t alignment);
+
+        /**
+         * \brief Release every range at once. Called when the device advances a frame.
+         */
+        void reset();
+
+        /**
+         * \brief Get the number of bytes handed out since the last reset.
+         * \return The number of bytes handed out since the last reset.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Get the number of bytes available to each frame.
+         * \return The number of bytes available to each frame.
+         */
+        size_t capacity() const;
+    };
+} // namespace moka
@@ -98,6 +98,7 @@ namespace moka
         bool normalized = false; /**< Specifies whether fixed-point data values should be normalized (true) or converted directly as fixed-point values (false) when they are accessed. The initial value is false.*/
         size_t stride = 0; /**< Specifies the byte offset between consecutive generic vertex attributes. If stride is 0, the generic vertex attributes are understood to be tightly packed in the array. The initial value is 0.*/
         size_t offset = 0; /**< Specifies a offset of the first component of the first generic vertex attribute in the array. The initial value is 0.*/
+        size_t divisor = 0; /**< Specifies the number of instances that pass between updates of the attribute. If divisor is 0, the attribute advances once per vertex. The initial value is 0.*/
 
         /**
          * \brief Create a new vertex_attribute object.
@@ -107,9 +108,10 @@ namespace moka
          * \param normalized Should the new vertex_attribute be normalized?
          * \param stride The stride of the new vertex_attribute object.
          * \param offset The offset of the new vertex_attribute object.
+         * \param divisor The instance divisor of the new vertex_attribute object.
          */
         constexpr vertex_attribute(
-            size_t index, attribute_type type, size_t size, bool normalized, size_t stride, size_t offset) noexcept;
+            size_t index, attribute_type type, size_t size, bool normalized, size_t stride, size_t offset, size_t divisor = 0) noexcept;
     };
 
     constexpr vertex_attribute::vertex_attribute(
@@ -118,8 +120,9 @@ namespace moka
         const size_t size,
         const bool normalized,
         const size_t stride,
-        const size_t offset) noexcept
-        : index(index), type(type), size(size), normalized(normalized), stride(stride), offset(offset)
+        const size_t offset,
+        const size_t divisor) noexcept
+        : index(index), type(type), size(size), normalized(normalized), stride(stride), offset(offset), divisor(divisor)
     {
     }
 } // namespace moka
@@ -39,7 +39,7 @@ namespace moka
      */
     struct vertex_buffer_handle final
     {
-        uint16_t id = std::numeric_limits<uint16_t>::max();
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const vertex_buffer_handle& rhs) const;
 
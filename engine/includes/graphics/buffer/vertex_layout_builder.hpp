@@ -53,10 +53,11 @@ namespace moka
          * \param normalized Should the new vertex_attribute be normalized?
          * \param stride The stride of the new vertex_attribute object.
          * \param offset The offset of the new vertex_attribute object.
+         * \param divisor The instance divisor of the new vertex_attribute object. 0 advances the attribute once per vertex.
          * \return A reference to this vertex_layout_builder object to enable method chaining.
          */
         vertex_layout_builder& add_attribute(
-            size_t index, size_t size, attribute_type type, bool normalized, size_t stride, size_t offset);
+            size_t index, size_t size, attribute_type type, bool normalized, size_t stride, size_t offset, size_t divisor = 0);
 
         /**
          * \brief Build the final vertex layout, upload it to the device, and
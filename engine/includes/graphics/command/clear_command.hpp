@@ -37,21 +37,15 @@ namespace moka
     /**
      * \brief Clear the current frame buffer.
      */
-    class clear_command final : public graphics_command
+    class clear_command final
     {
     public:
+        static constexpr command_type type = command_type::clear; /**< The tag that identifies this command in a command stream. */
+
         glm::vec4 color; /**< The color that should be used to clear the buffer. */
         bool clear_depth = false; /**< Should we clear the depth information? */
         bool clear_color = false; /**< Should we clear the color buffer? */
 
-        virtual ~clear_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the color of the clear_command.
          * \param color The color that should be used.
@@ -0,0 +1,138 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief A linear (bump) allocator that provides the storage for graphics commands.
+     * Memory is handed out from large blocks and released all at once with reset(). Blocks are kept after a reset,
+     * so an allocator that is reused every frame stops allocating from the heap once it has warmed up.
+     */
+    class command_allocator final
+    {
+        struct block final
+        {
+            std::unique_ptr<std::byte[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<block> blocks_;
+        size_t current_block_ = 0;
+        size_t offset_ = 0;
+        size_t block_size_;
+        size_t bytes_used_ = 0;
+        size_t heap_allocations_ = 0;
+
+        void* allocate_from_next_block(size_t size, size_t alignment);
+
+    public:
+        static constexpr size_t default_block_size = 64 * 1024; /**< The default size of each block of command memory. */
+
+        /**
+         * \brief Create a new command_allocator object.
+         * \param block_size The size of each block of memory that the allocator requests from the heap.
+         */
+        explicit command_allocator(size_t block_size = default_block_size);
+
+        ~command_allocator();
+
+        command_allocator(const command_allocator& rhs) = delete;
+
+        command_allocator(command_allocator&& rhs) noexcept;
+
+        command_allocator& operator=(const command_allocator& rhs) = delete;
+
+        command_allocator& operator=(command_allocator&& rhs) noexcept;
+
+        /**
+         * \brief Allocate an uninitialized region of memory.
+         * \param size The size of the region in bytes.
+         * \param alignment The required alignment of the region.
+         * \return A pointer to the new region. It remains valid until the allocator is reset or destroyed.
+         */
+        void* allocate(size_t size, size_t alignment);
+
+        /**
+         * \brief Grow the most recent allocation in place, if its block has room.
+         * \param memory The region returned by the most recent call to allocate.
+         * \param size The current size of the region in bytes.
+         * \param new_size The size the region should grow to.
+         * \return True if the region now spans new_size bytes. Otherwise, false, and the region is unchanged.
+         */
+        bool extend(void* memory, size_t size, size_t new_size);
+
+        /**
+         * \brief Allocate and construct a new object.
+         * \tparam T The type of object you want to create.
+         * \tparam Args The types of the constructor arguments.
+         * \param args The constructor arguments.
+         * \return A pointer to the new object. The allocator never calls the destructor of this object.
+         */
+        template <typename T, typename... Args>
+        T* make(Args&&... args);
+
+        /**
+         * \brief Release every allocation at once. This does not return any memory to the heap.
+         */
+        void reset();
+
+        /**
+         * \brief Get the number of bytes handed out since the last reset.
+         * \return The number of bytes handed out since the last reset.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Get the total number of bytes owned by this allocator.
+         * \return The total number of bytes owned by this allocator.
+         */
+        size_t capacity() const;
+
+        /**
+         * \brief Get the number of times this allocator has requested memory from the heap.
+         * \return The number of heap allocations made by this allocator.
+         */
+        size_t heap_allocations() const;
+    };
+
+    template <typename T, typename... Args>
+    T* command_allocator::make(Args&&... args)
+    {
+        auto* memory = allocate(sizeof(T), alignof(T));
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+} // namespace moka
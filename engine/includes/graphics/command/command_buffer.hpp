@@ -30,35 +30,125 @@ SOFTWARE.
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <graphics/command/clear_command.hpp>
+#include <graphics/command/command_allocator.hpp>
+#include <graphics/command/draw_command.hpp>
+#include <graphics/command/fill_index_buffer_command.hpp>
+#include <graphics/command/fill_stream_buffer_command.hpp>
+#include <graphics/command/fill_uniform_buffer_command.hpp>
+#include <graphics/command/fill_vertex_buffer_command.hpp>
+#include <graphics/command/frame_buffer_command.hpp>
+#include <graphics/command/frame_buffer_texture_command.hpp>
+#include <graphics/command/generate_mipmaps_command.hpp>
+#include <graphics/command/gpu_timer_command.hpp>
 #include <graphics/command/graphics_command.hpp>
-#include <graphics/device/graphics_visitor.hpp>
+#include <graphics/command/read_pixels_command.hpp>
+#include <graphics/command/scissor_command.hpp>
+#include <graphics/command/set_material_properties_command.hpp>
+#include <graphics/command/sort_key.hpp>
+#include <graphics/command/viewport_command.hpp>
+#include <new>
 #include <type_traits>
-#include <vector>
 
 namespace moka
 {
-    using sort_key = uint64_t;
+    class material_cache;
+
+    /**
+     * \brief Decode a command record and pass the command to a visitor.
+     * The visitor's type is known at compile time, so no virtual dispatch takes place when it is a concrete (final) type.
+     * \tparam Visitor Any type that provides a visit overload for every command type.
+     * \param header The header of the command record.
+     * \param visitor The visitor to pass the command to.
+     */
+    template <typename Visitor>
+    void dispatch(command_header& header, Visitor& visitor)
+    {
+        switch (header.type)
+        {
+        case command_type::clear:
+            visitor.visit(command_record<clear_command>::from_header(header));
+            break;
+        case command_type::draw:
+            visitor.visit(command_record<draw_command>::from_header(header));
+            break;
+        case command_type::viewport:
+            visitor.visit(command_record<viewport_command>::from_header(header));
+            break;
+        case command_type::scissor:
+            visitor.visit(command_record<scissor_command>::from_header(header));
+            break;
+        case command_type::fill_vertex_buffer:
+            visitor.visit(command_record<fill_vertex_buffer_command>::from_header(header));
+            break;
+        case command_type::fill_index_buffer:
+            visitor.visit(command_record<fill_index_buffer_command>::from_header(header));
+            break;
+        case command_type::frame_buffer:
+            visitor.visit(command_record<frame_buffer_command>::from_header(header));
+            break;
+        case command_type::frame_buffer_texture:
+            visitor.visit(command_record<frame_buffer_texture_command>::from_header(header));
+            break;
+        case command_type::generate_mipmaps:
+            visitor.visit(command_record<generate_mipmaps_command>::from_header(header));
+            break;
+        case command_type::set_material_parameters:
+            visitor.visit(command_record<set_material_parameters_command>::from_header(header));
+            break;
+        case command_type::fill_uniform_buffer:
+            visitor.visit(command_record<fill_uniform_buffer_command>::from_header(header));
+            break;
+        case command_type::fill_stream_buffer:
+            visitor.visit(command_record<fill_stream_buffer_command>::from_header(header));
+            break;
+        case command_type::gpu_timer:
+            visitor.visit(command_record<gpu_timer_command>::from_header(header));
+            break;
+        case command_type::read_pixels:
+            visitor.visit(command_record<read_pixels_command>::from_header(header));
+            break;
+        }
+    }
 
     /**
      * \brief A command_buffer is a collection of render commands married by a sort_key. Command buffers are owned by a command_list.
+     * Commands are stored as a contiguous stream of trivially copyable records in the command_list's allocator.
      */
     class command_buffer
     {
-        std::vector<graphics_command_ptr> commands_;
+        friend class set_material_parameters_builder;
+
+        command_allocator* allocator_ = nullptr;
+
+        const material_cache* materials_ = nullptr;
+
+        std::byte* data_ = nullptr;
+
+        uint32_t size_ = 0;
+
+        uint32_t capacity_ = 0;
 
         sort_key id_ = 0;
 
         template <typename T>
         T& emplace_back();
 
+        void reserve(size_t size);
+
+        std::byte* append(size_t size);
+
+        std::byte* grow_record(uint32_t offset, size_t used, size_t size);
+
     public:
         /**
          * \brief Create a new command_buffer object.
+         * \param allocator The allocator that will own the storage of every command in this command_buffer.
          * \param id The sort key that we should use for this command_buffer.
+         * \param materials The materials that set_material_parameters_builder looks parameter names up in, if any.
          */
-        explicit command_buffer(sort_key id);
-
-        command_buffer() = default;
+        command_buffer(command_allocator& allocator, sort_key id, const material_cache* materials = nullptr);
 
         ~command_buffer() = default;
 
@@ -77,10 +167,39 @@ namespace moka
         const sort_key& get_key() const;
 
         /**
-         * \brief Accept a graphics_visitor object and pass every command to it.
-         * \param device The graphics_visitor object.
+         * \brief Get the first command record in this command_buffer.
+         * \return An iterator to the header of the first command record.
+         */
+        command_iterator begin() const;
+
+        /**
+         * \brief Get the end of the command records in this command_buffer.
+         * \return An iterator past the last command record.
+         */
+        command_iterator end() const;
+
+        /**
+         * \brief Get the size of the command stream.
+         * \return The size of every command record in this command_buffer, in bytes.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Decode every command in this command_buffer and pass it to a visitor.
+         * \tparam Visitor Any type that provides a visit overload for every command type.
+         * \param visitor The visitor object.
          */
-        void accept(graphics_visitor& device);
+        template <typename Visitor>
+        void accept(Visitor& visitor);
+
+        /**
+         * \brief Remove every command that satisfies a predicate.
+         * \tparam Predicate A callable object that takes a command_header& and returns true if the command should be removed.
+         * \param predicate The predicate.
+         * \return The number of commands removed.
+         */
+        template <typename Predicate>
+        size_t remove_if(Predicate&& predicate);
 
         /**
          * \brief Create and return a frame_buffer_command object.
@@ -130,6 +249,30 @@ namespace moka
          */
         fill_vertex_buffer_command& fill_vertex_buffer();
 
+        /**
+         * \brief Create and return a fill_uniform_buffer_command object.
+         * \return A reference to the new fill_uniform_buffer_command object.
+         */
+        fill_uniform_buffer_command& fill_uniform_buffer();
+
+        /**
+         * \brief Create and return a fill_stream_buffer_command object.
+         * \return A reference to the new fill_stream_buffer_command object.
+         */
+        fill_stream_buffer_command& fill_stream_buffer();
+
+        /**
+         * \brief Create and return a gpu_timer_command object.
+         * \return A reference to the new gpu_timer_command object.
+         */
+        gpu_timer_command& gpu_timer();
+
+        /**
+         * \brief Create and return a read_pixels_command object.
+         * \return A reference to the new read_pixels_command object.
+         */
+        read_pixels_command& read_pixels();
+
         /**
          * \brief Create and return a generate_mipmaps_command object.
          * \return A reference to the new generate_mipmaps_command object.
@@ -137,24 +280,72 @@ namespace moka
         generate_mipmaps_command& generate_mipmaps();
 
         /**
-         * \brief Create and return a set_material_parameters_command object.
-         * \return A reference to the new set_material_parameters_command object.
+         * \brief Create a set_material_parameters_command object. Set its parameters before adding another command.
+         * \return A builder that appends parameters to the new set_material_parameters_command object.
          */
-        set_material_parameters_command& set_material_parameters();
+        set_material_parameters_builder set_material_parameters();
     };
 
     template <typename T>
     T& command_buffer::emplace_back()
     {
         static_assert(
-            std::is_base_of_v<graphics_command, T>,
-            "Please only emplace commands that derive from the "
-            "graphics_command interface!");
+            std::is_same_v<decltype(T::type), const command_type>,
+            "Please only emplace commands that declare their command_type!");
+        static_assert(
+            std::is_trivially_copyable_v<T>,
+            "Command records are copied as bytes, so commands must be trivially copyable!");
+        static_assert(alignof(command_record<T>) <= command_alignment);
+
+        constexpr auto size = align_command_size(sizeof(command_record<T>));
 
-        commands_.emplace_back(std::make_unique<T>());
+        auto* record = new (append(size)) command_record<T>{};
+        record->header.type = T::type;
+        record->header.size = static_cast<uint32_t>(size);
 
-        auto& ptr = commands_.back();
-        auto cast = static_cast<T*>(ptr.get());
-        return *cast;
+        return record->command;
+    }
+
+    template <typename Visitor>
+    void command_buffer::accept(Visitor& visitor)
+    {
+        for (auto& header : *this)
+        {
+            dispatch(header, visitor);
+        }
+    }
+
+    template <typename Predicate>
+    size_t command_buffer::remove_if(Predicate&& predicate)
+    {
+        size_t removed = 0;
+        uint32_t kept = 0;
+
+        // records are trivially copyable, so the ones we keep are slid down over the ones we remove
+        for (uint32_t offset = 0; offset < size_;)
+        {
+            auto& header = *reinterpret_cast<command_header*>(data_ + offset);
+            const auto size = header.size;
+
+            if (predicate(header))
+            {
+                ++removed;
+            }
+            else
+            {
+                if (kept != offset)
+                {
+                    std::memmove(data_ + kept, data_ + offset, size);
+                }
+
+                kept += size;
+            }
+
+            offset += size;
+        }
+
+        size_ = kept;
+
+        return removed;
     }
 } // namespace moka
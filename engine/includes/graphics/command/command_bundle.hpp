@@ -0,0 +1,164 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/command/command_list.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace moka
+{
+    class material_cache;
+
+    /**
+     * \brief A value for a patched material parameter, written to the bundle when it is executed.
+     */
+    struct bundle_patch final
+    {
+        const std::vector<material_parameter_record*>* locations; /**< The material parameters the value is written to. */
+        parameter value;                                          /**< The new value. */
+    };
+
+    /**
+     * \brief A command_bundle is a command_list that is recorded once and submitted every frame.
+     * The commands are sorted and validated when the bundle is created. Material parameters that change
+     * between frames (such as the view and projection matrices) are registered as patches and updated
+     * in place, without re-recording the bundle. New values are held until the bundle is submitted, so
+     * a bundle can be patched for the next frame while the render thread is still executing it.
+     */
+    class command_bundle final
+    {
+        command_list commands_;
+
+        std::unordered_map<std::string, std::vector<material_parameter_record*>> patches_;
+
+        std::vector<bundle_patch> pending_patches_;
+
+        size_t invalid_commands_ = 0;
+
+        template <typename T>
+        command_bundle& set_patch(const std::string& name, const T& data);
+
+    public:
+        /**
+         * \brief Create a new command_bundle from a command_list.
+         * \param commands The commands to bundle. The command_list must own its storage, so it must not be created by graphics_device::make_command_list.
+         */
+        explicit command_bundle(command_list&& commands);
+
+        /**
+         * \brief Register a material parameter that will be updated every frame. A name can only be registered once,
+         * because patches that have been set but not yet applied on the render thread point at its locations.
+         * \param materials The materials that the bundle's commands update, which map the name to each material's parameter.
+         * \param name The name of the material parameter.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& add_patch(const material_cache& materials, const std::string& name);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, float data);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, const glm::vec3& data);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, const glm::vec4& data);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, const glm::mat3& data);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, const glm::mat4& data);
+
+        /**
+         * \brief Update a patched material parameter in every command of the bundle the next time it is submitted.
+         * \param name The name of a material parameter registered with add_patch.
+         * \param data The new value.
+         * \return A reference to this command_bundle object to enable method chaining.
+         */
+        command_bundle& set_parameter(const std::string& name, texture_handle data);
+
+        /**
+         * \brief Get the number of commands that failed validation when the bundle was created.
+         * \return The number of invalid commands.
+         */
+        size_t get_invalid_command_count() const;
+
+        /**
+         * \brief Is the bundle valid?
+         * \return True if every command passed validation. Otherwise, false.
+         */
+        bool is_valid() const;
+
+        /**
+         * \brief Take the patched values set since the bundle was last submitted.
+         * \return The pending patches, in the order they were set.
+         */
+        std::vector<bundle_patch> take_patches();
+
+        /**
+         * \brief Write patched values to the bundled commands. Call this on the thread that executes the bundle.
+         * \param patches Patches taken from this bundle with take_patches.
+         */
+        void apply_patches(const std::vector<bundle_patch>& patches);
+
+        /**
+         * \brief Get the bundled commands.
+         * \return The bundled commands.
+         */
+        command_list& get_commands();
+    };
+} // namespace moka
@@ -31,13 +31,18 @@ SOFTWARE.
 
 #include "generate_mipmaps_command.hpp"
 #include <graphics/command/clear_command.hpp>
+#include <graphics/command/command_allocator.hpp>
 #include <graphics/command/command_buffer.hpp>
 #include <graphics/command/command_list.hpp>
 #include <graphics/command/draw_command.hpp>
 #include <graphics/command/fill_index_buffer_command.hpp>
+#include <graphics/command/fill_stream_buffer_command.hpp>
+#include <graphics/command/fill_uniform_buffer_command.hpp>
 #include <graphics/command/fill_vertex_buffer_command.hpp>
 #include <graphics/command/frame_buffer_command.hpp>
 #include <graphics/command/frame_buffer_texture_command.hpp>
+#include <graphics/command/gpu_timer_command.hpp>
+#include <graphics/command/read_pixels_command.hpp>
 #include <graphics/command/scissor_command.hpp>
 #include <graphics/command/set_material_properties_command.hpp>
 #include <graphics/command/viewport_command.hpp>
@@ -52,19 +57,50 @@ namespace moka
     {
         bool is_sorted_ = false;
         sort_key current_key_ = 0;
+        std::unique_ptr<command_allocator> owned_allocator_;
+        std::vector<std::unique_ptr<command_allocator>> retained_allocators_;
+        command_allocator* allocator_ = nullptr;
+        const material_cache* materials_ = nullptr;
         std::vector<command_buffer> command_packets_;
 
+        command_allocator& get_allocator();
+
         using iterator = std::vector<command_buffer>::iterator;
         using const_iterator = std::vector<command_buffer>::const_iterator;
 
-        struct key_comparator final
-        {
-            bool operator()(const command_buffer& left, const command_buffer& right) const;
-        };
-
     public:
+        /**
+         * \brief Lists with fewer command buffers than this are sorted with std::sort, larger lists use a radix sort.
+         * Each radix pass walks a 256 entry histogram, so the radix sort only pulls ahead at around a thousand entries
+         * (see the "Sorting sort entries" benchmark).
+         */
+        static constexpr size_t radix_sort_threshold = 1024;
+
+        /**
+         * \brief Create a new command_list object that owns the storage of its commands.
+         */
         command_list();
 
+        /**
+         * \brief Create a new command_list object that stores its commands in an external allocator.
+         * \param allocator The allocator to store commands in. It must not be reset while this command_list is alive.
+         */
+        explicit command_list(command_allocator& allocator);
+
+        /**
+         * \brief Create a new command_list object that owns the storage of its commands and can set material parameters by name.
+         * \param materials The materials to look parameter names up in.
+         */
+        explicit command_list(const material_cache& materials);
+
+        /**
+         * \brief Create a new command_list object that stores its commands in an external allocator and can set material
+         * parameters by name.
+         * \param allocator The allocator to store commands in. It must not be reset while this command_list is alive.
+         * \param materials The materials to look parameter names up in.
+         */
+        command_list(command_allocator& allocator, const material_cache& materials);
+
         ~command_list();
 
         command_list(const command_list& command_list) = delete;
@@ -81,13 +117,25 @@ namespace moka
         void destroy();
 
         /**
-         * \brief Accept a graphics_visitor object and pass every command to it.
-         * \param device The graphics_visitor object.
+         * \brief Merge command lists into a single sorted command_list, for example after recording them on different threads.
+         * Unsorted lists are sorted first; the sorted lists are then combined with a k-way merge. Command buffers with equal
+         * keys keep the order of the lists they came from. The merged list takes ownership of any allocators owned by the
+         * source lists, which are left empty.
+         * \param lists The command lists to merge.
+         * \return The merged command_list.
          */
-        void accept(graphics_visitor& device);
+        static command_list merge(std::vector<command_list>&& lists);
 
         /**
-         * \brief Sort the command_list.
+         * \brief Decode every command in this command_list and pass it to a visitor.
+         * \tparam Visitor Any type that provides a visit overload for every command type.
+         * \param visitor The visitor object.
+         */
+        template <typename Visitor>
+        void accept(Visitor& visitor);
+
+        /**
+         * \brief Sort the command_list by sort key. The sort is stable, command buffers with equal keys keep the order they were created in.
          */
         void sort();
 
@@ -125,17 +173,25 @@ namespace moka
         command_buffer& make_command_buffer(sort_key key);
 
         /**
-         * \brief Create and return a set_material_parameters_command object.
-         * \return A reference to the new set_material_parameters_command object.
+         * \brief Copy host memory into the storage of this command list, so that it lives as long as the commands do.
+         * \param data The host memory to copy.
+         * \param size The size of the host memory.
+         * \return The copy, or nullptr if there was nothing to copy.
          */
-        set_material_parameters_command& set_material_parameters();
+        const void* store(const void* data, size_t size);
 
         /**
-         * \brief Create and return a set_material_parameters_command object.
+         * \brief Create a set_material_parameters_command object in a new command_buffer.
+         * \return A builder that appends parameters to the new set_material_parameters_command object.
+         */
+        set_material_parameters_builder set_material_parameters();
+
+        /**
+         * \brief Create a set_material_parameters_command object in a new command_buffer.
          * \param key Use this sort_key to sort the command.
-         * \return A reference to the new set_material_parameters_command object.
+         * \return A builder that appends parameters to the new set_material_parameters_command object.
          */
-        set_material_parameters_command& set_material_parameters(sort_key key);
+        set_material_parameters_builder set_material_parameters(sort_key key);
 
         /**
          * \brief Create and return a frame_buffer_command object.
@@ -241,6 +297,58 @@ namespace moka
          */
         fill_vertex_buffer_command& fill_vertex_buffer(sort_key key);
 
+        /**
+         * \brief Create and return a fill_uniform_buffer_command object.
+         * \return A reference to the new fill_uniform_buffer_command object.
+         */
+        fill_uniform_buffer_command& fill_uniform_buffer();
+
+        /**
+         * \brief Create and return a fill_uniform_buffer_command object.
+         * \param key Use this sort_key to sort the command.
+         * \return A reference to the new fill_uniform_buffer_command object.
+         */
+        fill_uniform_buffer_command& fill_uniform_buffer(sort_key key);
+
+        /**
+         * \brief Create and return a fill_stream_buffer_command object.
+         * \return A reference to the new fill_stream_buffer_command object.
+         */
+        fill_stream_buffer_command& fill_stream_buffer();
+
+        /**
+         * \brief Create and return a fill_stream_buffer_command object.
+         * \param key Use this sort_key to sort the command.
+         * \return A reference to the new fill_stream_buffer_command object.
+         */
+        fill_stream_buffer_command& fill_stream_buffer(sort_key key);
+
+        /**
+         * \brief Create and return a gpu_timer_command object.
+         * \return A reference to the new gpu_timer_command object.
+         */
+        gpu_timer_command& gpu_timer();
+
+        /**
+         * \brief Create and return a gpu_timer_command object.
+         * \param key Use this sort_key to sort the command.
+         * \return A reference to the new gpu_timer_command object.
+         */
+        gpu_timer_command& gpu_timer(sort_key key);
+
+        /**
+         * \brief Create and return a read_pixels_command object.
+         * \return A reference to the new read_pixels_command object.
+         */
+        read_pixels_command& read_pixels();
+
+        /**
+         * \brief Create and return a read_pixels_command object.
+         * \param key Use this sort_key to sort the command.
+         * \return A reference to the new read_pixels_command object.
+         */
+        read_pixels_command& read_pixels(sort_key key);
+
         /**
          * \brief Create and return a generate_mipmaps_command object.
          * \return A reference to the new generate_mipmaps_command object.
@@ -254,4 +362,13 @@ namespace moka
          */
         generate_mipmaps_command& generate_mipmaps(sort_key key);
     };
+
+    template <typename Visitor>
+    void command_list::accept(Visitor& visitor)
+    {
+        for (auto& command_packet : command_packets_)
+        {
+            command_packet.accept(visitor);
+        }
+    }
 } // namespace moka
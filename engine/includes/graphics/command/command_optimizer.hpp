@@ -0,0 +1,75 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/command/command_list.hpp>
+#include <unordered_map>
+
+namespace moka
+{
+    class material_cache;
+
+    /**
+     * \brief The result of running a command_optimizer over a command_list.
+     */
+    struct command_optimizer_stats final
+    {
+        size_t commands_removed = 0;   /**< The number of commands that were removed. */
+        size_t parameters_removed = 0; /**< The number of material parameter writes that were removed. */
+    };
+
+    /**
+     * \brief Removes redundant commands from a command_list before it is executed.
+     * Viewport, scissor and frame buffer commands that repeat the current state are dropped, as are
+     * clears, draws and buffer fills that would do nothing. Material parameter writes that don't change
+     * the value a material already holds are removed, and parameter commands left empty are dropped.
+     */
+    class command_optimizer final
+    {
+        const material_cache& materials_;
+
+        std::unordered_map<uint16_t, std::unordered_map<uint16_t, parameter>> written_;
+
+    public:
+        /**
+         * \brief Create a new command_optimizer object.
+         * \param materials The materials that set_material_parameters commands will write to.
+         */
+        explicit command_optimizer(const material_cache& materials);
+
+        /**
+         * \brief Remove the redundant commands from a command_list. Commands are considered in the order they will execute,
+         * so the list should be sorted first. The material parameters must not change between optimizing and executing the list.
+         * \param list The command_list to optimize.
+         * \return The number of commands and parameter writes removed.
+         */
+        command_optimizer_stats optimize(command_list& list);
+    };
+} // namespace moka
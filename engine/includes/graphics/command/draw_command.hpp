@@ -39,9 +39,11 @@ namespace moka
     /**
      * \brief Render primitives using the specified material. Contains vertex buffer, index buffer (optional) and material data.
      */
-    class draw_command final : public graphics_command
+    class draw_command final
     {
     public:
+        static constexpr command_type type = command_type::draw; /**< The tag that identifies this command in a command stream. */
+
         material_handle material = {std::numeric_limits<uint16_t>::max()}; /**< The material that should be use for rendering. */
 
         vertex_buffer_handle vertex_buffer; /**< The vertex buffer that should be used. */
@@ -64,23 +66,47 @@ namespace moka
         primitive_type prim_type =
             primitive_type::triangles; /**< Specifies what kind of primitives to render. */
 
-        draw_command();
+        int32_t base_vertex = 0; /**< Specifies a constant that should be added to each index before fetching a vertex. */
+
+        bool streamed = false; /**< Read vertices and indices from the stream buffer. The vertex buffer only supplies the vertex layout. */
+
+        vertex_buffer_handle instance_buffer; /**< The buffer of per-instance attributes that should be used (optional). */
 
-        ~draw_command();
+        uint32_t instance_count = 1; /**< The number of instances to be rendered. */
 
-        draw_command(const draw_command& rhs);
+        uint32_t first_instance = 0; /**< Specifies the first instance read from the instance buffer. */
 
-        draw_command& operator=(const draw_command& rhs);
+        /**
+         * \brief Does this draw read an index buffer?
+         * \return True if the draw is indexed. Otherwise, false.
+         */
+        bool is_indexed() const;
 
-        draw_command(draw_command&& rhs) noexcept;
+        /**
+         * \brief Set the constant added to each index before fetching a vertex.
+         * \param base The base vertex.
+         * \return A reference to this draw_command object to enable method chaining.
+         */
+        draw_command& set_base_vertex(int32_t base);
 
-        draw_command& operator=(draw_command&& rhs) noexcept;
+        /**
+         * \brief Read vertices, and indices if the index count is not zero, from this frame's ranges of the stream buffer.
+         * The index buffer offset and base vertex (or first vertex, when not indexed) locate the ranges; align the vertex
+         * range to the stride of the vertex layout so that it starts on a whole vertex.
+         * \param streamed True to read from the stream buffer.
+         * \return A reference to this draw_command object to enable method chaining.
+         */
+        draw_command& set_streamed(bool streamed);
 
         /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
+         * \brief Render several instances of the primitives in one draw.
+         * \param instance_buffer A vertex buffer whose layout only has attributes with a non-zero divisor, such as a buffer of instance_data.
+         * \param count The number of instances to render.
+         * \param first The first instance to read from the instance buffer. Draws of the same primitives and material
+         * that read different instances are batched into one draw call.
+         * \return A reference to this draw_command object to enable method chaining.
          */
-        void accept(graphics_visitor& visitor) override;
+        draw_command& set_instances(vertex_buffer_handle instance_buffer, uint32_t count, uint32_t first = 0);
 
         /**
          * \brief Set the index buffer offset.
@@ -37,21 +37,15 @@ namespace moka
     /**
      * \brief Fill an index buffer.
      */
-    class fill_index_buffer_command final : public graphics_command
+    class fill_index_buffer_command final
     {
     public:
+        static constexpr command_type type = command_type::fill_index_buffer; /**< The tag that identifies this command in a command stream. */
+
         index_buffer_handle handle; /**< The index buffer you want to fill. */
         const void* data;           /**< The host buffer of index data. */
         size_t size;                /**< The size of the host buffer. */
 
-        virtual ~fill_index_buffer_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the index buffer that you want to fill.
          * \param handle The index buffer you want to fill.
@@ -0,0 +1,57 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/buffer/stream_buffer.hpp>
+#include <graphics/command/graphics_command.hpp>
+
+namespace moka
+{
+    /**
+     * \brief Copy host data into a range of the stream buffer. The stream buffer is persistently mapped, so this never
+     * reallocates device storage or waits for the device to finish reading the range.
+     */
+    class fill_stream_buffer_command final
+    {
+    public:
+        static constexpr command_type type = command_type::fill_stream_buffer; /**< The tag that identifies this command in a command stream. */
+
+        stream_range range;        /**< The range of the stream buffer you want to fill. */
+        const void* data = nullptr; /**< The host buffer of data. It must be at least as large as the range. */
+
+        /**
+         * \brief Set the range of the stream buffer that you want to fill.
+         * \param range The range you want to fill, allocated with graphics_device::allocate_stream during this frame.
+         * \param data The host buffer data you want to copy into the range.
+         * \return A reference to this fill_stream_buffer_command object to enable method chaining.
+         */
+        fill_stream_buffer_command& set_buffer(stream_range range, const void* data);
+    };
+} // namespace moka
@@ -37,21 +37,15 @@ namespace moka
     /**
      * \brief Fill a vertex buffer.
      */
-    class fill_vertex_buffer_command final : public graphics_command
+    class fill_vertex_buffer_command final
     {
     public:
+        static constexpr command_type type = command_type::fill_vertex_buffer; /**< The tag that identifies this command in a command stream. */
+
         vertex_buffer_handle handle; /**< The vertex buffer you want to fill. */
         const void* data;            /**< The host buffer of vertex data. */
         size_t size;                 /**< The size of the host buffer. */
 
-        virtual ~fill_vertex_buffer_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the vertex buffer that you want to fill.
          * \param handle The vertex buffer you want to fill.
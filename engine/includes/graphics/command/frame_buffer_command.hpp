@@ -37,28 +37,12 @@ namespace moka
     /**
      * \brief Set the current frame buffer. This will modify all subsequent draw commands in this list.
      */
-    class frame_buffer_command final : public graphics_command
+    class frame_buffer_command final
     {
     public:
-        frame_buffer_handle buffer; /**< The current frame buffer you want to use. */
-
-        frame_buffer_command();
-
-        ~frame_buffer_command();
-
-        frame_buffer_command(const frame_buffer_command& rhs);
-
-        frame_buffer_command& operator=(const frame_buffer_command& rhs);
+        static constexpr command_type type = command_type::frame_buffer; /**< The tag that identifies this command in a command stream. */
 
-        frame_buffer_command(frame_buffer_command&& rhs) noexcept;
-
-        frame_buffer_command& operator=(frame_buffer_command&& rhs) noexcept;
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
+        frame_buffer_handle buffer; /**< The current frame buffer you want to use. */
 
         /**
          * \brief Set the current frame buffer.
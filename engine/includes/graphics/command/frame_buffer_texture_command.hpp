@@ -38,22 +38,16 @@ namespace moka
     /**
      * \brief Set the texture you want to attach to this frame buffer.
      */
-    class frame_buffer_texture_command final : public graphics_command
+    class frame_buffer_texture_command final
     {
     public:
+        static constexpr command_type type = command_type::frame_buffer_texture; /**< The tag that identifies this command in a command stream. */
+
         texture_handle texture; /**< Specifies the texture object whose image is to be attached. */
         frame_attachment attachment; /**< Specifies the attachment to which the texture should be attached. */
         image_target target; /**< Specifies the texture target.  */
         int level; /**< Specifies the mipmap level of the texture image to be attached, which must be 0.*/
 
-        virtual ~frame_buffer_texture_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the texture whose image is to be attached.
          * \param texture The texture whose image is to be attached.
@@ -37,18 +37,12 @@ namespace moka
     /**
      * \brief Generate mipmaps for a specified texture.
      */
-    class generate_mipmaps_command final : public graphics_command
+    class generate_mipmaps_command final
     {
     public:
-        texture_handle texture; /**< The texture object to generate mipmaps for. */
-
-        virtual ~generate_mipmaps_command();
+        static constexpr command_type type = command_type::generate_mipmaps; /**< The tag that identifies this command in a command stream. */
 
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
+        texture_handle texture; /**< The texture object to generate mipmaps for. */
 
         /**
          * \brief Set the texture object to generate mipmaps for.
@@ -0,0 +1,74 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <array>
+#include <graphics/command/graphics_command.hpp>
+
+namespace moka
+{
+    /**
+     * \brief Whether a gpu_timer_command opens or closes a scope.
+     */
+    enum class gpu_timer_event : uint8_t
+    {
+        begin, //!< Start timing a scope. Scopes can be nested.
+        end    //!< Stop timing the innermost open scope.
+    };
+
+    /**
+     * \brief Open or close a named scope whose GPU time is measured. A scope can span several command lists, but must
+     * be closed in the frame it was opened in. Results are read back a few frames later, through graphics_device::get_gpu_timers.
+     */
+    class gpu_timer_command final
+    {
+    public:
+        static constexpr command_type type = command_type::gpu_timer; /**< The tag that identifies this command in a command stream. */
+
+        static constexpr size_t max_name_length = 31; /**< Longer names are truncated. */
+
+        gpu_timer_event event = gpu_timer_event::begin; /**< Whether this command opens or closes a scope. */
+
+        std::array<char, max_name_length + 1> name{}; /**< The null-terminated name of the scope being opened. */
+
+        /**
+         * \brief Open a scope.
+         * \param name The name of the scope. It's copied into the command.
+         * \return A reference to this gpu_timer_command object to enable method chaining.
+         */
+        gpu_timer_command& begin_scope(const char* name);
+
+        /**
+         * \brief Close the innermost open scope.
+         * \return A reference to this gpu_timer_command object to enable method chaining.
+         */
+        gpu_timer_command& end_scope();
+    };
+} // namespace moka
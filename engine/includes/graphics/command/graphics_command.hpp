@@ -29,29 +29,118 @@ SOFTWARE.
 */
 #pragma once
 
-#include <memory>
+#include <cstddef>
+#include <cstdint>
 
 namespace moka
 {
-    class graphics_visitor;
+    /**
+     * \brief Identifies the type of a command record in a command stream.
+     */
+    enum class command_type : uint8_t
+    {
+        clear,                   //!< clear_command
+        draw,                    //!< draw_command
+        viewport,                //!< viewport_command
+        scissor,                 //!< scissor_command
+        fill_vertex_buffer,      //!< fill_vertex_buffer_command
+        fill_index_buffer,       //!< fill_index_buffer_command
+        frame_buffer,            //!< frame_buffer_command
+        frame_buffer_texture,    //!< frame_buffer_texture_command
+        generate_mipmaps,        //!< generate_mipmaps_command
+        set_material_parameters, //!< set_material_parameters_command
+        fill_uniform_buffer,     //!< fill_uniform_buffer_command
+        fill_stream_buffer,      //!< fill_stream_buffer_command
+        gpu_timer,               //!< gpu_timer_command
+        read_pixels              //!< read_pixels_command
+    };
 
     /**
-     * \brief Base type for graphics commands
+     * \brief Every record in a command stream starts at a multiple of this alignment.
      */
-    class graphics_command
+    constexpr size_t command_alignment = 8;
+
+    /**
+     * \brief Round a size up to the next multiple of command_alignment.
+     * \param size The size in bytes.
+     * \return The aligned size in bytes.
+     */
+    constexpr size_t align_command_size(const size_t size)
     {
-    public:
+        return (size + command_alignment - 1) & ~(command_alignment - 1);
+    }
+
+    /**
+     * \brief The header of a command record. Every command in a command stream is stored directly after its header.
+     */
+    struct command_header final
+    {
+        command_type type; /**< The type of the command that follows this header. */
+        uint32_t size = 0; /**< The size of the record in bytes, including this header and any data that trails the command. */
+    };
+
+    /**
+     * \brief A command and its header, stored contiguously in a command stream.
+     * \tparam T The type of command.
+     */
+    template <typename T>
+    struct command_record final
+    {
+        command_header header; /**< The header of this record. */
+        T command;             /**< The command data. */
+
         /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
+         * \brief Get the command stored after a header.
+         * \param header The header of a command_record<T>.
+         * \return The command that follows the header.
          */
-        virtual void accept(graphics_visitor& visitor) = 0;
-
-        virtual ~graphics_command() = default;
+        static T& from_header(command_header& header)
+        {
+            return reinterpret_cast<command_record*>(&header)->command;
+        }
     };
 
     /**
-     * \brief An owning pointer to a graphics command.
+     * \brief Walks the records of a command stream in order.
      */
-    using graphics_command_ptr = std::unique_ptr<graphics_command>;
+    class command_iterator final
+    {
+        std::byte* record_;
+
+    public:
+        /**
+         * \brief Create a new command_iterator object.
+         * \param record The first byte of a record in a command stream.
+         */
+        explicit command_iterator(std::byte* record)
+            : record_(record)
+        {
+        }
+
+        command_header& operator*() const
+        {
+            return *reinterpret_cast<command_header*>(record_);
+        }
+
+        command_header* operator->() const
+        {
+            return reinterpret_cast<command_header*>(record_);
+        }
+
+        command_iterator& operator++()
+        {
+            record_ += operator*().size;
+            return *this;
+        }
+
+        bool operator==(const command_iterator& rhs) const
+        {
+            return record_ == rhs.record_;
+        }
+
+        bool operator!=(const command_iterator& rhs) const
+        {
+            return record_ != rhs.record_;
+        }
+    };
 } // namespace moka
@@ -0,0 +1,88 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/api/graphics_api.hpp>
+#include <graphics/command/graphics_command.hpp>
+
+namespace moka
+{
+    /**
+     * \brief Read a rectangle of pixels back from the bound frame buffer, without waiting for the GPU. The pixels are
+     * delivered a few frames later, through graphics_device::poll_readbacks.
+     */
+    class read_pixels_command final
+    {
+    public:
+        static constexpr command_type type = command_type::read_pixels; /**< The tag that identifies this command in a command stream. */
+
+        uint64_t tag = 0; /**< Identifies the pixels when they're delivered. */
+
+        int x = 0;      /**< The x position of the lower left corner of the rectangle. */
+        int y = 0;      /**< The y position of the lower left corner of the rectangle. */
+        int width = 0;  /**< The width of the rectangle. */
+        int height = 0; /**< The height of the rectangle. */
+
+        host_format format = host_format::rgba; /**< The format of the pixels delivered to the host. */
+        pixel_type pixel = pixel_type::uint8;   /**< The type of each channel of the pixels delivered to the host. */
+
+        /**
+         * \brief Set the tag that identifies the pixels when they're delivered.
+         * \param tag The tag of this readback.
+         * \return A reference to this read_pixels_command object to enable method chaining.
+         */
+        read_pixels_command& set_tag(uint64_t tag);
+
+        /**
+         * \brief Set the rectangle to read in window coordinates.
+         * \param x The x position of the lower left corner of the rectangle.
+         * \param y The y position of the lower left corner of the rectangle.
+         * \param width The width of the rectangle.
+         * \param height The height of the rectangle.
+         * \return A reference to this read_pixels_command object to enable method chaining.
+         */
+        read_pixels_command& set_rectangle(int x, int y, int width, int height);
+
+        /**
+         * \brief Set the rectangle to read in window coordinates.
+         * \param rectangle A rectangle whose x and y components specify its lower left corner.
+         * \return A reference to this read_pixels_command object to enable method chaining.
+         */
+        read_pixels_command& set_rectangle(const rectangle& rectangle);
+
+        /**
+         * \brief Set the layout of the pixels delivered to the host.
+         * \param format The channels of each pixel.
+         * \param pixel The type of each channel.
+         * \return A reference to this read_pixels_command object to enable method chaining.
+         */
+        read_pixels_command& set_format(host_format format, pixel_type pixel);
+    };
+} // namespace moka
@@ -38,22 +38,16 @@ namespace moka
     /**
      * \brief Set the scissor box to apply to the command list.
      */
-    class scissor_command final : public graphics_command
+    class scissor_command final
     {
     public:
+        static constexpr command_type type = command_type::scissor; /**< The tag that identifies this command in a command stream. */
+
         int width = 0;  /**< The width of the scissor box. */
         int height = 0; /**< The height of the scissor box. */
         int x = 0; /**< The x position of the lower left corner of the scissor box. Initially 0. */
         int y = 0; /**< The y position of the lower left corner of the scissor box. Initially 0. */
 
-        virtual ~scissor_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the rectangle of the scissor box in window coordinates.
          * \param x The x position of the lower left corner of the scissor box. Initially 0.
@@ -31,80 +31,300 @@ SOFTWARE.
 
 #include <graphics/command/graphics_command.hpp>
 #include <graphics/material/material.hpp>
+#include <limits>
 
 namespace moka
 {
+    class command_buffer;
+
+    /**
+     * \brief The value of one material parameter, stored in a command stream after the set_material_parameters_command that sets it.
+     * The data follows the record directly, and its size depends on the type of the parameter.
+     */
+    struct material_parameter_record final
+    {
+        uint16_t index;      /**< The index of the parameter in its material. */
+        parameter_type type; /**< The type of the data that follows this record. */
+
+        /**
+         * \brief Get the size of the data stored for a type of parameter.
+         * \param type The type of parameter.
+         * \return The size of the data in bytes.
+         */
+        static constexpr size_t get_data_size(const parameter_type type)
+        {
+            switch (type)
+            {
+            case parameter_type::texture:
+                return sizeof(texture_handle);
+            case parameter_type::vec3:
+                return sizeof(glm::vec3);
+            case parameter_type::vec4:
+                return sizeof(glm::vec4);
+            case parameter_type::mat3:
+                return sizeof(glm::mat3);
+            case parameter_type::mat4:
+                return sizeof(glm::mat4);
+            case parameter_type::float32:
+                return sizeof(float);
+            default:
+                return 0;
+            }
+        }
+
+        /**
+         * \brief Get the size of this record, including its data.
+         * \return The size of this record in bytes.
+         */
+        size_t size() const;
+
+        /**
+         * \brief Get the value stored in this record.
+         * \return The value stored in this record.
+         */
+        parameter get_data() const;
+
+        /**
+         * \brief Overwrite the value stored in this record.
+         * \param data The new value. It must have the same type as the record.
+         * \return True if the value was written. Otherwise, false.
+         */
+        bool set_data(const parameter& data);
+
+        /**
+         * \brief Get the record that follows this one.
+         * \return The next record. Only valid if the command has more parameters.
+         */
+        material_parameter_record* next();
+
+        /**
+         * \brief Get the record that follows this one.
+         * \return The next record. Only valid if the command has more parameters.
+         */
+        const material_parameter_record* next() const;
+    };
+
+    static_assert(sizeof(material_parameter_record) == 4, "Parameter data must stay aligned to 4 bytes!");
+
     /**
-     * \brief Update material parameters before drawing.
+     * \brief Update material parameters before drawing. The parameters are stored in the command stream directly after the command.
      */
-    class set_material_parameters_command final : public graphics_command
+    class set_material_parameters_command final
     {
     public:
-        material_handle material; /**< The material to update. */
+        static constexpr command_type type = command_type::set_material_parameters; /**< The tag that identifies this command in a command stream. */
 
-        std::vector<material_parameter> parameters; /**< The material parameters to update. */
+        material_handle material = {std::numeric_limits<uint16_t>::max()}; /**< The material to update. */
 
-        virtual ~set_material_parameters_command();
+        uint16_t count = 0; /**< The number of material_parameter_record objects that follow this command. */
+
+        /**
+         * \brief Get the first parameter that follows this command. Only commands stored in a command stream have parameters.
+         * \return The first parameter. Only valid if count is not zero.
+         */
+        material_parameter_record* get_parameters();
+
+        /**
+         * \brief Get the first parameter that follows this command. Only commands stored in a command stream have parameters.
+         * \return The first parameter. Only valid if count is not zero.
+         */
+        const material_parameter_record* get_parameters() const;
+
+        /**
+         * \brief Call a function for every parameter of this command.
+         * \tparam Function A callable object that takes a material_parameter_record&.
+         * \param function The function.
+         */
+        template <typename Function>
+        void for_each_parameter(Function&& function);
+
+        /**
+         * \brief Call a function for every parameter of this command.
+         * \tparam Function A callable object that takes a const material_parameter_record&.
+         * \param function The function.
+         */
+        template <typename Function>
+        void for_each_parameter(Function&& function) const;
+    };
+
+    /**
+     * \brief Records a set_material_parameters_command into a command_buffer. Every parameter is appended to the command
+     * stream after the command, so no other command can be added to the command_buffer until the last parameter is set.
+     */
+    class set_material_parameters_builder final
+    {
+        command_buffer& buffer_;
+        uint32_t offset_;
+        uint32_t size_;
+
+        set_material_parameters_command& get_command();
+
+        template <typename T>
+        set_material_parameters_builder& append(uint16_t index, parameter_type type, const T& data);
+
+        int32_t find_index(const std::string& name);
+
+        template <typename T>
+        set_material_parameters_builder& set_named_parameter(const std::string& name, const T& data);
+
+    public:
+        /**
+         * \brief Create a new set_material_parameters_builder object.
+         * \param buffer The command_buffer that holds the command.
+         * \param offset The offset of the command's record in the command_buffer.
+         */
+        set_material_parameters_builder(command_buffer& buffer, uint32_t offset);
+
+        set_material_parameters_builder(const set_material_parameters_builder& rhs) = delete;
+
+        set_material_parameters_builder& operator=(const set_material_parameters_builder& rhs) = delete;
 
         /**
          * \brief Set the material that you want to update.
          * \param material The material that you want to update.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_material(material_handle material);
+        set_material_parameters_builder& set_material(material_handle material);
 
         /**
          * \brief Update a material parameter.
-         * \param name The name of the material parameter you want to update.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, float data);
+        set_material_parameters_builder& set_parameter(uint16_t index, float data);
 
         /**
          * \brief Update a material parameter.
-         * \param name The name of the material parameter you want to update.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, const glm::vec3& data);
+        set_material_parameters_builder& set_parameter(uint16_t index, const glm::vec3& data);
 
         /**
          * \brief Update a material parameter.
-         * \param name The name of the material parameter you want to update.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, const glm::vec4& data);
+        set_material_parameters_builder& set_parameter(uint16_t index, const glm::vec4& data);
 
         /**
          * \brief Update a material parameter.
-         * \param name The name of the material parameter you want to update.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, const glm::mat3& data);
+        set_material_parameters_builder& set_parameter(uint16_t index, const glm::mat3& data);
 
         /**
          * \brief Update a material parameter.
-         * \param name The name of the material parameter you want to update.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, const glm::mat4& data);
+        set_material_parameters_builder& set_parameter(uint16_t index, const glm::mat4& data);
 
         /**
          * \brief Update a material parameter.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(uint16_t index, texture_handle data);
+
+        /**
+         * \brief Update a material parameter.
+         * \param index The index of the material parameter, from graphics_device::find_parameter_index.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(uint16_t index, const parameter& data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(const std::string& name, float data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
          * \param name The name of the material parameter you want to update.
          * \param data The new data you wish to update the material parameter with.
-         * \return A reference to this set_material_parameters_command object to enable method chaining.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        set_material_parameters_command& set_parameter(const std::string& name, texture_handle data);
+        set_material_parameters_builder& set_parameter(const std::string& name, const glm::vec3& data);
 
         /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
          */
-        void accept(graphics_visitor& visitor) override;
+        set_material_parameters_builder& set_parameter(const std::string& name, const glm::vec4& data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(const std::string& name, const glm::mat3& data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(const std::string& name, const glm::mat4& data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(const std::string& name, texture_handle data);
+
+        /**
+         * \brief Update a material parameter. The name is looked up in the material when the parameter is recorded, so set
+         * the material first. Prefer the index overloads for parameters that are set every frame.
+         * \param name The name of the material parameter you want to update.
+         * \param data The new data you wish to update the material parameter with.
+         * \return A reference to this set_material_parameters_builder object to enable method chaining.
+         */
+        set_material_parameters_builder& set_parameter(const std::string& name, const parameter& data);
     };
+
+    template <typename Function>
+    void set_material_parameters_command::for_each_parameter(Function&& function)
+    {
+        auto* parameter = get_parameters();
+
+        for (uint16_t i = 0; i < count; ++i, parameter = parameter->next())
+        {
+            function(*parameter);
+        }
+    }
+
+    template <typename Function>
+    void set_material_parameters_command::for_each_parameter(Function&& function) const
+    {
+        const auto* parameter = get_parameters();
+
+        for (uint16_t i = 0; i < count; ++i, parameter = parameter->next())
+        {
+            function(*parameter);
+        }
+    }
 } // namespace moka
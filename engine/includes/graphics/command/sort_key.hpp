@@ -0,0 +1,285 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <graphics/api/graphics_api.hpp>
+
+namespace moka
+{
+    using sort_key = uint64_t;
+
+    /**
+     * \brief A contiguous range of bits inside a sort_key.
+     */
+    struct sort_key_field final
+    {
+        uint8_t offset = 0; /**< The position of the least significant bit of the field. */
+        uint8_t width = 0;  /**< The number of bits in the field. */
+
+        /**
+         * \brief Get the largest value that fits in this field.
+         * \return The largest value that fits in this field.
+         */
+        constexpr uint64_t max() const
+        {
+            return width >= 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+        }
+
+        /**
+         * \brief Pack a value into this field. Bits that do not fit in the field are discarded.
+         * \param value The value to pack.
+         * \return A sort_key with only this field set.
+         */
+        constexpr sort_key encode(const uint64_t value) const
+        {
+            return (value & max()) << offset;
+        }
+
+        /**
+         * \brief Extract the value of this field from a sort_key.
+         * \param key The sort_key to read.
+         * \return The value stored in this field.
+         */
+        constexpr uint64_t decode(const sort_key key) const
+        {
+            return (key >> offset) & max();
+        }
+
+        /**
+         * \brief Get the bit after the most significant bit of this field.
+         * \return The offset of the next field up.
+         */
+        constexpr uint8_t end() const
+        {
+            return static_cast<uint8_t>(offset + width);
+        }
+    };
+
+    /**
+     * \brief The position of an item in a sorted collection, paired with its sort key.
+     */
+    struct sort_entry final
+    {
+        sort_key key;   /**< The sort key of the item. */
+        uint32_t index; /**< The position of the item before sorting. */
+    };
+
+    /**
+     * \brief Stable LSD radix sort of sort entries, one byte of the key per pass.
+     * Passes in which every key shares the same byte are skipped.
+     * \param entries The entries to sort. May be null if count is less than two.
+     * \param scratch Scratch memory for at least count entries.
+     * \param count The number of entries.
+     */
+    void radix_sort(sort_entry* entries, sort_entry* scratch, size_t count);
+
+    /**
+     * \brief The order in which classes of geometry are drawn within a view layer.
+     */
+    enum class translucency : uint8_t
+    {
+        opaque,     //!< Fully opaque geometry, drawn first, sorted to minimise state changes.
+        masked,     //!< Alpha tested geometry.
+        background, //!< Geometry drawn behind everything else, such as a skybox. Drawn after opaque geometry to save fill rate.
+        translucent //!< Blended geometry, drawn last from back to front.
+    };
+
+    /**
+     * \brief The bit layout of a sort_key. Fields are listed from the most significant down.
+     * Opaque geometry is sorted by state first and by depth (front to back) last; translucent geometry is sorted by inverted depth (back to front) first.
+     */
+    struct sort_key_layout final
+    {
+        static constexpr sort_key_field view_layer{60, 4};
+        static constexpr sort_key_field translucency{58, 2};
+
+        struct opaque final
+        {
+            static constexpr sort_key_field pipeline_state{46, 12};
+            static constexpr sort_key_field program{34, 12};
+            static constexpr sort_key_field texture_set{22, 12};
+            static constexpr sort_key_field depth{0, 22};
+        };
+
+        struct translucent final
+        {
+            static constexpr sort_key_field depth{36, 22};
+            static constexpr sort_key_field pipeline_state{24, 12};
+            static constexpr sort_key_field program{12, 12};
+            static constexpr sort_key_field texture_set{0, 12};
+        };
+
+        static_assert(translucency.end() == view_layer.offset);
+        static_assert(view_layer.end() == 64);
+        static_assert(opaque::pipeline_state.end() == translucency.offset);
+        static_assert(opaque::program.end() == opaque::pipeline_state.offset);
+        static_assert(opaque::texture_set.end() == opaque::program.offset);
+        static_assert(opaque::depth.end() == opaque::texture_set.offset);
+        static_assert(translucent::depth.end() == translucency.offset);
+        static_assert(translucent::pipeline_state.end() == translucent::depth.offset);
+        static_assert(translucent::program.end() == translucent::pipeline_state.offset);
+        static_assert(translucent::texture_set.end() == translucent::program.offset);
+        static_assert(translucent::depth.width == opaque::depth.width);
+    };
+
+    /**
+     * \brief Builds a sort_key from the properties of a draw, using sort_key_layout.
+     */
+    class sort_key_builder final
+    {
+        uint64_t view_layer_ = 0;
+        moka::translucency translucency_ = moka::translucency::opaque;
+        uint32_t depth_ = 0;
+        uint64_t pipeline_state_ = 0;
+        uint64_t program_ = 0;
+        uint64_t texture_set_ = 0;
+
+    public:
+        /**
+         * \brief Quantize a non-negative view depth so that its order is preserved.
+         * \param depth The view depth (or squared distance) to quantize.
+         * \return The most significant bits of the depth, suitable for the depth field.
+         */
+        static uint32_t quantize_depth(float depth);
+
+        /**
+         * \brief Set the view layer. Lower layers are drawn first.
+         * \param layer The view layer.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_view_layer(const uint8_t layer)
+        {
+            view_layer_ = layer;
+            return *this;
+        }
+
+        /**
+         * \brief Set the translucency class.
+         * \param translucency The translucency class.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_translucency(const moka::translucency translucency)
+        {
+            translucency_ = translucency;
+            return *this;
+        }
+
+        /**
+         * \brief Set the translucency class from a material's alpha mode.
+         * \param alpha The alpha mode of the material.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_translucency(const alpha_mode alpha)
+        {
+            switch (alpha)
+            {
+            case alpha_mode::blend:
+                translucency_ = moka::translucency::translucent;
+                break;
+            case alpha_mode::mask:
+                translucency_ = moka::translucency::masked;
+                break;
+            case alpha_mode::opaque:
+                translucency_ = moka::translucency::opaque;
+                break;
+            }
+            return *this;
+        }
+
+        /**
+         * \brief Set the view depth of the draw.
+         * \param depth The view depth (or squared distance), must not be negative.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        sort_key_builder& set_depth(float depth);
+
+        /**
+         * \brief Set the pipeline state id.
+         * \param id The pipeline state id.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_pipeline_state(const uint64_t id)
+        {
+            pipeline_state_ = id;
+            return *this;
+        }
+
+        /**
+         * \brief Set the program id.
+         * \param id The program id.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_program(const uint64_t id)
+        {
+            program_ = id;
+            return *this;
+        }
+
+        /**
+         * \brief Set the texture set id.
+         * \param id The texture set id.
+         * \return A reference to this sort_key_builder object to enable method chaining.
+         */
+        constexpr sort_key_builder& set_texture_set(const uint64_t id)
+        {
+            texture_set_ = id;
+            return *this;
+        }
+
+        /**
+         * \brief Build the sort_key.
+         * \return The sort_key.
+         */
+        constexpr sort_key build() const
+        {
+            const auto key = sort_key_layout::view_layer.encode(view_layer_) |
+                             sort_key_layout::translucency.encode(static_cast<uint64_t>(translucency_));
+
+            if (translucency_ == moka::translucency::translucent)
+            {
+                using layout = sort_key_layout::translucent;
+
+                // invert the depth so that distant geometry is drawn first
+                return key | layout::depth.encode(layout::depth.max() - depth_) |
+                       layout::pipeline_state.encode(pipeline_state_) |
+                       layout::program.encode(program_) |
+                       layout::texture_set.encode(texture_set_);
+            }
+
+            using layout = sort_key_layout::opaque;
+
+            return key | layout::pipeline_state.encode(pipeline_state_) |
+                   layout::program.encode(program_) |
+                   layout::texture_set.encode(texture_set_) | layout::depth.encode(depth_);
+        }
+    };
+} // namespace moka
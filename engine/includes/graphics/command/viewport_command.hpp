@@ -37,9 +37,11 @@ namespace moka
     /**
      * \brief Set the viewport to apply to the command list.
      */
-    class viewport_command : public graphics_command
+    class viewport_command
     {
     public:
+        static constexpr command_type type = command_type::viewport; /**< The tag that identifies this command in a command stream. */
+
         int width = 0;  /**< The width of the viewport. */
         int height = 0; /**< The height of the viewport. */
         int x = 0; /**< The x position of the lower left corner of the viewport. Initially 0. */
@@ -47,14 +49,6 @@ namespace moka
 
         const char* name = "viewport_command";
 
-        virtual ~viewport_command();
-
-        /**
-         * \brief Accept a graphics_visitor object. Invoke this command using
-         * the graphics_visitor. \param visitor A graphics_visitor object.
-         */
-        void accept(graphics_visitor& visitor) override;
-
         /**
          * \brief Set the rectangle of the viewport in window coordinates.
          * \param x The x position of the lower left corner of the viewport. Initially 0.
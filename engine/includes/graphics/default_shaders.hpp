@@ -55,8 +55,12 @@ namespace moka
 
                 layout (location = 0) in vec3 a_pos;
 
-                uniform mat4 projection;
-                uniform mat4 view;
+                layout (std140) uniform view_block
+                {
+                    mat4 view;
+                    mat4 projection;
+                    vec3 view_pos;
+                };
 
                 out vec3 local_position;
 
@@ -80,9 +84,21 @@ namespace moka
               
                 uniform samplerCube environment_map;
 
-                uniform float gamma;
+                struct directional_light
+                {
+                    vec3 direction;
+                    vec3 diffuse;
+                    vec3 ambient;
+                };
 
-                uniform float exposure;
+                layout (std140) uniform frame_block
+                {
+                    directional_light light;
+                    float gamma;
+                    float exposure;
+                    bool use_ibl;
+                    bool use_directional_light;
+                };
 
                 void main()
                 {
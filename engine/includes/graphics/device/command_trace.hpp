@@ -0,0 +1,300 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <graphics/command/command_list.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace moka
+{
+    class graphics_device;
+    class material_cache;
+    class pipeline_state_cache;
+
+    /**
+     * \brief The chunks that make up a command trace. Every chunk starts with its type and the size of its payload.
+     */
+    enum class trace_chunk : uint8_t
+    {
+        blob,            //!< host memory referenced by other chunks, stored once
+        vertex_buffer,   //!< make_vertex_buffer
+        index_buffer,    //!< make_index_buffer
+        shader,          //!< make_shader
+        program,         //!< make_program
+        texture,         //!< make_texture
+        frame_buffer,    //!< make_frame_buffer
+        material,        //!< the state of a material when it was first used, or changed
+        submit,          //!< a command_list submitted to the device
+        submit_and_swap, //!< a command_list submitted to the device, ending the frame
+        uniform_buffer   //!< make_uniform_buffer
+    };
+
+    /**
+     * \brief The first four bytes of every command trace.
+     */
+    constexpr uint32_t trace_magic = 0x544b4f4d; // "MOKT"
+
+    /**
+     * \brief The version of the command trace format written by this build.
+     */
+    constexpr uint32_t trace_version = 8;
+
+    /**
+     * \brief A command trace loaded from disk. Recreates the resources a captured application created, and
+     * replays its frames against any graphics_device. Resource handles are remapped to the ones created on replay.
+     */
+    class command_trace final
+    {
+        struct chunk final
+        {
+            trace_chunk type;
+            size_t offset;
+            size_t size;
+        };
+
+        struct frame final
+        {
+            size_t first_chunk;
+            size_t last_chunk;
+        };
+
+        std::vector<std::byte> data_;
+        std::vector<chunk> chunks_;
+        std::vector<frame> frames_;
+        std::vector<std::vector<std::byte>> blobs_;
+        std::vector<char> created_;
+
+        std::unordered_map<uint32_t, uint32_t> vertex_buffers_;
+        std::unordered_map<uint32_t, uint32_t> index_buffers_;
+        std::unordered_map<uint32_t, uint32_t> uniform_buffers_;
+        std::unordered_map<uint32_t, uint32_t> shaders_;
+        std::unordered_map<uint32_t, uint32_t> programs_;
+        std::unordered_map<uint32_t, uint32_t> textures_;
+        std::unordered_map<uint32_t, uint32_t> frame_buffers_;
+        std::unordered_map<uint16_t, uint16_t> materials_;
+
+        std::vector<std::pair<command_list, bool>> submissions_;
+
+        size_t unresolved_handles_ = 0;
+
+        bool valid_ = false;
+
+        struct decoder;
+
+    public:
+        /**
+         * \brief Load a command trace from disk.
+         * \param path The path of the command trace.
+         */
+        explicit command_trace(const std::filesystem::path& path);
+
+        command_trace(const command_trace& rhs) = delete;
+        command_trace(command_trace&& rhs) = delete;
+        command_trace& operator=(const command_trace& rhs) = delete;
+        command_trace& operator=(command_trace&& rhs) = delete;
+        ~command_trace();
+
+        /**
+         * \brief Was the command trace loaded successfully?
+         * \return True if the trace can be replayed. Otherwise, false.
+         */
+        bool is_valid() const;
+
+        /**
+         * \brief Get the number of complete frames in this trace.
+         * \return The number of frames.
+         */
+        size_t get_frame_count() const;
+
+        /**
+         * \brief Get the number of handles that referenced resources created before the capture started.
+         * These are replayed as invalid handles.
+         * \return The number of unresolved handles seen so far.
+         */
+        size_t get_unresolved_handle_count() const;
+
+        /**
+         * \brief Prepare a frame for replay. Creates the resources that the frame needs the first time it is loaded,
+         * restores the captured material state, and decodes the frame's command lists.
+         * Call this outside of any timed region, then call play_frame.
+         * \param device The graphics_device to replay the trace on.
+         * \param index The index of the frame.
+         */
+        void load_frame(graphics_device& device, size_t index);
+
+        /**
+         * \brief Submit the command lists of the frame prepared by load_frame. The last command list swaps the main framebuffer.
+         * \param device The graphics_device to replay the trace on.
+         * \param timer If set, the frame is measured by a gpu timer scope of this name, see graphics_device::get_gpu_timers.
+         */
+        void play_frame(graphics_device& device, const char* timer = nullptr);
+    };
+
+    /**
+     * \brief Writes a command trace to disk. Resources are written when they are created, host memory is
+     * written the first time it is seen, and materials are written whenever they change.
+     * Command lists are written after they have been sorted and optimized, exactly as the graphics_api sees them.
+     */
+    class command_trace_writer final
+    {
+        std::vector<std::byte> chunk_;
+        std::unordered_multimap<uint64_t, uint32_t> blobs_;
+        std::vector<std::vector<std::byte>> blob_data_;
+        std::vector<uint64_t> material_hashes_;
+        std::filesystem::path path_;
+        std::ofstream file_;
+        size_t frames_ = 0;
+        size_t bytes_written_ = 0;
+
+        struct encoder;
+
+        void begin_chunk();
+
+        void end_chunk(trace_chunk type);
+
+        uint32_t write_blob(const void* data, size_t size);
+
+    public:
+        /**
+         * \brief Create a new command trace.
+         * \param path The path of the command trace. An existing file is overwritten.
+         */
+        explicit command_trace_writer(const std::filesystem::path& path);
+
+        command_trace_writer(const command_trace_writer& rhs) = delete;
+        command_trace_writer(command_trace_writer&& rhs) = delete;
+        command_trace_writer& operator=(const command_trace_writer& rhs) = delete;
+        command_trace_writer& operator=(command_trace_writer&& rhs) = delete;
+
+        /**
+         * \brief Flush and close the command trace.
+         */
+        ~command_trace_writer();
+
+        /**
+         * \brief Was the command trace opened successfully?
+         * \return True if commands can be written to the trace. Otherwise, false.
+         */
+        bool is_open() const;
+
+        /**
+         * \brief Get the number of complete frames written to the trace.
+         * \return The number of frames.
+         */
+        size_t get_frame_count() const;
+
+        /**
+         * \brief Get the size of the trace.
+         * \return The number of bytes written to the trace.
+         */
+        size_t get_bytes_written() const;
+
+        /**
+         * \brief Write the creation of a vertex buffer.
+         * \param handle The vertex buffer that was created.
+         * \param vertices The host memory that was used as vertex data.
+         * \param size The size of the host vertex buffer.
+         * \param layout The layout of the vertex data.
+         * \param use The buffer usage hint.
+         */
+        void write_vertex_buffer(
+            vertex_buffer_handle handle, const void* vertices, size_t size, const vertex_layout& layout, buffer_usage use);
+
+        /**
+         * \brief Write the creation of an index buffer.
+         * \param handle The index buffer that was created.
+         * \param indices The host memory that was used as index data.
+         * \param size The size of the host index buffer.
+         * \param type The layout of the index data.
+         * \param use The buffer usage hint.
+         */
+        void write_index_buffer(index_buffer_handle handle, const void* indices, size_t size, index_type type, buffer_usage use);
+
+        /**
+         * \brief Write the creation of a uniform buffer.
+         * \param handle The uniform buffer that was created.
+         * \param block The uniform block that the buffer holds.
+         * \param size The size of the uniform buffer.
+         */
+        void write_uniform_buffer(uniform_buffer_handle handle, uniform_block block, size_t size);
+
+        /**
+         * \brief Write the creation of a shader.
+         * \param handle The shader that was created.
+         * \param type The type of the shader.
+         * \param source The source code of the shader.
+         */
+        void write_shader(shader_handle handle, shader_type type, const std::string& source);
+
+        /**
+         * \brief Write the creation of a program.
+         * \param handle The program that was created.
+         * \param vertex_handle The vertex shader linked to the program.
+         * \param fragment_handle The fragment shader linked to the program.
+         */
+        void write_program(program_handle handle, shader_handle vertex_handle, shader_handle fragment_handle);
+
+        /**
+         * \brief Write the creation of a texture.
+         * \param handle The texture that was created.
+         * \param data The host memory that was used as texture data.
+         * \param metadata Metadata describing the texture data.
+         */
+        void write_texture(texture_handle handle, const void** data, const texture_metadata& metadata);
+
+        /**
+         * \brief Write the creation of a frame buffer.
+         * \param handle The frame buffer that was created.
+         * \param render_textures An array of render_texture_data.
+         * \param render_texture_count Size of the render_textures array.
+         */
+        void write_frame_buffer(frame_buffer_handle handle, const render_texture_data* render_textures, size_t render_texture_count);
+
+        /**
+         * \brief Write every material that was added or changed since the last call.
+         * \param materials The material cache of the device being captured.
+         * \param pipeline_states The pipeline state cache of the device being captured.
+         */
+        void write_materials(const material_cache& materials, const pipeline_state_cache& pipeline_states);
+
+        /**
+         * \brief Write a command list that is about to be executed.
+         * \param commands The command list.
+         * \param swap True if the command list ends the frame.
+         */
+        void write_commands(command_list& commands, bool swap);
+    };
+} // namespace moka
@@ -32,12 +32,24 @@ SOFTWARE.
 #include <application/window.hpp>
 #include <graphics/api/graphics_api.hpp>
 #include <graphics/buffer/frame_buffer_handle.hpp>
+#include <graphics/buffer/stream_buffer.hpp>
+#include <graphics/command/command_bundle.hpp>
 #include <graphics/command/command_list.hpp>
+#include <graphics/command/command_optimizer.hpp>
+#include <graphics/device/command_trace.hpp>
+#include <graphics/device/render_thread.hpp>
 #include <graphics/material/material_builder.hpp>
+#include <array>
+#include <filesystem>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
 
 namespace moka
 {
+    class null_graphics_api;
+
     /**
      * \brief The type of graphics api to initialize.
      */
@@ -51,7 +63,7 @@ namespace moka
         opengl_es,
         opengl,
         vulkan,
-        null
+        null //!< validates and counts commands without a device, see null_graphics_api
     };
 
     /* string containing unique identifier of the texture
@@ -103,8 +115,20 @@ namespace moka
      */
     using program_id = std::size_t;
 
+    /**
+     * \brief The number of programs a program_cache found in memory or on disk, and the number it had to compile.
+     */
+    struct program_cache_stats final
+    {
+        size_t memory_hits = 0; /**< The number of programs that were already loaded. */
+        size_t binary_hits = 0; /**< The number of programs loaded from a binary in the cache directory. */
+        size_t misses = 0;      /**< The number of programs compiled and linked from source. */
+    };
+
     /**
      * \brief A cache of loaded programs. Used to avoid loading the same program multiple times.
+     * Linked programs are also stored as driver binaries in a cache directory, so that later runs can skip compiling
+     * them. A binary is only loaded while the driver and the source that produced it are unchanged.
      */
     class program_cache
     {
@@ -113,6 +137,35 @@ namespace moka
         std::vector<program_handle> shaders_;
         std::unordered_map<program_id, int> shader_lookup_;
 
+        std::filesystem::path directory_;
+
+        std::optional<std::string> driver_id_;
+
+        program_cache_stats stats_;
+
+        /**
+         * \brief A program whose binary hasn't been stored yet.
+         */
+        struct pending_binary final
+        {
+            program_handle program;
+            std::filesystem::path path;
+            std::string vertex_source;
+            std::string fragment_source;
+            program_binary binary; /**< Retrieved on the render thread once the program has linked. */
+        };
+
+        std::mutex binaries_mutex_;
+
+        std::vector<pending_binary> pending_binaries_;
+
+        const std::string& get_driver_id();
+
+        program_handle load_binary(
+            const std::filesystem::path& path, const std::string& vertex_source, const std::string& fragment_source);
+
+        void store_binary(const pending_binary& pending);
+
     public:
         /**
          * \brief Create a new program cache object.
@@ -141,6 +194,45 @@ namespace moka
          * \return The program identified by the id.
          */
         program_handle get_program(const program_id& id) const;
+
+        /**
+         * \brief Get a program built from vertex & fragment shader source code. The program is looked up in memory,
+         * then loaded from the cache directory, and only compiled if neither has it.
+         * \param vertex_source The source code of the vertex shader, including its preprocessor definitions.
+         * \param fragment_source The source code of the fragment shader, including its preprocessor definitions.
+         * \return The program built from the source code.
+         */
+        program_handle make_program(const std::string& vertex_source, const std::string& fragment_source);
+
+        /**
+         * \brief Retrieve the binaries of the compiled programs that have finished linking. Programs that are still being
+         * linked stay pending, so this never waits for the driver. Call this on the thread that owns the graphics context.
+         * \param api The graphics api that owns the programs.
+         */
+        void collect_binaries(graphics_api& api);
+
+        /**
+         * \brief Write the binaries retrieved by collect_binaries to the cache directory.
+         */
+        void store_binaries();
+
+        /**
+         * \brief Set the directory that program binaries are stored in. An empty path disables the binary cache.
+         * \param directory The cache directory. It is created when the first binary is stored.
+         */
+        void set_directory(const std::filesystem::path& directory);
+
+        /**
+         * \brief Get the directory that program binaries are stored in.
+         * \return The cache directory, or an empty path if the binary cache is disabled.
+         */
+        const std::filesystem::path& get_directory() const;
+
+        /**
+         * \brief Get the number of programs found in memory or on disk, and the number that had to be compiled.
+         * \return The stats of every program requested so far.
+         */
+        const program_cache_stats& get_stats() const;
     };
 
     /**
@@ -180,6 +272,52 @@ namespace moka
          * \return The material identified by the id.
          */
         const material* get_material(material_handle handle) const;
+
+        /**
+         * \brief Get the number of materials in the cache.
+         * \return The number of materials in the cache.
+         */
+        size_t size() const;
+    };
+
+    /**
+     * \brief A cache of deduplicated pipeline states. Materials that share fixed-function render state share one pipeline
+     * state, so the backend only needs to compare ids to know whether any of that state must change. The default
+     * pipeline state always has id 0.
+     */
+    class pipeline_state_cache
+    {
+        graphics_device& device_;
+
+        std::vector<pipeline_state> states_;
+        std::unordered_map<uint64_t, uint16_t> state_lookup_;
+
+    public:
+        /**
+         * \brief Create a new pipeline state cache object.
+         * \param device The graphics device object to use.
+         */
+        explicit pipeline_state_cache(graphics_device& device);
+
+        /**
+         * \brief Add a pipeline state to the cache. If an equal pipeline state is already cached, it's reused.
+         * \param state The pipeline state you want to add to the cache.
+         * \return The pipeline state id.
+         */
+        pipeline_state_handle add_pipeline_state(const pipeline_state& state);
+
+        /**
+         * \brief Get the pipeline state identified by its id.
+         * \param handle The pipeline state id.
+         * \return The pipeline state identified by the id.
+         */
+        const pipeline_state& get_pipeline_state(pipeline_state_handle handle) const;
+
+        /**
+         * \brief Get the number of pipeline states in the cache.
+         * \return The number of pipeline states in the cache.
+         */
+        size_t size() const;
     };
 
     /**
@@ -187,6 +325,27 @@ namespace moka
      */
     class graphics_device
     {
+    public:
+        /**
+         * \brief The most frames that can be recorded before the oldest one has been executed.
+         */
+        static constexpr size_t max_frames_in_flight = 4;
+
+    private:
+        /**
+         * \brief The storage of the commands recorded during one frame.
+         */
+        struct frame_storage final
+        {
+            command_allocator allocator;
+            std::vector<std::unique_ptr<command_allocator>> recording_allocators;
+            size_t recording_allocators_used = 0;
+
+            void reset();
+        };
+
+        window& window_;
+
         std::unique_ptr<graphics_api> graphics_api_;
 
         texture_cache textures_;
@@ -195,6 +354,62 @@ namespace moka
 
         material_cache materials_;
 
+        pipeline_state_cache pipeline_states_;
+
+        // the frame storage never moves, so command lists that are recording into it stay valid when the number of frames in flight changes
+        std::array<frame_storage, max_frames_in_flight> frames_;
+
+        size_t frames_in_flight_ = 1;
+
+        size_t first_frame_ = 0;
+
+        size_t frame_ = 0;
+
+        stream_allocator stream_;
+
+        command_optimizer optimizer_;
+
+        bool optimize_commands_ = false;
+
+        command_optimizer_stats optimizer_stats_;
+
+        command_optimizer_stats frame_optimizer_stats_;
+
+        state_change_stats frame_state_stats_;
+
+        draw_stats frame_draw_stats_;
+
+        texture_upload_stats frame_upload_stats_;
+
+        null_graphics_api* null_api_ = nullptr; /**< The api when the null backend is in use, for its call stats. */
+
+        null_call_stats frame_null_stats_;
+
+        std::vector<readback_result> readbacks_;
+
+        std::vector<gpu_timer_result> gpu_timers_;
+
+        mutable std::mutex stats_mutex_;
+
+        std::unique_ptr<command_trace_writer> capture_;
+
+        std::unique_ptr<render_thread> render_thread_;
+
+        frame_storage& current_frame();
+
+        void optimize(command_list& command_list);
+
+        void execute(command_list& command_list, bool swap);
+
+        void execute(command_bundle& bundle, const std::vector<bundle_patch>& patches) const;
+
+        void execute(render_item& item);
+
+        void end_frame();
+
+        template <typename Function>
+        auto invoke(Function&& function) const;
+
     public:
         /**
          * \brief Get the texture cache.
@@ -232,6 +447,155 @@ namespace moka
          */
         const material_cache& get_material_cache() const;
 
+        /**
+         * \brief Get the pipeline state cache.
+         * \return The pipeline state cache.
+         */
+        pipeline_state_cache& get_pipeline_state_cache();
+
+        /**
+         * \brief Get the pipeline state cache.
+         * \return The pipeline state cache.
+         */
+        const pipeline_state_cache& get_pipeline_state_cache() const;
+
+        /**
+         * \brief Enable or disable the removal of redundant commands from every command_list submitted to the device.
+         * \param enabled True to remove redundant commands before execution. Disabled by default.
+         */
+        void set_optimize_commands(bool enabled);
+
+        /**
+         * \brief Are redundant commands removed from submitted command lists?
+         * \return True if redundant commands are removed. Otherwise, false.
+         */
+        bool get_optimize_commands() const;
+
+        /**
+         * \brief Get the number of redundant commands and parameter writes removed during the last complete frame.
+         * \return The optimizer stats of the last frame.
+         */
+        command_optimizer_stats get_optimizer_stats() const;
+
+        /**
+         * \brief Get the number of render state changes that reached the driver, and the number that were skipped
+         * because the state was already set, during the last complete frame.
+         * \return The state change stats of the last frame.
+         */
+        state_change_stats get_state_change_stats() const;
+
+        /**
+         * \brief Get the number of draws executed during the last complete frame, and the number of draw calls the
+         * backend needed after batching compatible draws together.
+         * \return The draw stats of the last frame.
+         */
+        draw_stats get_draw_stats() const;
+
+        /**
+         * \brief Get the latest GPU time measured for every timer scope opened so far. Scopes that only ran once, such as
+         * precomputation passes, keep their last measurement.
+         * \return The latest measurement of every scope, in the order the scopes were first seen.
+         */
+        std::vector<gpu_timer_result> get_gpu_timers() const;
+
+        /**
+         * \brief Get the pixel data uploaded to textures during the last complete frame, and the number of streamed
+         * textures still waiting for theirs.
+         * \return The texture upload stats of the last frame.
+         */
+        texture_upload_stats get_texture_upload_stats() const;
+
+        /**
+         * \brief Set the number of bytes of streamed texture data that may be uploaded each frame, so that streaming
+         * textures never causes a frame spike. At least one image is uploaded every frame.
+         * \param bytes The upload budget of a frame. 16 MiB by default.
+         */
+        void set_texture_upload_budget(size_t bytes);
+
+        /**
+         * \brief Get the commands received by the null backend during the last complete frame.
+         * \return The call stats of the last frame, or empty stats if this device isn't using the null backend.
+         */
+        null_call_stats get_null_call_stats() const;
+
+        /**
+         * \brief Start or stop recording the commands executed by the null backend. Does nothing with any other backend.
+         * \param enabled True to record commands. Otherwise, false.
+         */
+        void set_record_null_calls(bool enabled);
+
+        /**
+         * \brief Take the commands recorded by the null backend since the last call.
+         * \return The recorded commands, in the order they were executed.
+         */
+        std::vector<null_call> take_recorded_null_calls();
+
+        /**
+         * \brief Take the pixels of every read_pixels_command that completed since the last call, without waiting for
+         * the GPU. Readbacks are checked when a frame is swapped, so pixels usually arrive a few frames after their command.
+         * \return The completed readbacks, in the order their commands were executed.
+         */
+        std::vector<readback_result> poll_readbacks();
+
+        /**
+         * \brief Wait for every submitted read_pixels_command to complete, and take their pixels along with any that
+         * weren't polled yet. This stalls until the device is idle, so prefer poll_readbacks while rendering.
+         * \return Every outstanding readback, in the order their commands were executed.
+         */
+        std::vector<readback_result> drain_readbacks();
+
+        /**
+         * \brief Move the graphics context to a dedicated render thread. Submitted command lists are queued and executed
+         * on the render thread while the next frame is recorded, and resources are created on the render thread.
+         * Host memory referenced by fill commands is copied when the commands are submitted. Materials and bundles
+         * must not be destroyed, and materials must not be changed outside of commands, until wait_idle returns.
+         * Command lists that are already recording for the current frame stay valid, and are executed on the render thread.
+         * \param frames_in_flight The number of frames that can be recorded before the oldest one has been executed. This is
+         * clamped to max_frames_in_flight.
+         */
+        void start_render_thread(size_t frames_in_flight = 2);
+
+        /**
+         * \brief Execute everything that has been submitted, and move the graphics context back to the calling thread.
+         */
+        void stop_render_thread();
+
+        /**
+         * \brief Is a render thread executing the commands submitted to this device?
+         * \return True if a render thread is running. Otherwise, false.
+         */
+        bool has_render_thread() const;
+
+        /**
+         * \brief Block until everything submitted to this device has been executed. Returns immediately without a render thread.
+         */
+        void wait_idle() const;
+
+        /**
+         * \brief Start capturing every resource created and every command executed by this device to a command trace.
+         * Start the capture before any resources are created, so that the trace can be replayed on its own.
+         * \param path The path of the command trace. An existing file is overwritten.
+         * \return True if the capture started. Otherwise, false.
+         */
+        bool start_capture(const std::filesystem::path& path);
+
+        /**
+         * \brief Stop capturing and close the command trace.
+         */
+        void stop_capture();
+
+        /**
+         * \brief Is this device capturing a command trace?
+         * \return True if a capture is in progress. Otherwise, false.
+         */
+        bool is_capturing() const;
+
+        /**
+         * \brief Get the allocator that stores the commands of the current frame.
+         * \return The frame allocator.
+         */
+        const command_allocator& get_frame_allocator() const;
+
         /**
          * \brief Create a graphics device object
          * \param window The window to attach to this graphics device
@@ -239,6 +603,16 @@ namespace moka
          */
         explicit graphics_device(window& window, graphics_backend graphics_backend = graphics_backend::opengl);
 
+        graphics_device(const graphics_device& rhs) = delete;
+        graphics_device(graphics_device&& rhs) = delete;
+        graphics_device& operator=(const graphics_device& rhs) = delete;
+        graphics_device& operator=(graphics_device&& rhs) = delete;
+
+        /**
+         * \brief Stop the render thread, if there is one, and destroy the graphics api.
+         */
+        ~graphics_device();
+
         /**
          * \brief Create a new vertex buffer.
          * \param vertices The host memory buffer that will be used as vertex data.
@@ -261,6 +635,24 @@ namespace moka
         index_buffer_handle make_index_buffer(
             const void* indices, size_t size, index_type type, buffer_usage use) const;
 
+        /**
+         * \brief Create a new uniform buffer.
+         * \param block The uniform block that the buffer holds. Filling the buffer binds it to the block's binding point.
+         * \param size The size of the uniform buffer.
+         * \return A new uniform_buffer_handle representing a uniform buffer on the device.
+         */
+        uniform_buffer_handle make_uniform_buffer(uniform_block block, size_t size) const;
+
+        /**
+         * \brief Allocate a range of the stream buffer for dynamic vertex and index data. Fill the range with a
+         * fill_stream_buffer_command and draw from it with a streamed draw_command. The range is only valid for the
+         * commands of the current frame, and is released by submit_and_swap.
+         * \param size The size of the range in bytes.
+         * \param alignment The required alignment of the range. Align vertex ranges to the vertex stride.
+         * \return The new range, or an invalid range if the current frame has used up its part of the stream buffer.
+         */
+        stream_range allocate_stream(size_t size, size_t alignment);
+
         /**
          * \brief Create a shader from source code.
          * \param type The type of shader you want to create.
@@ -277,6 +669,48 @@ namespace moka
          */
         program_handle make_program(shader_handle vertex_handle, shader_handle fragment_handle) const;
 
+        /**
+         * \brief Create a shader program from a binary previously retrieved with get_program_binary.
+         * \param binary The binary of the program.
+         * \return A new program_handle representing a program on the device, or an invalid handle if the driver rejected
+         * the binary.
+         */
+        program_handle make_program(const program_binary& binary) const;
+
+        /**
+         * \brief Retrieve the binary of a linked program, so that it can be loaded again without compiling it.
+         * \param program The program whose binary you want.
+         * \param binary The binary of the program.
+         * \return True if the binary was retrieved. Otherwise, false.
+         */
+        bool get_program_binary(program_handle program, program_binary& binary) const;
+
+        /**
+         * \brief Get a string identifying the driver and the device it runs on. Program binaries are only valid for the
+         * driver that produced them.
+         * \return The driver identifier, or an empty string if the device can't retrieve program binaries.
+         */
+        std::string get_driver_id() const;
+
+        /**
+         * \brief Find the location of an active uniform in a program. Only the first lookup in a program queries the
+         * driver, and it waits for the program to finish linking.
+         * \param program The program to search.
+         * \param name The name of the uniform.
+         * \return The location of the uniform, or -1 if the program has no active uniform with this name.
+         */
+        int32_t find_uniform(program_handle program, const std::string& name) const;
+
+        /**
+         * \brief Find the index that set_material_parameters commands use to update a material parameter. The lookup only
+         * reads the material, so it doesn't wait for the render thread, but look indices up once rather than every frame.
+         * \param material The material.
+         * \param name The name of the material parameter.
+         * \return The index of the material parameter, or the largest uint16_t if the material doesn't exist or has no
+         * parameter with this name.
+         */
+        uint16_t find_parameter_index(material_handle material, const std::string& name) const;
+
         /**
          * \brief Create a new texture.
          * \param data The host memory buffer that will be used as texture data.
@@ -342,19 +776,58 @@ namespace moka
          */
         void destroy(index_buffer_handle handle);
 
+        /**
+         * \brief Create a command_list that stores its commands in the frame allocator.
+         * The frame allocator is reset by submit_and_swap, so the command_list must be submitted within the current frame.
+         * \return A new command_list.
+         */
+        command_list make_command_list();
+
+        /**
+         * \brief Create command lists that can be recorded on different threads at the same time.
+         * Every list stores its commands in its own frame allocator, which is reset by submit_and_swap.
+         * Combine the lists with command_list::merge before submitting them.
+         * \param count The number of command lists to create.
+         * \return The new command lists.
+         */
+        std::vector<command_list> make_command_lists(size_t count);
+
         /**
          * \brief Submit a command_list to execute on the device.
          * \param command_list The command_list you wish to run.
          * \param sort Sort the command list before submitting it to the graphics device.
          */
-        void submit(command_list&& command_list, bool sort = true) const;
+        void submit(command_list&& command_list, bool sort = true);
+
+        /**
+         * \brief Submit a command_bundle to execute on the device. The bundle is already sorted and can be submitted again.
+         * \param bundle The command_bundle you wish to run.
+         */
+        void submit(command_bundle& bundle) const;
 
         /**
          * \brief Submit a command_list to execute on the device. The main framebuffer will be
-         * swapped after executing, advancing a frame.
+         * swapped after executing, advancing a frame. The frame allocator is reset.
          *  \param command_list The command_list you wish to run.
          * \param sort Sort the command list before submitting it to the graphics device.
          */
-        void submit_and_swap(command_list&& command_list, bool sort = true) const;
+        void submit_and_swap(command_list&& command_list, bool sort = true);
     };
+
+    template <typename Function>
+    auto graphics_device::invoke(Function&& function) const
+    {
+        if (!render_thread_)
+        {
+            return function();
+        }
+
+        // the render thread owns the context, so run there and wait for the result
+        std::packaged_task<decltype(function())()> task(std::forward<Function>(function));
+        auto result = task.get_future();
+
+        render_thread_->run_and_wait([&task]() { task(); });
+
+        return result.get();
+    }
 } // namespace moka
@@ -41,6 +41,10 @@ namespace moka
     class frame_buffer_texture_command;
     class generate_mipmaps_command;
     class set_material_parameters_command;
+    class fill_uniform_buffer_command;
+    class fill_stream_buffer_command;
+    class gpu_timer_command;
+    class read_pixels_command;
 
     /**
      * \brief Used to define visitor-pattern functionality for graphics_commands
@@ -59,5 +63,9 @@ namespace moka
         virtual void visit(frame_buffer_texture_command& cmd) = 0;
         virtual void visit(generate_mipmaps_command& cmd) = 0;
         virtual void visit(set_material_parameters_command& cmd) = 0;
+        virtual void visit(fill_uniform_buffer_command& cmd) = 0;
+        virtual void visit(fill_stream_buffer_command& cmd) = 0;
+        virtual void visit(gpu_timer_command& cmd) = 0;
+        virtual void visit(read_pixels_command& cmd) = 0;
     };
 } // namespace moka
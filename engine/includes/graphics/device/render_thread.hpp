@@ -0,0 +1,145 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <graphics/command/command_bundle.hpp>
+#include <graphics/command/command_list.hpp>
+#include <graphics/device/spsc_queue.hpp>
+#include <mutex>
+#include <thread>
+
+namespace moka
+{
+    class window;
+
+    /**
+     * \brief A unit of work sent to the render thread.
+     */
+    struct render_item final
+    {
+        /**
+         * \brief The kind of work a render_item carries.
+         */
+        enum class kind : uint8_t
+        {
+            commands, //!< execute a command_list
+            bundle,   //!< execute a command_bundle
+            task,     //!< run a function that needs the graphics context, such as creating a resource
+            stop      //!< stop the render thread
+        };
+
+        kind type = kind::stop;                /**< The kind of work. */
+        command_list commands;                 /**< The commands to execute, if type is kind::commands. */
+        bool swap = false;                     /**< Swap the main framebuffer after executing the commands. */
+        command_bundle* bundle = nullptr;      /**< The bundle to execute, if type is kind::bundle. */
+        std::vector<bundle_patch> patches;     /**< The patches to apply to the bundle before executing it. */
+        std::function<void()> task;            /**< The function to run, if type is kind::task. */
+    };
+
+    /**
+     * \brief Owns the graphics context on a dedicated thread, and executes the work submitted to it in order.
+     * Work is passed through a bounded lock-free queue, so that recording the next frame overlaps the execution of the current one.
+     */
+    class render_thread final
+    {
+        const window& window_;
+
+        std::function<void(render_item&)> execute_;
+
+        spsc_queue<render_item> queue_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable work_done_;
+
+        std::atomic<size_t> completed_frames_{0};
+        std::atomic<size_t> executed_items_{0};
+
+        size_t pushed_items_ = 0;
+
+        std::thread thread_;
+
+        void run();
+
+        void notify(std::condition_variable& condition);
+
+    public:
+        /**
+         * \brief Move the window's graphics context to a new render thread.
+         * \param window The window that owns the graphics context.
+         * \param queue_capacity The maximum number of items waiting to be executed.
+         * \param execute Executes a render_item on the render thread.
+         */
+        render_thread(const window& window, size_t queue_capacity, std::function<void(render_item&)> execute);
+
+        render_thread(const render_thread& rhs) = delete;
+        render_thread(render_thread&& rhs) = delete;
+        render_thread& operator=(const render_thread& rhs) = delete;
+        render_thread& operator=(render_thread&& rhs) = delete;
+
+        /**
+         * \brief Execute the remaining work, stop the render thread and move the graphics context back to the calling thread.
+         */
+        ~render_thread();
+
+        /**
+         * \brief Send work to the render thread. Blocks while the queue is full. Only call this from one thread.
+         * \param item The work to execute.
+         */
+        void push(render_item&& item);
+
+        /**
+         * \brief Run a function on the render thread and wait for it to return.
+         * \param task The function to run.
+         */
+        void run_and_wait(std::function<void()> task);
+
+        /**
+         * \brief Block until the render thread has swapped the main framebuffer a number of times.
+         * \param count The number of frames to wait for.
+         */
+        void wait_for_frames(size_t count);
+
+        /**
+         * \brief Block until the render thread has executed all of the work sent to it.
+         */
+        void wait_idle();
+
+        /**
+         * \brief Get the number of frames the render thread has finished.
+         * \return The number of times the main framebuffer has been swapped.
+         */
+        size_t get_completed_frames() const;
+    };
+} // namespace moka
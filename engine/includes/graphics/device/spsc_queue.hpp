@@ -0,0 +1,164 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief A bounded, lock-free queue for exactly one producer thread and one consumer thread.
+     * \tparam T The type of the values in the queue. Must be default constructible and move assignable.
+     */
+    template <typename T>
+    class spsc_queue final
+    {
+        static constexpr size_t cache_line_size = 64;
+
+        std::vector<T> slots_;
+        size_t mask_;
+
+        // the producer and consumer each own one index, keep them on separate cache lines
+        alignas(cache_line_size) std::atomic<size_t> head_{0};
+        alignas(cache_line_size) std::atomic<size_t> tail_{0};
+
+    public:
+        /**
+         * \brief Create a new spsc_queue object.
+         * \param capacity The maximum number of values in the queue. Rounded up to a power of two.
+         */
+        explicit spsc_queue(size_t capacity);
+
+        spsc_queue(const spsc_queue& rhs) = delete;
+        spsc_queue(spsc_queue&& rhs) = delete;
+        spsc_queue& operator=(const spsc_queue& rhs) = delete;
+        spsc_queue& operator=(spsc_queue&& rhs) = delete;
+        ~spsc_queue() = default;
+
+        /**
+         * \brief Add a value to the back of the queue. Only call this from the producer thread.
+         * \param value The value to add. It is only moved from if the push succeeds.
+         * \return True if the value was added, false if the queue is full.
+         */
+        bool try_push(T&& value);
+
+        /**
+         * \brief Remove the value at the front of the queue. Only call this from the consumer thread.
+         * \param value Receives the value at the front of the queue.
+         * \return True if a value was removed, false if the queue is empty.
+         */
+        bool try_pop(T& value);
+
+        /**
+         * \brief Is the queue empty?
+         * \return True if the queue is empty. Otherwise, false.
+         */
+        bool empty() const;
+
+        /**
+         * \brief Is the queue full?
+         * \return True if the queue is full. Otherwise, false.
+         */
+        bool full() const;
+
+        /**
+         * \brief Get the maximum number of values in the queue.
+         * \return The capacity of the queue.
+         */
+        size_t capacity() const;
+    };
+
+    template <typename T>
+    spsc_queue<T>::spsc_queue(const size_t capacity)
+    {
+        size_t size = 1;
+
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    template <typename T>
+    bool spsc_queue<T>::try_push(T&& value)
+    {
+        const auto tail = tail_.load(std::memory_order_relaxed);
+
+        if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+        {
+            return false;
+        }
+
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T>
+    bool spsc_queue<T>::try_pop(T& value)
+    {
+        const auto head = head_.load(std::memory_order_relaxed);
+
+        if (head == tail_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    template <typename T>
+    bool spsc_queue<T>::empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    template <typename T>
+    bool spsc_queue<T>::full() const
+    {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire) == slots_.size();
+    }
+
+    template <typename T>
+    size_t spsc_queue<T>::capacity() const
+    {
+        return slots_.size();
+    }
+} // namespace moka
@@ -0,0 +1,100 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief A fixed set of threads that is kept alive between frames, so that recording work can be split across threads
+     * without paying for thread creation every frame.
+     */
+    class worker_pool final
+    {
+        std::vector<std::thread> threads_;
+
+        std::mutex mutex_;
+        std::condition_variable work_available_;
+        std::condition_variable work_done_;
+
+        const std::function<void(size_t)>* job_ = nullptr;
+        size_t job_count_ = 0;
+        size_t generation_ = 0;
+        size_t busy_workers_ = 0;
+        bool stop_ = false;
+
+        std::atomic<size_t> next_job_{0};
+
+        std::exception_ptr error_;
+
+        void work();
+
+        void run_jobs(const std::function<void(size_t)>& job, size_t count);
+
+    public:
+        /**
+         * \brief Create a new worker_pool and start its threads.
+         * \param thread_count The number of worker threads. The thread that calls run works too, so 0 runs every job on it.
+         */
+        explicit worker_pool(size_t thread_count);
+
+        worker_pool(const worker_pool& rhs) = delete;
+        worker_pool(worker_pool&& rhs) = delete;
+        worker_pool& operator=(const worker_pool& rhs) = delete;
+        worker_pool& operator=(worker_pool&& rhs) = delete;
+
+        /**
+         * \brief Stop and join the worker threads.
+         */
+        ~worker_pool();
+
+        /**
+         * \brief Run a job once for each index in [0, count) and wait for every call to return.
+         * Jobs are shared between the worker threads and the calling thread. Only call this from one thread at a time.
+         * \param count The number of jobs.
+         * \param job The job to run, which is passed the index of the call.
+         * The first exception thrown by a job is rethrown once every job has finished.
+         */
+        void run(size_t count, const std::function<void(size_t)>& job);
+
+        /**
+         * \brief Get the number of worker threads.
+         * \return The number of worker threads, not counting the thread that calls run.
+         */
+        size_t size() const;
+    };
+} // namespace moka
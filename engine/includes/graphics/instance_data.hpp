@@ -0,0 +1,56 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <glm/glm.hpp>
+#include <graphics/buffer/vertex_layout.hpp>
+
+namespace moka
+{
+    /**
+     * \brief The per-instance attributes read by instanced materials (see material_builder::set_instanced).
+     * Fill a vertex buffer with an array of these, create it with instance_data::layout(), and pass it to
+     * draw_command::set_instances.
+     */
+    struct instance_data final
+    {
+        static constexpr size_t model_attribute = 4;          /**< The first of the four attribute locations that hold the columns of the model matrix. */
+        static constexpr size_t material_index_attribute = 8; /**< The attribute location that holds the material index. */
+
+        glm::mat4 model;          /**< The model matrix of the instance. */
+        float material_index = 0; /**< An index that the shaders can use to vary the material per instance. Exact for indices below 2^24. */
+
+        /**
+         * \brief Get the vertex layout of a buffer of instance_data. Every attribute advances once per instance.
+         * \return The vertex layout of a buffer of instance_data.
+         */
+        static vertex_layout layout();
+    };
+} // namespace moka
@@ -32,6 +32,7 @@ SOFTWARE.
 #include <graphics/api/graphics_api.hpp>
 #include <graphics/material/material_parameter.hpp>
 #include <graphics/material/parameter_collection.hpp>
+#include <graphics/material/pipeline_state.hpp>
 #include <vector>
 
 namespace moka
@@ -45,42 +46,6 @@ namespace moka
         uint16_t id;
     };
 
-    enum class polygon_draw_mode
-    {
-        fill,
-        line,
-        points
-    };
-
-    /**
-     * \brief The polygon mode to use with a material.
-     */
-    struct polygon_mode final
-    {
-        polygon_draw_mode mode = polygon_draw_mode::fill;
-        face faces = face::front_and_back;
-    };
-
-    /**
-     * \brief Culling settings to use with a material.
-     */
-    struct culling final
-    {
-        bool enabled = true;
-        face faces = face::back;
-    };
-
-    /**
-     * \brief Blend settings to use with a material.
-     */
-    struct blend final
-    {
-        bool enabled = false;
-        blend_equation equation = blend_equation::func_add;
-        blend_function_factor source = blend_function_factor::src_alpha;
-        blend_function_factor destination = blend_function_factor::one_minus_src_alpha;
-    };
-
     class material_builder;
 
     /**
@@ -89,14 +54,11 @@ namespace moka
     class material final
     {
         alpha_mode alpha_mode_ = alpha_mode::opaque;
-        std::vector<program_handle> programs_ = {{std::numeric_limits<uint16_t>::max()}};
+        std::vector<program_handle> programs_ = {program_handle{}};
         size_t active_program_ = 0;
         parameter_collection parameters_;
-        blend blend_;
-        culling culling_;
-        polygon_mode polygon_mode_;
-        bool depth_test_ = true;
-        bool scissor_test_ = false;
+        pipeline_state_handle pipeline_state_ = {0};
+        std::vector<std::vector<int32_t>> uniform_locations_;
 
     public:
         using iterator = parameter_collection::iterator;
@@ -121,21 +83,13 @@ namespace moka
          * \param program_handles The programs that can be used to render this
          * material. \param parameters The parameters to use with the material.
          * \param alpha_mode The alpha mode to use with the material.
-         * \param blend The blend mode to use with the material.
-         * \param culling The culling mode to use with the material.
-         * \param polygon_mode The polygon mode to use with the material.
-         * \param depth_test Does this material require the depth test?
-         * \param scissor_test Does this material require the scissor test?
+         * \param pipeline_state The fixed-function render state to use with the material.
          */
         material(
             std::vector<program_handle>&& program_handles,
             parameter_collection&& parameters,
             alpha_mode alpha_mode,
-            const blend& blend,
-            const culling& culling,
-            const polygon_mode& polygon_mode,
-            bool depth_test,
-            bool scissor_test);
+            pipeline_state_handle pipeline_state);
 
         /**
          * \brief Create a new material object.
@@ -156,22 +110,43 @@ namespace moka
         program_handle get_program() const;
 
         /**
-         * \brief Get the number of parameters in this material.
-         * \return The number of parameters in this material.
+         * \brief Get one of the programs this material can be rendered with.
+         * \param index The index of the program.
+         * \return The program at the index.
          */
-        size_t size() const;
+        program_handle get_program(size_t index) const;
+
+        /**
+         * \brief Get the number of programs this material can be rendered with.
+         * \return The number of programs.
+         */
+        size_t get_program_count() const;
+
+        /**
+         * \brief Bind this material's parameters to the uniforms of one of its programs.
+         * \param index The index of the program.
+         * \param locations The uniform location of each parameter, in parameter order. -1 if the program doesn't use the parameter.
+         */
+        void set_uniform_locations(size_t index, std::vector<int32_t>&& locations);
 
         /**
-         * \brief Does this material require the scissor test?
-         * \return True if scissor test is required, otherwise false.
+         * \brief Get the uniform locations of this material's parameters in the active program.
+         * Parameters added after the material was built have no location yet, so the list can be shorter than the parameters.
+         * \return The uniform location of each parameter, in parameter order.
          */
-        bool get_scissor_test() const;
+        std::vector<int32_t>& get_uniform_locations();
 
         /**
-         * \brief Does this material require the depth test?
-         * \return True if depth test is required, otherwise false.
+         * \brief Get the number of parameters in this material.
+         * \return The number of parameters in this material.
          */
-        bool get_depth_test() const;
+        size_t size() const;
+
+        /**
+         * \brief Get the fixed-function render state of this material.
+         * \return The pipeline state of this material.
+         */
+        pipeline_state_handle get_pipeline_state() const;
 
         const_iterator begin() const;
 
@@ -203,22 +178,18 @@ namespace moka
         material_parameter& operator[](const std::string& name);
 
         /**
-         * \brief Get the blend mode of this material.
-         * \return The blend mode of this material.
-         */
-        const blend& get_blend() const;
-
-        /**
-         * \brief Get the culling mode of this material.
-         * \return The culling mode of this material.
+         * \brief Find a material parameter by name without creating it.
+         * \param name The name of the material parameter.
+         * \return The material parameter, or nullptr if the material has no parameter with this name.
          */
-        const culling& get_culling() const;
+        const material_parameter* find(const std::string& name) const;
 
         /**
-         * \brief Get the polygon mode of this material.
-         * \return The polygon mode of this material.
+         * \brief Find the index of a material parameter by name without creating it.
+         * \param name The name of the material parameter.
+         * \return The index of the material parameter, or -1 if the material has no parameter with this name.
          */
-        const polygon_mode& get_polygon_mode() const;
+        int32_t find_index(const std::string& name) const;
 
         /**
          * \brief Set this material's active program.
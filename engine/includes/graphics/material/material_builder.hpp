@@ -54,11 +54,8 @@ namespace moka
         size_t active_program_ = 0;
 
         alpha_mode alpha_mode_ = alpha_mode::opaque;
-        blend blend_;
-        culling culling_;
-        polygon_mode polygon_mode_;
-        bool scissor_test_ = false;
-        bool depth_test_ = true;
+        pipeline_state pipeline_state_;
+        bool instanced_ = false;
 
         static std::string get_property_name(material_property property);
 
@@ -172,6 +169,14 @@ namespace moka
          */
         material_builder& set_alpha_mode(alpha_mode alpha_mode);
 
+        /**
+         * \brief Compile the shaders of this material for instanced draws, which read the model matrix and material index
+         * from per-instance attributes (see instance_data) instead of from uniforms.
+         * \param instanced True to compile the shaders for instanced draws.
+         * \return A reference to this material_builder object to enable method chaining.
+         */
+        material_builder& set_instanced(bool instanced);
+
         /**
          * \brief Set the polygon mode of this material.
          * \param faces Specifies the polygons that the mode applies to.
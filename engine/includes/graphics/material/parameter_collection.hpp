@@ -76,6 +76,10 @@ namespace moka
 
         material_parameter& operator[](const std::string& name);
 
+        size_t get_index(const std::string& name);
+
+        const material_parameter* find(const std::string& name) const;
+
         size_t size() const;
     };
 } // namespace moka
@@ -0,0 +1,107 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <graphics/api/graphics_api.hpp>
+
+namespace moka
+{
+    /**
+     * \brief A unique identifier for a pipeline state.
+     */
+    struct pipeline_state_handle
+    {
+        uint16_t id;
+    };
+
+    enum class polygon_draw_mode
+    {
+        fill,
+        line,
+        points
+    };
+
+    /**
+     * \brief The polygon mode to use with a material.
+     */
+    struct polygon_mode final
+    {
+        polygon_draw_mode mode = polygon_draw_mode::fill;
+        face faces = face::front_and_back;
+    };
+
+    /**
+     * \brief Culling settings to use with a material.
+     */
+    struct culling final
+    {
+        bool enabled = true;
+        face faces = face::back;
+    };
+
+    /**
+     * \brief Blend settings to use with a material.
+     */
+    struct blend final
+    {
+        bool enabled = false;
+        blend_equation equation = blend_equation::func_add;
+        blend_function_factor source = blend_function_factor::src_alpha;
+        blend_function_factor destination = blend_function_factor::one_minus_src_alpha;
+    };
+
+    /**
+     * \brief The fixed-function render state of a material. Pipeline states are immutable once they are added to the
+     * pipeline_state_cache, and materials that share a state share its id.
+     */
+    struct pipeline_state final
+    {
+        moka::blend blend;
+        moka::culling culling;
+        moka::polygon_mode polygon_mode;
+        bool depth_test = true;
+        bool scissor_test = false;
+
+        /**
+         * \brief Pack this pipeline state into an integer. Two pipeline states are equal if their keys are equal.
+         * \return The key of this pipeline state.
+         */
+        constexpr uint64_t key() const
+        {
+            const auto flags = uint64_t{blend.enabled} | uint64_t{culling.enabled} << 1 | uint64_t{depth_test} << 2 |
+                               uint64_t{scissor_test} << 3;
+
+            return flags | static_cast<uint64_t>(blend.equation) << 8 | static_cast<uint64_t>(blend.source) << 16 |
+                   static_cast<uint64_t>(blend.destination) << 24 | static_cast<uint64_t>(culling.faces) << 32 |
+                   static_cast<uint64_t>(polygon_mode.mode) << 40 | static_cast<uint64_t>(polygon_mode.faces) << 48;
+        }
+    };
+} // namespace moka
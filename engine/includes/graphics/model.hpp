@@ -47,6 +47,7 @@ namespace moka
         index_type index_type_;
         uint32_t index_count_ = 0;
         uint32_t index_buffer_offset_ = 0;
+        int32_t base_vertex_ = 0;
 
         primitive_type type_ = primitive_type::triangles;
 
@@ -62,11 +63,21 @@ namespace moka
             index_type index_type,
             uint32_t index_count,
             uint32_t index_buffer_offset,
-            material_handle material);
+            material_handle material,
+            int32_t base_vertex = 0);
 
         primitive(vertex_buffer_handle vertex_buffer, uint32_t vertex_count, material_handle material);
 
         void draw(command_buffer& list) const;
+
+        /**
+         * \brief Draw several instances of this primitive in one draw. The primitive's material must be instanced.
+         * \param list The command buffer to record the draw into.
+         * \param instance_buffer A vertex buffer of instance_data, created with instance_data::layout().
+         * \param count The number of instances to draw.
+         * \param first The first instance to read from the instance buffer.
+         */
+        void draw_instances(command_buffer& list, vertex_buffer_handle instance_buffer, uint32_t count, uint32_t first = 0) const;
     };
 
     /**
@@ -31,13 +31,22 @@ SOFTWARE.
 
 #include "../deps/nlohmann/json.hpp"
 #include <application/application.hpp>
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <optional>
 #include <graphics/camera/basic_camera.hpp>
 #include <graphics/color.hpp>
+#include <graphics/command/command_bundle.hpp>
 #include <graphics/device/graphics_device.hpp>
+#include <graphics/device/worker_pool.hpp>
+#include <graphics/instance_data.hpp>
 #include <graphics/model.hpp>
 #include <graphics/pbr.hpp>
+#include <graphics/uniform_blocks.hpp>
+#include <thread>
+#include <vector>
 
 namespace moka
 {
@@ -50,6 +59,17 @@ namespace moka
 
     class pbr_scene
     {
+        /**
+         * \brief What the scene looks up about a material once, rather than for each draw.
+         */
+        struct material_data
+        {
+            uint16_t irradiance_map = 0; /**< The index of the irradiance map parameter. */
+            uint16_t prefilter_map = 0;  /**< The index of the prefilter map parameter. */
+            uint16_t brdf_lut = 0;       /**< The index of the BRDF lookup table parameter. */
+            uint16_t texture_set = 0;    /**< Materials that bind the same textures share a texture set. */
+        };
+
         texture_handle hdr_{};
 
         texture_handle irradiance_{};
@@ -64,28 +84,191 @@ namespace moka
 
         graphics_device& device_;
 
-        static uint32_t depth_to_bits(const float depth)
+        uniform_buffer_handle frame_uniforms_{}; /**< The frame_block shared by every program the scene draws with. */
+
+        uniform_buffer_handle view_uniforms_{}; /**< The view_block shared by every program the scene draws with. */
+
+        static constexpr uint8_t scene_layer = 1; /**< The view layer of scene geometry. Layer 0 sets up the viewport. */
+
+        static constexpr size_t meshes_per_recording_thread = 128; /**< Fewer translucent meshes than this are recorded on one thread. */
+
+        size_t applied_program_ = std::numeric_limits<size_t>::max();
+
+        std::optional<command_bundle> static_draws_; /**< The opaque & masked geometry of the model, recorded once. */
+
+        std::vector<material_data> materials_; /**< The material_data of each material, indexed by material id. */
+
+        std::vector<size_t> translucent_meshes_; /**< The meshes with blended primitives, which are recorded every frame. */
+
+        vertex_buffer_handle instances_{}; /**< The instance_data of every primitive of the model, in the order of its meshes. */
+
+        std::vector<uint32_t> first_instances_; /**< The instance of the first primitive of each mesh. */
+
+        worker_pool workers_; /**< Records the translucent meshes alongside the calling thread. */
+
+        /**
+         * \brief Look up the parameter indices and texture set of every material of the model, and make its instances.
+         */
+        void resolve_materials()
         {
-            // http://aras-p.info/blog/2014/01/16/rough-sorting-by-depth/
-            // use type punning to reinterpret the data of a float as an unsigned
-            union {
-                float f = 0.0f;
-                uint32_t i;
-            } data;
+            // the importer builds a material per glTF material, but different materials often share their textures
+            std::map<std::vector<uint32_t>, uint16_t> texture_sets;
 
-            data.f = depth;
+            auto& meshes = model_.get_meshes();
 
-            // take highest 10 bits
-            return data.i >> 22;
+            std::vector<instance_data> instances;
+
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                auto& mesh = meshes[i];
+
+                auto translucent = false;
+
+                first_instances_.emplace_back(static_cast<uint32_t>(instances.size()));
+
+                for (auto& primitive : mesh)
+                {
+                    // the model is static, so each primitive's model matrix is uploaded once rather than with each draw
+                    instances.push_back({mesh.get_transform().to_matrix()});
+
+                    const auto material = primitive.get_material();
+
+                    const auto* mat = device_.get_material_cache().get_material(material);
+
+                    if (!mat)
+                    {
+                        continue;
+                    }
+
+                    translucent |= mat->get_alpha_mode() == alpha_mode::blend;
+
+                    if (material.id >= materials_.size())
+                    {
+                        materials_.resize(material.id + 1);
+                    }
+
+                    std::vector<uint32_t> textures;
+
+                    for (const auto& parameter : *mat)
+                    {
+                        if (const auto* texture = std::get_if<texture_handle>(&parameter.data))
+                        {
+                            textures.emplace_back(texture->id);
+                        }
+                    }
+
+                    auto& indices = materials_[material.id];
+                    indices.texture_set =
+                        texture_sets.try_emplace(std::move(textures), static_cast<uint16_t>(texture_sets.size())).first->second;
+                    indices.irradiance_map = device_.find_parameter_index(material, "irradiance_map");
+                    indices.prefilter_map = device_.find_parameter_index(material, "prefilter_map");
+                    indices.brdf_lut = device_.find_parameter_index(material, "brdf_lut");
+                }
+
+                if (translucent)
+                {
+                    translucent_meshes_.emplace_back(i);
+                }
+            }
+
+            instances_ = device_.make_vertex_buffer(
+                instances.data(), instances.size() * sizeof(instance_data), instance_data::layout(), buffer_usage::static_draw);
         }
 
-        static sort_key generate_sort_key(const float depth, const uint16_t material_id, const alpha_mode alpha)
+        /**
+         * \brief Give every material of the model the environment maps. They never change, so no draw has to set them.
+         */
+        void bind_environment()
         {
-            // http://realtimecollisiondetection.net/blog/?p=86
-            // sort by alpha, then by depth, then by material
-            return static_cast<sort_key>(material_id) |
-                   static_cast<sort_key>(depth_to_bits(depth)) << 16 |
-                   static_cast<sort_key>(alpha == alpha_mode::blend) << 48;
+            auto list = device_.make_command_list();
+
+            for (auto& mesh : model_.get_meshes())
+            {
+                for (auto& primitive : mesh)
+                {
+                    const auto material = primitive.get_material();
+
+                    if (!device_.get_material_cache().get_material(material))
+                    {
+                        continue;
+                    }
+
+                    const auto& indices = materials_[material.id];
+
+                    list.make_command_buffer()
+                        .set_material_parameters()
+                        .set_material(material)
+                        .set_parameter(indices.irradiance_map, irradiance_)
+                        .set_parameter(indices.prefilter_map, prefiltered_)
+                        .set_parameter(indices.brdf_lut, brdf_);
+                }
+            }
+
+            device_.submit(std::move(list), false);
+        }
+
+        /**
+         * \brief Record the draws of a mesh of the model.
+         * \param list The command_list to record into.
+         * \param mesh The mesh to record.
+         * \param first_instance The instance of the first primitive of the mesh.
+         * \param view_pos The position of the camera, which blended primitives are sorted back to front from.
+         * \param translucent If true, only record blended primitives. Otherwise, only record opaque & masked primitives.
+         */
+        void record_mesh(
+            command_list& list, mesh& mesh, const uint32_t first_instance, const glm::vec3& view_pos, const bool translucent) const
+        {
+            auto instance = first_instance;
+
+            for (auto& primitive : mesh)
+            {
+                const auto material = primitive.get_material();
+
+                const auto* mat = device_.get_material_cache().get_material(material);
+
+                if (mat && (mat->get_alpha_mode() == alpha_mode::blend) == translucent)
+                {
+                    // opaque & masked draws are bundled once, so a depth taken from one camera would go stale as
+                    // soon as it moves. they're ordered by state alone, blending only needs depth to be correct
+                    const auto distance =
+                        translucent ? glm::distance2(mesh.get_transform().get_world_position(), view_pos) : 0.0f;
+
+                    const auto sort_key = sort_key_builder{}
+                                              .set_view_layer(scene_layer)
+                                              .set_translucency(mat->get_alpha_mode())
+                                              .set_depth(distance)
+                                              .set_pipeline_state(mat->get_pipeline_state().id)
+                                              .set_program(mat->get_program().id)
+                                              .set_texture_set(materials_[material.id].texture_set)
+                                              .build();
+
+                    // frame & view constants come from the shared uniform blocks, and the model matrix from the instance,
+                    // so draws of the same state can be issued together
+                    primitive.draw_instances(list.make_command_buffer(sort_key), instances_, 1, instance);
+                }
+
+                ++instance;
+            }
+        }
+
+        /**
+         * \brief Record the static draws of the model into a command_bundle. They are ordered by state, not depth.
+         * \return The new command_bundle.
+         */
+        command_bundle make_static_draws()
+        {
+            // the bundle outlives the frame, so it must not use the frame allocator
+            command_list list;
+
+            auto& meshes = model_.get_meshes();
+
+            for (size_t i = 0; i < meshes.size(); ++i)
+            {
+                record_mesh(list, meshes[i], first_instances_[i], {}, false);
+            }
+
+            // the per-frame parameters live in uniform buffers, so the bundle is replayed without patches
+            return command_bundle{std::move(list)};
         }
 
     public:
@@ -103,9 +286,10 @@ namespace moka
          * \brief Create a new scene object.
          * \param device Graphics device object to use with the scene.
          * \param root The root resource folder where PBR assets are located.
+         * \param model The glTF asset to draw, relative to the root folder. If empty, the model named by config.json is drawn.
          */
-        pbr_scene(graphics_device& device, const std::filesystem::path& root)
-            : device_(device)
+        pbr_scene(graphics_device& device, const std::filesystem::path& root, const std::filesystem::path& model = {})
+            : device_(device), workers_(std::max(1u, std::thread::hardware_concurrency()) - 1)
         {
             const pbr_util util(device, root);
 
@@ -113,10 +297,13 @@ namespace moka
             nlohmann::json j;
             i >> j;
 
-            const auto& model = j["config"]["model"].get<std::string>();
             const auto& draw_environment = j["config"]["environment"].get<std::string>();
 
-            model_ = util.load_model(model, "Materials/pbr.material");
+            model_ = util.load_model(
+                model.empty() ? std::filesystem::path{j["config"]["model"].get<std::string>()} : model,
+                "Materials/pbr_instanced.material");
+
+            resolve_materials();
 
             hdr_ = util.equirectangular_to_cubemap(
                 util.import_equirectangular_map(draw_environment));
@@ -127,7 +314,13 @@ namespace moka
 
             brdf_ = util.make_brdf_integration_map();
 
+            bind_environment();
+
             cube_ = util.make_skybox(hdr_);
+
+            frame_uniforms_ = device_.make_uniform_buffer(uniform_block::frame, sizeof(frame_block));
+
+            view_uniforms_ = device_.make_uniform_buffer(uniform_block::view, sizeof(view_block));
         }
 
         /**
@@ -137,81 +330,129 @@ namespace moka
          */
         void draw(const basic_camera& camera, const rectangle& viewport)
         {
-            const auto& view_pos = camera.get_position();
+            auto& meshes = model_.get_meshes();
 
-            command_list scene_draw;
+            // materials are shared between primitives, so switch programs before recording starts
+            if (applied_program_ != active_program)
+            {
+                // the render thread may still be drawing with these materials and the old bundle
+                device_.wait_idle();
 
-            scene_draw.viewport().set_rectangle(viewport);
+                for (auto& mesh : meshes)
+                {
+                    for (auto& primitive : mesh)
+                    {
+                        if (auto* mat = device_.get_material_cache().get_material(primitive.get_material()))
+                        {
+                            mat->set_active_program(active_program);
+                        }
+                    }
+                }
 
-            scene_draw.scissor().set_rectangle(viewport);
+                applied_program_ = active_program;
 
-            scene_draw.clear().set_color(color).set_clear_color(true).set_clear_depth(true);
+                // the bundled sort keys depend on the active program
+                static_draws_.reset();
+            }
 
-            for (auto& mesh : model_)
+            if (!static_draws_)
             {
-                for (auto& primitive : mesh)
+                static_draws_.emplace(make_static_draws());
+            }
+
+            frame_block frame{};
+            frame.light_direction = light.direction;
+            frame.light_diffuse = light.diffuse;
+            frame.light_ambient = light.ambient;
+            frame.gamma = gamma;
+            frame.exposure = exposure;
+            frame.use_ibl = use_ibl;
+            frame.use_directional_light = use_directional_light;
+
+            view_block view{};
+            view.view = camera.get_view();
+            view.projection = camera.get_projection();
+            view.view_pos = camera.get_position();
+
+            auto setup = device_.make_command_list();
+
+            // uploaded once, before any draw of the frame
+            setup.fill_uniform_buffer().set_buffer(frame_uniforms_, &frame, sizeof frame);
+
+            setup.fill_uniform_buffer().set_buffer(view_uniforms_, &view, sizeof view);
+
+            setup.viewport().set_rectangle(viewport);
+
+            setup.scissor().set_rectangle(viewport);
+
+            setup.clear().set_color(color).set_clear_color(true).set_clear_depth(true);
+
+            // the scope spans the bundle and the sorted list, it's closed by a list of its own once both are submitted
+            setup.gpu_timer().begin_scope("scene");
+
+            device_.submit(std::move(setup), false);
+
+            device_.submit(*static_draws_);
+
+            // translucent geometry is re-recorded every frame to keep it sorted back to front
+            const auto thread_count = std::clamp<size_t>(
+                translucent_meshes_.size() / meshes_per_recording_thread, 1, workers_.size() + 1);
+
+            auto lists = device_.make_command_lists(thread_count);
+
+            auto& scene_draw = lists.front();
+
+            const auto& view_pos = camera.get_position();
+
+            // split the meshes evenly, one list per job
+            const auto meshes_per_thread = (translucent_meshes_.size() + thread_count - 1) / thread_count;
+
+            workers_.run(thread_count, [this, &meshes, &lists, &view_pos, meshes_per_thread](const size_t i) {
+                const auto first = std::min(translucent_meshes_.size(), i * meshes_per_thread);
+                const auto last = std::min(translucent_meshes_.size(), (i + 1) * meshes_per_thread);
+
+                for (auto mesh = first; mesh < last; ++mesh)
                 {
-                    const auto material = primitive.get_material();
+                    const auto index = translucent_meshes_[mesh];
 
-                    auto* mat = device_.get_material_cache().get_material(material);
+                    record_mesh(lists[i], meshes[index], first_instances_[index], view_pos, true);
+                }
 
-                    if (mat)
-                    {
-                        mat->set_active_program(active_program);
-
-                        auto pos = mesh.get_transform().get_world_position();
-
-                        const auto distance = glm::distance2(pos, view_pos);
-
-                        const auto sort_key = generate_sort_key(
-                            distance, mat->get_program().id, mat->get_alpha_mode());
-
-                        auto& buffer = scene_draw.make_command_buffer(sort_key);
-
-                        buffer.set_material_parameters()
-                            .set_material(material)
-                            .set_parameter("gamma", gamma)
-                            .set_parameter("exposure", exposure)
-                            .set_parameter("irradiance_map", irradiance_)
-                            .set_parameter("prefilter_map", prefiltered_)
-                            .set_parameter("brdf_lut", brdf_)
-                            .set_parameter("model", mesh.get_transform().to_matrix())
-                            .set_parameter("view", camera.get_view())
-                            .set_parameter("projection", camera.get_projection())
-                            .set_parameter("view_pos", view_pos)
-                            .set_parameter("light.direction", light.direction)
-                            .set_parameter("light.ambient", light.ambient)
-                            .set_parameter("light.diffuse", light.diffuse)
-                            .set_parameter("use_ibl", use_ibl)
-                            .set_parameter("use_directional_light", use_directional_light);
-                        primitive.draw(buffer);
-                    }
+                // the first list is sorted once the environment has been added to it
+                if (i != 0)
+                {
+                    lists[i].sort();
                 }
-            }
+            });
 
             if (draw_environment)
             {
+                constexpr auto environment_key = sort_key_builder{}
+                                                     .set_view_layer(scene_layer)
+                                                     .set_translucency(translucency::background)
+                                                     .build();
+
+                // sorting is stable, so commands sharing the environment key stay between the scope's begin and end
+                scene_draw.gpu_timer(environment_key).begin_scope("skybox");
+
                 for (auto& mesh : cube_)
                 {
                     for (auto& primitive : mesh)
                     {
-                        const auto material = primitive.get_material();
-
-                        auto& buffer = scene_draw.make_command_buffer();
-
-                        buffer.set_material_parameters()
-                            .set_material(material)
-                            .set_parameter("gamma", gamma)
-                            .set_parameter("exposure", exposure)
-                            .set_parameter("view", camera.get_view())
-                            .set_parameter("projection", camera.get_projection());
+                        auto& buffer = scene_draw.make_command_buffer(environment_key);
 
                         primitive.draw(buffer);
                     }
                 }
+
+                scene_draw.gpu_timer(environment_key).end_scope();
             }
 
-            device_.submit(std::move(scene_draw));
+            device_.submit(command_list::merge(std::move(lists)));
+
+            auto finish = device_.make_command_list();
+            finish.gpu_timer().end_scope();
+            device_.submit(std::move(finish), false);
         }
     };
 } // namespace moka
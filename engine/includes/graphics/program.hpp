@@ -30,6 +30,7 @@ SOFTWARE.
 #pragma once
 
 #include <cstdint>
+#include <limits>
 
 namespace moka
 {
@@ -38,7 +39,7 @@ namespace moka
      */
     struct program_handle
     {
-        uint16_t id = std::numeric_limits<uint16_t>::max();
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const program_handle& rhs) const
         {
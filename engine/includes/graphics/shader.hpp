@@ -30,6 +30,7 @@ SOFTWARE.
 #pragma once
 
 #include <cstdint>
+#include <limits>
 
 namespace moka
 {
@@ -48,7 +49,7 @@ namespace moka
      */
     struct shader_handle
     {
-        uint16_t id;
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const shader_handle& rhs) const
         {
@@ -30,6 +30,7 @@ SOFTWARE.
 #pragma once
 
 #include <cstdint>
+#include <limits>
 #include <vector>
 
 namespace moka
@@ -219,7 +220,7 @@ namespace moka
      */
     struct texture_handle final
     {
-        uint16_t id;
+        uint32_t id = std::numeric_limits<uint32_t>::max(); /**< A generational index into the device's pool. */
 
         bool operator==(const texture_handle& rhs) const;
 
@@ -253,6 +254,13 @@ namespace moka
         host_format base_format = host_format::auto_detect;
     };
 
+    /**
+     * \brief Get the size of the host pixel data of an image. Rows are padded to the default unpack alignment of 4 bytes.
+     * \param image The image.
+     * \return The size of the image's pixel data in bytes.
+     */
+    size_t image_size(const image_metadata& image);
+
     struct host_image_data final
     {
         image_metadata metadata; // description of pixel data
@@ -271,6 +279,8 @@ namespace moka
         filter filter_mode = {mag_filter::linear, min_filter::linear};
 
         bool generate_mipmaps = false;
+
+        bool streamed = false; // upload the pixels over several frames, sampling nothing until they arrive
     };
 
     /**
@@ -341,6 +351,14 @@ namespace moka
          */
         texture_builder& set_mipmaps(bool generate_mipmaps);
 
+        /**
+         * \brief Stream this texture's pixels to the device within the per-frame upload budget. Until they arrive, the
+         * texture is left unbound when it's drawn, so don't stream textures that are rendered into or sampled only once.
+         * \param streamed True if this texture should be streamed. Otherwise, its pixels are uploaded immediately.
+         * \return A reference to this texture_builder object to enable method chaining.
+         */
+        texture_builder& set_streamed(bool streamed);
+
         /**
          * \brief Build the final texture, upload it to the device, and return
          * the handle. \return The handle to the new texture.
@@ -0,0 +1,69 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace moka
+{
+    /**
+     * \brief The host layout of the std140 frame_block that shaders share. Filled once per frame.
+     */
+    struct frame_block final
+    {
+        glm::vec3 light_direction;      /**< The direction of the directional light. */
+        float padding0;                 /**< std140 aligns every vec3 of the light struct to 16 bytes. */
+        glm::vec3 light_diffuse;        /**< The diffuse color of the directional light. */
+        float padding1;                 /**< std140 aligns every vec3 of the light struct to 16 bytes. */
+        glm::vec3 light_ambient;        /**< The ambient color of the directional light. */
+        float padding2;                 /**< std140 rounds the size of the light struct up to 16 bytes. */
+        float gamma;                    /**< The gamma used for gamma correction. */
+        float exposure;                 /**< The exposure used for tone mapping. */
+        uint32_t use_ibl;               /**< Non-zero to use image-based lighting. A GLSL bool is 4 bytes in std140. */
+        uint32_t use_directional_light; /**< Non-zero to use the directional light. */
+    };
+
+    static_assert(sizeof(frame_block) == 64, "frame_block must match the std140 layout of the GLSL block");
+
+    /**
+     * \brief The host layout of the std140 view_block that shaders share. Filled once per view.
+     */
+    struct view_block final
+    {
+        glm::mat4 view;       /**< The view matrix. */
+        glm::mat4 projection; /**< The projection matrix. */
+        glm::vec3 view_pos;   /**< The world position of the camera. */
+        float padding;        /**< std140 rounds the size of the block up to 16 bytes. */
+    };
+
+    static_assert(sizeof(view_block) == 144, "view_block must match the std140 layout of the GLSL block");
+} // namespace moka
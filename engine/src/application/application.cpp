@@ -37,9 +37,19 @@ namespace moka
         : log_("app", moka::log_level::info),
           timer_(true),
           window_(app_settings.window),
-          graphics_(window_)
+          graphics_(window_, app_settings.graphics)
     {
         log_.info("Application started");
+
+        if (!app_settings.capture_path.empty())
+        {
+            graphics_.start_capture(app_settings.capture_path);
+        }
+
+        if (app_settings.render_thread)
+        {
+            graphics_.start_render_thread(app_settings.frames_in_flight);
+        }
     }
 
     float application::seconds_elapsed() const
@@ -33,56 +33,107 @@ SOFTWARE.
 #include <application/window.hpp>
 #include <atomic>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 
+#ifdef MOKA_HEADLESS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
 namespace moka
 {
     class window::impl
+    {
+    public:
+        signal<> exit;
+
+        impl() = default;
+        impl(const impl& impl) = delete;
+        impl(impl&& impl) = delete;
+        impl& operator=(const impl& impl) = delete;
+        impl& operator=(impl&& impl) = delete;
+
+        virtual ~impl() = default;
+
+        virtual void swap_buffer() = 0;
+
+        virtual rectangle get_viewport() const = 0;
+
+        virtual void set_size(int width, int height) = 0;
+
+        virtual float aspect() const = 0;
+
+        virtual context_handle make_context() = 0;
+
+        virtual void set_current_context(context_handle handle) = 0;
+
+        virtual void acquire_context() const = 0;
+
+        virtual void release_context() const = 0;
+
+        virtual glm::ivec2 get_size() const = 0;
+
+        virtual glm::ivec2 get_drawable_size() const = 0;
+
+        virtual GLuint get_default_frame_buffer() const
+        {
+            return 0;
+        }
+    };
+
+    /**
+     * \brief Window implementation backed by an SDL window and its GL context.
+     */
+    class window::sdl_impl final : public impl
     {
         SDL_Window* window_;
         logger log_{"Window"};
         std::unordered_map<uint16_t, SDL_GLContext> contexts_;
+        SDL_GLContext context_ = nullptr;
         window_settings settings_;
 
     public:
-        signal<> exit;
+        void swap_buffer() override;
 
-        void swap_buffer() const;
+        rectangle get_viewport() const override;
 
-        rectangle get_viewport() const;
+        explicit sdl_impl(const window_settings& settings);
 
-        explicit impl(const window_settings& settings);
+        ~sdl_impl();
 
-        ~impl();
+        void set_size(int width, int height) override;
 
-        void set_size(int width, int height) const;
+        float aspect() const override;
 
-        float aspect() const;
+        context_handle make_context() override;
 
-        context_handle make_context();
+        void set_current_context(context_handle handle) override;
 
-        void set_current_context(context_handle handle);
+        void acquire_context() const override;
 
-        glm::ivec2 get_size() const;
+        void release_context() const override;
 
-        glm::ivec2 get_drawable_size() const;
+        glm::ivec2 get_size() const override;
+
+        glm::ivec2 get_drawable_size() const override;
     };
 
-    glm::ivec2 window::impl::get_size() const
+    glm::ivec2 window::sdl_impl::get_size() const
     {
         int w, h;
         SDL_GetWindowSize(window_, &w, &h);
         return {w, h};
     }
 
-    glm::ivec2 window::impl::get_drawable_size() const
+    glm::ivec2 window::sdl_impl::get_drawable_size() const
     {
         int display_w, display_h;
         SDL_GL_GetDrawableSize(window_, &display_w, &display_h);
         return {display_w, display_h};
     }
 
-    context_handle window::impl::make_context()
+    context_handle window::sdl_impl::make_context()
     {
         static std::atomic<uint16_t> current_id = 0;
         contexts_.emplace(current_id, SDL_GL_CreateContext(window_));
@@ -91,7 +142,7 @@ namespace moka
         return handle;
     }
 
-    void window::impl::set_current_context(const context_handle handle)
+    void window::sdl_impl::set_current_context(const context_handle handle)
     {
         const auto pos = contexts_.find(handle.id);
         if (pos != contexts_.end())
@@ -100,19 +151,32 @@ namespace moka
         }
     }
 
-    void window::impl::swap_buffer() const
+    void window::sdl_impl::acquire_context() const
+    {
+        if (SDL_GL_MakeCurrent(window_, context_) < 0)
+        {
+            log_.error("Unable to acquire GL Context: {}", SDL_GetError());
+        }
+    }
+
+    void window::sdl_impl::release_context() const
+    {
+        SDL_GL_MakeCurrent(window_, nullptr);
+    }
+
+    void window::sdl_impl::swap_buffer()
     {
         SDL_GL_SwapWindow(window_);
     }
 
-    rectangle window::impl::get_viewport() const
+    rectangle window::sdl_impl::get_viewport() const
     {
         int w, h;
         SDL_GL_GetDrawableSize(window_, &w, &h);
         return rectangle{0, 0, w, h};
     }
 
-    window::impl::impl(const window_settings& settings) : settings_(settings)
+    window::sdl_impl::sdl_impl(const window_settings& settings) : settings_(settings)
     {
         /* First, initialize SDL's video subsystem. */
         if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -156,6 +220,8 @@ namespace moka
             {
                 const auto ctx = SDL_GL_CreateContext(window_);
 
+                context_ = ctx;
+
                 if (!ctx)
                 {
                     log_.error("Error creating GL Context: {}", SDL_GetError());
@@ -178,7 +244,7 @@ namespace moka
         }
     }
 
-    window::impl::~impl()
+    window::sdl_impl::~sdl_impl()
     {
         for (const auto& item : contexts_)
         {
@@ -188,23 +254,425 @@ namespace moka
         SDL_Quit();
     }
 
-    void window::impl::set_size(const int width, const int height) const
+    void window::sdl_impl::set_size(const int width, const int height)
     {
         SDL_SetWindowSize(window_, width, height);
     }
 
-    float window::impl::aspect() const
+    float window::sdl_impl::aspect() const
     {
         return static_cast<float>(settings_.resolution.x) / settings_.resolution.y;
     }
 
+
+#ifdef MOKA_HEADLESS_EGL
+    /**
+     * \brief Window implementation without a display server. Creates a GL context on the EGL surfaceless platform
+     * and renders the default frame buffer into an offscreen frame buffer object of the configured resolution.
+     */
+    class window::headless_impl final : public impl
+    {
+        logger log_{"Window"};
+        EGLDisplay display_ = EGL_NO_DISPLAY;
+        EGLConfig config_ = nullptr;
+        EGLContext context_ = EGL_NO_CONTEXT;
+        std::unordered_map<uint16_t, EGLContext> contexts_;
+        window_settings settings_;
+
+        GLuint frame_buffer_ = 0;
+        GLuint color_buffer_ = 0;
+        GLuint depth_buffer_ = 0;
+
+        glm::ivec2 size_;
+        glm::ivec2 pending_size_;
+
+        EGLContext create_context(EGLContext share) const;
+
+        void make_frame_buffer();
+
+        void destroy_frame_buffer();
+
+    public:
+        explicit headless_impl(const window_settings& settings);
+
+        ~headless_impl();
+
+        bool is_valid() const;
+
+        void swap_buffer() override;
+
+        rectangle get_viewport() const override;
+
+        void set_size(int width, int height) override;
+
+        float aspect() const override;
+
+        context_handle make_context() override;
+
+        void set_current_context(context_handle handle) override;
+
+        void acquire_context() const override;
+
+        void release_context() const override;
+
+        glm::ivec2 get_size() const override;
+
+        glm::ivec2 get_drawable_size() const override;
+
+        GLuint get_default_frame_buffer() const override;
+    };
+
+    window::headless_impl::headless_impl(const window_settings& settings)
+        : settings_(settings), size_(settings.resolution), pending_size_(settings.resolution)
+    {
+        const auto* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+        if (!client_extensions || !std::strstr(client_extensions, "EGL_MESA_platform_surfaceless"))
+        {
+            log_.error("EGL_MESA_platform_surfaceless is not supported");
+            return;
+        }
+
+        const auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+        if (!get_platform_display)
+        {
+            log_.error("eglGetPlatformDisplayEXT is not available");
+            return;
+        }
+
+        display_ = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+
+        EGLint major = 0, minor = 0;
+        if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, &major, &minor))
+        {
+            log_.error("EGL initialization failed: {:#x}", eglGetError());
+            display_ = EGL_NO_DISPLAY;
+            return;
+        }
+
+        log_.info("EGL {}.{} surfaceless display: {}", major, minor, eglQueryString(display_, EGL_VENDOR));
+
+        if (!eglBindAPI(EGL_OPENGL_API))
+        {
+            log_.error("Unable to bind the OpenGL API: {:#x}", eglGetError());
+            return;
+        }
+
+        const EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display_, config_attributes, &config_, 1, &config_count) || config_count == 0)
+        {
+            log_.error("No EGL config supports OpenGL: {:#x}", eglGetError());
+            return;
+        }
+
+        context_ = create_context(EGL_NO_CONTEXT);
+
+        if (context_ == EGL_NO_CONTEXT)
+        {
+            log_.error("Error creating GL Context: {:#x}", eglGetError());
+            return;
+        }
+
+        if (!eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_))
+        {
+            log_.error("Unable to make the GL Context current: {:#x}", eglGetError());
+            return;
+        }
+
+        glewExperimental = GL_TRUE;
+        const auto glew_error = glewInit();
+
+        // GLEW finishes loading the core entry points before it looks for an X display, so a missing display is harmless here
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+        if (glew_error != GLEW_OK && glew_error != GLEW_ERROR_NO_GLX_DISPLAY)
+#else
+        if (glew_error != GLEW_OK)
+#endif
+        {
+            log_.error("Error initializing GLEW: {}", glewGetErrorString(glew_error));
+        }
+
+        make_frame_buffer();
+    }
+
+    window::headless_impl::~headless_impl()
+    {
+        if (display_ == EGL_NO_DISPLAY)
+        {
+            return;
+        }
+
+        if (context_ != EGL_NO_CONTEXT)
+        {
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_);
+            destroy_frame_buffer();
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+
+        for (const auto& item : contexts_)
+        {
+            eglDestroyContext(display_, item.second);
+        }
+
+        if (context_ != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(display_, context_);
+        }
+
+        eglTerminate(display_);
+    }
+
+    EGLContext window::headless_impl::create_context(const EGLContext share) const
+    {
+        const EGLint context_attributes[] = {EGL_CONTEXT_MAJOR_VERSION,
+                                             4,
+                                             EGL_CONTEXT_MINOR_VERSION,
+                                             0,
+                                             EGL_CONTEXT_OPENGL_PROFILE_MASK,
+                                             EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+                                             EGL_NONE};
+
+        return eglCreateContext(display_, config_, share, context_attributes);
+    }
+
+    void window::headless_impl::make_frame_buffer()
+    {
+        glGenRenderbuffers(1, &color_buffer_);
+        glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size_.x, size_.y);
+
+        glGenRenderbuffers(1, &depth_buffer_);
+        glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size_.x, size_.y);
+
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &frame_buffer_);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_buffer_);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth_buffer_);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            log_.error("Offscreen frame buffer is incomplete");
+        }
+
+        glDrawBuffer(GL_COLOR_ATTACHMENT0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+    }
+
+    void window::headless_impl::destroy_frame_buffer()
+    {
+        glDeleteFramebuffers(1, &frame_buffer_);
+        glDeleteRenderbuffers(1, &color_buffer_);
+        glDeleteRenderbuffers(1, &depth_buffer_);
+
+        frame_buffer_ = color_buffer_ = depth_buffer_ = 0;
+    }
+
+    bool window::headless_impl::is_valid() const
+    {
+        return frame_buffer_ != 0;
+    }
+
+    void window::headless_impl::swap_buffer()
+    {
+        glFlush();
+
+        // there's no surface to present, so resizes take effect at the frame boundary by reallocating the attachments
+        if (pending_size_ != size_)
+        {
+            size_ = pending_size_;
+
+            glBindRenderbuffer(GL_RENDERBUFFER, color_buffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size_.x, size_.y);
+            glBindRenderbuffer(GL_RENDERBUFFER, depth_buffer_);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, size_.x, size_.y);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+        }
+    }
+
+    rectangle window::headless_impl::get_viewport() const
+    {
+        return rectangle{0, 0, size_.x, size_.y};
+    }
+
+    void window::headless_impl::set_size(const int width, const int height)
+    {
+        pending_size_ = {width, height};
+    }
+
+    float window::headless_impl::aspect() const
+    {
+        return static_cast<float>(settings_.resolution.x) / settings_.resolution.y;
+    }
+
+    context_handle window::headless_impl::make_context()
+    {
+        static std::atomic<uint16_t> current_id = 0;
+        contexts_.emplace(current_id, create_context(context_));
+        const context_handle handle{current_id};
+        ++current_id;
+        return handle;
+    }
+
+    void window::headless_impl::set_current_context(const context_handle handle)
+    {
+        const auto pos = contexts_.find(handle.id);
+        if (pos != contexts_.end())
+        {
+            eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, pos->second);
+        }
+    }
+
+    void window::headless_impl::acquire_context() const
+    {
+        if (!eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, context_))
+        {
+            log_.error("Unable to acquire GL Context: {:#x}", eglGetError());
+        }
+    }
+
+    void window::headless_impl::release_context() const
+    {
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    }
+
+    glm::ivec2 window::headless_impl::get_size() const
+    {
+        return size_;
+    }
+
+    glm::ivec2 window::headless_impl::get_drawable_size() const
+    {
+        return size_;
+    }
+
+    GLuint window::headless_impl::get_default_frame_buffer() const
+    {
+        return frame_buffer_;
+    }
+#endif
+
+    /**
+     * \brief Window implementation without a window or a graphics context. Only the null graphics backend can render to it.
+     */
+    class window::null_impl final : public impl
+    {
+        glm::ivec2 size_;
+
+    public:
+        explicit null_impl(const window_settings& settings);
+
+        void swap_buffer() override;
+
+        rectangle get_viewport() const override;
+
+        void set_size(int width, int height) override;
+
+        float aspect() const override;
+
+        context_handle make_context() override;
+
+        void set_current_context(context_handle handle) override;
+
+        void acquire_context() const override;
+
+        void release_context() const override;
+
+        glm::ivec2 get_size() const override;
+
+        glm::ivec2 get_drawable_size() const override;
+    };
+
+    window::null_impl::null_impl(const window_settings& settings) : size_(settings.resolution)
+    {
+    }
+
+    void window::null_impl::swap_buffer()
+    {
+    }
+
+    rectangle window::null_impl::get_viewport() const
+    {
+        return rectangle{0, 0, size_.x, size_.y};
+    }
+
+    void window::null_impl::set_size(const int width, const int height)
+    {
+        size_ = {width, height};
+    }
+
+    float window::null_impl::aspect() const
+    {
+        return static_cast<float>(size_.x) / size_.y;
+    }
+
+    context_handle window::null_impl::make_context()
+    {
+        return context_handle{0};
+    }
+
+    void window::null_impl::set_current_context(const context_handle handle)
+    {
+    }
+
+    void window::null_impl::acquire_context() const
+    {
+    }
+
+    void window::null_impl::release_context() const
+    {
+    }
+
+    glm::ivec2 window::null_impl::get_size() const
+    {
+        return size_;
+    }
+
+    glm::ivec2 window::null_impl::get_drawable_size() const
+    {
+        return size_;
+    }
+
     rectangle window::get_viewport() const
     {
         return impl_->get_viewport();
     }
 
-    window::window(const window_settings& settings) : impl_(new impl(settings))
+    window::window(const window_settings& settings)
     {
+        if (settings.null_context)
+        {
+            impl_ = std::make_unique<null_impl>(settings);
+        }
+        else if (settings.headless)
+        {
+#ifdef MOKA_HEADLESS_EGL
+            auto headless = std::make_unique<headless_impl>(settings);
+
+            if (headless->is_valid())
+            {
+                impl_ = std::move(headless);
+            }
+            else
+            {
+                logger{"Window"}.error("Unable to create a headless context, falling back to a window");
+            }
+#else
+            logger{"Window"}.error("Headless contexts require EGL, falling back to a window");
+#endif
+        }
+
+        if (!impl_)
+        {
+            impl_ = std::make_unique<sdl_impl>(settings);
+        }
+
         impl_->exit.connect([this]() { exit(); });
     }
 
@@ -235,6 +703,16 @@ namespace moka
         impl_->set_current_context(handle);
     }
 
+    void window::acquire_context() const
+    {
+        impl_->acquire_context();
+    }
+
+    void window::release_context() const
+    {
+        impl_->release_context();
+    }
+
     glm::ivec2 window::get_size() const
     {
         return impl_->get_size();
@@ -244,4 +722,9 @@ namespace moka
     {
         return impl_->get_drawable_size();
     }
+
+    uint32_t window::get_default_frame_buffer() const
+    {
+        return impl_->get_default_frame_buffer();
+    }
 } // namespace moka
@@ -47,8 +47,10 @@ References:
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <tiny_gltf.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <unordered_map>
 #include <vector>
 #include <glm/gtc/type_ptr.hpp>
 
@@ -189,691 +191,793 @@ namespace moka
     {
     }
 
-    mesh load_mesh(
+    /**
+     * \brief Primitives that share a vertex layout and an index type, packed into one vertex buffer and one index buffer.
+     * Their draws read the same vertex array, so the device can issue them together.
+     */
+    struct packed_geometry final
+    {
+        /**
+         * \brief The data of one attribute of every packed primitive, laid out as one block of the vertex buffer.
+         */
+        struct attribute final
+        {
+            size_t index = 0;
+            size_t size = 0;
+            bool normalized = false;
+            std::vector<uint8_t> data;
+        };
+
+        std::vector<attribute> attributes;
+        index_type type = index_type::uint32;
+        std::vector<uint8_t> indices;
+        uint32_t vertex_count = 0;
+    };
+
+    /**
+     * \brief A primitive whose geometry has been packed, but whose buffers haven't been made yet.
+     */
+    struct packed_primitive final
+    {
+        size_t geometry = 0;        /**< The index of the packed_geometry the primitive was packed into. */
+        int32_t base_vertex = 0;    /**< The first vertex of the primitive in the packed vertex buffer. */
+        uint32_t vertex_count = 0;  /**< The number of vertices of the primitive. */
+        uint32_t index_offset = 0;  /**< The offset of the first index of the primitive in the packed index buffer. */
+        uint32_t index_count = 0;   /**< The number of indices of the primitive. */
+        index_type type = index_type::uint32;
+        material_handle material;
+    };
+
+    struct packed_mesh final
+    {
+        std::vector<packed_primitive> primitives;
+        glm::mat4 transform;
+    };
+
+    /**
+     * \brief Everything gathered while the nodes of a glTF asset are walked, before any buffer is made.
+     */
+    struct model_import final
+    {
+        std::vector<packed_geometry> geometry;
+        std::vector<packed_mesh> meshes;
+        std::unordered_map<int, material_handle> materials; /**< The material made for each glTF material. */
+    };
+
+    // a buffer missing from the asset, or a truncated one, must not be read out of bounds
+    bool can_read(const tinygltf::Model& model, const tinygltf::Accessor& accessor, const size_t element_size)
+    {
+        if (accessor.bufferView < 0 || accessor.count == 0)
+        {
+            return false;
+        }
+
+        const auto& view = model.bufferViews[accessor.bufferView];
+        const auto stride = view.byteStride != 0 ? view.byteStride : element_size;
+
+        return view.byteOffset + accessor.byteOffset + (accessor.count - 1) * stride + element_size <=
+               model.buffers[view.buffer].data.size();
+    }
+
+    // elements are appended tightly packed, dropping the stride of an interleaved view
+    void append(
+        const tinygltf::Model& model, const tinygltf::Accessor& accessor, const size_t element_size, std::vector<uint8_t>& data)
+    {
+        const auto& view = model.bufferViews[accessor.bufferView];
+        const auto stride = view.byteStride != 0 ? view.byteStride : element_size;
+        const auto* first = model.buffers[view.buffer].data.data() + view.byteOffset + accessor.byteOffset;
+
+        if (stride == element_size)
+        {
+            data.insert(data.end(), first, first + accessor.count * element_size);
+            return;
+        }
+
+        for (size_t i = 0; i < accessor.count; ++i)
+        {
+            data.insert(data.end(), first + i * stride, first + i * stride + element_size);
+        }
+    }
+
+    material_handle load_material(
         const logger& log,
         const tinygltf::Model& model,
-        const tinygltf::Mesh& mesh,
+        const int material_index,
         graphics_device& device,
-        const glm::mat4& trans,
         const std::filesystem::path& root_directory,
         const std::filesystem::path& material_path,
         const std::filesystem::path& parent_path)
     {
         auto& texture_cache = device.get_texture_cache();
 
-        const auto transform = trans;
-
-        std::vector<primitive> primitives;
-
-        for (const auto& primitive : mesh.primitives)
+        /*
+        Importing assets authored by third parties brings additional complexity - each asset may define a number of materials
+        and each may be vastly different from the last. For Moka to be able to import and render assets in a uniform, generic
+        way without requiring modifications to the asset, it must have a way to deal with shader permutations. When loading an
+        asset, materials must be attached to a shader that is written to expect those exact inputs. A naive approach would be
+        to write a simple .json file that creates a 1:1 relationship between a 3D asset and a shader, but this will not work for
+        more complicated 3D assets that define a number of complex materials. Moka will feature a simple, automatic system for
+        dealing with shader permutations. As materials are processed, a description of the material will be built, detailing the
+        inputs and their uses. Moka will hash the material description and maintain a lookup table of currently loaded shaders,
+        using the hashed value as a key. At the end of the importing process, Moka will perform a lookup to see if a shader
+        capable of rendering a material of that description exists. If a shader exists, it is used. If a shader does not, it is
+        created by using conditional compilation techniques, including all the code snippets necessary to deal with those material
+        inputs.
+        Todo: hash the shader code after adding the #defines, then use it as a key for a table of existing shaders.
+        Where should this shader table live? graphics_device is a strong contender
+        */
+
+        material_builder mat_builder(device);
+
+        mat_builder.add_material_parameter(
+            "material.diffuse_factor", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        mat_builder.add_material_parameter(
+            "material.emissive_factor", glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
+        mat_builder.add_material_parameter("material.roughness_factor", 1.0f);
+        mat_builder.add_material_parameter("material.metalness_factor", 1.0f);
+
+        std::ifstream i(material_path);
+        json j;
+        i >> j;
+
+        auto& programs = j["programs"];
+
+        for (const auto& program : programs)
         {
-            std::vector<uint8_t> index_buffer;
-            std::vector<uint8_t> vertex_buffer;
+            const auto& vertex = program["vertex"]["file"].get<std::string>();
+            const auto& fragment = program["fragment"]["file"].get<std::string>();
 
-            moka::vertex_buffer_handle vertex_handle;
-            moka::index_buffer_handle index_handle;
+            mat_builder.add_vertex_shader(root_directory / vertex);
+            mat_builder.add_fragment_shader(root_directory / fragment);
+        }
 
-            const auto& indices_accessor = model.accessors[primitive.indices];
-            const auto& indices_buffer_view = model.bufferViews[indices_accessor.bufferView];
-            const auto& indices_buffer =
-                model.buffers[indices_buffer_view.buffer].data;
+        const auto instanced = j.value("instanced", false);
 
-            std::move(
-                indices_buffer.begin() + indices_buffer_view.byteOffset +
-                    indices_accessor.byteOffset,
-                indices_buffer.begin() + indices_buffer_view.byteOffset +
-                    indices_buffer_view.byteLength,
-                std::back_inserter(index_buffer));
+        mat_builder.set_instanced(instanced);
 
-            auto indices_count = indices_accessor.count;
+        // parameters can only be set by name if the material has them, so declare the ones the scene sets
+        mat_builder.add_material_parameter("irradiance_map", texture_handle{});
+        mat_builder.add_material_parameter("prefilter_map", texture_handle{});
+        mat_builder.add_material_parameter("brdf_lut", texture_handle{});
 
-            index_type type;
+        if (!instanced)
+        {
+            mat_builder.add_material_parameter("model", glm::mat4(1.0f));
+        }
 
-            switch (indices_accessor.componentType)
+        if (material_index != -1)
+        {
+            const auto& material = model.materials[material_index];
+
+            if (!material.values.empty())
             {
-            case 5120:
-                type = index_type::int8;
-                break;
-            case 5121:
-                type = index_type::uint8;
-                break;
-            case 5122:
-                type = index_type::int16;
-                break;
-            case 5123:
-                type = index_type::uint16;
-                break;
-            case 5125:
-                type = index_type::uint32;
-                break;
-            case 5126:
-                type = index_type::float32;
-                break;
-            default:;
-            }
+                if (auto base_color_factor_itr =
+                        material.values.find("baseColorFactor");
+                    base_color_factor_itr != material.values.end())
+                {
+                    const auto& data = base_color_factor_itr->second.number_array;
+                    glm::vec4 diffuse_factor(data[0], data[1], data[2], data[3]);
+                    mat_builder.add_material_parameter(
+                        "material.diffuse_factor", diffuse_factor);
+                }
 
-            vertex_layout::builder layout_builder;
+                if (auto base_color_texture_itr =
+                        material.values.find("baseColorTexture");
+                    base_color_texture_itr != material.values.end())
+                {
+                    const auto& texture_value = base_color_texture_itr->second;
 
-            size_t vertices_count = 0;
+                    auto properties = texture_value.json_double_value;
 
-            auto get_size = [](const int type) {
-                switch (type)
+                    if (auto index_itr = properties.find("index");
+                        index_itr != properties.end())
+                    {
+                        const auto& index = index_itr->second;
+                        const auto& texture = model.textures[static_cast<size_t>(index)];
+                        const auto& texture_source = texture.source;
+                        const auto& image_data = model.images[texture_source];
+                        const auto uri = parent_path / image_data.uri;
+
+                        // a texture whose image is missing from the asset would be built from no pixels at all
+                        if (image_data.image.empty())
+                        {
+                            log.warn("Image {} could not be loaded, the material will be drawn without it", uri.string());
+                        }
+                        else if (!texture_cache.exists(uri.string()))
+                        {
+                            auto wrap_s = wrap_mode::clamp_to_edge;
+                            auto wrap_t = wrap_mode::clamp_to_edge;
+                            auto min = min_filter::linear_mipmap_linear;
+                            auto mag = mag_filter::linear;
+                            if (texture.sampler != -1)
+                            {
+                                const auto& sampler = model.samplers[texture.sampler];
+                                wrap_s = gltf_wrap_to_moka(sampler.wrapS);
+                                wrap_t = gltf_wrap_to_moka(sampler.wrapT);
+                                min = gltf_min_filter_to_moka(sampler.minFilter);
+                                mag = gltf_mag_filter_to_moka(sampler.magFilter);
+                            }
+
+                            auto diffuse_map =
+                                device.build_texture()
+                                    .add_image_data(
+                                        image_target::texture_2d,
+                                        0,
+                                        device_format::srgb8_alpha8,
+                                        image_data.width,
+                                        image_data.height,
+                                        0,
+                                        stb_to_moka(image_data.component),
+                                        pixel_type::uint8,
+                                        reinterpret_cast<const void*>(image_data.image.data()))
+                                    .set_mipmaps(true)
+                                    .set_streamed(true)
+                                    .set_wrap_s(wrap_s)
+                                    .set_wrap_t(wrap_t)
+                                    .set_min_filter(min)
+                                    .set_mag_filter(mag)
+                                    .build();
+
+                            mat_builder.add_texture(
+                                material_property::diffuse_map, diffuse_map);
+
+                            texture_cache.add_texture(diffuse_map, uri.string());
+                        }
+                        else
+                        {
+                            auto diffuse_map =
+                                texture_cache.get_texture(uri.string());
+
+                            mat_builder.add_texture(
+                                material_property::diffuse_map, diffuse_map);
+                        }
+                    }
+                }
+
+                if (auto metallic_factor_itr =
+                        material.values.find("metallicFactor");
+                    metallic_factor_itr != material.values.end())
                 {
-                case TINYGLTF_TYPE_SCALAR:
-                    return 1;
-                case TINYGLTF_TYPE_VEC2:
-                    return 2;
-                case TINYGLTF_TYPE_VEC3:
-                    return 3;
-                case TINYGLTF_TYPE_VEC4:
-                    return 4;
-                default:
-                    throw std::runtime_error("Invalid TinyGLTF type");
+                    auto& data = metallic_factor_itr->second.number_value;
+                    auto metallic_factor(static_cast<float>(data));
+                    mat_builder.add_material_parameter(
+                        "material.metalness_factor", metallic_factor);
                 }
-            };
 
-            auto tex_coordinate_0 = primitive.attributes.find("TEXCOORD_0");
-            if (tex_coordinate_0 != primitive.attributes.end())
-            {
-                const auto& vertices_accessor = model.accessors[tex_coordinate_0->second];
-                const auto& vertices_buffer_view =
-                    model.bufferViews[vertices_accessor.bufferView];
-                vertices_count = vertices_accessor.count;
-                const auto& vertices_buffer =
-                    model.buffers[vertices_buffer_view.buffer].data;
-                layout_builder.add_attribute(
-                    3,
-                    get_size(vertices_accessor.type),
-                    attribute_type::float32,
-                    vertices_accessor.normalized,
-                    0,
-                    vertex_buffer.size());
-
-                std::move(
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_accessor.byteOffset,
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_buffer_view.byteLength,
-                    std::back_inserter(vertex_buffer));
-            }
+                if (auto roughness_factor_itr =
+                        material.values.find("roughnessFactor");
+                    roughness_factor_itr != material.values.end())
+                {
+                    const auto& data = roughness_factor_itr->second.number_value;
+                    auto roughness_factor(static_cast<float>(data));
+                    mat_builder.add_material_parameter(
+                        "material.roughness_factor", roughness_factor);
+                }
 
-            // Implementation note: When tangents are not specified, client implementations should calculate tangents using default MikkTSpace algorithms.
-            // For best results, the mesh triangles should also be processed using default MikkTSpace algorithms.
-            auto tangent = primitive.attributes.find("TANGENT");
-            if (tangent != primitive.attributes.end())
-            {
-                const auto& vertices_accessor = model.accessors[tangent->second];
-                const auto& vertices_buffer_view =
-                    model.bufferViews[vertices_accessor.bufferView];
-                vertices_count = vertices_accessor.count;
-                const auto& vertices_buffer =
-                    model.buffers[vertices_buffer_view.buffer].data;
-                layout_builder.add_attribute(
-                    2,
-                    get_size(vertices_accessor.type),
-                    attribute_type::float32,
-                    vertices_accessor.normalized,
-                    0,
-                    vertex_buffer.size());
-
-                std::move(
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_accessor.byteOffset,
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_buffer_view.byteLength,
-                    std::back_inserter(vertex_buffer));
-            }
-            else
-            {
-                log.warn("Model does not have tangents. In the future, the app can use MikkTSpace to calculate tangents when none are provided.");
-            }
+                if (auto metallic_roughness_texture_itr =
+                        material.values.find("metallicRoughnessTexture");
+                    metallic_roughness_texture_itr != material.values.end())
+                {
+                    const auto& texture_value =
+                        metallic_roughness_texture_itr->second;
 
-            auto normal = primitive.attributes.find("NORMAL");
-            if (normal != primitive.attributes.end())
-            {
-                const auto& vertices_accessor = model.accessors[normal->second];
-                const auto& vertices_buffer_view =
-                    model.bufferViews[vertices_accessor.bufferView];
-                vertices_count = vertices_accessor.count;
-                const auto& vertices_buffer =
-                    model.buffers[vertices_buffer_view.buffer].data;
-                layout_builder.add_attribute(
-                    1,
-                    get_size(vertices_accessor.type),
-                    attribute_type::float32,
-                    vertices_accessor.normalized,
-                    0,
-                    vertex_buffer.size());
-
-                std::move(
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_accessor.byteOffset,
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_buffer_view.byteLength,
-                    std::back_inserter(vertex_buffer));
-            }
+                    const auto& properties = texture_value.json_double_value;
 
-            auto position = primitive.attributes.find("POSITION");
-            if (position != primitive.attributes.end())
-            {
-                const auto& vertices_accessor = model.accessors[position->second];
-                const auto& vertices_buffer_view =
-                    model.bufferViews[vertices_accessor.bufferView];
-                vertices_count = vertices_accessor.count;
-                const auto& vertices_buffer =
-                    model.buffers[vertices_buffer_view.buffer].data;
-                layout_builder.add_attribute(
-                    0,
-                    get_size(vertices_accessor.type),
-                    attribute_type::float32,
-                    vertices_accessor.normalized,
-                    0,
-                    vertex_buffer.size());
-
-                std::move(
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_accessor.byteOffset,
-                    vertices_buffer.begin() + vertices_buffer_view.byteOffset +
-                        vertices_buffer_view.byteLength,
-                    std::back_inserter(vertex_buffer));
-            }
+                    if (auto index_itr = properties.find("index");
+                        index_itr != properties.end())
+                    {
+                        const auto& index = index_itr->second;
+                        const auto& texture = model.textures[static_cast<size_t>(index)];
+                        const auto& texture_source = texture.source;
+                        const auto& image_data = model.images[texture_source];
+                        const auto uri = parent_path / image_data.uri;
+
+                        // a texture whose image is missing from the asset would be built from no pixels at all
+                        if (image_data.image.empty())
+                        {
+                            log.warn("Image {} could not be loaded, the material will be drawn without it", uri.string());
+                        }
+                        else if (!texture_cache.exists(uri.string()))
+                        {
+                            auto wrap_s = wrap_mode::clamp_to_edge;
+                            auto wrap_t = wrap_mode::clamp_to_edge;
+                            auto min = min_filter::linear_mipmap_linear;
+                            auto mag = mag_filter::linear;
+                            if (texture.sampler != -1)
+                            {
+                                const auto& sampler = model.samplers[texture.sampler];
+                                wrap_s = gltf_wrap_to_moka(sampler.wrapS);
+                                wrap_t = gltf_wrap_to_moka(sampler.wrapT);
+                                min = gltf_min_filter_to_moka(sampler.minFilter);
+                                mag = gltf_mag_filter_to_moka(sampler.magFilter);
+                            }
 
-            vertex_handle = device.make_vertex_buffer(
-                vertex_buffer.data(), vertex_buffer.size(), layout_builder.build(), buffer_usage::static_draw);
-            index_handle = device.make_index_buffer(
-                index_buffer.data(), index_buffer.size(), type, buffer_usage::static_draw);
-
-            /*
-            Importing assets authored by third parties brings additional complexity - each asset may define a number of materials
-            and each may be vastly different from the last. For Moka to be able to import and render assets in a uniform, generic
-            way without requiring modifications to the asset, it must have a way to deal with shader permutations. When loading an
-            asset, materials must be attached to a shader that is written to expect those exact inputs. A naive approach would be
-            to write a simple .json file that creates a 1:1 relationship between a 3D asset and a shader, but this will not work for
-            more complicated 3D assets that define a number of complex materials. Moka will feature a simple, automatic system for
-            dealing with shader permutations. As materials are processed, a description of the material will be built, detailing the
-            inputs and their uses. Moka will hash the material description and maintain a lookup table of currently loaded shaders,
-            using the hashed value as a key. At the end of the importing process, Moka will perform a lookup to see if a shader
-            capable of rendering a material of that description exists. If a shader exists, it is used. If a shader does not, it is
-            created by using conditional compilation techniques, including all the code snippets necessary to deal with those material
-            inputs.
-            Todo: hash the shader code after adding the #defines, then use it as a key for a table of existing shaders.
-            Where should this shader table live? graphics_device is a strong contender
-            */
-
-            material_builder mat_builder(device);
-
-            mat_builder.add_material_parameter("view_pos", glm::vec3(0.0f));
-            mat_builder.add_material_parameter(
-                "material.diffuse_factor", glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
-            mat_builder.add_material_parameter(
-                "material.emissive_factor", glm::vec4(0.0f, 0.0f, 0.0f, 0.0f));
-            mat_builder.add_material_parameter("material.roughness_factor", 1.0f);
-            mat_builder.add_material_parameter("material.metalness_factor", 1.0f);
-
-            std::ifstream i(material_path);
-            json j;
-            i >> j;
-
-            auto& programs = j["programs"];
-
-            for (const auto& program : programs)
-            {
-                const auto& vertex = program["vertex"]["file"].get<std::string>();
-                const auto& fragment = program["fragment"]["file"].get<std::string>();
+                            auto metallic_roughness_map =
+                                device.build_texture()
+                                    .add_image_data(
+                                        image_target::texture_2d,
+                                        0,
+                                        device_format::rgba,
+                                        image_data.width,
+                                        image_data.height,
+                                        0,
+                                        stb_to_moka(image_data.component),
+                                        pixel_type::uint8,
+                                        reinterpret_cast<const void*>(image_data.image.data()))
+                                    .set_mipmaps(true)
+                                    .set_streamed(true)
+                                    .set_wrap_s(wrap_s)
+                                    .set_wrap_t(wrap_t)
+                                    .set_min_filter(min)
+                                    .set_mag_filter(mag)
+                                    .build();
+
+                            mat_builder.add_texture(
+                                material_property::metallic_roughness_map,
+                                metallic_roughness_map);
+
+                            texture_cache.add_texture(
+                                metallic_roughness_map, uri.string());
+                        }
+                        else
+                        {
+                            auto metallic_roughness_map =
+                                texture_cache.get_texture(uri.string());
 
-                mat_builder.add_vertex_shader(root_directory / vertex);
-                mat_builder.add_fragment_shader(root_directory / fragment);
+                            mat_builder.add_texture(
+                                material_property::metallic_roughness_map,
+                                metallic_roughness_map);
+                        }
+                    }
+                }
             }
 
-            if (primitive.material != -1)
+            if (!material.additionalValues.empty())
             {
-                const auto& material = model.materials[primitive.material];
-
-                if (!material.values.empty())
+                if (auto name_itr = material.additionalValues.find("name");
+                    name_itr != material.additionalValues.end())
                 {
-                    if (auto base_color_factor_itr =
-                            material.values.find("baseColorFactor");
-                        base_color_factor_itr != material.values.end())
-                    {
-                        const auto& data = base_color_factor_itr->second.number_array;
-                        glm::vec4 diffuse_factor(data[0], data[1], data[2], data[3]);
-                        mat_builder.add_material_parameter(
-                            "material.diffuse_factor", diffuse_factor);
-                    }
+                }
 
-                    if (auto base_color_texture_itr =
-                            material.values.find("baseColorTexture");
-                        base_color_texture_itr != material.values.end())
-                    {
-                        const auto& texture_value = base_color_texture_itr->second;
+                if (auto normal_texture_itr = material.additionalValues.find("normalTexture");
+                    normal_texture_itr != material.additionalValues.end())
+                {
+                    const auto& texture_value = normal_texture_itr->second;
 
-                        auto properties = texture_value.json_double_value;
+                    const auto& properties = texture_value.json_double_value;
 
-                        if (auto index_itr = properties.find("index");
-                            index_itr != properties.end())
+                    if (auto index_itr = properties.find("index");
+                        index_itr != properties.end())
+                    {
+                        const auto& index = index_itr->second;
+                        const auto& texture = model.textures[static_cast<size_t>(index)];
+                        const auto& texture_source = texture.source;
+                        const auto& image_data = model.images[texture_source];
+                        const auto uri = parent_path / image_data.uri;
+
+                        // a texture whose image is missing from the asset would be built from no pixels at all
+                        if (image_data.image.empty())
                         {
-                            const auto& index = index_itr->second;
-                            const auto& texture = model.textures[static_cast<size_t>(index)];
-                            const auto& texture_source = texture.source;
-                            const auto& image_data = model.images[texture_source];
-                            const auto uri = parent_path / image_data.uri;
-
-                            if (!texture_cache.exists(uri.string()))
+                            log.warn("Image {} could not be loaded, the material will be drawn without it", uri.string());
+                        }
+                        else if (!texture_cache.exists(uri.string()))
+                        {
+                            auto wrap_s = wrap_mode::clamp_to_edge;
+                            auto wrap_t = wrap_mode::clamp_to_edge;
+                            auto min = min_filter::linear_mipmap_linear;
+                            auto mag = mag_filter::linear;
+                            if (texture.sampler != -1)
                             {
-                                auto wrap_s = wrap_mode::clamp_to_edge;
-                                auto wrap_t = wrap_mode::clamp_to_edge;
-                                auto min = min_filter::linear_mipmap_linear;
-                                auto mag = mag_filter::linear;
-                                if (texture.sampler != -1)
-                                {
-                                    const auto& sampler = model.samplers[texture.sampler];
-                                    wrap_s = gltf_wrap_to_moka(sampler.wrapS);
-                                    wrap_t = gltf_wrap_to_moka(sampler.wrapT);
-                                    min = gltf_min_filter_to_moka(sampler.minFilter);
-                                    mag = gltf_mag_filter_to_moka(sampler.magFilter);
-                                }
-
-                                auto diffuse_map =
-                                    device.build_texture()
-                                        .add_image_data(
-                                            image_target::texture_2d,
-                                            0,
-                                            device_format::srgb8_alpha8,
-                                            image_data.width,
-                                            image_data.height,
-                                            0,
-                                            stb_to_moka(image_data.component),
-                                            pixel_type::uint8,
-                                            reinterpret_cast<const void*>(image_data.image.data()))
-                                        .set_mipmaps(true)
-                                        .set_wrap_s(wrap_s)
-                                        .set_wrap_t(wrap_t)
-                                        .set_min_filter(min)
-                                        .set_mag_filter(mag)
-                                        .build();
-
-                                mat_builder.add_texture(
-                                    material_property::diffuse_map, diffuse_map);
-
-                                texture_cache.add_texture(diffuse_map, uri.string());
+                                const auto& sampler = model.samplers[texture.sampler];
+                                wrap_s = gltf_wrap_to_moka(sampler.wrapS);
+                                wrap_t = gltf_wrap_to_moka(sampler.wrapT);
+                                min = gltf_min_filter_to_moka(sampler.minFilter);
+                                mag = gltf_mag_filter_to_moka(sampler.magFilter);
                             }
-                            else
-                            {
-                                auto diffuse_map =
-                                    texture_cache.get_texture(uri.string());
 
-                                mat_builder.add_texture(
-                                    material_property::diffuse_map, diffuse_map);
-                            }
+                            auto normal_map =
+                                device.build_texture()
+                                    .add_image_data(
+                                        image_target::texture_2d,
+                                        0,
+                                        device_format::rgba,
+                                        image_data.width,
+                                        image_data.height,
+                                        0,
+                                        stb_to_moka(image_data.component),
+                                        pixel_type::uint8,
+                                        reinterpret_cast<const void*>(image_data.image.data()))
+                                    .set_mipmaps(true)
+                                    .set_streamed(true)
+                                    .set_wrap_s(wrap_s)
+                                    .set_wrap_t(wrap_t)
+                                    .set_min_filter(min)
+                                    .set_mag_filter(mag)
+                                    .build();
+
+                            mat_builder.add_texture(
+                                material_property::normal_map, normal_map);
+
+                            texture_cache.add_texture(normal_map, uri.string());
                         }
-                    }
-
-                    if (auto metallic_factor_itr =
-                            material.values.find("metallicFactor");
-                        metallic_factor_itr != material.values.end())
-                    {
-                        auto& data = metallic_factor_itr->second.number_value;
-                        auto metallic_factor(static_cast<float>(data));
-                        mat_builder.add_material_parameter(
-                            "material.metalness_factor", metallic_factor);
-                    }
+                        else
+                        {
+                            auto normal_map =
+                                texture_cache.get_texture(uri.string());
 
-                    if (auto roughness_factor_itr =
-                            material.values.find("roughnessFactor");
-                        roughness_factor_itr != material.values.end())
-                    {
-                        const auto& data = roughness_factor_itr->second.number_value;
-                        auto roughness_factor(static_cast<float>(data));
-                        mat_builder.add_material_parameter(
-                            "material.roughness_factor", roughness_factor);
+                            mat_builder.add_texture(
+                                material_property::normal_map, normal_map);
+                        }
                     }
+                }
 
-                    if (auto metallic_roughness_texture_itr =
-                            material.values.find("metallicRoughnessTexture");
-                        metallic_roughness_texture_itr != material.values.end())
-                    {
-                        const auto& texture_value =
-                            metallic_roughness_texture_itr->second;
+                if (auto occlusion_texture_itr =
+                        material.additionalValues.find("occlusionTexture");
+                    occlusion_texture_itr != material.additionalValues.end())
+                {
+                    const auto& texture_value = occlusion_texture_itr->second;
 
-                        const auto& properties = texture_value.json_double_value;
+                    const auto& properties = texture_value.json_double_value;
 
-                        if (auto index_itr = properties.find("index");
-                            index_itr != properties.end())
+                    if (auto index_itr = properties.find("index");
+                        index_itr != properties.end())
+                    {
+                        const auto& index = index_itr->second;
+                        const auto& texture = model.textures[static_cast<size_t>(index)];
+                        const auto& texture_source = texture.source;
+                        const auto& image_data = model.images[texture_source];
+                        const auto uri = parent_path / image_data.uri;
+
+                        // a texture whose image is missing from the asset would be built from no pixels at all
+                        if (image_data.image.empty())
                         {
-                            const auto& index = index_itr->second;
-                            const auto& texture = model.textures[static_cast<size_t>(index)];
-                            const auto& texture_source = texture.source;
-                            const auto& image_data = model.images[texture_source];
-                            const auto uri = parent_path / image_data.uri;
-
-                            if (!texture_cache.exists(uri.string()))
+                            log.warn("Image {} could not be loaded, the material will be drawn without it", uri.string());
+                        }
+                        else if (!texture_cache.exists(uri.string()))
+                        {
+                            auto wrap_s = wrap_mode::clamp_to_edge;
+                            auto wrap_t = wrap_mode::clamp_to_edge;
+                            auto min = min_filter::linear_mipmap_linear;
+                            auto mag = mag_filter::linear;
+                            if (texture.sampler != -1)
                             {
-                                auto wrap_s = wrap_mode::clamp_to_edge;
-                                auto wrap_t = wrap_mode::clamp_to_edge;
-                                auto min = min_filter::linear_mipmap_linear;
-                                auto mag = mag_filter::linear;
-                                if (texture.sampler != -1)
-                                {
-                                    const auto& sampler = model.samplers[texture.sampler];
-                                    wrap_s = gltf_wrap_to_moka(sampler.wrapS);
-                                    wrap_t = gltf_wrap_to_moka(sampler.wrapT);
-                                    min = gltf_min_filter_to_moka(sampler.minFilter);
-                                    mag = gltf_mag_filter_to_moka(sampler.magFilter);
-                                }
-
-                                auto metallic_roughness_map =
-                                    device.build_texture()
-                                        .add_image_data(
-                                            image_target::texture_2d,
-                                            0,
-                                            device_format::rgba,
-                                            image_data.width,
-                                            image_data.height,
-                                            0,
-                                            stb_to_moka(image_data.component),
-                                            pixel_type::uint8,
-                                            reinterpret_cast<const void*>(image_data.image.data()))
-                                        .set_mipmaps(true)
-                                        .set_wrap_s(wrap_s)
-                                        .set_wrap_t(wrap_t)
-                                        .set_min_filter(min)
-                                        .set_mag_filter(mag)
-                                        .build();
-
-                                mat_builder.add_texture(
-                                    material_property::metallic_roughness_map,
-                                    metallic_roughness_map);
-
-                                texture_cache.add_texture(
-                                    metallic_roughness_map, uri.string());
+                                const auto& sampler = model.samplers[texture.sampler];
+                                wrap_s = gltf_wrap_to_moka(sampler.wrapS);
+                                wrap_t = gltf_wrap_to_moka(sampler.wrapT);
+                                min = gltf_min_filter_to_moka(sampler.minFilter);
+                                mag = gltf_mag_filter_to_moka(sampler.magFilter);
                             }
-                            else
-                            {
-                                auto metallic_roughness_map =
-                                    texture_cache.get_texture(uri.string());
 
-                                mat_builder.add_texture(
-                                    material_property::metallic_roughness_map,
-                                    metallic_roughness_map);
-                            }
+                            auto occlusion_map =
+                                device.build_texture()
+                                    .add_image_data(
+                                        image_target::texture_2d,
+                                        0,
+                                        device_format::rgba,
+                                        image_data.width,
+                                        image_data.height,
+                                        0,
+                                        stb_to_moka(image_data.component),
+                                        pixel_type::uint8,
+                                        reinterpret_cast<const void*>(image_data.image.data()))
+                                    .set_mipmaps(true)
+                                    .set_streamed(true)
+                                    .set_wrap_s(wrap_s)
+                                    .set_wrap_t(wrap_t)
+                                    .set_min_filter(min)
+                                    .set_mag_filter(mag)
+                                    .build();
+
+                            mat_builder.add_texture(material_property::ao_map, occlusion_map);
+
+                            texture_cache.add_texture(occlusion_map, uri.string());
+                        }
+                        else
+                        {
+                            auto occlusion_map =
+                                texture_cache.get_texture(uri.string());
+
+                            mat_builder.add_texture(material_property::ao_map, occlusion_map);
                         }
                     }
                 }
 
-                if (!material.additionalValues.empty())
+                if (auto emissive_factor_itr =
+                        material.additionalValues.find("emissiveFactor");
+                    emissive_factor_itr != material.additionalValues.end())
                 {
-                    if (auto name_itr = material.additionalValues.find("name");
-                        name_itr != material.additionalValues.end())
-                    {
-                    }
+                    auto data = emissive_factor_itr->second.number_array;
+                    glm::vec4 emissive_factor(data[0], data[1], data[2], 1.0f);
+                    mat_builder.add_material_parameter(
+                        "material.emissive_factor", emissive_factor);
+                }
 
-                    if (auto normal_texture_itr = material.additionalValues.find("normalTexture");
-                        normal_texture_itr != material.additionalValues.end())
-                    {
-                        const auto& texture_value = normal_texture_itr->second;
+                if (auto emissive_texture_itr =
+                        material.additionalValues.find("emissiveTexture");
+                    emissive_texture_itr != material.additionalValues.end())
+                {
+                    const auto& texture_value = emissive_texture_itr->second;
 
-                        const auto& properties = texture_value.json_double_value;
+                    const auto& properties = texture_value.json_double_value;
 
-                        if (auto index_itr = properties.find("index");
-                            index_itr != properties.end())
+                    if (auto index_itr = properties.find("index");
+                        index_itr != properties.end())
+                    {
+                        const auto& index = index_itr->second;
+                        const auto& texture = model.textures[static_cast<size_t>(index)];
+                        const auto& texture_source = texture.source;
+                        const auto& image_data = model.images[texture_source];
+                        const auto uri = parent_path / image_data.uri;
+
+                        // a texture whose image is missing from the asset would be built from no pixels at all
+                        if (image_data.image.empty())
                         {
-                            const auto& index = index_itr->second;
-                            const auto& texture = model.textures[static_cast<size_t>(index)];
-                            const auto& texture_source = texture.source;
-                            const auto& image_data = model.images[texture_source];
-                            const auto uri = parent_path / image_data.uri;
-
-                            if (!texture_cache.exists(uri.string()))
+                            log.warn("Image {} could not be loaded, the material will be drawn without it", uri.string());
+                        }
+                        else if (!texture_cache.exists(uri.string()))
+                        {
+                            auto wrap_s = wrap_mode::clamp_to_edge;
+                            auto wrap_t = wrap_mode::clamp_to_edge;
+                            auto min = min_filter::linear_mipmap_linear;
+                            auto mag = mag_filter::linear;
+                            if (texture.sampler != -1)
                             {
-                                auto wrap_s = wrap_mode::clamp_to_edge;
-                                auto wrap_t = wrap_mode::clamp_to_edge;
-                                auto min = min_filter::linear_mipmap_linear;
-                                auto mag = mag_filter::linear;
-                                if (texture.sampler != -1)
-                                {
-                                    const auto& sampler = model.samplers[texture.sampler];
-                                    wrap_s = gltf_wrap_to_moka(sampler.wrapS);
-                                    wrap_t = gltf_wrap_to_moka(sampler.wrapT);
-                                    min = gltf_min_filter_to_moka(sampler.minFilter);
-                                    mag = gltf_mag_filter_to_moka(sampler.magFilter);
-                                }
-
-                                auto normal_map =
-                                    device.build_texture()
-                                        .add_image_data(
-                                            image_target::texture_2d,
-                                            0,
-                                            device_format::rgba,
-                                            image_data.width,
-                                            image_data.height,
-                                            0,
-                                            stb_to_moka(image_data.component),
-                                            pixel_type::uint8,
-                                            reinterpret_cast<const void*>(image_data.image.data()))
-                                        .set_mipmaps(true)
-                                        .set_wrap_s(wrap_s)
-                                        .set_wrap_t(wrap_t)
-                                        .set_min_filter(min)
-                                        .set_mag_filter(mag)
-                                        .build();
-
-                                mat_builder.add_texture(
-                                    material_property::normal_map, normal_map);
-
-                                texture_cache.add_texture(normal_map, uri.string());
+                                const auto& sampler = model.samplers[texture.sampler];
+                                wrap_s = gltf_wrap_to_moka(sampler.wrapS);
+                                wrap_t = gltf_wrap_to_moka(sampler.wrapT);
+                                min = gltf_min_filter_to_moka(sampler.minFilter);
+                                mag = gltf_mag_filter_to_moka(sampler.magFilter);
                             }
-                            else
-                            {
-                                auto normal_map =
-                                    texture_cache.get_texture(uri.string());
 
-                                mat_builder.add_texture(
-                                    material_property::normal_map, normal_map);
-                            }
+                            auto emissive_map =
+                                device.build_texture()
+                                    .add_image_data(
+                                        image_target::texture_2d,
+                                        0,
+                                        device_format::srgb8_alpha8,
+                                        image_data.width,
+                                        image_data.height,
+                                        0,
+                                        stb_to_moka(image_data.component),
+                                        pixel_type::uint8,
+                                        reinterpret_cast<const void*>(image_data.image.data()))
+                                    .set_mipmaps(true)
+                                    .set_streamed(true)
+                                    .set_wrap_s(wrap_s)
+                                    .set_wrap_t(wrap_t)
+                                    .set_min_filter(min)
+                                    .set_mag_filter(mag)
+                                    .build();
+
+                            mat_builder.add_texture(
+                                material_property::emissive_map, emissive_map);
+
+                            texture_cache.add_texture(emissive_map, uri.string());
+                        }
+                        else
+                        {
+                            auto emissive_map =
+                                texture_cache.get_texture(uri.string());
+
+                            mat_builder.add_texture(
+                                material_property::emissive_map, emissive_map);
                         }
                     }
+                }
 
-                    if (auto occlusion_texture_itr =
-                            material.additionalValues.find("occlusionTexture");
-                        occlusion_texture_itr != material.additionalValues.end())
-                    {
-                        const auto& texture_value = occlusion_texture_itr->second;
+                // The alpha cutoff value of the material.
+                auto alpha_cutoff = 0.5f;
 
-                        const auto& properties = texture_value.json_double_value;
+                if (auto alpha_cutoff_itr = material.additionalValues.find("alphaCutoff");
+                    alpha_cutoff_itr != material.additionalValues.end())
+                {
+                    auto alpha_cutoff_name = alpha_cutoff_itr->first;
+                    auto alpha_cutoff_value = alpha_cutoff_itr->second;
 
-                        if (auto index_itr = properties.find("index");
-                            index_itr != properties.end())
-                        {
-                            const auto& index = index_itr->second;
-                            const auto& texture = model.textures[static_cast<size_t>(index)];
-                            const auto& texture_source = texture.source;
-                            const auto& image_data = model.images[texture_source];
-                            const auto uri = parent_path / image_data.uri;
+                    alpha_cutoff = static_cast<float>(alpha_cutoff_value.number_value);
+                }
 
-                            if (!texture_cache.exists(uri.string()))
-                            {
-                                auto wrap_s = wrap_mode::clamp_to_edge;
-                                auto wrap_t = wrap_mode::clamp_to_edge;
-                                auto min = min_filter::linear_mipmap_linear;
-                                auto mag = mag_filter::linear;
-                                if (texture.sampler != -1)
-                                {
-                                    const auto& sampler = model.samplers[texture.sampler];
-                                    wrap_s = gltf_wrap_to_moka(sampler.wrapS);
-                                    wrap_t = gltf_wrap_to_moka(sampler.wrapT);
-                                    min = gltf_min_filter_to_moka(sampler.minFilter);
-                                    mag = gltf_mag_filter_to_moka(sampler.magFilter);
-                                }
-
-                                auto occlusion_map =
-                                    device.build_texture()
-                                        .add_image_data(
-                                            image_target::texture_2d,
-                                            0,
-                                            device_format::rgba,
-                                            image_data.width,
-                                            image_data.height,
-                                            0,
-                                            stb_to_moka(image_data.component),
-                                            pixel_type::uint8,
-                                            reinterpret_cast<const void*>(image_data.image.data()))
-                                        .set_mipmaps(true)
-                                        .set_wrap_s(wrap_s)
-                                        .set_wrap_t(wrap_t)
-                                        .set_min_filter(min)
-                                        .set_mag_filter(mag)
-                                        .build();
-
-                                mat_builder.add_texture(material_property::ao_map, occlusion_map);
-
-                                texture_cache.add_texture(occlusion_map, uri.string());
-                            }
-                            else
-                            {
-                                auto occlusion_map =
-                                    texture_cache.get_texture(uri.string());
+                auto alpha = alpha_mode::opaque;
 
-                                mat_builder.add_texture(material_property::ao_map, occlusion_map);
-                            }
-                        }
-                    }
+                if (auto alpha_mode_itr =
+                        material.additionalValues.find("alphaMode");
+                    alpha_mode_itr != material.additionalValues.end())
+                {
+                    auto alpha_mode_name = alpha_mode_itr->first;
+                    auto alpha_mode_value = alpha_mode_itr->second;
+
+                    auto alpha_str = alpha_mode_value.string_value;
 
-                    if (auto emissive_factor_itr =
-                            material.additionalValues.find("emissiveFactor");
-                        emissive_factor_itr != material.additionalValues.end())
+                    if (alpha_str == "OPAQUE")
                     {
-                        auto data = emissive_factor_itr->second.number_array;
-                        glm::vec4 emissive_factor(data[0], data[1], data[2], 1.0f);
+                        alpha = alpha_mode::opaque;
+                    }
+                    else if (alpha_str == "MASK")
+                    {
+                        alpha = alpha_mode::mask;
                         mat_builder.add_material_parameter(
-                            "material.emissive_factor", emissive_factor);
+                            "material.alpha_cutoff", alpha_cutoff);
+                        mat_builder.set_blend_enabled(true);
                     }
-
-                    if (auto emissive_texture_itr =
-                            material.additionalValues.find("emissiveTexture");
-                        emissive_texture_itr != material.additionalValues.end())
+                    else if (alpha_str == "BLEND")
                     {
-                        const auto& texture_value = emissive_texture_itr->second;
+                        alpha = alpha_mode::blend;
+                        mat_builder.set_blend_enabled(true);
+                    }
+                }
 
-                        const auto& properties = texture_value.json_double_value;
+                mat_builder.set_alpha_mode(alpha);
+            }
+        }
 
-                        if (auto index_itr = properties.find("index");
-                            index_itr != properties.end())
-                        {
-                            const auto& index = index_itr->second;
-                            const auto& texture = model.textures[static_cast<size_t>(index)];
-                            const auto& texture_source = texture.source;
-                            const auto& image_data = model.images[texture_source];
-                            const auto uri = parent_path / image_data.uri;
+        return mat_builder.build();
+    }
 
-                            if (!texture_cache.exists(uri.string()))
-                            {
-                                auto wrap_s = wrap_mode::clamp_to_edge;
-                                auto wrap_t = wrap_mode::clamp_to_edge;
-                                auto min = min_filter::linear_mipmap_linear;
-                                auto mag = mag_filter::linear;
-                                if (texture.sampler != -1)
-                                {
-                                    const auto& sampler = model.samplers[texture.sampler];
-                                    wrap_s = gltf_wrap_to_moka(sampler.wrapS);
-                                    wrap_t = gltf_wrap_to_moka(sampler.wrapT);
-                                    min = gltf_min_filter_to_moka(sampler.minFilter);
-                                    mag = gltf_mag_filter_to_moka(sampler.magFilter);
-                                }
-
-                                auto emissive_map =
-                                    device.build_texture()
-                                        .add_image_data(
-                                            image_target::texture_2d,
-                                            0,
-                                            device_format::srgb8_alpha8,
-                                            image_data.width,
-                                            image_data.height,
-                                            0,
-                                            stb_to_moka(image_data.component),
-                                            pixel_type::uint8,
-                                            reinterpret_cast<const void*>(image_data.image.data()))
-                                        .set_mipmaps(true)
-                                        .set_wrap_s(wrap_s)
-                                        .set_wrap_t(wrap_t)
-                                        .set_min_filter(min)
-                                        .set_mag_filter(mag)
-                                        .build();
-
-                                mat_builder.add_texture(
-                                    material_property::emissive_map, emissive_map);
-
-                                texture_cache.add_texture(emissive_map, uri.string());
-                            }
-                            else
-                            {
-                                auto emissive_map =
-                                    texture_cache.get_texture(uri.string());
+    void load_mesh(
+        const logger& log,
+        const tinygltf::Model& model,
+        const tinygltf::Mesh& mesh,
+        graphics_device& device,
+        const glm::mat4& trans,
+        const std::filesystem::path& root_directory,
+        const std::filesystem::path& material_path,
+        const std::filesystem::path& parent_path,
+        model_import& import)
+    {
+        auto get_size = [](const int type) -> size_t {
+            switch (type)
+            {
+            case TINYGLTF_TYPE_SCALAR:
+                return 1;
+            case TINYGLTF_TYPE_VEC2:
+                return 2;
+            case TINYGLTF_TYPE_VEC3:
+                return 3;
+            case TINYGLTF_TYPE_VEC4:
+                return 4;
+            default:
+                throw std::runtime_error("Invalid TinyGLTF type");
+            }
+        };
 
-                                mat_builder.add_texture(
-                                    material_property::emissive_map, emissive_map);
-                            }
-                        }
-                    }
+        // attributes are read as floats, and each is given a block of the vertex buffer in this order
+        constexpr std::pair<const char*, size_t> semantics[] = {{"TEXCOORD_0", 3}, {"TANGENT", 2}, {"NORMAL", 1}, {"POSITION", 0}};
 
-                    // The alpha cutoff value of the material.
-                    auto alpha_cutoff = 0.5f;
+        packed_mesh result{{}, trans};
 
-                    if (auto alpha_cutoff_itr = material.additionalValues.find("alphaCutoff");
-                        alpha_cutoff_itr != material.additionalValues.end())
-                    {
-                        auto alpha_cutoff_name = alpha_cutoff_itr->first;
-                        auto alpha_cutoff_value = alpha_cutoff_itr->second;
+        for (const auto& primitive : mesh.primitives)
+        {
+            if (primitive.indices == -1)
+            {
+                log.warn("Primitives without indices are not supported, skipping primitive");
+                continue;
+            }
 
-                        alpha_cutoff = static_cast<float>(alpha_cutoff_value.number_value);
-                    }
+            const auto& indices_accessor = model.accessors[primitive.indices];
 
-                    auto alpha = alpha_mode::opaque;
+            index_type type;
 
-                    if (auto alpha_mode_itr =
-                            material.additionalValues.find("alphaMode");
-                        alpha_mode_itr != material.additionalValues.end())
-                    {
-                        auto alpha_mode_name = alpha_mode_itr->first;
-                        auto alpha_mode_value = alpha_mode_itr->second;
+            switch (indices_accessor.componentType)
+            {
+            case 5120:
+                type = index_type::int8;
+                break;
+            case 5121:
+                type = index_type::uint8;
+                break;
+            case 5122:
+                type = index_type::int16;
+                break;
+            case 5123:
+                type = index_type::uint16;
+                break;
+            case 5125:
+                type = index_type::uint32;
+                break;
+            case 5126:
+                type = index_type::float32;
+                break;
+            default:;
+            }
 
-                        auto alpha_str = alpha_mode_value.string_value;
+            std::vector<std::pair<const tinygltf::Accessor*, size_t>> attributes;
 
-                        if (alpha_str == "OPAQUE")
-                        {
-                            alpha = alpha_mode::opaque;
-                        }
-                        else if (alpha_str == "MASK")
-                        {
-                            alpha = alpha_mode::mask;
-                            mat_builder.add_material_parameter(
-                                "material.alpha_cutoff", alpha_cutoff);
-                            mat_builder.set_blend_enabled(true);
-                        }
-                        else if (alpha_str == "BLEND")
-                        {
-                            alpha = alpha_mode::blend;
-                            mat_builder.set_blend_enabled(true);
-                        }
-                    }
+            for (const auto& [semantic, index] : semantics)
+            {
+                if (auto attribute = primitive.attributes.find(semantic); attribute != primitive.attributes.end())
+                {
+                    attributes.emplace_back(&model.accessors[attribute->second], index);
+                }
+                // Implementation note: When tangents are not specified, client implementations should calculate tangents using default MikkTSpace algorithms.
+                // For best results, the mesh triangles should also be processed using default MikkTSpace algorithms.
+                else if (index == 2)
+                {
+                    log.warn("Model does not have tangents. In the future, the app can use MikkTSpace to calculate tangents when none are provided.");
+                }
+            }
+
+            if (attributes.empty())
+            {
+                log.warn("Primitive has no attributes, skipping primitive");
+                continue;
+            }
+
+            const auto vertices_count = attributes.back().first->count;
+
+            const auto readable = can_read(model, indices_accessor, index_size(type)) &&
+                                  std::all_of(attributes.begin(), attributes.end(), [&](const auto& attribute) {
+                                      const auto& accessor = *attribute.first;
+                                      return accessor.count == vertices_count &&
+                                             can_read(model, accessor, get_size(accessor.type) * sizeof(float));
+                                  });
+
+            if (!readable)
+            {
+                log.error("Primitive reads outside of its buffers, skipping primitive");
+                continue;
+            }
+
+            // primitives with the same attributes & index type share their buffers, each drawn from a base vertex
+            auto geometry = std::find_if(import.geometry.begin(), import.geometry.end(), [&](const packed_geometry& geometry) {
+                return geometry.type == type &&
+                       std::equal(
+                           geometry.attributes.begin(),
+                           geometry.attributes.end(),
+                           attributes.begin(),
+                           attributes.end(),
+                           [&](const packed_geometry::attribute& lhs, const auto& rhs) {
+                               return lhs.index == rhs.second && lhs.size == get_size(rhs.first->type) &&
+                                      lhs.normalized == rhs.first->normalized;
+                           });
+            });
+
+            if (geometry == import.geometry.end())
+            {
+                geometry = import.geometry.emplace(import.geometry.end());
+                geometry->type = type;
 
-                    mat_builder.set_alpha_mode(alpha);
+                for (const auto& [accessor, index] : attributes)
+                {
+                    geometry->attributes.push_back({index, get_size(accessor->type), accessor->normalized, {}});
                 }
             }
 
-            index_buffer.clear();
-            vertex_buffer.clear();
-
-            primitives.emplace_back(
-                vertex_handle,
-                vertices_count,
-                index_handle,
-                type,
-                indices_count,
-                0,
-                mat_builder.build());
+            packed_primitive packed;
+            packed.geometry = static_cast<size_t>(geometry - import.geometry.begin());
+            packed.base_vertex = static_cast<int32_t>(geometry->vertex_count);
+            packed.vertex_count = static_cast<uint32_t>(vertices_count);
+            packed.index_offset = static_cast<uint32_t>(geometry->indices.size());
+            packed.index_count = static_cast<uint32_t>(indices_accessor.count);
+            packed.type = type;
+
+            for (size_t i = 0; i < attributes.size(); ++i)
+            {
+                auto& attribute = geometry->attributes[i];
+                append(model, *attributes[i].first, attribute.size * sizeof(float), attribute.data);
+            }
+
+            append(model, indices_accessor, index_size(type), geometry->indices);
+
+            geometry->vertex_count += packed.vertex_count;
+
+            // primitives that share a glTF material share its material, so their draws bind the same state
+            auto material = import.materials.find(primitive.material);
+
+            if (material == import.materials.end())
+            {
+                material = import.materials
+                               .emplace(
+                                   primitive.material,
+                                   load_material(log, model, primitive.material, device, root_directory, material_path, parent_path))
+                               .first;
+            }
+
+            packed.material = material->second;
+
+            result.primitives.emplace_back(packed);
         }
 
-        return moka::mesh{std::move(primitives), transform::from_matrix(transform)};
+        import.meshes.emplace_back(std::move(result));
     }
 
     glm::mat4 get_transform(const tinygltf::Node& n)
@@ -912,7 +1016,7 @@ namespace moka
     void add_node(
         const logger& log,
         const glm::mat4& parent_transform,
-        std::vector<mesh>& meshes,
+        model_import& import,
         const int node_id,
         const tinygltf::Model& model,
         graphics_device& device,
@@ -930,11 +1034,10 @@ namespace moka
 
         for (const auto i : model.nodes[node_id].children)
         {
-            add_node(log, worldTransform, meshes, i, model, device, root_directory, material_path, parent_path);
+            add_node(log, worldTransform, import, i, model, device, root_directory, material_path, parent_path);
         }
 
-        meshes.emplace_back(load_mesh(log,
-            model, model.meshes[mesh_id], device, worldTransform, root_directory, material_path, parent_path));
+        load_mesh(log, model, model.meshes[mesh_id], device, worldTransform, root_directory, material_path, parent_path, import);
     }
 
     model load_model(
@@ -945,7 +1048,7 @@ namespace moka
         const std::filesystem::path& material_path,
         const std::filesystem::path& parent_path)
     {
-        std::vector<mesh> meshes;
+        model_import import;
 
         for (const auto& scene : model.scenes)
         {
@@ -964,20 +1067,67 @@ namespace moka
 
                     for (const auto i : model.nodes[node].children)
                     {
-                        add_node(log, trans, meshes, i, model, device, root_directory, material_path, parent_path);
+                        add_node(log, trans, import, i, model, device, root_directory, material_path, parent_path);
                     }
 
-                    meshes.emplace_back(load_mesh(log,
-                        model, model.meshes[mesh_id], device, trans, root_directory, material_path, parent_path));
+                    load_mesh(log, model, model.meshes[mesh_id], device, trans, root_directory, material_path, parent_path, import);
                 }
 
                 for (const auto i : model.nodes[node].children)
                 {
-                    add_node(log, transform, meshes, i, model, device, root_directory, material_path, parent_path);
+                    add_node(log, transform, import, i, model, device, root_directory, material_path, parent_path);
                 }
             }
         }
 
+        // every attribute of a packed vertex buffer is a block of its own, as the layout has always been declared
+        std::vector<std::pair<vertex_buffer_handle, index_buffer_handle>> buffers;
+
+        for (const auto& geometry : import.geometry)
+        {
+            vertex_layout::builder layout_builder;
+
+            std::vector<uint8_t> vertex_buffer;
+
+            for (const auto& attribute : geometry.attributes)
+            {
+                layout_builder.add_attribute(
+                    attribute.index, attribute.size, attribute_type::float32, attribute.normalized, 0, vertex_buffer.size());
+
+                vertex_buffer.insert(vertex_buffer.end(), attribute.data.begin(), attribute.data.end());
+            }
+
+            buffers.emplace_back(
+                device.make_vertex_buffer(
+                    vertex_buffer.data(), vertex_buffer.size(), layout_builder.build(), buffer_usage::static_draw),
+                device.make_index_buffer(
+                    geometry.indices.data(), geometry.indices.size(), geometry.type, buffer_usage::static_draw));
+        }
+
+        std::vector<mesh> meshes;
+
+        for (const auto& packed : import.meshes)
+        {
+            std::vector<primitive> primitives;
+
+            for (const auto& primitive : packed.primitives)
+            {
+                const auto& [vertex_handle, index_handle] = buffers[primitive.geometry];
+
+                primitives.emplace_back(
+                    vertex_handle,
+                    primitive.vertex_count,
+                    index_handle,
+                    primitive.type,
+                    primitive.index_count,
+                    primitive.index_offset,
+                    primitive.material,
+                    primitive.base_vertex);
+            }
+
+            meshes.emplace_back(std::move(primitives), transform::from_matrix(packed.transform));
+        }
+
         return moka::model{std::move(meshes)};
     }
 
@@ -0,0 +1,140 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <graphics/api/draw_batch.hpp>
+#include <graphics/device/graphics_device.hpp>
+
+namespace moka
+{
+    namespace
+    {
+        bool same_state(const material& lhs, const material& rhs)
+        {
+            if (lhs.get_program() != rhs.get_program() || lhs.get_pipeline_state().id != rhs.get_pipeline_state().id ||
+                lhs.size() != rhs.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < lhs.size(); ++i)
+            {
+                if (lhs[i].type != rhs[i].type || lhs[i].count != rhs[i].count || !(lhs[i].data == rhs[i].data))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    } // namespace
+
+    bool draw_batch::accepts(const draw_command& cmd, const material_cache& materials) const
+    {
+        if (draws_.empty())
+        {
+            return true;
+        }
+
+        const auto& first = draws_.front();
+
+        // the draws of a run are issued through one vertex array
+        if (!first.is_indexed() || !cmd.is_indexed() || first.vertex_buffer != cmd.vertex_buffer ||
+            first.index_buffer != cmd.index_buffer || first.instance_buffer != cmd.instance_buffer ||
+            first.streamed != cmd.streamed || first.idx_type != cmd.idx_type || first.prim_type != cmd.prim_type)
+        {
+            return false;
+        }
+
+        if (material_changed_)
+        {
+            return false;
+        }
+
+        if (first.material.id == cmd.material.id)
+        {
+            return true;
+        }
+
+        const auto* lhs = materials.get_material(first.material);
+        const auto* rhs = materials.get_material(cmd.material);
+
+        return lhs && rhs && same_state(*lhs, *rhs);
+    }
+
+    void draw_batch::add(const draw_command& cmd)
+    {
+        draws_.emplace_back(cmd);
+    }
+
+    void draw_batch::write_parameters(set_material_parameters_command& cmd, const material& material)
+    {
+        if (draws_.empty() || material_changed_ || draws_.front().material.id != cmd.material.id)
+        {
+            return;
+        }
+
+        cmd.for_each_parameter([this, &material](const material_parameter_record& record) {
+            if (record.index < material.size() && !(material[record.index].data == record.get_data()))
+            {
+                material_changed_ = true;
+            }
+        });
+    }
+
+    void draw_batch::clear()
+    {
+        draws_.clear();
+        material_changed_ = false;
+    }
+
+    bool draw_batch::empty() const
+    {
+        return draws_.empty();
+    }
+
+    size_t draw_batch::size() const
+    {
+        return draws_.size();
+    }
+
+    const draw_command& draw_batch::front() const
+    {
+        return draws_.front();
+    }
+
+    draw_batch::const_iterator draw_batch::begin() const
+    {
+        return draws_.begin();
+    }
+
+    draw_batch::const_iterator draw_batch::end() const
+    {
+        return draws_.end();
+    }
+} // namespace moka
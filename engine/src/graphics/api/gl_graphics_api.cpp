@@ -28,23 +28,31 @@ SOFTWARE.
 ===========================================================================
 */
 
+#include <algorithm>
 #include <application/logger.hpp>
 #include <application/window.hpp>
+#include <cstring>
 #include <filesystem>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <graphics/api/gl_graphics_api.hpp>
 #include <graphics/buffer/vertex_layout.hpp>
 #include <graphics/command/clear_command.hpp>
+#include <graphics/command/command_bundle.hpp>
 #include <graphics/command/command_list.hpp>
 #include <graphics/command/draw_command.hpp>
 #include <graphics/command/fill_index_buffer_command.hpp>
+#include <graphics/command/fill_stream_buffer_command.hpp>
+#include <graphics/command/fill_uniform_buffer_command.hpp>
 #include <graphics/command/fill_vertex_buffer_command.hpp>
+#include <graphics/command/gpu_timer_command.hpp>
+#include <graphics/command/read_pixels_command.hpp>
 #include <graphics/command/scissor_command.hpp>
 #include <graphics/command/set_material_properties_command.hpp>
 #include <graphics/command/viewport_command.hpp>
 #include <graphics/material/material.hpp>
 #include <string>
+#include <utility>
 
 namespace moka
 {
@@ -404,6 +412,8 @@ namespace moka
 
     void gl_graphics_api::visit(clear_command& cmd)
     {
+        flush_draws();
+
         uint32_t bitmask = 0;
 
         if (cmd.clear_color)
@@ -428,6 +438,8 @@ namespace moka
 
     void gl_graphics_api::visit(viewport_command& cmd)
     {
+        flush_draws();
+
         glViewport(cmd.x, cmd.y, cmd.width, cmd.height);
 
         if constexpr (application_traits::is_debug_build)
@@ -438,6 +450,8 @@ namespace moka
 
     void gl_graphics_api::visit(scissor_command& cmd)
     {
+        flush_draws();
+
         glScissor(cmd.x, cmd.y, cmd.width, cmd.height);
 
         if constexpr (application_traits::is_debug_build)
@@ -448,14 +462,20 @@ namespace moka
 
     void gl_graphics_api::visit(fill_vertex_buffer_command& cmd)
     {
-        const GLuint handle(cmd.handle.id);
+        flush_draws();
+
+        auto* buffer = find(vertex_buffers_, cmd.handle, "visit fill_vertex_buffer_command");
+
+        if (!buffer)
+        {
+            return;
+        }
 
-        auto& data = vertex_buffer_data_[cmd.handle.id];
+        auto& data = buffer->metadata;
         data.size = cmd.size;
 
-        glBindBuffer(GL_ARRAY_BUFFER, handle);
+        state_.bind_buffer(GL_ARRAY_BUFFER, buffer->name);
         glBufferData(GL_ARRAY_BUFFER, cmd.size, cmd.data, moka_to_gl(data.buffer_use));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         if constexpr (application_traits::is_debug_build)
         {
@@ -465,22 +485,77 @@ namespace moka
 
     void gl_graphics_api::visit(fill_index_buffer_command& cmd)
     {
-        const GLuint handle(cmd.handle.id);
+        flush_draws();
 
-        auto& data = index_buffer_data_[cmd.handle.id];
+        auto* buffer = find(index_buffers_, cmd.handle, "visit fill_index_buffer_command");
+
+        if (!buffer)
+        {
+            return;
+        }
+
+        auto& data = buffer->metadata;
         data.size = cmd.size;
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
+        // the element array binding belongs to the bound vertex array, so upload through one that no draw uses
+        state_.bind_vertex_array(vao_);
+        state_.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer->name);
         glBufferData(GL_ELEMENT_ARRAY_BUFFER, cmd.size, cmd.data, moka_to_gl(data.buffer_use));
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-
         if constexpr (application_traits::is_debug_build)
         {
             check_errors("visit fill_index_buffer_command");
         }
     }
 
+    void gl_graphics_api::visit(fill_uniform_buffer_command& cmd)
+    {
+        flush_draws();
+
+        const auto* buffer = find(uniform_buffers_, cmd.handle, "visit fill_uniform_buffer_command");
+
+        if (!buffer)
+        {
+            return;
+        }
+
+        // binding to the block's binding point also binds GL_UNIFORM_BUFFER, which the upload goes through
+        glBindBufferBase(GL_UNIFORM_BUFFER, static_cast<GLuint>(buffer->metadata), buffer->name);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, cmd.size, cmd.data);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("visit fill_uniform_buffer_command");
+        }
+    }
+
+    void gl_graphics_api::visit(fill_stream_buffer_command& cmd)
+    {
+        flush_draws();
+
+        if (!cmd.range.is_valid())
+        {
+            return;
+        }
+
+        const auto offset = get_stream_base() + cmd.range.offset;
+
+        // the device finished reading this frame's part of the buffer before the frame started, so write straight into it
+        if (stream_memory_)
+        {
+            std::memcpy(stream_memory_ + offset, cmd.data, cmd.range.size);
+            return;
+        }
+
+        state_.bind_buffer(GL_ARRAY_BUFFER, stream_buffer_);
+        glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(offset), cmd.range.size, cmd.data);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("visit fill_stream_buffer_command");
+        }
+    }
+
     void gl_graphics_api::check_errors(const char* caller)
     {
         // check OpenGL error
@@ -490,9 +565,156 @@ namespace moka
         }
     }
 
+    void gl_graphics_api::visit(gpu_timer_command& cmd)
+    {
+        // draws held back for batching belong inside the scope they were recorded in
+        flush_draws();
+
+        if (cmd.event == gpu_timer_event::begin)
+        {
+            gpu_timer_queries scope;
+            scope.name = cmd.name.data();
+            scope.depth = open_timer_scopes_.size();
+            scope.begin = make_timer_query();
+
+            // timestamps, unlike GL_TIME_ELAPSED queries, can be nested
+            glQueryCounter(scope.begin, GL_TIMESTAMP);
+
+            open_timer_scopes_.emplace_back(timer_scopes_.size());
+            timer_scopes_.emplace_back(std::move(scope));
+        }
+        else
+        {
+            if (open_timer_scopes_.empty())
+            {
+                log_.error("gpu_timer_command closed a scope, but no scope is open");
+                return;
+            }
+
+            auto& scope = timer_scopes_[open_timer_scopes_.back()];
+            open_timer_scopes_.pop_back();
+
+            scope.end = make_timer_query();
+            glQueryCounter(scope.end, GL_TIMESTAMP);
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("visit gpu_timer_command");
+        }
+    }
+
+    GLuint gl_graphics_api::make_timer_query()
+    {
+        if (free_timer_queries_.empty())
+        {
+            GLuint query;
+            glGenQueries(1, &query);
+            return query;
+        }
+
+        const auto query = free_timer_queries_.back();
+        free_timer_queries_.pop_back();
+        return query;
+    }
+
+    void gl_graphics_api::resolve_gpu_timers()
+    {
+        while (!open_timer_scopes_.empty())
+        {
+            auto& scope = timer_scopes_[open_timer_scopes_.back()];
+            open_timer_scopes_.pop_back();
+
+            log_.warn("GPU timer scope {} was still open at the end of the frame", scope.name);
+
+            scope.end = make_timer_query();
+            glQueryCounter(scope.end, GL_TIMESTAMP);
+        }
+
+        if (!timer_scopes_.empty())
+        {
+            pending_timer_frames_.emplace_back(std::move(timer_scopes_));
+            timer_scopes_.clear();
+        }
+
+        const auto release = [this](const std::vector<gpu_timer_queries>& scopes) {
+            for (const auto& scope : scopes)
+            {
+                free_timer_queries_.emplace_back(scope.begin);
+                free_timer_queries_.emplace_back(scope.end);
+            }
+        };
+
+        // dropping a frame whose results haven't arrived is cheaper than stalling to read them
+        while (pending_timer_frames_.size() > max_pending_timer_frames)
+        {
+            release(pending_timer_frames_.front());
+            pending_timer_frames_.pop_front();
+        }
+
+        gpu_timers_.clear();
+
+        while (!pending_timer_frames_.empty())
+        {
+            const auto& scopes = pending_timer_frames_.front();
+
+            // frames finish in order, so the first frame that isn't available ends the search
+            const auto available = std::all_of(scopes.begin(), scopes.end(), [](const gpu_timer_queries& scope) {
+                GLint result = GL_FALSE;
+                glGetQueryObjectiv(scope.end, GL_QUERY_RESULT_AVAILABLE, &result);
+                return result == GL_TRUE;
+            });
+
+            if (!available)
+            {
+                break;
+            }
+
+            gpu_timers_.clear();
+
+            for (const auto& scope : scopes)
+            {
+                GLuint64 begin = 0;
+                GLuint64 end = 0;
+                glGetQueryObjectui64v(scope.begin, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(scope.end, GL_QUERY_RESULT, &end);
+
+                gpu_timer_result result;
+                result.name = scope.name;
+                result.depth = scope.depth;
+                result.milliseconds = static_cast<double>(end - begin) / 1000000.0;
+                gpu_timers_.emplace_back(std::move(result));
+            }
+
+            release(scopes);
+            pending_timer_frames_.pop_front();
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("resolve_gpu_timers");
+        }
+    }
+
     void gl_graphics_api::visit(frame_buffer_command& cmd)
     {
-        glBindFramebuffer(GL_FRAMEBUFFER, GLuint{cmd.buffer.id});
+        flush_draws();
+
+        GLuint name = default_frame_buffer_;
+
+        if (cmd.buffer.id != 0)
+        {
+            const auto* buffer = find(frame_buffers_, cmd.buffer, "visit frame_buffer_command");
+
+            if (!buffer)
+            {
+                return;
+            }
+
+            name = buffer->name;
+        }
+
+        state_.bind_frame_buffer(name);
 
         if constexpr (application_traits::is_debug_build)
         {
@@ -502,11 +724,22 @@ namespace moka
 
     void gl_graphics_api::visit(frame_buffer_texture_command& cmd)
     {
+        flush_draws();
+
+        finish_texture_upload(cmd.texture);
+
+        const auto* texture = find(textures_, cmd.texture, "visit frame_buffer_texture_command");
+
+        if (!texture)
+        {
+            return;
+        }
+
         glFramebufferTexture2D(
             GL_FRAMEBUFFER,
             moka_to_gl(cmd.attachment),
             moka_to_gl(cmd.target),
-            GLuint{cmd.texture.id},
+            texture->name,
             cmd.level);
 
         if constexpr (application_traits::is_debug_build)
@@ -517,7 +750,18 @@ namespace moka
 
     void gl_graphics_api::visit(generate_mipmaps_command& cmd)
     {
-        glBindTexture(GL_TEXTURE_CUBE_MAP, cmd.texture.id);
+        flush_draws();
+
+        finish_texture_upload(cmd.texture);
+
+        const auto* texture = find(textures_, cmd.texture, "visit generate_mipmaps_command");
+
+        if (!texture)
+        {
+            return;
+        }
+
+        state_.bind_texture(0, GL_TEXTURE_CUBE_MAP, texture->name);
         glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
         if constexpr (application_traits::is_debug_build)
@@ -534,97 +778,107 @@ namespace moka
 
         if (material)
         {
-            for (const auto& parameter : cmd.parameters)
-            {
-                (*material)[parameter.name] = parameter;
-            }
+            // the pending draws were bound with the values they need, so a write only keeps later draws out of their run
+            draw_batch_.write_parameters(cmd, *material);
+
+            cmd.for_each_parameter([material](const material_parameter_record& record) {
+                if (record.index < material->size())
+                {
+                    auto& parameter = (*material)[record.index];
+                    parameter.type = record.type;
+                    parameter.data = record.get_data();
+                    parameter.count = 1;
+                }
+            });
         }
     }
 
     void gl_graphics_api::visit(draw_command& cmd)
     {
         // early exit if a bogus vertex buffer is given to us
-        if (cmd.vertex_buffer.id == std::numeric_limits<uint16_t>::max())
+        if (cmd.vertex_buffer.id == std::numeric_limits<uint32_t>::max())
         {
             return;
         }
 
-        const auto indexed = cmd.index_buffer.id != std::numeric_limits<uint16_t>::max();
+        // vertex arrays are cached by slot, so a stale handle must never reach the cache and poison the slot's next owner
+        const auto is_stale = [](const auto& pool, const auto handle) {
+            return handle.id != std::numeric_limits<uint32_t>::max() && !pool.get(handle);
+        };
 
-        glBindBuffer(GL_ARRAY_BUFFER, cmd.vertex_buffer.id);
-
-        if (indexed)
+        if (is_stale(vertex_buffers_, cmd.vertex_buffer) || is_stale(vertex_buffers_, cmd.instance_buffer) ||
+            (!cmd.streamed && is_stale(index_buffers_, cmd.index_buffer)))
         {
-            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cmd.index_buffer.id);
+            log_.error("Invalid or stale buffer handle passed to visit draw_command");
+            return;
         }
 
-        // update the current vertex layout to match the vertices we're about to render
-        auto& layout = vertex_buffer_data_[cmd.vertex_buffer.id].layout;
-
-        for (const auto& attribute : layout)
+        // the draw is held back until a draw that can't share its state arrives, so a run can go out as one multi-draw
+        if (!draw_batch_.accepts(cmd, device_.get_material_cache()))
         {
-            glVertexAttribPointer(
-                static_cast<GLuint>(attribute.index),
-                static_cast<GLint>(attribute.size),
-                moka_to_gl(attribute.type),
-                attribute.normalized,
-                static_cast<GLsizei>(attribute.stride),
-                reinterpret_cast<void*>(attribute.offset));
+            flush_draws();
+        }
 
-            glEnableVertexAttribArray(static_cast<GLuint>(attribute.index));
+        if (draw_batch_.empty())
+        {
+            begin_batch(cmd);
         }
 
-        glEnableVertexAttribArray(0);
+        draw_batch_.add(cmd);
+    }
 
-        auto& material_handle = cmd.material;
-        auto& previous_handle = previous_command_.material;
+    void gl_graphics_api::begin_batch(const draw_command& cmd)
+    {
+        // every draw in the batch shares the first draw's vertex array and material
+        state_.bind_vertex_array(
+            cmd.streamed ? get_stream_vertex_array(cmd.vertex_buffer, cmd.instance_buffer)
+                         : get_vertex_array(cmd.vertex_buffer, cmd.index_buffer, cmd.instance_buffer));
 
         auto& material_cache = device_.get_material_cache();
-        auto* material = material_cache.get_material(material_handle);
-        auto* previous = material_cache.get_material(previous_handle);
+        auto* material = material_cache.get_material(cmd.material);
 
         if (material)
         {
-            if (previous)
-            {
-                // if this is a different shader, update the program state
-                if (material->get_program().id != previous->get_program().id)
-                {
-                    glUseProgram(material->get_program().id);
-                }
-            }
-            else
+            auto* program = programs_.get(material->get_program());
+
+            if (program)
             {
-                glUseProgram(material->get_program().id);
+                resolve_program(*program);
             }
 
-            auto& blend = material->get_blend();
-            blend.enabled ? glEnable(GL_BLEND) : glDisable(GL_BLEND);
-            glBlendEquation(moka_to_gl(blend.equation));
-            glBlendFunc(moka_to_gl(blend.source), moka_to_gl(blend.destination));
+            state_.use_program(program ? program->name : 0);
 
-            auto& polygon_mode = material->get_polygon_mode();
-            glPolygonMode(
-                moka_to_gl(polygon_mode.faces), moka_to_gl(polygon_mode.mode));
+            // materials that share a pipeline state share its id, so one comparison covers all fixed-function state
+            const auto pipeline_state = material->get_pipeline_state();
 
-            auto& culling = material->get_culling();
-            culling.enabled ? glEnable(GL_CULL_FACE) : glDisable(GL_CULL_FACE);
-            glCullFace(moka_to_gl(culling.faces));
-
-            material->get_depth_test() ? glEnable(GL_DEPTH_TEST) : glDisable(GL_DEPTH_TEST);
-            material->get_scissor_test() ? glEnable(GL_SCISSOR_TEST)
-                                         : glDisable(GL_SCISSOR_TEST);
+            if (pipeline_state.id != pipeline_state_)
+            {
+                apply(device_.get_pipeline_state_cache().get_pipeline_state(pipeline_state));
+                pipeline_state_ = pipeline_state.id;
+            }
 
             const auto size = material->size();
 
+            auto& locations = material->get_uniform_locations();
+
             size_t current_texture_unit = 0;
 
             for (size_t i = 0; i < size; i++)
             {
                 auto& parameter = (*material)[i];
 
-                const auto location = glGetUniformLocation(
-                    static_cast<GLuint>(material->get_program().id), parameter.name.c_str());
+                // parameters are bound to their uniforms the first time they're drawn, so each is only reported once
+                if (locations.size() <= i)
+                {
+                    locations.emplace_back(find_uniform(material->get_program(), parameter.name));
+
+                    if (locations.back() == -1)
+                    {
+                        warn_unused_parameter(*material, parameter.name);
+                    }
+                }
+
+                const auto location = locations[i];
 
                 if (location == -1)
                     continue;
@@ -635,11 +889,19 @@ namespace moka
                 {
                     const auto data = std::get<texture_handle>(parameter.data);
                     glUniform1i(location, static_cast<GLint>(current_texture_unit));
-                    glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(current_texture_unit));
 
-                    auto& meta_data = texture_data_[data.id];
+                    const auto* texture = textures_.get(data);
 
-                    glBindTexture(moka_to_gl(meta_data.target), static_cast<GLuint>(data.id));
+                    if (texture)
+                    {
+                        // a streamed texture samples nothing until its pixels arrive
+                        const auto uploading = !texture_uploads_.empty() && is_uploading(data);
+
+                        state_.bind_texture(
+                            static_cast<GLuint>(current_texture_unit),
+                            moka_to_gl(texture->metadata.target),
+                            uploading ? 0 : texture->name);
+                    }
 
                     ++current_texture_unit;
                     break;
@@ -681,292 +943,1411 @@ namespace moka
             }
         }
 
-        if (indexed)
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("begin_batch");
+        }
+    }
+
+    void gl_graphics_api::flush_draws()
+    {
+        if (draw_batch_.empty())
         {
-            glDrawElements(
-                moka_to_gl(cmd.prim_type),
-                static_cast<GLsizei>(cmd.index_count),
-                moka_to_gl(cmd.idx_type),
-                reinterpret_cast<void*>(static_cast<std::uintptr_t>(cmd.index_buffer_offset)));
+            return;
+        }
+
+        if (draw_batch_.size() == 1)
+        {
+            draw(draw_batch_.front());
         }
         else
         {
-            glDrawArrays(
-                moka_to_gl(cmd.prim_type), static_cast<GLint>(cmd.first_vertex), static_cast<GLsizei>(cmd.vertex_count));
+            multi_draw();
         }
 
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
-
-        previous_command_ = cmd;
+        draw_stats_.draws += draw_batch_.size();
+        draw_batch_.clear();
 
         if constexpr (application_traits::is_debug_build)
         {
-            check_errors("visit draw_command");
+            check_errors("flush_draws");
         }
     }
 
-    program_handle gl_graphics_api::make_program(const shader_handle& vertex_handle, const shader_handle& fragment_handle)
+    void gl_graphics_api::draw(const draw_command& cmd)
     {
-        const auto id = glCreateProgram();
-
-        const program_handle result{static_cast<uint16_t>(id)};
+        ++draw_stats_.draw_calls;
 
-        // Attach shaders as necessary.
+        if (cmd.first_instance != 0 && !GLEW_ARB_base_instance)
+        {
+            log_.error("Drawing from a first instance other than 0 requires ARB_base_instance");
+            return;
+        }
 
-        glAttachShader(id, vertex_handle.id);
+        if (cmd.is_indexed())
+        {
+            const auto index_buffer_offset =
+                cmd.streamed ? get_stream_base() + cmd.index_buffer_offset : size_t{cmd.index_buffer_offset};
 
-        glAttachShader(id, fragment_handle.id);
+            if (cmd.first_instance != 0)
+            {
+                glDrawElementsInstancedBaseVertexBaseInstance(
+                    moka_to_gl(cmd.prim_type),
+                    static_cast<GLsizei>(cmd.index_count),
+                    moka_to_gl(cmd.idx_type),
+                    reinterpret_cast<void*>(static_cast<std::uintptr_t>(index_buffer_offset)),
+                    static_cast<GLsizei>(cmd.instance_count),
+                    static_cast<GLint>(cmd.base_vertex),
+                    static_cast<GLuint>(cmd.first_instance));
+            }
+            else
+            {
+                glDrawElementsInstancedBaseVertex(
+                    moka_to_gl(cmd.prim_type),
+                    static_cast<GLsizei>(cmd.index_count),
+                    moka_to_gl(cmd.idx_type),
+                    reinterpret_cast<void*>(static_cast<std::uintptr_t>(index_buffer_offset)),
+                    static_cast<GLsizei>(cmd.instance_count),
+                    static_cast<GLint>(cmd.base_vertex));
+            }
+        }
+        else if (cmd.first_instance != 0)
+        {
+            glDrawArraysInstancedBaseInstance(
+                moka_to_gl(cmd.prim_type),
+                static_cast<GLint>(cmd.first_vertex),
+                static_cast<GLsizei>(cmd.vertex_count),
+                static_cast<GLsizei>(cmd.instance_count),
+                static_cast<GLuint>(cmd.first_instance));
+        }
+        else
+        {
+            glDrawArraysInstanced(
+                moka_to_gl(cmd.prim_type),
+                static_cast<GLint>(cmd.first_vertex),
+                static_cast<GLsizei>(cmd.vertex_count),
+                static_cast<GLsizei>(cmd.instance_count));
+        }
+    }
 
-        // Link the program.
-        glLinkProgram(id);
+    void gl_graphics_api::multi_draw()
+    {
+        const auto& first = draw_batch_.front();
 
-        auto is_linked = 0;
+        const auto base = first.streamed ? get_stream_base() : 0;
+        const auto element_size = index_size(first.idx_type);
 
-        glGetProgramiv(id, GL_LINK_STATUS, &is_linked);
-        if (is_linked == GL_FALSE)
+        // a frame that has used up its part of the indirect ring falls through to the calls that need no buffer
+        if (indirect_buffer_ && indirect_cursor_ + draw_batch_.size() <= indirect_commands_per_frame)
         {
-            auto max_length = 0;
-            glGetProgramiv(id, GL_INFO_LOG_LENGTH, &max_length);
+            indirect_commands_.clear();
 
-            // The maxLength includes the NULL character
-            char info_log[512];
+            for (const auto& cmd : draw_batch_)
+            {
+                indirect_commands_.push_back(
+                    {cmd.index_count,
+                     cmd.instance_count,
+                     static_cast<uint32_t>((base + cmd.index_buffer_offset) / element_size),
+                     cmd.base_vertex,
+                     cmd.first_instance});
+            }
 
-            glGetProgramInfoLog(id, max_length, &max_length, &info_log[0]);
+            const auto size = indirect_commands_.size() * sizeof(draw_indirect_command);
+            const auto offset = (stream_frame_ * indirect_commands_per_frame + indirect_cursor_) * sizeof(draw_indirect_command);
 
-            // The program is useless now. So delete it.
-            glDeleteProgram(id);
+            state_.bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+
+            // each frame writes its own part of the ring, which the fence of the frame that last used it protects
+            if (indirect_memory_)
+            {
+                std::memcpy(indirect_memory_ + offset, indirect_commands_.data(), size);
+            }
+            else
+            {
+                glBufferSubData(
+                    GL_DRAW_INDIRECT_BUFFER,
+                    static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(size),
+                    indirect_commands_.data());
+            }
+
+            glMultiDrawElementsIndirect(
+                moka_to_gl(first.prim_type),
+                moka_to_gl(first.idx_type),
+                reinterpret_cast<const void*>(static_cast<std::uintptr_t>(offset)),
+                static_cast<GLsizei>(indirect_commands_.size()),
+                0);
 
-            glGetShaderInfoLog(id, 512, nullptr, info_log);
+            indirect_cursor_ += indirect_commands_.size();
 
-            log_.info(info_log);
+            ++draw_stats_.draw_calls;
+            return;
         }
 
-        if constexpr (application_traits::is_debug_build)
+        const auto single_instances = std::all_of(draw_batch_.begin(), draw_batch_.end(), [](const draw_command& cmd) {
+            return cmd.instance_count == 1 && cmd.first_instance == 0;
+        });
+
+        if (!single_instances)
         {
-            check_errors("make_program");
+            for (const auto& cmd : draw_batch_)
+            {
+                draw(cmd);
+            }
+
+            return;
         }
 
-        return result;
+        multi_draw_counts_.clear();
+        multi_draw_offsets_.clear();
+        multi_draw_base_vertices_.clear();
+
+        for (const auto& cmd : draw_batch_)
+        {
+            multi_draw_counts_.push_back(static_cast<GLsizei>(cmd.index_count));
+            multi_draw_offsets_.push_back(reinterpret_cast<void*>(static_cast<std::uintptr_t>(base + cmd.index_buffer_offset)));
+            multi_draw_base_vertices_.push_back(static_cast<GLint>(cmd.base_vertex));
+        }
+
+        glMultiDrawElementsBaseVertex(
+            moka_to_gl(first.prim_type),
+            multi_draw_counts_.data(),
+            moka_to_gl(first.idx_type),
+            multi_draw_offsets_.data(),
+            static_cast<GLsizei>(multi_draw_counts_.size()),
+            multi_draw_base_vertices_.data());
+
+        ++draw_stats_.draw_calls;
     }
 
-    shader_handle gl_graphics_api::make_shader(const shader_type type, const std::string& source)
+    // packs three pool indices, which are at most 20 bits wide, into the key of a cached vertex array
+    constexpr uint64_t vertex_array_key(const uint32_t vertex_buffer, const uint32_t second, const uint32_t instance_buffer)
     {
-        int success;
-
-        char info_log[512];
+        constexpr auto bits = handle_pool<vertex_buffer_handle, int>::index_bits;
+        return uint64_t{vertex_buffer} << 2 * bits | uint64_t{second} << bits | instance_buffer;
+    }
 
-        const auto id = glCreateShader(moka_to_gl(type));
+    GLuint gl_graphics_api::get_vertex_array(
+        const vertex_buffer_handle vertex_buffer, const index_buffer_handle index_buffer, const vertex_buffer_handle instance_buffer)
+    {
+        const auto key = vertex_array_key(
+            vertex_buffer_pool::index(vertex_buffer), index_buffer_pool::index(index_buffer), vertex_buffer_pool::index(instance_buffer));
 
-        const shader_handle result{static_cast<uint16_t>(id)};
+        const auto it = vertex_arrays_.find(key);
 
-        auto source_chars = source.c_str();
+        if (it != vertex_arrays_.end())
+        {
+            return it->second;
+        }
 
-        glShaderSource(id, 1, &source_chars, nullptr);
+        // the layout of a vertex buffer never changes, so its attributes only need to be specified once per combination
+        GLuint vertex_array;
+        glGenVertexArrays(1, &vertex_array);
 
-        glCompileShader(id);
+        state_.bind_vertex_array(vertex_array);
+        specify_vertex_attributes(vertex_buffer, 0);
 
-        glGetShaderiv(id, GL_COMPILE_STATUS, &success);
-        if (!success)
+        if (instance_buffer.id != std::numeric_limits<uint32_t>::max())
         {
-            using namespace std::string_literals;
-
-            glGetShaderInfoLog(id, 512, nullptr, info_log);
+            specify_vertex_attributes(instance_buffer, 0);
+        }
 
-            log_.error(info_log);
+        if (const auto* buffer = index_buffers_.get(index_buffer))
+        {
+            state_.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, buffer->name);
         }
 
         if constexpr (application_traits::is_debug_build)
         {
-            check_errors("make_shader");
+            check_errors("get_vertex_array");
         }
 
-        return result;
+        vertex_arrays_.emplace(key, vertex_array);
+
+        return vertex_array;
     }
 
-    vertex_buffer_handle gl_graphics_api::make_vertex_buffer(
-        const void* vertices, const size_t size, vertex_layout&& layout, const buffer_usage use)
+    GLuint gl_graphics_api::get_stream_vertex_array(
+        const vertex_buffer_handle vertex_buffer, const vertex_buffer_handle instance_buffer)
     {
-        vertex_buffer_handle result;
-
-        GLuint handle;
+        const auto key = vertex_array_key(
+            vertex_buffer_pool::index(vertex_buffer), static_cast<uint32_t>(stream_frame_), vertex_buffer_pool::index(instance_buffer));
 
-        vertex_metadata data;
-        data.layout = std::move(layout);
-        data.buffer_use = use;
-        data.size = size;
+        const auto it = stream_vertex_arrays_.find(key);
 
-        glGenBuffers(1, &handle);
+        if (it != stream_vertex_arrays_.end())
+        {
+            return it->second;
+        }
 
-        result.id = static_cast<uint16_t>(handle);
+        // the attributes point at the start of one frame's part of the stream buffer, so every frame needs its own array
+        GLuint vertex_array;
+        glGenVertexArrays(1, &vertex_array);
 
-        vertex_buffer_data_[result.id] = std::move(data);
+        state_.bind_vertex_array(vertex_array);
+        specify_vertex_attributes(vertex_buffer, get_stream_base(), stream_buffer_);
+        state_.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, stream_buffer_);
 
-        glBindBuffer(GL_ARRAY_BUFFER, handle);
-        glBufferData(GL_ARRAY_BUFFER, size, vertices, moka_to_gl(use));
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        if (instance_buffer.id != std::numeric_limits<uint32_t>::max())
+        {
+            specify_vertex_attributes(instance_buffer, 0);
+        }
 
         if constexpr (application_traits::is_debug_build)
         {
-            check_errors("make_vertex_buffer");
+            check_errors("get_stream_vertex_array");
+        }
+
+        stream_vertex_arrays_.emplace(key, vertex_array);
+
+        return vertex_array;
+    }
+
+    void gl_graphics_api::specify_vertex_attributes(const vertex_buffer_handle vertex_buffer, const size_t base, const GLuint buffer)
+    {
+        const auto* data = find(vertex_buffers_, vertex_buffer, "specify_vertex_attributes");
+
+        if (!data)
+        {
+            return;
+        }
+
+        // streamed vertices take their layout from the vertex buffer, but are read from the stream buffer
+        state_.bind_buffer(GL_ARRAY_BUFFER, buffer != 0 ? buffer : data->name);
+
+        for (const auto& attribute : data->metadata.layout)
+        {
+            glVertexAttribPointer(
+                static_cast<GLuint>(attribute.index),
+                static_cast<GLint>(attribute.size),
+                moka_to_gl(attribute.type),
+                attribute.normalized,
+                static_cast<GLsizei>(attribute.stride),
+                reinterpret_cast<void*>(base + attribute.offset));
+
+            glEnableVertexAttribArray(static_cast<GLuint>(attribute.index));
+
+            if (attribute.divisor != 0)
+            {
+                glVertexAttribDivisor(static_cast<GLuint>(attribute.index), static_cast<GLuint>(attribute.divisor));
+            }
+        }
+    }
+
+    void gl_graphics_api::make_stream_buffer()
+    {
+        const auto size = static_cast<GLsizeiptr>(stream_allocator::default_capacity * stream_allocator::frame_count);
+
+        glGenBuffers(1, &stream_buffer_);
+        state_.bind_buffer(GL_ARRAY_BUFFER, stream_buffer_);
+
+        if (GLEW_ARB_buffer_storage)
+        {
+            // immutable storage can stay mapped while the device reads from it; coherent writes need no explicit flush
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+            stream_memory_ = static_cast<std::byte*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+
+            if (!stream_memory_)
+            {
+                // immutable storage can't be respecified, so start again with a mutable buffer
+                glDeleteBuffers(1, &stream_buffer_);
+                glGenBuffers(1, &stream_buffer_);
+
+                // the deleted buffer's binding reverted to 0, and the new one may reuse its name
+                state_.invalidate();
+                state_.bind_buffer(GL_ARRAY_BUFFER, stream_buffer_);
+            }
+        }
+
+        if (!stream_memory_)
+        {
+            log_.warn("Persistently mapped buffers are unsupported, stream uploads will use glBufferSubData");
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_stream_buffer");
+        }
+    }
+
+    void gl_graphics_api::make_indirect_buffer()
+    {
+        // without base instances, an indirect draw couldn't reach the instance data of any draw but the first
+        if (!GLEW_ARB_multi_draw_indirect || !GLEW_ARB_base_instance)
+        {
+            return;
+        }
+
+        const auto size =
+            static_cast<GLsizeiptr>(indirect_commands_per_frame * stream_allocator::frame_count * sizeof(draw_indirect_command));
+
+        glGenBuffers(1, &indirect_buffer_);
+        state_.bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+
+        if (GLEW_ARB_buffer_storage)
+        {
+            constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glBufferStorage(GL_DRAW_INDIRECT_BUFFER, size, nullptr, flags);
+            indirect_memory_ = static_cast<std::byte*>(glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, size, flags));
+
+            if (!indirect_memory_)
+            {
+                glDeleteBuffers(1, &indirect_buffer_);
+                glGenBuffers(1, &indirect_buffer_);
+
+                state_.invalidate();
+                state_.bind_buffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+            }
+        }
+
+        if (!indirect_memory_)
+        {
+            glBufferData(GL_DRAW_INDIRECT_BUFFER, size, nullptr, GL_STREAM_DRAW);
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_indirect_buffer");
+        }
+    }
+
+    void gl_graphics_api::advance_stream_buffer()
+    {
+        indirect_cursor_ = 0;
+
+        // the indirect ring shares the stream buffer's frames, so a mapped ring needs the same fences
+        if (stream_memory_ || indirect_memory_)
+        {
+            stream_fences_[stream_frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        stream_frame_ = (stream_frame_ + 1) % stream_allocator::frame_count;
+
+        auto& fence = stream_fences_[stream_frame_];
+
+        if (!fence)
+        {
+            return;
+        }
+
+        // the next frame overwrites the part of the buffer read by the frame submitted frame_count frames ago
+        while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+        {
+        }
+
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    size_t gl_graphics_api::get_stream_base() const
+    {
+        return stream_frame_ * stream_allocator::default_capacity;
+    }
+
+    void gl_graphics_api::apply(const pipeline_state& pipeline_state)
+    {
+        auto& blend = pipeline_state.blend;
+        state_.set_enabled(gl_state_cache::capability::blend, blend.enabled);
+        state_.set_blend_equation(moka_to_gl(blend.equation));
+        state_.set_blend_function(moka_to_gl(blend.source), moka_to_gl(blend.destination));
+
+        auto& polygon_mode = pipeline_state.polygon_mode;
+        state_.set_polygon_mode(moka_to_gl(polygon_mode.faces), moka_to_gl(polygon_mode.mode));
+
+        auto& culling = pipeline_state.culling;
+        state_.set_enabled(gl_state_cache::capability::cull_face, culling.enabled);
+        state_.set_cull_face(moka_to_gl(culling.faces));
+
+        state_.set_enabled(gl_state_cache::capability::depth_test, pipeline_state.depth_test);
+        state_.set_enabled(gl_state_cache::capability::scissor_test, pipeline_state.scissor_test);
+    }
+
+    program_handle gl_graphics_api::make_program(const shader_handle& vertex_handle, const shader_handle& fragment_handle)
+    {
+        const auto id = glCreateProgram();
+
+        gl_object<program_metadata> program;
+        program.name = id;
+
+        // Attach shaders as necessary.
+
+        if (const auto* shader = find(shaders_, vertex_handle, "make_program"))
+        {
+            glAttachShader(id, shader->name);
+            program.metadata.vertex_shader = shader->name;
+        }
+
+        if (const auto* shader = find(shaders_, fragment_handle, "make_program"))
+        {
+            glAttachShader(id, shader->name);
+            program.metadata.fragment_shader = shader->name;
+        }
+
+        // ask the driver to keep the binary around, so that the program cache can store it
+        if (GLEW_ARB_get_program_binary)
+        {
+            glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        }
+
+        // Link the program. The link status isn't checked until the program is needed, so that the driver can keep
+        // compiling and linking every program that was queued in the meantime.
+        glLinkProgram(id);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_program");
+        }
+
+        // time every program queued until the last of them is ready
+        if (pending_programs_.empty())
+        {
+            compile_start_ = std::chrono::steady_clock::now();
+            compiled_programs_ = 0;
+        }
+
+        const auto handle = programs_.allocate(std::move(program));
+        pending_programs_.emplace_back(handle);
+
+        return handle;
+    }
+
+    void gl_graphics_api::resolve_program(gl_object<program_metadata>& program)
+    {
+        if (program.metadata.linked)
+        {
+            return;
+        }
+
+        program.metadata.linked = true;
+
+        auto is_linked = 0;
+
+        glGetProgramiv(program.name, GL_LINK_STATUS, &is_linked);
+        if (is_linked == GL_FALSE)
+        {
+            char info_log[512];
+
+            // a failed link is usually caused by a shader that failed to compile, so report those first
+            for (const auto shader : {program.metadata.vertex_shader, program.metadata.fragment_shader})
+            {
+                auto success = 0;
+
+                if (shader != 0 && (glGetShaderiv(shader, GL_COMPILE_STATUS, &success), success == GL_FALSE))
+                {
+                    glGetShaderInfoLog(shader, sizeof(info_log), nullptr, info_log);
+
+                    log_.error(info_log);
+                }
+            }
+
+            glGetProgramInfoLog(program.name, sizeof(info_log), nullptr, info_log);
+
+            log_.error(info_log);
+
+            // The program is useless now. So delete it.
+            glDeleteProgram(program.name);
+            state_.program_deleted(program.name);
+
+            program.name = 0;
+        }
+        else
+        {
+            reflect_uniforms(program.name, program.metadata);
+            bind_uniform_blocks(program.name);
+        }
+
+        compile_end_ = std::chrono::steady_clock::now();
+        ++compiled_programs_;
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("resolve_program");
+        }
+    }
+
+    void gl_graphics_api::resolve_pending_programs()
+    {
+        if (pending_programs_.empty())
+        {
+            return;
+        }
+
+        const auto is_resolved = [this](const program_handle handle) {
+            auto* program = programs_.get(handle);
+
+            if (!program || program->metadata.linked)
+            {
+                return true;
+            }
+
+            // without parallel compilation there's no way to ask without waiting, but the frame has been queued already
+            if (GLEW_KHR_parallel_shader_compile)
+            {
+                auto is_complete = 0;
+                glGetProgramiv(program->name, GL_COMPLETION_STATUS_KHR, &is_complete);
+
+                if (is_complete == GL_FALSE)
+                {
+                    return false;
+                }
+            }
+
+            resolve_program(*program);
+            return true;
+        };
+
+        pending_programs_.erase(
+            std::remove_if(pending_programs_.begin(), pending_programs_.end(), is_resolved), pending_programs_.end());
+
+        if (pending_programs_.empty())
+        {
+            const std::chrono::duration<double, std::milli> elapsed = compile_end_ - compile_start_;
+
+            log_.info("Compiled and linked {} programs in {:.1f} ms", compiled_programs_, elapsed.count());
+        }
+    }
+
+    std::string gl_graphics_api::get_driver_id() const
+    {
+        if (!GLEW_ARB_get_program_binary)
+        {
+            return {};
+        }
+
+        // a driver may support the extension without exposing a single binary format
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        if (formats == 0)
+        {
+            return {};
+        }
+
+        std::string id;
+
+        for (const auto name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            if (const auto* value = reinterpret_cast<const char*>(glGetString(name)))
+            {
+                id.append(value);
+            }
+
+            id.push_back('\n');
+        }
+
+        return id;
+    }
+
+    bool gl_graphics_api::get_program_binary(const program_handle program, program_binary& binary)
+    {
+        auto* data = find(programs_, program, "get_program_binary");
+
+        if (!data || !GLEW_ARB_get_program_binary)
+        {
+            return false;
+        }
+
+        resolve_program(*data);
+
+        if (data->name == 0)
+        {
+            return false;
+        }
+
+        GLint length = 0;
+        glGetProgramiv(data->name, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        if (length <= 0)
+        {
+            return false;
+        }
+
+        binary.data.resize(static_cast<size_t>(length));
+
+        GLenum format = 0;
+        glGetProgramBinary(data->name, length, &length, &format, binary.data.data());
+
+        binary.data.resize(static_cast<size_t>(length));
+        binary.format = static_cast<uint32_t>(format);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("get_program_binary");
+        }
+
+        return length > 0;
+    }
+
+    bool gl_graphics_api::is_program_linked(const program_handle program)
+    {
+        auto* data = find(programs_, program, "is_program_linked");
+
+        if (!data || data->metadata.linked)
+        {
+            return true;
+        }
+
+        if (!GLEW_KHR_parallel_shader_compile)
+        {
+            return false;
+        }
+
+        auto is_complete = 0;
+        glGetProgramiv(data->name, GL_COMPLETION_STATUS_KHR, &is_complete);
+
+        if (is_complete == GL_FALSE)
+        {
+            return false;
+        }
+
+        // the link has finished, so resolving it doesn't wait for the driver
+        resolve_program(*data);
+        return true;
+    }
+
+    program_handle gl_graphics_api::make_program(const program_binary& binary)
+    {
+        if (!GLEW_ARB_get_program_binary || binary.data.empty())
+        {
+            return program_handle{};
+        }
+
+        const auto id = glCreateProgram();
+
+        glProgramBinary(id, static_cast<GLenum>(binary.format), binary.data.data(), static_cast<GLsizei>(binary.data.size()));
+
+        // drivers reject binaries they no longer understand, after an update for example
+        auto is_linked = 0;
+
+        glGetProgramiv(id, GL_LINK_STATUS, &is_linked);
+        if (is_linked == GL_FALSE)
+        {
+            glDeleteProgram(id);
+
+            // the error raised by a rejected binary is expected, so don't report it
+            while (glGetError() != GL_NO_ERROR)
+            {
+            }
+
+            return program_handle{};
+        }
+
+        gl_object<program_metadata> program;
+        program.name = id;
+        program.metadata.linked = true;
+
+        reflect_uniforms(id, program.metadata);
+        bind_uniform_blocks(id);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_program");
+        }
+
+        return programs_.allocate(std::move(program));
+    }
+
+    void gl_graphics_api::reflect_uniforms(const GLuint program, program_metadata& metadata)
+    {
+        metadata.uniforms.clear();
+
+        GLint count = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+
+        GLint max_length = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+        std::vector<GLchar> name(static_cast<size_t>(std::max(max_length, 1)));
+
+        for (GLint i = 0; i < count; ++i)
+        {
+            GLsizei length = 0;
+            GLint size = 0;
+            GLenum type = 0;
+
+            glGetActiveUniform(
+                program, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+
+            std::string uniform(name.data(), static_cast<size_t>(length));
+
+            // members of uniform blocks don't have a location
+            const auto location = glGetUniformLocation(program, uniform.c_str());
+
+            if (location == -1)
+            {
+                continue;
+            }
+
+            // arrays are reported as "name[0]", but materials refer to them by "name"
+            const std::string array_suffix = "[0]";
+
+            if (uniform.size() > array_suffix.size() &&
+                uniform.compare(uniform.size() - array_suffix.size(), array_suffix.size(), array_suffix) == 0)
+            {
+                metadata.uniforms[uniform.substr(0, uniform.size() - array_suffix.size())] = location;
+            }
+
+            metadata.uniforms[std::move(uniform)] = location;
+        }
+    }
+
+    void gl_graphics_api::bind_uniform_blocks(const GLuint program)
+    {
+        // GLSL 330 can't declare binding points, so every shared block is bound to its fixed one after linking
+        constexpr std::pair<const char*, uniform_block> blocks[] = {
+            {"frame_block", uniform_block::frame}, {"view_block", uniform_block::view}};
+
+        for (const auto& [name, block] : blocks)
+        {
+            const auto index = glGetUniformBlockIndex(program, name);
+
+            if (index != GL_INVALID_INDEX)
+            {
+                glUniformBlockBinding(program, index, static_cast<GLuint>(block));
+            }
+        }
+    }
+
+    void gl_graphics_api::warn_unused_parameter(const material& material, const std::string& name)
+    {
+        for (size_t program = 0; program < material.get_program_count(); ++program)
+        {
+            if (find_uniform(material.get_program(program), name) != -1)
+            {
+                return;
+            }
+        }
+
+        log_.warn("Material parameter \"{}\" is not an active uniform in any of the material's programs", name);
+    }
+
+    int32_t gl_graphics_api::find_uniform(const program_handle program, const std::string& name)
+    {
+        auto* data = programs_.get(program);
+
+        if (!data)
+        {
+            return -1;
+        }
+
+        resolve_program(*data);
+
+        const auto& uniforms = data->metadata.uniforms;
+        const auto uniform = uniforms.find(name);
+
+        return uniform != uniforms.end() ? uniform->second : -1;
+    }
+
+    shader_handle gl_graphics_api::make_shader(const shader_type type, const std::string& source)
+    {
+        const auto id = glCreateShader(moka_to_gl(type));
+
+        auto source_chars = source.c_str();
+
+        glShaderSource(id, 1, &source_chars, nullptr);
+
+        // the compile status is checked along with the link status of the programs using this shader
+        glCompileShader(id);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_shader");
+        }
+
+        return shaders_.allocate({id, type});
+    }
+
+    vertex_buffer_handle gl_graphics_api::make_vertex_buffer(
+        const void* vertices, const size_t size, vertex_layout&& layout, const buffer_usage use)
+    {
+        GLuint handle;
+
+        vertex_metadata data;
+        data.layout = std::move(layout);
+        data.buffer_use = use;
+        data.size = size;
+
+        glGenBuffers(1, &handle);
+
+        const auto result = vertex_buffers_.allocate({handle, std::move(data)});
+
+        state_.bind_buffer(GL_ARRAY_BUFFER, handle);
+        glBufferData(GL_ARRAY_BUFFER, size, vertices, moka_to_gl(use));
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_vertex_buffer");
+        }
+
+        return result;
+    }
+
+    index_buffer_handle gl_graphics_api::make_index_buffer(
+        const void* indices, const size_t size, const index_type type, const buffer_usage use)
+    {
+        GLuint handle;
+
+        index_metadata data;
+        data.buffer_use = use;
+        data.size = size;
+        data.type = type;
+
+        glGenBuffers(1, &handle);
+
+        const auto result = index_buffers_.allocate({handle, data});
+
+        state_.bind_vertex_array(vao_);
+        state_.bind_buffer(GL_ELEMENT_ARRAY_BUFFER, handle);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, moka_to_gl(use));
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_index_buffer");
         }
 
         return result;
     }
 
-    index_buffer_handle gl_graphics_api::make_index_buffer(
-        const void* indices, const size_t size, const index_type type, const buffer_usage use)
+    uniform_buffer_handle gl_graphics_api::make_uniform_buffer(const uniform_block block, const size_t size)
+    {
+        GLuint handle;
+
+        glGenBuffers(1, &handle);
+
+        state_.bind_buffer(GL_UNIFORM_BUFFER, handle);
+        glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_uniform_buffer");
+        }
+
+        return uniform_buffers_.allocate({handle, block});
+    }
+
+    void gl_graphics_api::submit(command_list&& commands)
+    {
+        commands.accept(*this);
+        flush_draws();
+
+        reset_gl_state();
+    }
+
+    void gl_graphics_api::submit(command_bundle& bundle)
+    {
+        bundle.get_commands().accept(*this);
+        flush_draws();
+
+        reset_gl_state();
+    }
+
+    void gl_graphics_api::reset_gl_state()
+    {
+        state_.bind_frame_buffer(default_frame_buffer_);
+        glDrawBuffer(default_frame_buffer_ == 0 ? GL_BACK : GL_COLOR_ATTACHMENT0);
+    }
+
+    void gl_graphics_api::submit_and_swap(command_list&& commands)
+    {
+        stream_texture_uploads();
+
+        commands.accept(*this);
+        flush_draws();
+        window_.swap_buffer();
+
+        reset_gl_state();
+
+        advance_stream_buffer();
+
+        frame_state_stats_ = state_.get_stats();
+        state_.reset_stats();
+
+        frame_draw_stats_ = draw_stats_;
+        draw_stats_ = {};
+
+        frame_upload_stats_ = upload_stats_;
+        frame_upload_stats_.textures_pending = texture_uploads_.size();
+        upload_stats_ = {};
+
+        resolve_gpu_timers();
+
+        resolve_pending_programs();
+
+        resolve_readbacks(false);
+    }
+
+    state_change_stats gl_graphics_api::get_state_change_stats() const
+    {
+        return frame_state_stats_;
+    }
+
+    draw_stats gl_graphics_api::get_draw_stats() const
+    {
+        return frame_draw_stats_;
+    }
+
+    std::vector<gpu_timer_result> gl_graphics_api::get_gpu_timers() const
+    {
+        return gpu_timers_;
+    }
+
+    constexpr GLenum moka_to_gl(const wrap_mode type)
+    {
+        switch (type)
+        {
+        case wrap_mode::clamp_to_edge:
+            return GL_CLAMP_TO_EDGE;
+        case wrap_mode::mirrored_repeat:
+            return GL_MIRRORED_REPEAT;
+        case wrap_mode::repeat:
+            return GL_REPEAT;
+        default:
+            return 0;
+        }
+    }
+
+    constexpr GLenum moka_to_gl(const min_filter type)
+    {
+        switch (type)
+        {
+        case min_filter::nearest:
+            return GL_NEAREST;
+        case min_filter::linear:
+            return GL_LINEAR;
+        case min_filter::nearest_mipmap_nearest:
+            return GL_NEAREST_MIPMAP_NEAREST;
+        case min_filter::linear_mipmap_nearest:
+            return GL_LINEAR_MIPMAP_NEAREST;
+        case min_filter::nearest_mipmap_linear:
+            return GL_NEAREST_MIPMAP_LINEAR;
+        case min_filter::linear_mipmap_linear:
+            return GL_LINEAR_MIPMAP_LINEAR;
+        default:
+            return 0;
+        }
+    }
+
+    constexpr GLenum moka_to_gl(const mag_filter type)
+    {
+        switch (type)
+        {
+        case mag_filter::nearest:
+            return GL_NEAREST;
+        case mag_filter::linear:
+            return GL_LINEAR;
+        default:
+            return 0;
+        }
+    }
+
+    texture_handle gl_graphics_api::make_texture(const void** data, texture_metadata&& metadata, const bool free_host_data)
+    {
+        const auto gl_target = moka_to_gl(metadata.target);
+
+        unsigned int texture;
+        glGenTextures(1, &texture);
+        state_.bind_texture(0, gl_target, texture);
+
+        texture_upload upload;
+        upload.generate_mipmaps = metadata.generate_mipmaps;
+
+        std::vector<const void*> pixels;
+
+        size_t staging_size = 0;
+
+        // allocate every image first, their pixels are copied from a staging buffer afterwards
+        for (size_t i = 0; i < metadata.data.size(); i++)
+        {
+            const auto& tex_image = metadata.data[i];
+
+            glTexImage2D(
+                moka_to_gl(tex_image.target),
+                tex_image.mip_level,
+                moka_to_gl(tex_image.internal_format),
+                tex_image.width,
+                tex_image.height,
+                tex_image.border,
+                moka_to_gl(tex_image.base_format),
+                moka_to_gl(tex_image.type),
+                nullptr);
+
+            if (data && data[i])
+            {
+                upload.images.emplace_back(tex_image);
+                upload.offsets.emplace_back(staging_size);
+                pixels.emplace_back(data[i]);
+                staging_size += image_size(tex_image);
+            }
+        }
+
+        glTexParameteri(
+            gl_target, GL_TEXTURE_WRAP_S, moka_to_gl(metadata.wrap_mode.s));
+        glTexParameteri(
+            gl_target, GL_TEXTURE_WRAP_T, moka_to_gl(metadata.wrap_mode.t));
+        glTexParameteri(
+            gl_target, GL_TEXTURE_WRAP_R, moka_to_gl(metadata.wrap_mode.r));
+        glTexParameteri(
+            gl_target, GL_TEXTURE_MIN_FILTER, moka_to_gl(metadata.filter_mode.min));
+        glTexParameteri(
+            gl_target, GL_TEXTURE_MAG_FILTER, moka_to_gl(metadata.filter_mode.mag));
+
+        const auto streamed = metadata.streamed;
+
+        const auto handle = textures_.allocate({texture, std::move(metadata)});
+
+        if (upload.images.empty())
+        {
+            if (upload.generate_mipmaps)
+            {
+                glGenerateMipmap(gl_target);
+            }
+        }
+        else
+        {
+            upload.texture = handle;
+            upload.staging_buffer =
+                acquire_staging_buffer(staging_buffers_, GL_PIXEL_UNPACK_BUFFER, GL_STREAM_DRAW, staging_size);
+
+            // the caller only waits for this copy, the driver copies the staging buffer to the texture asynchronously
+            state_.bind_buffer(GL_PIXEL_UNPACK_BUFFER, staging_buffers_[upload.staging_buffer].name);
+
+            auto* memory = static_cast<std::byte*>(glMapBufferRange(
+                GL_PIXEL_UNPACK_BUFFER,
+                0,
+                static_cast<GLsizeiptr>(staging_size),
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+
+            if (memory)
+            {
+                for (size_t i = 0; i < upload.images.size(); ++i)
+                {
+                    std::memcpy(memory + upload.offsets[i], pixels[i], image_size(upload.images[i]));
+                }
+
+                glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            }
+            else
+            {
+                log_.error("Failed to map a staging buffer of {} bytes, the texture will be left empty", staging_size);
+            }
+
+            state_.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            texture_uploads_.emplace_back(std::move(upload));
+
+            if (!streamed)
+            {
+                finish_texture_upload(handle);
+            }
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("make_texture");
+        }
+
+        return handle;
+    }
+
+    size_t gl_graphics_api::acquire_staging_buffer(
+        std::vector<staging_buffer>& pool, const GLenum target, const GLenum usage, const size_t size)
+    {
+        auto best = pool.size();
+
+        for (size_t i = 0; i < pool.size(); ++i)
+        {
+            auto& buffer = pool[i];
+
+            // a buffer is reused once the copies reading from it have finished
+            if (buffer.fence)
+            {
+                const auto status = glClientWaitSync(buffer.fence, 0, 0);
+
+                if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+                {
+                    glDeleteSync(buffer.fence);
+                    buffer.fence = nullptr;
+                    buffer.in_use = false;
+                }
+            }
+
+            if (!buffer.in_use && buffer.size >= size && (best == pool.size() || buffer.size < pool[best].size))
+            {
+                best = i;
+            }
+        }
+
+        if (best == pool.size())
+        {
+            staging_buffer buffer;
+            buffer.size = size;
+
+            glGenBuffers(1, &buffer.name);
+            state_.bind_buffer(target, buffer.name);
+            glBufferData(target, static_cast<GLsizeiptr>(size), nullptr, usage);
+            state_.bind_buffer(target, 0);
+
+            pool.emplace_back(buffer);
+        }
+
+        pool[best].in_use = true;
+
+        return best;
+    }
+
+    void gl_graphics_api::upload_next_image(texture_upload& upload)
+    {
+        const auto& image = upload.images[upload.next_image];
+        auto& buffer = staging_buffers_[upload.staging_buffer];
+
+        const auto* texture = textures_.get(upload.texture);
+
+        if (texture)
+        {
+            const auto target = moka_to_gl(texture->metadata.target);
+
+            state_.bind_texture(0, target, texture->name);
+            state_.bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer.name);
+
+            // with a pixel unpack buffer bound, the data pointer is an offset into it
+            glTexSubImage2D(
+                moka_to_gl(image.target),
+                image.mip_level,
+                0,
+                0,
+                image.width,
+                image.height,
+                moka_to_gl(image.base_format),
+                moka_to_gl(image.type),
+                reinterpret_cast<const void*>(upload.offsets[upload.next_image]));
+
+            state_.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            if (upload.next_image + 1 == upload.images.size() && upload.generate_mipmaps)
+            {
+                glGenerateMipmap(target);
+            }
+
+            upload_stats_.bytes_uploaded += image_size(image);
+        }
+
+        if (++upload.next_image == upload.images.size())
+        {
+            buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("upload_next_image");
+        }
+    }
+
+    bool gl_graphics_api::is_uploading(const texture_handle texture) const
+    {
+        return std::any_of(texture_uploads_.begin(), texture_uploads_.end(), [texture](const texture_upload& upload) {
+            return upload.texture == texture;
+        });
+    }
+
+    void gl_graphics_api::finish_texture_upload(const texture_handle texture)
+    {
+        const auto upload = std::find_if(texture_uploads_.begin(), texture_uploads_.end(), [texture](const texture_upload& upload) {
+            return upload.texture == texture;
+        });
+
+        if (upload == texture_uploads_.end())
+        {
+            return;
+        }
+
+        while (upload->next_image < upload->images.size())
+        {
+            upload_next_image(*upload);
+        }
+
+        texture_uploads_.erase(upload);
+    }
+
+    void gl_graphics_api::stream_texture_uploads()
+    {
+        size_t uploaded = 0;
+
+        // at least one image is uploaded every frame, so that an image larger than the budget still arrives
+        while (!texture_uploads_.empty())
+        {
+            auto& upload = texture_uploads_.front();
+
+            const auto size = image_size(upload.images[upload.next_image]);
+
+            if (uploaded != 0 && uploaded + size > texture_upload_budget_)
+            {
+                break;
+            }
+
+            upload_next_image(upload);
+            uploaded += size;
+
+            if (upload.next_image == upload.images.size())
+            {
+                texture_uploads_.pop_front();
+            }
+        }
+
+        if (!texture_uploads_.empty())
+        {
+            return;
+        }
+
+        // release the staging memory once streaming has finished, textures made later only need a small buffer
+        const auto idle = std::remove_if(staging_buffers_.begin(), staging_buffers_.end(), [](staging_buffer& buffer) {
+            if (buffer.fence)
+            {
+                const auto status = glClientWaitSync(buffer.fence, 0, 0);
+
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                {
+                    return false;
+                }
+
+                glDeleteSync(buffer.fence);
+            }
+
+            glDeleteBuffers(1, &buffer.name);
+            return true;
+        });
+
+        staging_buffers_.erase(idle, staging_buffers_.end());
+    }
+
+    void gl_graphics_api::visit(read_pixels_command& cmd)
     {
-        index_buffer_handle result;
+        flush_draws();
 
-        GLuint handle;
+        if (cmd.width <= 0 || cmd.height <= 0)
+        {
+            return;
+        }
 
-        index_metadata data;
-        data.buffer_use = use;
-        data.size = size;
-        data.type = type;
+        pending_readback readback;
+        readback.tag = cmd.tag;
+        readback.width = cmd.width;
+        readback.height = cmd.height;
+        readback.format = cmd.format;
+        readback.pixel = cmd.pixel;
 
-        glGenBuffers(1, &handle);
+        image_metadata image;
+        image.width = cmd.width;
+        image.height = cmd.height;
+        image.base_format = cmd.format;
+        image.type = cmd.pixel;
 
-        result.id = static_cast<uint16_t>(handle);
+        readback.buffer = acquire_staging_buffer(readback_buffers_, GL_PIXEL_PACK_BUFFER, GL_STREAM_READ, image_size(image));
 
-        index_buffer_data_[result.id] = data;
+        // with a pixel pack buffer bound, glReadPixels returns without waiting and the pointer is an offset into it
+        state_.bind_buffer(GL_PIXEL_PACK_BUFFER, readback_buffers_[readback.buffer].name);
+        glReadPixels(cmd.x, cmd.y, cmd.width, cmd.height, moka_to_gl(cmd.format), moka_to_gl(cmd.pixel), nullptr);
+        state_.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, handle);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, moka_to_gl(use));
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        pending_readbacks_.emplace_back(readback);
 
         if constexpr (application_traits::is_debug_build)
         {
-            check_errors("make_index_buffer");
+            check_errors("visit read_pixels_command");
         }
-
-        return result;
     }
 
-    void gl_graphics_api::submit(command_list&& commands)
+    void gl_graphics_api::resolve_readbacks(const bool wait)
     {
-        commands.accept(*this);
+        // the GPU finishes readbacks in order, so stop at the first one that isn't ready
+        while (!pending_readbacks_.empty())
+        {
+            auto& readback = pending_readbacks_.front();
 
-        reset_gl_state();
-    }
+            auto status = glClientWaitSync(readback.fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, 0);
 
-    void gl_graphics_api::reset_gl_state()
-    {
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDrawBuffer(GL_BACK);
-    }
+            while (wait && status == GL_TIMEOUT_EXPIRED)
+            {
+                status = glClientWaitSync(readback.fence, 0, 1000000000);
+            }
 
-    void gl_graphics_api::submit_and_swap(command_list&& commands)
-    {
-        commands.accept(*this);
-        window_.swap_buffer();
+            if (status == GL_TIMEOUT_EXPIRED)
+            {
+                break;
+            }
 
-        reset_gl_state();
+            auto& buffer = readback_buffers_[readback.buffer];
 
-        previous_command_ = {};
-    }
+            readback_result result;
+            result.tag = readback.tag;
+            result.width = readback.width;
+            result.height = readback.height;
+            result.format = readback.format;
+            result.pixel = readback.pixel;
 
-    constexpr GLenum moka_to_gl(const wrap_mode type)
-    {
-        switch (type)
-        {
-        case wrap_mode::clamp_to_edge:
-            return GL_CLAMP_TO_EDGE;
-        case wrap_mode::mirrored_repeat:
-            return GL_MIRRORED_REPEAT;
-        case wrap_mode::repeat:
-            return GL_REPEAT;
-        default:
-            return 0;
-        }
-    }
+            if (status == GL_WAIT_FAILED)
+            {
+                log_.error("Failed to wait for the readback tagged {}, its pixels are lost", readback.tag);
+            }
+            else
+            {
+                image_metadata image;
+                image.width = readback.width;
+                image.height = readback.height;
+                image.base_format = readback.format;
+                image.type = readback.pixel;
 
-    constexpr GLenum moka_to_gl(const min_filter type)
-    {
-        switch (type)
-        {
-        case min_filter::nearest:
-            return GL_NEAREST;
-        case min_filter::linear:
-            return GL_LINEAR;
-        case min_filter::nearest_mipmap_nearest:
-            return GL_NEAREST_MIPMAP_NEAREST;
-        case min_filter::linear_mipmap_nearest:
-            return GL_LINEAR_MIPMAP_NEAREST;
-        case min_filter::nearest_mipmap_linear:
-            return GL_NEAREST_MIPMAP_LINEAR;
-        case min_filter::linear_mipmap_linear:
-            return GL_LINEAR_MIPMAP_LINEAR;
-        default:
-            return 0;
-        }
-    }
+                const auto size = image_size(image);
 
-    constexpr GLenum moka_to_gl(const mag_filter type)
-    {
-        switch (type)
-        {
-        case mag_filter::nearest:
-            return GL_NEAREST;
-        case mag_filter::linear:
-            return GL_LINEAR;
-        default:
-            return 0;
-        }
-    }
+                state_.bind_buffer(GL_PIXEL_PACK_BUFFER, buffer.name);
 
-    texture_handle gl_graphics_api::make_texture(const void** data, texture_metadata&& metadata, const bool free_host_data)
-    {
-        const auto gl_target = moka_to_gl(metadata.target);
+                if (const auto* memory = static_cast<const uint8_t*>(
+                        glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(size), GL_MAP_READ_BIT)))
+                {
+                    result.pixels.assign(memory, memory + size);
+                    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+                }
 
-        unsigned int texture;
-        glGenTextures(1, &texture);
-        glBindTexture(gl_target, texture);
+                state_.bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
 
-        for (size_t i = 0; i < metadata.data.size(); i++)
-        {
-            const auto* pixels = data[i];
-            const auto& tex_image = metadata.data[i];
+                readbacks_.emplace_back(std::move(result));
+            }
 
-            glTexImage2D(
-                moka_to_gl(metadata.data[i].target),
-                tex_image.mip_level,
-                moka_to_gl(tex_image.internal_format),
-                tex_image.width,
-                tex_image.height,
-                tex_image.border,
-                moka_to_gl(tex_image.base_format),
-                moka_to_gl(tex_image.type),
-                pixels);
-        }
+            glDeleteSync(readback.fence);
+            buffer.in_use = false;
 
-        glTexParameteri(
-            gl_target, GL_TEXTURE_WRAP_S, moka_to_gl(metadata.wrap_mode.s));
-        glTexParameteri(
-            gl_target, GL_TEXTURE_WRAP_T, moka_to_gl(metadata.wrap_mode.t));
-        glTexParameteri(
-            gl_target, GL_TEXTURE_WRAP_R, moka_to_gl(metadata.wrap_mode.r));
-        glTexParameteri(
-            gl_target, GL_TEXTURE_MIN_FILTER, moka_to_gl(metadata.filter_mode.min));
-        glTexParameteri(
-            gl_target, GL_TEXTURE_MAG_FILTER, moka_to_gl(metadata.filter_mode.mag));
+            pending_readbacks_.pop_front();
+        }
 
-        if (metadata.generate_mipmaps)
+        if constexpr (application_traits::is_debug_build)
         {
-            glGenerateMipmap(gl_target);
+            check_errors("resolve_readbacks");
         }
+    }
 
-        if constexpr (application_traits::is_debug_build)
+    std::vector<readback_result> gl_graphics_api::take_readbacks(const bool wait)
+    {
+        if (wait)
         {
-            check_errors("make_texture");
+            resolve_readbacks(true);
         }
 
-        const auto id = static_cast<uint16_t>(texture);
+        return std::exchange(readbacks_, {});
+    }
 
-        texture_data_[id] = std::move(metadata);
+    void gl_graphics_api::set_texture_upload_budget(const size_t bytes)
+    {
+        texture_upload_budget_ = bytes;
+    }
 
-        return moka::texture_handle{id};
+    texture_upload_stats gl_graphics_api::get_texture_upload_stats() const
+    {
+        return frame_upload_stats_;
     }
 
     frame_buffer_handle gl_graphics_api::make_frame_buffer(
@@ -974,7 +2355,10 @@ namespace moka
     {
         unsigned int capture_fbo;
         glGenFramebuffers(1, &capture_fbo);
-        glBindFramebuffer(GL_FRAMEBUFFER, capture_fbo);
+        state_.bind_frame_buffer(capture_fbo);
+
+        gl_object<frame_buffer_metadata> frame_buffer;
+        frame_buffer.name = capture_fbo;
 
         for (size_t i = 0; i < render_texture_count; i++)
         {
@@ -993,7 +2377,7 @@ namespace moka
             glFramebufferRenderbuffer(
                 GL_FRAMEBUFFER, moka_to_gl(render_texture.attachment), GL_RENDERBUFFER, capture_rbo);
 
-            frame_buffer_data_[capture_fbo].attachments.emplace_back(capture_rbo);
+            frame_buffer.metadata.attachments.emplace_back(capture_rbo);
         }
 
         if constexpr (application_traits::is_debug_build)
@@ -1001,7 +2385,7 @@ namespace moka
             check_errors("make_frame_buffer");
         }
 
-        return frame_buffer_handle{static_cast<uint16_t>(capture_fbo)};
+        return frame_buffers_.allocate(std::move(frame_buffer));
     }
 
     std::string source_to_string(GLenum source)
@@ -1093,7 +2477,7 @@ namespace moka
     logger gl_graphics_api::log_("OpenGL");
 
     gl_graphics_api::gl_graphics_api(window& window, graphics_device& device)
-        : window_(window), device_(device)
+        : window_(window), device_(device), default_frame_buffer_(window.get_default_frame_buffer())
     {
         // enable GL_DEBUG_OUTPUT by default if it's a debug build
         if constexpr (application_traits::is_debug_build)
@@ -1103,7 +2487,17 @@ namespace moka
         }
 
         glGenVertexArrays(1, &vao_);
-        glBindVertexArray(vao_);
+        state_.bind_vertex_array(vao_);
+
+        make_stream_buffer();
+
+        make_indirect_buffer();
+
+        // let the driver compile and link on as many threads as it likes
+        if (GLEW_KHR_parallel_shader_compile)
+        {
+            glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+        }
 
         glEnable(GL_MULTISAMPLE);
         glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -1116,14 +2510,84 @@ namespace moka
         }
     }
 
+    template <typename Handle, typename T>
+    gl_object<T>* gl_graphics_api::find(handle_pool<Handle, gl_object<T>>& pool, const Handle handle, const char* caller)
+    {
+        auto* object = pool.get(handle);
+
+        if (!object)
+        {
+            log_.error("Invalid or stale handle {} passed to {}", handle.id, caller);
+        }
+
+        return object;
+    }
+
+    void gl_graphics_api::erase_vertex_arrays(const vertex_buffer_handle vertex_buffer)
+    {
+        // a vertex buffer appears in the first and last index of a key, as either the vertices or the instances
+        constexpr auto bits = vertex_buffer_pool::index_bits;
+        constexpr auto mask = uint64_t{vertex_buffer_pool::index_mask};
+
+        const auto index = uint64_t{vertex_buffer_pool::index(vertex_buffer)};
+
+        for (auto* vertex_arrays : {&vertex_arrays_, &stream_vertex_arrays_})
+        {
+            for (auto it = vertex_arrays->begin(); it != vertex_arrays->end();)
+            {
+                if ((it->first >> 2 * bits & mask) == index || (it->first & mask) == index)
+                {
+                    state_.vertex_array_deleted(it->second);
+                    glDeleteVertexArrays(1, &it->second);
+                    it = vertex_arrays->erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+    }
+
+    void gl_graphics_api::erase_vertex_arrays(const index_buffer_handle index_buffer)
+    {
+        constexpr auto bits = index_buffer_pool::index_bits;
+        constexpr auto mask = uint64_t{index_buffer_pool::index_mask};
+
+        const auto index = uint64_t{index_buffer_pool::index(index_buffer)};
+
+        for (auto it = vertex_arrays_.begin(); it != vertex_arrays_.end();)
+        {
+            if ((it->first >> bits & mask) == index)
+            {
+                state_.vertex_array_deleted(it->second);
+                glDeleteVertexArrays(1, &it->second);
+                it = vertex_arrays_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
     void gl_graphics_api::destroy(frame_buffer_handle handle)
     {
-        auto& data = frame_buffer_data_[handle.id].attachments;
+        const auto* frame_buffer = find(frame_buffers_, handle, "destroy frame_buffer_handle");
+
+        if (!frame_buffer)
+        {
+            return;
+        }
+
+        auto& data = frame_buffer->metadata.attachments;
 
         glDeleteRenderbuffers(static_cast<uint32_t>(data.size()), data.data());
 
-        const auto framebufferHandle = static_cast<GLuint>(handle.id);
-        glDeleteFramebuffers(1, &framebufferHandle);
+        glDeleteFramebuffers(1, &frame_buffer->name);
+        state_.frame_buffer_deleted(frame_buffer->name);
+
+        frame_buffers_.release(handle);
 
         if constexpr (application_traits::is_debug_build)
         {
@@ -1131,8 +2595,153 @@ namespace moka
         }
     }
 
+    void gl_graphics_api::destroy(program_handle handle)
+    {
+        const auto* program = find(programs_, handle, "destroy program_handle");
+
+        if (!program)
+        {
+            return;
+        }
+
+        glDeleteProgram(program->name);
+        state_.program_deleted(program->name);
+
+        programs_.release(handle);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("destroy program_handle");
+        }
+    }
+
+    void gl_graphics_api::destroy(shader_handle handle)
+    {
+        const auto* shader = find(shaders_, handle, "destroy shader_handle");
+
+        if (!shader)
+        {
+            return;
+        }
+
+        // programs the shader is attached to keep it alive until they are deleted too
+        glDeleteShader(shader->name);
+
+        shaders_.release(handle);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("destroy shader_handle");
+        }
+    }
+
+    void gl_graphics_api::destroy(vertex_buffer_handle handle)
+    {
+        const auto* buffer = find(vertex_buffers_, handle, "destroy vertex_buffer_handle");
+
+        if (!buffer)
+        {
+            return;
+        }
+
+        // the slot can be reused by the next vertex buffer, which mustn't pick up arrays that point at this one
+        erase_vertex_arrays(handle);
+
+        glDeleteBuffers(1, &buffer->name);
+        state_.buffer_deleted(buffer->name);
+
+        vertex_buffers_.release(handle);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("destroy vertex_buffer_handle");
+        }
+    }
+
+    void gl_graphics_api::destroy(index_buffer_handle handle)
+    {
+        const auto* buffer = find(index_buffers_, handle, "destroy index_buffer_handle");
+
+        if (!buffer)
+        {
+            return;
+        }
+
+        erase_vertex_arrays(handle);
+
+        glDeleteBuffers(1, &buffer->name);
+        state_.buffer_deleted(buffer->name);
+
+        index_buffers_.release(handle);
+
+        if constexpr (application_traits::is_debug_build)
+        {
+            check_errors("destroy index_buffer_handle");
+        }
+    }
+
     gl_graphics_api::~gl_graphics_api()
     {
+        for (const auto& vertex_array : vertex_arrays_)
+        {
+            glDeleteVertexArrays(1, &vertex_array.second);
+        }
+
+        for (const auto& vertex_array : stream_vertex_arrays_)
+        {
+            glDeleteVertexArrays(1, &vertex_array.second);
+        }
+
+        for (auto* fence : stream_fences_)
+        {
+            if (fence)
+            {
+                glDeleteSync(fence);
+            }
+        }
+
+        for (const auto& buffer : staging_buffers_)
+        {
+            if (buffer.fence)
+            {
+                glDeleteSync(buffer.fence);
+            }
+
+            glDeleteBuffers(1, &buffer.name);
+        }
+
+        for (const auto& readback : pending_readbacks_)
+        {
+            glDeleteSync(readback.fence);
+        }
+
+        for (const auto& buffer : readback_buffers_)
+        {
+            glDeleteBuffers(1, &buffer.name);
+        }
+
+        // deleting a mapped buffer unmaps it
+        glDeleteBuffers(1, &stream_buffer_);
+        glDeleteBuffers(1, &indirect_buffer_);
+
+        for (const auto& scope : timer_scopes_)
+        {
+            free_timer_queries_.emplace_back(scope.begin);
+            free_timer_queries_.emplace_back(scope.end);
+        }
+
+        for (const auto& scopes : pending_timer_frames_)
+        {
+            for (const auto& scope : scopes)
+            {
+                free_timer_queries_.emplace_back(scope.begin);
+                free_timer_queries_.emplace_back(scope.end);
+            }
+        }
+
+        // scopes that were never closed have an end query of 0, which glDeleteQueries ignores
+        glDeleteQueries(static_cast<GLsizei>(free_timer_queries_.size()), free_timer_queries_.data());
+
         glDeleteVertexArrays(1, &vao_);
 
         if constexpr (application_traits::is_debug_build)
@@ -0,0 +1,289 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <graphics/api/gl_state_cache.hpp>
+
+namespace moka
+{
+    namespace
+    {
+        constexpr GLenum moka_to_gl(const gl_state_cache::capability cap)
+        {
+            switch (cap)
+            {
+            case gl_state_cache::capability::blend:
+                return GL_BLEND;
+            case gl_state_cache::capability::cull_face:
+                return GL_CULL_FACE;
+            case gl_state_cache::capability::depth_test:
+                return GL_DEPTH_TEST;
+            case gl_state_cache::capability::scissor_test:
+                return GL_SCISSOR_TEST;
+            default:
+                return 0;
+            }
+        }
+    } // namespace
+
+    template <typename T>
+    bool gl_state_cache::update(T& shadow, const T value)
+    {
+        if (shadow == value)
+        {
+            ++stats_.calls_elided;
+            return false;
+        }
+
+        shadow = value;
+        ++stats_.calls_issued;
+        return true;
+    }
+
+    gl_state_cache::gl_state_cache()
+    {
+        invalidate();
+    }
+
+    void gl_state_cache::invalidate()
+    {
+        capabilities_.fill(-1);
+        blend_equation_ = unknown;
+        blend_source_ = unknown;
+        blend_destination_ = unknown;
+        polygon_faces_ = unknown;
+        polygon_mode_ = unknown;
+        cull_faces_ = unknown;
+        program_ = unknown;
+        vertex_array_ = unknown;
+        array_buffer_ = unknown;
+        element_array_buffer_ = unknown;
+        frame_buffer_ = unknown;
+        active_texture_unit_ = unknown;
+
+        for (auto& unit : textures_)
+        {
+            unit.fill(unknown);
+        }
+    }
+
+    void gl_state_cache::set_enabled(const capability cap, const bool enabled)
+    {
+        if (update(capabilities_[static_cast<size_t>(cap)], static_cast<int8_t>(enabled)))
+        {
+            enabled ? glEnable(moka_to_gl(cap)) : glDisable(moka_to_gl(cap));
+        }
+    }
+
+    void gl_state_cache::set_blend_equation(const GLenum equation)
+    {
+        if (update(blend_equation_, equation))
+        {
+            glBlendEquation(equation);
+        }
+    }
+
+    void gl_state_cache::set_blend_function(const GLenum source, const GLenum destination)
+    {
+        if (blend_source_ == source && blend_destination_ == destination)
+        {
+            ++stats_.calls_elided;
+            return;
+        }
+
+        blend_source_ = source;
+        blend_destination_ = destination;
+        ++stats_.calls_issued;
+
+        glBlendFunc(source, destination);
+    }
+
+    void gl_state_cache::set_polygon_mode(const GLenum faces, const GLenum mode)
+    {
+        if (polygon_faces_ == faces && polygon_mode_ == mode)
+        {
+            ++stats_.calls_elided;
+            return;
+        }
+
+        // a mode set for a single face leaves the other face's mode unknown
+        polygon_faces_ = faces;
+        polygon_mode_ = faces == GL_FRONT_AND_BACK ? mode : unknown;
+        ++stats_.calls_issued;
+
+        glPolygonMode(faces, mode);
+    }
+
+    void gl_state_cache::set_cull_face(const GLenum faces)
+    {
+        if (update(cull_faces_, faces))
+        {
+            glCullFace(faces);
+        }
+    }
+
+    void gl_state_cache::use_program(const GLuint program)
+    {
+        if (update(program_, program))
+        {
+            glUseProgram(program);
+        }
+    }
+
+    void gl_state_cache::bind_vertex_array(const GLuint vertex_array)
+    {
+        if (update(vertex_array_, vertex_array))
+        {
+            glBindVertexArray(vertex_array);
+            element_array_buffer_ = unknown;
+        }
+    }
+
+    void gl_state_cache::bind_buffer(const GLenum target, const GLuint buffer)
+    {
+        switch (target)
+        {
+        case GL_ARRAY_BUFFER:
+            if (!update(array_buffer_, buffer))
+            {
+                return;
+            }
+            break;
+        case GL_ELEMENT_ARRAY_BUFFER:
+            if (!update(element_array_buffer_, buffer))
+            {
+                return;
+            }
+            break;
+        default:
+            ++stats_.calls_issued;
+            break;
+        }
+
+        glBindBuffer(target, buffer);
+    }
+
+    void gl_state_cache::bind_frame_buffer(const GLuint frame_buffer)
+    {
+        if (update(frame_buffer_, frame_buffer))
+        {
+            glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer);
+        }
+    }
+
+    void gl_state_cache::bind_texture(const GLuint unit, const GLenum target, const GLuint texture)
+    {
+        GLuint* shadow = nullptr;
+
+        if (unit < max_texture_units)
+        {
+            switch (target)
+            {
+            case GL_TEXTURE_2D:
+                shadow = &textures_[unit][static_cast<size_t>(texture_slot::texture_2d)];
+                break;
+            case GL_TEXTURE_CUBE_MAP:
+                shadow = &textures_[unit][static_cast<size_t>(texture_slot::texture_cube_map)];
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (shadow)
+        {
+            if (!update(*shadow, texture))
+            {
+                return;
+            }
+        }
+        else
+        {
+            ++stats_.calls_issued;
+        }
+
+        // the active unit only matters when a binding changes, so it's switched lazily
+        if (active_texture_unit_ != unit)
+        {
+            active_texture_unit_ = unit;
+            ++stats_.calls_issued;
+            glActiveTexture(GL_TEXTURE0 + unit);
+        }
+
+        glBindTexture(target, texture);
+    }
+
+    void gl_state_cache::frame_buffer_deleted(const GLuint frame_buffer)
+    {
+        if (frame_buffer_ == frame_buffer)
+        {
+            frame_buffer_ = 0;
+        }
+    }
+
+    void gl_state_cache::program_deleted(const GLuint program)
+    {
+        if (program_ == program)
+        {
+            program_ = unknown;
+        }
+    }
+
+    void gl_state_cache::vertex_array_deleted(const GLuint vertex_array)
+    {
+        if (vertex_array_ == vertex_array)
+        {
+            vertex_array_ = 0;
+            element_array_buffer_ = unknown;
+        }
+    }
+
+    void gl_state_cache::buffer_deleted(const GLuint buffer)
+    {
+        if (array_buffer_ == buffer)
+        {
+            array_buffer_ = 0;
+        }
+
+        if (element_array_buffer_ == buffer)
+        {
+            element_array_buffer_ = 0;
+        }
+    }
+
+    const state_change_stats& gl_state_cache::get_stats() const
+    {
+        return stats_;
+    }
+
+    void gl_state_cache::reset_stats()
+    {
+        stats_ = {};
+    }
+} // namespace moka
@@ -0,0 +1,639 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <algorithm>
+#include <graphics/api/null_graphics_api.hpp>
+#include <graphics/command/clear_command.hpp>
+#include <graphics/command/command_bundle.hpp>
+#include <graphics/command/command_list.hpp>
+#include <graphics/command/draw_command.hpp>
+#include <graphics/command/fill_index_buffer_command.hpp>
+#include <graphics/command/fill_stream_buffer_command.hpp>
+#include <graphics/command/fill_uniform_buffer_command.hpp>
+#include <graphics/command/fill_vertex_buffer_command.hpp>
+#include <graphics/command/frame_buffer_command.hpp>
+#include <graphics/command/frame_buffer_texture_command.hpp>
+#include <graphics/command/generate_mipmaps_command.hpp>
+#include <graphics/command/gpu_timer_command.hpp>
+#include <graphics/command/read_pixels_command.hpp>
+#include <graphics/command/scissor_command.hpp>
+#include <graphics/command/set_material_properties_command.hpp>
+#include <graphics/command/viewport_command.hpp>
+#include <graphics/material/material.hpp>
+#include <limits>
+#include <utility>
+
+namespace moka
+{
+    logger null_graphics_api::log_("Null");
+
+    size_t null_buffer::vertex_capacity() const
+    {
+        // without a layout there's nothing to count vertices with, so every draw is assumed to fit
+        auto capacity = std::numeric_limits<size_t>::max();
+
+        for (const auto& attribute : layout)
+        {
+            const auto attribute_size = moka::size(attribute.type) * attribute.size;
+            const auto stride = attribute.stride != 0 ? attribute.stride : attribute_size;
+
+            if (attribute.offset + attribute_size > size)
+            {
+                return 0;
+            }
+
+            capacity = std::min(capacity, (size - attribute.offset - attribute_size) / stride + 1);
+        }
+
+        return capacity;
+    }
+
+    null_graphics_api::null_graphics_api(graphics_device& device) : device_(device)
+    {
+    }
+
+    void null_graphics_api::count(const command_type type, const bool valid)
+    {
+        // the GL backend issues its pending run before any command that isn't a draw or a parameter write
+        if (type != command_type::draw && type != command_type::set_material_parameters)
+        {
+            end_batch();
+        }
+
+        ++stats_.commands[static_cast<size_t>(type)];
+
+        if (!valid)
+        {
+            ++stats_.invalid_commands;
+        }
+
+        if (recording_)
+        {
+            recorded_.push_back({frame_, type, valid});
+        }
+    }
+
+    void null_graphics_api::end_batch()
+    {
+        if (batch_.empty())
+        {
+            return;
+        }
+
+        ++draw_calls_;
+        batch_.clear();
+    }
+
+    void null_graphics_api::bind(uint32_t& bound, const uint32_t object)
+    {
+        if (bound == object)
+        {
+            ++state_stats_.calls_elided;
+            return;
+        }
+
+        bound = object;
+        ++state_stats_.calls_issued;
+    }
+
+    void null_graphics_api::bind(const material& material)
+    {
+        bind(bound_pipeline_state_, material.get_pipeline_state().id);
+        bind(bound_program_, material.get_program().id);
+
+        // textures are bound to consecutive units in parameter order, as the GL backend binds them
+        size_t unit = 0;
+
+        for (const auto& parameter : material)
+        {
+            const auto* texture = std::get_if<texture_handle>(&parameter.data);
+
+            if (parameter.type != parameter_type::texture || !texture)
+            {
+                continue;
+            }
+
+            if (unit == bound_textures_.size())
+            {
+                bound_textures_.push_back(std::numeric_limits<uint32_t>::max());
+            }
+
+            bind(bound_textures_[unit++], texture->id);
+        }
+    }
+
+    template <typename Handle>
+    bool null_graphics_api::is_live(const handle_pool<Handle, null_buffer>& pool, const Handle handle, const char* caller)
+    {
+        if (!pool.get(handle))
+        {
+            log_.error("Invalid or stale handle {} passed to {}", handle.id, caller);
+            return false;
+        }
+
+        return true;
+    }
+
+    template <typename Handle>
+    void null_graphics_api::release(handle_pool<Handle, null_buffer>& pool, const Handle handle, const char* caller)
+    {
+        if (!pool.release(handle))
+        {
+            log_.error("Invalid or stale handle {} passed to {}", handle.id, caller);
+            return;
+        }
+
+        ++stats_.resources_destroyed;
+    }
+
+    null_call_stats null_graphics_api::get_call_stats() const
+    {
+        return frame_stats_;
+    }
+
+    void null_graphics_api::set_recording(const bool enabled)
+    {
+        recording_ = enabled;
+    }
+
+    std::vector<null_call> null_graphics_api::take_recorded_calls()
+    {
+        return std::exchange(recorded_, {});
+    }
+
+    program_handle null_graphics_api::make_program(const shader_handle& vertex_handle, const shader_handle& fragment_handle)
+    {
+        if (!is_live(shaders_, vertex_handle, "make_program") || !is_live(shaders_, fragment_handle, "make_program"))
+        {
+            return program_handle{};
+        }
+
+        ++stats_.resources_created;
+        return programs_.allocate({});
+    }
+
+    shader_handle null_graphics_api::make_shader(const shader_type type, const std::string& source)
+    {
+        ++stats_.resources_created;
+        return shaders_.allocate({source.size()});
+    }
+
+    int32_t null_graphics_api::find_uniform(const program_handle program, const std::string& name)
+    {
+        is_live(programs_, program, "find_uniform");
+        return -1;
+    }
+
+    std::string null_graphics_api::get_driver_id() const
+    {
+        return {};
+    }
+
+    bool null_graphics_api::get_program_binary(const program_handle program, program_binary& binary)
+    {
+        return false;
+    }
+
+    bool null_graphics_api::is_program_linked(const program_handle program)
+    {
+        is_live(programs_, program, "is_program_linked");
+        return true;
+    }
+
+    program_handle null_graphics_api::make_program(const program_binary& binary)
+    {
+        return program_handle{};
+    }
+
+    vertex_buffer_handle null_graphics_api::make_vertex_buffer(
+        const void* vertices, const size_t size, vertex_layout&& layout, const buffer_usage use)
+    {
+        ++stats_.resources_created;
+        return vertex_buffers_.allocate({size, std::move(layout)});
+    }
+
+    index_buffer_handle null_graphics_api::make_index_buffer(
+        const void* indices, const size_t size, const index_type type, const buffer_usage use)
+    {
+        ++stats_.resources_created;
+        return index_buffers_.allocate({size});
+    }
+
+    uniform_buffer_handle null_graphics_api::make_uniform_buffer(const uniform_block block, const size_t size)
+    {
+        ++stats_.resources_created;
+        return uniform_buffers_.allocate({size});
+    }
+
+    texture_handle null_graphics_api::make_texture(const void** data, texture_metadata&& metadata, const bool free_host_data)
+    {
+        size_t size = 0;
+
+        for (const auto& image : metadata.data)
+        {
+            size += image_size(image);
+        }
+
+        ++stats_.resources_created;
+        return textures_.allocate({size});
+    }
+
+    frame_buffer_handle null_graphics_api::make_frame_buffer(
+        render_texture_data* render_textures, const size_t render_texture_count)
+    {
+        ++stats_.resources_created;
+        return frame_buffers_.allocate({});
+    }
+
+    state_change_stats null_graphics_api::get_state_change_stats() const
+    {
+        return frame_state_stats_;
+    }
+
+    draw_stats null_graphics_api::get_draw_stats() const
+    {
+        draw_stats stats;
+        stats.draws = frame_stats_.commands[static_cast<size_t>(command_type::draw)];
+        stats.draw_calls = frame_draw_calls_;
+        return stats;
+    }
+
+    std::vector<gpu_timer_result> null_graphics_api::get_gpu_timers() const
+    {
+        return {};
+    }
+
+    void null_graphics_api::set_texture_upload_budget(const size_t bytes)
+    {
+    }
+
+    texture_upload_stats null_graphics_api::get_texture_upload_stats() const
+    {
+        return {};
+    }
+
+    std::vector<readback_result> null_graphics_api::take_readbacks(const bool wait)
+    {
+        return std::exchange(readbacks_, {});
+    }
+
+    void null_graphics_api::submit(command_list&& commands)
+    {
+        ++stats_.submits;
+        commands.accept(*this);
+        end_batch();
+    }
+
+    void null_graphics_api::submit(command_bundle& bundle)
+    {
+        ++stats_.submits;
+        bundle.get_commands().accept(*this);
+        end_batch();
+    }
+
+    void null_graphics_api::submit_and_swap(command_list&& commands)
+    {
+        submit(std::move(commands));
+
+        if (open_timer_scopes_ > 0)
+        {
+            log_.error("{} gpu timer scopes were left open at the end of frame {}", open_timer_scopes_, frame_);
+            open_timer_scopes_ = 0;
+        }
+
+        frame_stats_ = std::exchange(stats_, {});
+        frame_state_stats_ = std::exchange(state_stats_, {});
+        frame_draw_calls_ = std::exchange(draw_calls_, 0);
+        ++frame_;
+    }
+
+    void null_graphics_api::destroy(const frame_buffer_handle handle)
+    {
+        release(frame_buffers_, handle, "destroy frame_buffer_handle");
+    }
+
+    void null_graphics_api::destroy(const program_handle handle)
+    {
+        release(programs_, handle, "destroy program_handle");
+    }
+
+    void null_graphics_api::destroy(const shader_handle handle)
+    {
+        release(shaders_, handle, "destroy shader_handle");
+    }
+
+    void null_graphics_api::destroy(const vertex_buffer_handle handle)
+    {
+        release(vertex_buffers_, handle, "destroy vertex_buffer_handle");
+    }
+
+    void null_graphics_api::destroy(const index_buffer_handle handle)
+    {
+        release(index_buffers_, handle, "destroy index_buffer_handle");
+    }
+
+    void null_graphics_api::visit(clear_command& cmd)
+    {
+        count(command_type::clear, true);
+    }
+
+    void null_graphics_api::visit(draw_command& cmd)
+    {
+        constexpr auto invalid = std::numeric_limits<uint32_t>::max();
+
+        // the instance buffer is optional, and streamed draws read their indices from the stream buffer
+        auto valid = is_live(vertex_buffers_, cmd.vertex_buffer, "visit draw_command");
+
+        if (cmd.instance_buffer.id != invalid)
+        {
+            valid = is_live(vertex_buffers_, cmd.instance_buffer, "visit draw_command") && valid;
+        }
+
+        if (!cmd.streamed && cmd.index_buffer.id != invalid)
+        {
+            valid = is_live(index_buffers_, cmd.index_buffer, "visit draw_command") && valid;
+        }
+
+        // the indices themselves aren't kept, so only the ranges the draw reads can be checked against the buffer sizes
+        if (valid && !cmd.streamed)
+        {
+            const auto vertices = vertex_buffers_.get(cmd.vertex_buffer)->vertex_capacity();
+
+            if (cmd.is_indexed())
+            {
+                const auto index_end =
+                    cmd.index_buffer_offset + static_cast<size_t>(cmd.index_count) * index_size(cmd.idx_type);
+                const auto index_buffer_size = index_buffers_.get(cmd.index_buffer)->size;
+
+                if (index_end > index_buffer_size)
+                {
+                    log_.error("Draw reads {} bytes of indices from an index buffer of {} bytes", index_end, index_buffer_size);
+                    valid = false;
+                }
+
+                if (cmd.base_vertex < 0 || (cmd.index_count > 0 && static_cast<size_t>(cmd.base_vertex) >= vertices))
+                {
+                    log_.error("Base vertex {} is outside a vertex buffer of {} vertices", cmd.base_vertex, vertices);
+                    valid = false;
+                }
+            }
+            else if (static_cast<size_t>(cmd.first_vertex) + cmd.vertex_count > vertices)
+            {
+                log_.error(
+                    "Draw reads vertices {} to {} from a vertex buffer of {} vertices",
+                    cmd.first_vertex,
+                    static_cast<size_t>(cmd.first_vertex) + cmd.vertex_count,
+                    vertices);
+                valid = false;
+            }
+
+            if (cmd.instance_buffer.id != invalid)
+            {
+                const auto instances = vertex_buffers_.get(cmd.instance_buffer)->vertex_capacity();
+
+                if (static_cast<size_t>(cmd.first_instance) + cmd.instance_count > instances)
+                {
+                    log_.error(
+                        "Draw reads instances {} to {} from an instance buffer of {} instances",
+                        cmd.first_instance,
+                        static_cast<size_t>(cmd.first_instance) + cmd.instance_count,
+                        instances);
+                    valid = false;
+                }
+            }
+        }
+
+        // the material cache doesn't bounds check, so a material from another device would read past its end
+        if (cmd.material.id >= device_.get_material_cache().size())
+        {
+            log_.error("Invalid material {} passed to visit draw_command", cmd.material.id);
+            valid = false;
+        }
+
+        // draws are batched exactly as the GL backend batches them, which binds a material once for its whole run
+        if (valid)
+        {
+            auto& materials = device_.get_material_cache();
+
+            if (!batch_.accepts(cmd, materials))
+            {
+                end_batch();
+            }
+
+            if (batch_.empty())
+            {
+                bind(*materials.get_material(cmd.material));
+            }
+
+            batch_.add(cmd);
+        }
+
+        count(command_type::draw, valid);
+    }
+
+    void null_graphics_api::visit(viewport_command& cmd)
+    {
+        const auto valid = cmd.width >= 0 && cmd.height >= 0;
+
+        if (!valid)
+        {
+            log_.error("Negative viewport size {}x{}", cmd.width, cmd.height);
+        }
+
+        count(command_type::viewport, valid);
+    }
+
+    void null_graphics_api::visit(scissor_command& cmd)
+    {
+        const auto valid = cmd.width >= 0 && cmd.height >= 0;
+
+        if (!valid)
+        {
+            log_.error("Negative scissor size {}x{}", cmd.width, cmd.height);
+        }
+
+        count(command_type::scissor, valid);
+    }
+
+    void null_graphics_api::visit(fill_vertex_buffer_command& cmd)
+    {
+        auto valid = is_live(vertex_buffers_, cmd.handle, "visit fill_vertex_buffer_command");
+
+        // filling a vertex buffer reallocates it, just as glBufferData does
+        if (valid)
+        {
+            vertex_buffers_.get(cmd.handle)->size = cmd.size;
+        }
+
+        count(command_type::fill_vertex_buffer, valid);
+    }
+
+    void null_graphics_api::visit(fill_index_buffer_command& cmd)
+    {
+        auto valid = is_live(index_buffers_, cmd.handle, "visit fill_index_buffer_command");
+
+        if (valid)
+        {
+            index_buffers_.get(cmd.handle)->size = cmd.size;
+        }
+
+        count(command_type::fill_index_buffer, valid);
+    }
+
+    void null_graphics_api::visit(fill_uniform_buffer_command& cmd)
+    {
+        auto valid = is_live(uniform_buffers_, cmd.handle, "visit fill_uniform_buffer_command");
+
+        if (valid && cmd.size > uniform_buffers_.get(cmd.handle)->size)
+        {
+            log_.error(
+                "{} bytes written to a uniform buffer of {} bytes", cmd.size, uniform_buffers_.get(cmd.handle)->size);
+            valid = false;
+        }
+
+        count(command_type::fill_uniform_buffer, valid);
+    }
+
+    void null_graphics_api::visit(fill_stream_buffer_command& cmd)
+    {
+        // an invalid range means the stream buffer was full, which draws from it already tolerate
+        const auto valid = !cmd.range.is_valid() || cmd.data;
+
+        if (!valid)
+        {
+            log_.error("No host data passed to visit fill_stream_buffer_command");
+        }
+
+        count(command_type::fill_stream_buffer, valid);
+    }
+
+    void null_graphics_api::visit(gpu_timer_command& cmd)
+    {
+        auto valid = true;
+
+        if (cmd.event == gpu_timer_event::begin)
+        {
+            ++open_timer_scopes_;
+        }
+        else if (open_timer_scopes_ == 0)
+        {
+            log_.error("gpu_timer_command closed a scope that was never opened");
+            valid = false;
+        }
+        else
+        {
+            --open_timer_scopes_;
+        }
+
+        count(command_type::gpu_timer, valid);
+    }
+
+    void null_graphics_api::visit(read_pixels_command& cmd)
+    {
+        if (cmd.width <= 0 || cmd.height <= 0)
+        {
+            count(command_type::read_pixels, true);
+            return;
+        }
+
+        image_metadata image;
+        image.width = cmd.width;
+        image.height = cmd.height;
+        image.base_format = cmd.format;
+        image.type = cmd.pixel;
+
+        readback_result result;
+        result.tag = cmd.tag;
+        result.width = cmd.width;
+        result.height = cmd.height;
+        result.format = cmd.format;
+        result.pixel = cmd.pixel;
+        result.pixels.resize(image_size(image));
+
+        readbacks_.emplace_back(std::move(result));
+
+        count(command_type::read_pixels, true);
+    }
+
+    void null_graphics_api::visit(frame_buffer_command& cmd)
+    {
+        const auto valid = cmd.buffer.id == 0 || is_live(frame_buffers_, cmd.buffer, "visit frame_buffer_command");
+
+        count(command_type::frame_buffer, valid);
+    }
+
+    void null_graphics_api::visit(frame_buffer_texture_command& cmd)
+    {
+        const auto valid = is_live(textures_, cmd.texture, "visit frame_buffer_texture_command");
+
+        count(command_type::frame_buffer_texture, valid);
+    }
+
+    void null_graphics_api::visit(generate_mipmaps_command& cmd)
+    {
+        const auto valid = is_live(textures_, cmd.texture, "visit generate_mipmaps_command");
+
+        count(command_type::generate_mipmaps, valid);
+    }
+
+    void null_graphics_api::visit(set_material_parameters_command& cmd)
+    {
+        auto& materials = device_.get_material_cache();
+        auto* material = cmd.material.id < materials.size() ? materials.get_material(cmd.material) : nullptr;
+
+        auto valid = material != nullptr;
+
+        if (material)
+        {
+            batch_.write_parameters(cmd, *material);
+
+            cmd.for_each_parameter([material, &valid](const material_parameter_record& record) {
+                if (record.index < material->size())
+                {
+                    auto& parameter = (*material)[record.index];
+                    parameter.type = record.type;
+                    parameter.data = record.get_data();
+                    parameter.count = 1;
+                }
+                else
+                {
+                    log_.error("Invalid material parameter {} passed to visit set_material_parameters_command", record.index);
+                    valid = false;
+                }
+            });
+        }
+        else
+        {
+            log_.error("Invalid material {} passed to visit set_material_parameters_command", cmd.material.id);
+        }
+
+        count(command_type::set_material_parameters, valid);
+    }
+} // namespace moka
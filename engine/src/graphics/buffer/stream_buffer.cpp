@@ -0,0 +1,79 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <graphics/buffer/stream_buffer.hpp>
+
+namespace moka
+{
+    bool stream_range::is_valid() const
+    {
+        return offset != std::numeric_limits<uint32_t>::max();
+    }
+
+    stream_allocator::stream_allocator(const size_t capacity) : head_(0), capacity_(capacity)
+    {
+    }
+
+    stream_range stream_allocator::allocate(const size_t size, const size_t alignment)
+    {
+        const auto align = alignment == 0 ? 1 : alignment;
+
+        auto head = head_.load(std::memory_order_relaxed);
+
+        size_t offset;
+
+        do
+        {
+            offset = (head + align - 1) / align * align;
+
+            if (offset + size > capacity_)
+            {
+                return {};
+            }
+        } while (!head_.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+        return {static_cast<uint32_t>(offset), static_cast<uint32_t>(size)};
+    }
+
+    void stream_allocator::reset()
+    {
+        head_.store(0, std::memory_order_relaxed);
+    }
+
+    size_t stream_allocator::size() const
+    {
+        return head_.load(std::memory_order_relaxed);
+    }
+
+    size_t stream_allocator::capacity() const
+    {
+        return capacity_;
+    }
+} // namespace moka
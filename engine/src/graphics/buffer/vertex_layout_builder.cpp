@@ -33,9 +33,9 @@ SOFTWARE.
 namespace moka
 {
     vertex_layout_builder& vertex_layout_builder::add_attribute(
-        size_t index, size_t size, attribute_type type, bool normalized, size_t stride, size_t offset)
+        size_t index, size_t size, attribute_type type, bool normalized, size_t stride, size_t offset, size_t divisor)
     {
-        this->attr_.emplace_back(index, type, size, normalized, stride, offset);
+        this->attr_.emplace_back(index, type, size, normalized, stride, offset, divisor);
         return *this;
     }
 
@@ -28,17 +28,9 @@ SOFTWARE.
 ===========================================================================
 */
 #include <graphics/command/clear_command.hpp>
-#include <graphics/device/graphics_visitor.hpp>
 
 namespace moka
 {
-    clear_command::~clear_command() = default;
-
-    void clear_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
-    }
-
     clear_command& clear_command::set_color(const glm::vec4& color)
     {
         this->color = color;
@@ -0,0 +1,178 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <algorithm>
+#include <cstdint>
+#include <graphics/command/command_allocator.hpp>
+
+namespace moka
+{
+    namespace
+    {
+        size_t align_offset(const std::byte* base, const size_t offset, const size_t alignment)
+        {
+            const auto address = reinterpret_cast<std::uintptr_t>(base) + offset;
+            const auto aligned = (address + alignment - 1) & ~(static_cast<std::uintptr_t>(alignment) - 1);
+            return offset + static_cast<size_t>(aligned - address);
+        }
+    } // namespace
+
+    command_allocator::command_allocator(const size_t block_size)
+        : block_size_(block_size)
+    {
+    }
+
+    command_allocator::~command_allocator() = default;
+
+    command_allocator::command_allocator(command_allocator&& rhs) noexcept
+        : blocks_(std::move(rhs.blocks_)),
+          current_block_(rhs.current_block_),
+          offset_(rhs.offset_),
+          block_size_(rhs.block_size_),
+          bytes_used_(rhs.bytes_used_),
+          heap_allocations_(rhs.heap_allocations_)
+    {
+        rhs.current_block_ = 0;
+        rhs.offset_ = 0;
+        rhs.bytes_used_ = 0;
+    }
+
+    command_allocator& command_allocator::operator=(command_allocator&& rhs) noexcept
+    {
+        blocks_ = std::move(rhs.blocks_);
+        current_block_ = rhs.current_block_;
+        offset_ = rhs.offset_;
+        block_size_ = rhs.block_size_;
+        bytes_used_ = rhs.bytes_used_;
+        heap_allocations_ = rhs.heap_allocations_;
+        rhs.current_block_ = 0;
+        rhs.offset_ = 0;
+        rhs.bytes_used_ = 0;
+        return *this;
+    }
+
+    void* command_allocator::allocate(const size_t size, const size_t alignment)
+    {
+        if (current_block_ < blocks_.size())
+        {
+            auto& current = blocks_[current_block_];
+
+            const auto start = align_offset(current.data.get(), offset_, alignment);
+
+            if (start + size <= current.size)
+            {
+                offset_ = start + size;
+                bytes_used_ += size;
+                return current.data.get() + start;
+            }
+
+            ++current_block_;
+        }
+
+        return allocate_from_next_block(size, alignment);
+    }
+
+    bool command_allocator::extend(void* memory, const size_t size, const size_t new_size)
+    {
+        if (current_block_ >= blocks_.size() || new_size < size)
+        {
+            return false;
+        }
+
+        // only the most recent allocation can grow, and only into the rest of its block
+        auto& current = blocks_[current_block_];
+
+        if (static_cast<std::byte*>(memory) + size != current.data.get() + offset_ || offset_ - size + new_size > current.size)
+        {
+            return false;
+        }
+
+        offset_ += new_size - size;
+        bytes_used_ += new_size - size;
+        return true;
+    }
+
+    void* command_allocator::allocate_from_next_block(const size_t size, const size_t alignment)
+    {
+        // reuse blocks kept from previous frames before going to the heap
+        for (; current_block_ < blocks_.size(); ++current_block_)
+        {
+            auto& candidate = blocks_[current_block_];
+
+            const auto start = align_offset(candidate.data.get(), 0, alignment);
+
+            if (start + size <= candidate.size)
+            {
+                offset_ = start + size;
+                bytes_used_ += size;
+                return candidate.data.get() + start;
+            }
+        }
+
+        block new_block;
+        new_block.size = std::max(block_size_, size + alignment);
+        new_block.data = std::make_unique<std::byte[]>(new_block.size);
+        ++heap_allocations_;
+
+        auto& current = blocks_.emplace_back(std::move(new_block));
+        current_block_ = blocks_.size() - 1;
+
+        const auto start = align_offset(current.data.get(), 0, alignment);
+        offset_ = start + size;
+        bytes_used_ += size;
+        return current.data.get() + start;
+    }
+
+    void command_allocator::reset()
+    {
+        current_block_ = 0;
+        offset_ = 0;
+        bytes_used_ = 0;
+    }
+
+    size_t command_allocator::size() const
+    {
+        return bytes_used_;
+    }
+
+    size_t command_allocator::capacity() const
+    {
+        size_t result = 0;
+        for (const auto& item : blocks_)
+        {
+            result += item.size;
+        }
+        return result;
+    }
+
+    size_t command_allocator::heap_allocations() const
+    {
+        return heap_allocations_;
+    }
+} // namespace moka
@@ -27,47 +27,137 @@ SOFTWARE.
 
 ===========================================================================
 */
-#include <graphics/command/clear_command.hpp>
+#include <algorithm>
 #include <graphics/command/command_buffer.hpp>
-#include <graphics/command/draw_command.hpp>
-#include <graphics/command/fill_index_buffer_command.hpp>
-#include <graphics/command/fill_vertex_buffer_command.hpp>
-#include <graphics/command/frame_buffer_command.hpp>
-#include <graphics/command/frame_buffer_texture_command.hpp>
-#include <graphics/command/generate_mipmaps_command.hpp>
-#include <graphics/command/scissor_command.hpp>
-#include <graphics/command/set_material_properties_command.hpp>
-#include <graphics/command/viewport_command.hpp>
 
 namespace moka
 {
-    command_buffer::command_buffer(const sort_key id) : id_(id)
+    static_assert(std::is_trivially_copyable_v<clear_command>);
+    static_assert(std::is_trivially_copyable_v<draw_command>);
+    static_assert(std::is_trivially_copyable_v<viewport_command>);
+    static_assert(std::is_trivially_copyable_v<scissor_command>);
+    static_assert(std::is_trivially_copyable_v<fill_vertex_buffer_command>);
+    static_assert(std::is_trivially_copyable_v<fill_index_buffer_command>);
+    static_assert(std::is_trivially_copyable_v<fill_uniform_buffer_command>);
+    static_assert(std::is_trivially_copyable_v<fill_stream_buffer_command>);
+    static_assert(std::is_trivially_copyable_v<gpu_timer_command>);
+    static_assert(std::is_trivially_copyable_v<read_pixels_command>);
+    static_assert(std::is_trivially_copyable_v<frame_buffer_command>);
+    static_assert(std::is_trivially_copyable_v<frame_buffer_texture_command>);
+    static_assert(std::is_trivially_copyable_v<generate_mipmaps_command>);
+    static_assert(std::is_trivially_copyable_v<set_material_parameters_command>);
+
+    command_buffer::command_buffer(command_allocator& allocator, const sort_key id, const material_cache* materials)
+        : allocator_(&allocator), materials_(materials), id_(id)
     {
     }
 
     command_buffer::command_buffer(command_buffer&& command_buffer) noexcept
-        : commands_(std::move(command_buffer.commands_)), id_(command_buffer.id_)
+        : allocator_(command_buffer.allocator_),
+          materials_(command_buffer.materials_),
+          data_(command_buffer.data_),
+          size_(command_buffer.size_),
+          capacity_(command_buffer.capacity_),
+          id_(command_buffer.id_)
     {
+        command_buffer.data_ = nullptr;
+        command_buffer.size_ = 0;
+        command_buffer.capacity_ = 0;
     }
 
     command_buffer& command_buffer::operator=(command_buffer&& command_buffer) noexcept
     {
-        commands_ = std::move(command_buffer.commands_);
-        id_ = command_buffer.id_;
+        if (this != &command_buffer)
+        {
+            allocator_ = command_buffer.allocator_;
+            materials_ = command_buffer.materials_;
+            data_ = command_buffer.data_;
+            size_ = command_buffer.size_;
+            capacity_ = command_buffer.capacity_;
+            id_ = command_buffer.id_;
+            command_buffer.data_ = nullptr;
+            command_buffer.size_ = 0;
+            command_buffer.capacity_ = 0;
+        }
         return *this;
     }
 
-    const sort_key& command_buffer::get_key() const
+    void command_buffer::reserve(const size_t size)
     {
-        return id_;
+        if (size <= capacity_)
+        {
+            return;
+        }
+
+        // while this buffer was the last thing allocated it grows in place, so a frame's records stay contiguous
+        if (data_ && allocator_->extend(data_, capacity_, size))
+        {
+            capacity_ = static_cast<uint32_t>(size);
+            return;
+        }
+
+        const auto capacity = std::max<size_t>(size, capacity_ * 2);
+        auto* data = static_cast<std::byte*>(allocator_->allocate(capacity, command_alignment));
+
+        // the old records stay in the allocator until it is reset
+        if (size_ > 0)
+        {
+            std::memcpy(data, data_, size_);
+        }
+
+        data_ = data;
+        capacity_ = static_cast<uint32_t>(capacity);
     }
 
-    void command_buffer::accept(graphics_visitor& device)
+    std::byte* command_buffer::append(const size_t size)
     {
-        for (auto& command : commands_)
+        reserve(size_ + size);
+
+        auto* record = data_ + size_;
+        size_ += static_cast<uint32_t>(size);
+
+        return record;
+    }
+
+    std::byte* command_buffer::grow_record(const uint32_t offset, const size_t used, const size_t size)
+    {
+        const auto record_size = reinterpret_cast<command_header*>(data_ + offset)->size;
+
+        // data can only trail the last record
+        if (offset + record_size != size_)
         {
-            command->accept(device);
+            return nullptr;
         }
+
+        const auto new_size = align_command_size(used + size);
+
+        if (new_size > record_size)
+        {
+            append(new_size - record_size);
+            reinterpret_cast<command_header*>(data_ + offset)->size = static_cast<uint32_t>(new_size);
+        }
+
+        return data_ + offset + used;
+    }
+
+    const sort_key& command_buffer::get_key() const
+    {
+        return id_;
+    }
+
+    command_iterator command_buffer::begin() const
+    {
+        return command_iterator{data_};
+    }
+
+    command_iterator command_buffer::end() const
+    {
+        return command_iterator{data_ + size_};
+    }
+
+    size_t command_buffer::size() const
+    {
+        return size_;
     }
 
     frame_buffer_command& command_buffer::frame_buffer()
@@ -110,13 +200,35 @@ namespace moka
         return emplace_back<fill_vertex_buffer_command>();
     }
 
+    fill_uniform_buffer_command& command_buffer::fill_uniform_buffer()
+    {
+        return emplace_back<fill_uniform_buffer_command>();
+    }
+
+    fill_stream_buffer_command& command_buffer::fill_stream_buffer()
+    {
+        return emplace_back<fill_stream_buffer_command>();
+    }
+
+    gpu_timer_command& command_buffer::gpu_timer()
+    {
+        return emplace_back<gpu_timer_command>();
+    }
+
+    read_pixels_command& command_buffer::read_pixels()
+    {
+        return emplace_back<read_pixels_command>();
+    }
+
     generate_mipmaps_command& command_buffer::generate_mipmaps()
     {
         return emplace_back<generate_mipmaps_command>();
     }
 
-    set_material_parameters_command& command_buffer::set_material_parameters()
+    set_material_parameters_builder command_buffer::set_material_parameters()
     {
-        return emplace_back<set_material_parameters_command>();
+        const auto offset = size_;
+        emplace_back<set_material_parameters_command>();
+        return set_material_parameters_builder{*this, offset};
     }
 } // namespace moka
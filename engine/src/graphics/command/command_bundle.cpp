@@ -0,0 +1,262 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <application/logger.hpp>
+#include <graphics/command/command_bundle.hpp>
+#include <graphics/device/graphics_device.hpp>
+#include <utility>
+
+namespace moka
+{
+    namespace
+    {
+        logger log_("command_bundle");
+
+        /**
+         * \brief Counts the commands of a bundle that can't be executed.
+         */
+        struct bundle_validator final
+        {
+            size_t invalid_commands = 0;
+
+            void visit(draw_command& cmd)
+            {
+                if (cmd.vertex_buffer.id == std::numeric_limits<uint32_t>::max())
+                {
+                    log_.error("Bundled draw_command has no vertex buffer");
+                    ++invalid_commands;
+                }
+
+                if (cmd.streamed)
+                {
+                    log_.error("Bundled draw_command reads from the stream buffer, which is only valid for one frame");
+                    ++invalid_commands;
+                }
+            }
+
+            void visit(set_material_parameters_command& cmd)
+            {
+                if (cmd.material.id == std::numeric_limits<uint16_t>::max())
+                {
+                    log_.error("Bundled set_material_parameters_command has no material");
+                    ++invalid_commands;
+                }
+            }
+
+            void visit(fill_vertex_buffer_command& cmd)
+            {
+                if (!cmd.data)
+                {
+                    log_.error("Bundled fill_vertex_buffer_command has no data");
+                    ++invalid_commands;
+                }
+            }
+
+            void visit(fill_index_buffer_command& cmd)
+            {
+                if (!cmd.data)
+                {
+                    log_.error("Bundled fill_index_buffer_command has no data");
+                    ++invalid_commands;
+                }
+            }
+
+            void visit(fill_uniform_buffer_command& cmd)
+            {
+                if (!cmd.data)
+                {
+                    log_.error("Bundled fill_uniform_buffer_command has no data");
+                    ++invalid_commands;
+                }
+            }
+
+            void visit(fill_stream_buffer_command&)
+            {
+                log_.error("Bundled fill_stream_buffer_command writes to the stream buffer, which is only valid for one frame");
+                ++invalid_commands;
+            }
+
+            template <typename T>
+            void visit(T&)
+            {
+            }
+        };
+
+        /**
+         * \brief Collects the material parameters with a given name.
+         */
+        struct patch_collector final
+        {
+            const material_cache& materials;
+            const std::string& name;
+            std::vector<material_parameter_record*>& locations;
+
+            void visit(set_material_parameters_command& cmd)
+            {
+                const auto* material = cmd.material.id < materials.size() ? materials.get_material(cmd.material) : nullptr;
+
+                // each material has its own parameter indices
+                const auto index = material ? material->find_index(name) : -1;
+
+                if (index == -1)
+                {
+                    return;
+                }
+
+                cmd.for_each_parameter([this, index](material_parameter_record& record) {
+                    if (record.index == index)
+                    {
+                        locations.emplace_back(&record);
+                    }
+                });
+            }
+
+            template <typename T>
+            void visit(T&)
+            {
+            }
+        };
+    } // namespace
+
+    command_bundle::command_bundle(command_list&& commands)
+        : commands_(std::move(commands))
+    {
+        if (!commands_.is_sorted())
+        {
+            commands_.sort();
+        }
+
+        bundle_validator validator;
+        commands_.accept(validator);
+        invalid_commands_ = validator.invalid_commands;
+    }
+
+    command_bundle& command_bundle::add_patch(const material_cache& materials, const std::string& name)
+    {
+        const auto [patch, added] = patches_.try_emplace(name);
+
+        if (!added)
+        {
+            log_.error("Bundle patch \"{}\" is already registered", name);
+            return *this;
+        }
+
+        auto& locations = patch->second;
+
+        patch_collector collector{materials, name, locations};
+        commands_.accept(collector);
+
+        if (locations.empty())
+        {
+            log_.warn("Bundle patch \"{}\" does not match any material parameter", name);
+        }
+
+        return *this;
+    }
+
+    template <typename T>
+    command_bundle& command_bundle::set_patch(const std::string& name, const T& data)
+    {
+        const auto patch = patches_.find(name);
+
+        if (patch == patches_.end())
+        {
+            log_.error("Bundle parameter \"{}\" has not been registered with add_patch", name);
+            return *this;
+        }
+
+        pending_patches_.push_back({&patch->second, parameter{data}});
+
+        return *this;
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const float data)
+    {
+        return set_patch(name, data);
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const glm::vec3& data)
+    {
+        return set_patch(name, data);
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const glm::vec4& data)
+    {
+        return set_patch(name, data);
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const glm::mat3& data)
+    {
+        return set_patch(name, data);
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const glm::mat4& data)
+    {
+        return set_patch(name, data);
+    }
+
+    command_bundle& command_bundle::set_parameter(const std::string& name, const texture_handle data)
+    {
+        return set_patch(name, data);
+    }
+
+    size_t command_bundle::get_invalid_command_count() const
+    {
+        return invalid_commands_;
+    }
+
+    bool command_bundle::is_valid() const
+    {
+        return invalid_commands_ == 0;
+    }
+
+    std::vector<bundle_patch> command_bundle::take_patches()
+    {
+        return std::exchange(pending_patches_, {});
+    }
+
+    void command_bundle::apply_patches(const std::vector<bundle_patch>& patches)
+    {
+        for (const auto& patch : patches)
+        {
+            for (auto* record : *patch.locations)
+            {
+                if (!record->set_data(patch.value))
+                {
+                    log_.error("Bundle patch value doesn't match the type of material parameter {}", record->index);
+                }
+            }
+        }
+    }
+
+    command_list& command_bundle::get_commands()
+    {
+        return commands_;
+    }
+} // namespace moka
@@ -28,46 +28,235 @@ SOFTWARE.
 ===========================================================================
 */
 #include <algorithm>
+#include <cstring>
 #include <graphics/command/command_list.hpp>
 
 namespace moka
 {
-    bool command_list::key_comparator::operator()(const command_buffer& left, const command_buffer& right) const
+    command_list::command_list() = default;
+
+    command_list::command_list(command_allocator& allocator)
+        : allocator_(&allocator)
     {
-        return left.get_key() < right.get_key();
     }
 
-    command_list::command_list() = default;
+    command_list::command_list(const material_cache& materials)
+        : materials_(&materials)
+    {
+    }
+
+    command_list::command_list(command_allocator& allocator, const material_cache& materials)
+        : allocator_(&allocator), materials_(&materials)
+    {
+    }
 
     command_list::~command_list() = default;
 
     command_list::command_list(command_list&& command_list) noexcept
-        : command_packets_(std::move(command_list.command_packets_))
+        : is_sorted_(command_list.is_sorted_),
+          current_key_(command_list.current_key_),
+          owned_allocator_(std::move(command_list.owned_allocator_)),
+          retained_allocators_(std::move(command_list.retained_allocators_)),
+          allocator_(command_list.allocator_),
+          materials_(command_list.materials_),
+          command_packets_(std::move(command_list.command_packets_))
     {
+        command_list.allocator_ = nullptr;
     }
 
     command_list& command_list::operator=(command_list&& command_list) noexcept
     {
+        // release our commands before the allocator that owns them
+        command_packets_.clear();
+        is_sorted_ = command_list.is_sorted_;
+        current_key_ = command_list.current_key_;
+        owned_allocator_ = std::move(command_list.owned_allocator_);
+        retained_allocators_ = std::move(command_list.retained_allocators_);
+        allocator_ = command_list.allocator_;
+        materials_ = command_list.materials_;
         command_packets_ = std::move(command_list.command_packets_);
+        command_list.allocator_ = nullptr;
         return *this;
     }
 
+    command_allocator& command_list::get_allocator()
+    {
+        // command lists that don't borrow an allocator create their own on first use
+        if (!allocator_)
+        {
+            owned_allocator_ = std::make_unique<command_allocator>();
+            allocator_ = owned_allocator_.get();
+        }
+        return *allocator_;
+    }
+
     void command_list::destroy()
     {
         command_packets_.clear();
+        retained_allocators_.clear();
+
+        if (owned_allocator_)
+        {
+            owned_allocator_->reset();
+        }
     }
 
-    void command_list::accept(graphics_visitor& device)
+    command_list command_list::merge(std::vector<command_list>&& lists)
     {
-        for (auto& command_packet : command_packets_)
+        command_list result;
+
+        size_t total = 0;
+        for (auto& list : lists)
         {
-            command_packet.accept(device);
+            if (!list.is_sorted())
+            {
+                list.sort();
+            }
+            total += list.command_packets_.size();
         }
+
+        result.command_packets_.reserve(total);
+
+        // the next unmerged command buffer of each list, kept in a min-heap
+        struct cursor final
+        {
+            sort_key key;
+            uint32_t list;
+            uint32_t position;
+        };
+
+        const auto later = [](const cursor& left, const cursor& right) {
+            return left.key > right.key || (left.key == right.key && left.list > right.list);
+        };
+
+        std::vector<cursor> heap;
+        heap.reserve(lists.size());
+
+        for (size_t i = 0; i < lists.size(); ++i)
+        {
+            if (!lists[i].command_packets_.empty())
+            {
+                heap.push_back({lists[i].command_packets_.front().get_key(), static_cast<uint32_t>(i), 0});
+            }
+        }
+
+        std::make_heap(heap.begin(), heap.end(), later);
+
+        while (!heap.empty())
+        {
+            std::pop_heap(heap.begin(), heap.end(), later);
+            auto& next = heap.back();
+
+            auto& source = lists[next.list].command_packets_;
+            result.command_packets_.emplace_back(std::move(source[next.position]));
+
+            if (++next.position < source.size())
+            {
+                next.key = source[next.position].get_key();
+                std::push_heap(heap.begin(), heap.end(), later);
+            }
+            else
+            {
+                heap.pop_back();
+            }
+        }
+
+        // the merged command buffers still live in the allocators of the source lists
+        for (auto& list : lists)
+        {
+            list.command_packets_.clear();
+
+            // keep recording into a borrowed allocator, never into one that is only retained
+            if (!result.allocator_ && !list.owned_allocator_)
+            {
+                result.allocator_ = list.allocator_;
+            }
+
+            if (!result.materials_)
+            {
+                result.materials_ = list.materials_;
+            }
+
+            if (list.owned_allocator_)
+            {
+                result.retained_allocators_.emplace_back(std::move(list.owned_allocator_));
+            }
+
+            for (auto& allocator : list.retained_allocators_)
+            {
+                result.retained_allocators_.emplace_back(std::move(allocator));
+            }
+
+            list.retained_allocators_.clear();
+            list.allocator_ = nullptr;
+        }
+
+        if (!result.command_packets_.empty())
+        {
+            result.current_key_ = result.command_packets_.back().get_key();
+        }
+
+        result.is_sorted_ = true;
+
+        return result;
     }
 
     void command_list::sort()
     {
-        std::sort(command_packets_.begin(), command_packets_.end(), key_comparator{});
+        const auto count = command_packets_.size();
+
+        if (count > 1)
+        {
+            // sort (key, index) pairs rather than shuffling the command buffers themselves
+            auto& allocator = get_allocator();
+            auto* entries = static_cast<sort_entry*>(
+                allocator.allocate(sizeof(sort_entry) * count * 2, alignof(sort_entry)));
+            auto* scratch = entries + count;
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                entries[i] = {command_packets_[i].get_key(), static_cast<uint32_t>(i)};
+            }
+
+            if (count < radix_sort_threshold)
+            {
+                std::sort(entries, entries + count, [](const sort_entry& left, const sort_entry& right) {
+                    return left.key < right.key || (left.key == right.key && left.index < right.index);
+                });
+            }
+            else
+            {
+                radix_sort(entries, scratch, count);
+            }
+
+            // apply the permutation in place, following each cycle once
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (entries[i].index == i)
+                {
+                    continue;
+                }
+
+                auto temp = std::move(command_packets_[i]);
+                auto current = i;
+
+                while (true)
+                {
+                    const size_t next = entries[current].index;
+                    entries[current].index = static_cast<uint32_t>(current);
+
+                    if (next == i)
+                    {
+                        command_packets_[current] = std::move(temp);
+                        break;
+                    }
+
+                    command_packets_[current] = std::move(command_packets_[next]);
+                    current = next;
+                }
+            }
+        }
+
         is_sorted_ = true;
     }
 
@@ -103,27 +292,38 @@ namespace moka
 
     command_buffer& command_list::make_command_buffer(const sort_key key)
     {
-        static auto num_calls = 0;
-        num_calls++;
         is_sorted_ = false;
 
         current_key_ = key;
-        command_packets_.emplace_back(key);
+        command_packets_.emplace_back(get_allocator(), key, materials_);
 
         return command_packets_.back();
     }
 
+    const void* command_list::store(const void* data, const size_t size)
+    {
+        if (!data || size == 0)
+        {
+            return nullptr;
+        }
+
+        auto* copy = get_allocator().allocate(size, alignof(std::max_align_t));
+        std::memcpy(copy, data, size);
+
+        return copy;
+    }
+
     command_buffer& command_list::make_command_buffer()
     {
         return make_command_buffer(current_key_ + 1);
     }
 
-    set_material_parameters_command& command_list::set_material_parameters()
+    set_material_parameters_builder command_list::set_material_parameters()
     {
         return make_command_buffer().set_material_parameters();
     }
 
-    set_material_parameters_command& command_list::set_material_parameters(sort_key key)
+    set_material_parameters_builder command_list::set_material_parameters(sort_key key)
     {
         return make_command_buffer(key).set_material_parameters();
     }
@@ -208,6 +408,46 @@ namespace moka
         return make_command_buffer(key).fill_vertex_buffer();
     }
 
+    fill_uniform_buffer_command& command_list::fill_uniform_buffer()
+    {
+        return make_command_buffer().fill_uniform_buffer();
+    }
+
+    fill_uniform_buffer_command& command_list::fill_uniform_buffer(const sort_key key)
+    {
+        return make_command_buffer(key).fill_uniform_buffer();
+    }
+
+    fill_stream_buffer_command& command_list::fill_stream_buffer()
+    {
+        return make_command_buffer().fill_stream_buffer();
+    }
+
+    fill_stream_buffer_command& command_list::fill_stream_buffer(const sort_key key)
+    {
+        return make_command_buffer(key).fill_stream_buffer();
+    }
+
+    gpu_timer_command& command_list::gpu_timer()
+    {
+        return make_command_buffer().gpu_timer();
+    }
+
+    gpu_timer_command& command_list::gpu_timer(const sort_key key)
+    {
+        return make_command_buffer(key).gpu_timer();
+    }
+
+    read_pixels_command& command_list::read_pixels()
+    {
+        return make_command_buffer().read_pixels();
+    }
+
+    read_pixels_command& command_list::read_pixels(const sort_key key)
+    {
+        return make_command_buffer(key).read_pixels();
+    }
+
     generate_mipmaps_command& command_list::generate_mipmaps()
     {
         return make_command_buffer().generate_mipmaps();
@@ -0,0 +1,230 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <algorithm>
+#include <cstring>
+#include <graphics/command/command_optimizer.hpp>
+#include <graphics/device/graphics_device.hpp>
+
+namespace moka
+{
+    namespace
+    {
+        bool same_value(const material_parameter& left, const parameter& right)
+        {
+            return left.type != parameter_type::null && left.count == 1 && left.data == right;
+        }
+
+        /**
+         * \brief Tracks the state set by the commands seen so far, and flags the commands that are redundant.
+         */
+        struct redundancy_tracker final
+        {
+            const material_cache& materials;
+            std::unordered_map<uint16_t, std::unordered_map<uint16_t, parameter>>& written;
+
+            bool has_viewport = false;
+            int viewport[4] = {};
+
+            bool has_scissor = false;
+            int scissor[4] = {};
+
+            bool has_frame_buffer = false;
+            frame_buffer_handle frame_buffer;
+
+            size_t parameters_removed = 0;
+
+            bool remove = false;
+
+            static bool update(bool& has_state, int (&state)[4], const int x, const int y, const int width, const int height)
+            {
+                const auto same = has_state && state[0] == x && state[1] == y && state[2] == width && state[3] == height;
+
+                has_state = true;
+                state[0] = x;
+                state[1] = y;
+                state[2] = width;
+                state[3] = height;
+
+                return same;
+            }
+
+            void visit(viewport_command& cmd)
+            {
+                remove = update(has_viewport, viewport, cmd.x, cmd.y, cmd.width, cmd.height);
+            }
+
+            void visit(scissor_command& cmd)
+            {
+                remove = update(has_scissor, scissor, cmd.x, cmd.y, cmd.width, cmd.height);
+            }
+
+            void visit(frame_buffer_command& cmd)
+            {
+                remove = has_frame_buffer && frame_buffer.id == cmd.buffer.id;
+                has_frame_buffer = true;
+                frame_buffer = cmd.buffer;
+            }
+
+            void visit(clear_command& cmd)
+            {
+                remove = !cmd.clear_color && !cmd.clear_depth;
+            }
+
+            void visit(draw_command& cmd)
+            {
+                remove = cmd.vertex_buffer.id == std::numeric_limits<uint32_t>::max() || cmd.instance_count == 0 ||
+                         (cmd.is_indexed() ? cmd.index_count == 0 : cmd.vertex_count == 0);
+            }
+
+            void visit(fill_vertex_buffer_command& cmd)
+            {
+                remove = cmd.size == 0;
+            }
+
+            void visit(fill_index_buffer_command& cmd)
+            {
+                remove = cmd.size == 0;
+            }
+
+            void visit(fill_uniform_buffer_command& cmd)
+            {
+                remove = cmd.size == 0;
+            }
+
+            void visit(fill_stream_buffer_command& cmd)
+            {
+                remove = !cmd.range.is_valid() || cmd.range.size == 0;
+            }
+
+            void visit(frame_buffer_texture_command&)
+            {
+                remove = false;
+            }
+
+            void visit(generate_mipmaps_command&)
+            {
+                remove = false;
+            }
+
+            void visit(gpu_timer_command&)
+            {
+                remove = false;
+            }
+
+            void visit(read_pixels_command&)
+            {
+                remove = false;
+            }
+
+            void visit(set_material_parameters_command& cmd)
+            {
+                const auto* material = materials.get_material(cmd.material);
+
+                // the backend ignores parameters for materials that don't exist
+                if (!material)
+                {
+                    parameters_removed += cmd.count;
+                    remove = true;
+                    return;
+                }
+
+                auto& values = written[cmd.material.id];
+
+                // slide the parameters that change a value over the ones that don't
+                auto* record = cmd.get_parameters();
+                auto* kept = reinterpret_cast<std::byte*>(record);
+                uint16_t count = 0;
+
+                for (uint16_t i = 0; i < cmd.count; ++i)
+                {
+                    auto* next = record->next();
+                    const auto size = record->size();
+                    const auto data = record->get_data();
+
+                    const auto previous = values.find(record->index);
+
+                    const auto same = previous != values.end()
+                                          ? previous->second == data
+                                          : record->index < material->size() && same_value((*material)[record->index], data);
+
+                    if (same)
+                    {
+                        ++parameters_removed;
+                    }
+                    else
+                    {
+                        values[record->index] = data;
+
+                        if (kept != reinterpret_cast<std::byte*>(record))
+                        {
+                            std::memmove(kept, record, size);
+                        }
+
+                        kept += size;
+                        ++count;
+                    }
+
+                    record = next;
+                }
+
+                cmd.count = count;
+
+                remove = count == 0;
+            }
+        };
+    } // namespace
+
+    command_optimizer::command_optimizer(const material_cache& materials)
+        : materials_(materials)
+    {
+    }
+
+    command_optimizer_stats command_optimizer::optimize(command_list& list)
+    {
+        written_.clear();
+
+        redundancy_tracker tracker{materials_, written_};
+
+        command_optimizer_stats stats;
+
+        for (auto& buffer : list)
+        {
+            stats.commands_removed += buffer.remove_if([&tracker](command_header& header) {
+                tracker.remove = false;
+                dispatch(header, tracker);
+                return tracker.remove;
+            });
+        }
+
+        stats.parameters_removed = tracker.parameters_removed;
+
+        return stats;
+    }
+} // namespace moka
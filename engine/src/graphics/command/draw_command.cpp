@@ -28,70 +28,13 @@ SOFTWARE.
 ===========================================================================
 */
 #include <graphics/command/draw_command.hpp>
+#include <limits>
 
 namespace moka
 {
-    draw_command::draw_command() = default;
-
-    draw_command::~draw_command() = default;
-
-    draw_command::draw_command(const draw_command& rhs)
-        : material(rhs.material),
-          vertex_buffer(rhs.vertex_buffer),
-          vertex_count(rhs.vertex_count),
-          first_vertex(rhs.first_vertex),
-          index_buffer(rhs.index_buffer),
-          index_count(rhs.index_count),
-          idx_type(rhs.idx_type),
-          index_buffer_offset(rhs.index_buffer_offset),
-          prim_type(rhs.prim_type)
+    bool draw_command::is_indexed() const
     {
-    }
-
-    draw_command& draw_command::operator=(const draw_command& rhs)
-    {
-        material = rhs.material;
-        vertex_buffer = rhs.vertex_buffer;
-        vertex_count = rhs.vertex_count;
-        first_vertex = rhs.first_vertex;
-        index_buffer = rhs.index_buffer;
-        index_count = rhs.index_count;
-        idx_type = rhs.idx_type;
-        index_buffer_offset = rhs.index_buffer_offset;
-        prim_type = rhs.prim_type;
-        return *this;
-    }
-
-    draw_command::draw_command(draw_command&& rhs) noexcept
-        : material(std::move(rhs.material)),
-          vertex_buffer(rhs.vertex_buffer),
-          vertex_count(rhs.vertex_count),
-          first_vertex(rhs.first_vertex),
-          index_buffer(rhs.index_buffer),
-          index_count(rhs.index_count),
-          idx_type(rhs.idx_type),
-          index_buffer_offset(rhs.index_buffer_offset),
-          prim_type(rhs.prim_type)
-    {
-    }
-
-    draw_command& draw_command::operator=(draw_command&& rhs) noexcept
-    {
-        material = std::move(rhs.material);
-        vertex_buffer = rhs.vertex_buffer;
-        vertex_count = rhs.vertex_count;
-        first_vertex = rhs.first_vertex;
-        index_buffer = rhs.index_buffer;
-        index_count = rhs.index_count;
-        idx_type = rhs.idx_type;
-        index_buffer_offset = rhs.index_buffer_offset;
-        prim_type = rhs.prim_type;
-        return *this;
-    }
-
-    void draw_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
+        return streamed ? index_count != 0 : index_buffer.id != std::numeric_limits<uint32_t>::max();
     }
 
     draw_command& draw_command::set_index_buffer_offset(uint32_t offset)
@@ -147,4 +90,25 @@ namespace moka
         this->index_buffer = index_buffer;
         return *this;
     }
+
+    draw_command& draw_command::set_base_vertex(const int32_t base)
+    {
+        this->base_vertex = base;
+        return *this;
+    }
+
+    draw_command& draw_command::set_streamed(const bool streamed)
+    {
+        this->streamed = streamed;
+        return *this;
+    }
+
+    draw_command& draw_command::set_instances(
+        const vertex_buffer_handle instance_buffer, const uint32_t count, const uint32_t first)
+    {
+        this->instance_buffer = instance_buffer;
+        this->instance_count = count;
+        this->first_instance = first;
+        return *this;
+    }
 } // namespace moka
@@ -28,17 +28,9 @@ SOFTWARE.
 ===========================================================================
 */
 #include <graphics/command/fill_index_buffer_command.hpp>
-#include <graphics/device/graphics_visitor.hpp>
 
 namespace moka
 {
-    fill_index_buffer_command::~fill_index_buffer_command() = default;
-
-    void fill_index_buffer_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
-    }
-
     fill_index_buffer_command& fill_index_buffer_command::set_buffer(
         const index_buffer_handle handle, const void* data, const size_t size)
     {
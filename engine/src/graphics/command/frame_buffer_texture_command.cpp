@@ -28,17 +28,9 @@ SOFTWARE.
 ===========================================================================
 */
 #include <graphics/command/frame_buffer_texture_command.hpp>
-#include <graphics/device/graphics_visitor.hpp>
 
 namespace moka
 {
-    frame_buffer_texture_command::~frame_buffer_texture_command() = default;
-
-    void frame_buffer_texture_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
-    }
-
     frame_buffer_texture_command& frame_buffer_texture_command::set_texture(const texture_handle texture)
     {
         this->texture = texture;
@@ -0,0 +1,65 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <graphics/command/read_pixels_command.hpp>
+
+namespace moka
+{
+    read_pixels_command& read_pixels_command::set_tag(const uint64_t tag)
+    {
+        this->tag = tag;
+        return *this;
+    }
+
+    read_pixels_command& read_pixels_command::set_rectangle(
+        const int x, const int y, const int width, const int height)
+    {
+        this->x = x;
+        this->y = y;
+        this->width = width;
+        this->height = height;
+        return *this;
+    }
+
+    read_pixels_command& read_pixels_command::set_rectangle(const rectangle& rectangle)
+    {
+        this->x = rectangle.x;
+        this->y = rectangle.y;
+        this->width = rectangle.width;
+        this->height = rectangle.height;
+        return *this;
+    }
+
+    read_pixels_command& read_pixels_command::set_format(const host_format format, const pixel_type pixel)
+    {
+        this->format = format;
+        this->pixel = pixel;
+        return *this;
+    }
+} // namespace moka
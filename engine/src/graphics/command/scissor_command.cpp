@@ -31,13 +31,6 @@ SOFTWARE.
 
 namespace moka
 {
-    scissor_command::~scissor_command() = default;
-
-    void scissor_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
-    }
-
     scissor_command& scissor_command::set_rectangle(int x, int y, int width, int height)
     {
         this->width = width;
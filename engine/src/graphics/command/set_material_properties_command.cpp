@@ -27,62 +27,270 @@ SOFTWARE.
 
 ===========================================================================
 */
+#include <application/logger.hpp>
+#include <cstddef>
+#include <cstring>
+#include <graphics/command/command_buffer.hpp>
 #include <graphics/command/set_material_properties_command.hpp>
+#include <graphics/device/graphics_device.hpp>
 
 namespace moka
 {
-    set_material_parameters_command::~set_material_parameters_command() = default;
+    // parameters start right after the command, where the record ends
+    static_assert(
+        offsetof(command_record<set_material_parameters_command>, command) + sizeof(set_material_parameters_command) ==
+        sizeof(command_record<set_material_parameters_command>));
 
-    set_material_parameters_command& set_material_parameters_command::set_material(material_handle material)
+    namespace
     {
-        this->material = material;
+        logger log_("set_material_parameters_command");
+
+        template <typename T>
+        parameter read(const material_parameter_record& record)
+        {
+            T data;
+            std::memcpy(&data, reinterpret_cast<const std::byte*>(&record + 1), sizeof(T));
+            return data;
+        }
+
+        parameter_type get_type(const parameter& data)
+        {
+            return std::visit(
+                [](const auto& value) {
+                    using type = std::decay_t<decltype(value)>;
+
+                    if constexpr (std::is_same_v<type, float>)
+                        return parameter_type::float32;
+                    else if constexpr (std::is_same_v<type, glm::vec3>)
+                        return parameter_type::vec3;
+                    else if constexpr (std::is_same_v<type, glm::vec4>)
+                        return parameter_type::vec4;
+                    else if constexpr (std::is_same_v<type, glm::mat3>)
+                        return parameter_type::mat3;
+                    else if constexpr (std::is_same_v<type, glm::mat4>)
+                        return parameter_type::mat4;
+                    else
+                        return parameter_type::texture;
+                },
+                data);
+        }
+    } // namespace
+
+    size_t material_parameter_record::size() const
+    {
+        return sizeof(material_parameter_record) + get_data_size(type);
+    }
+
+    parameter material_parameter_record::get_data() const
+    {
+        switch (type)
+        {
+        case parameter_type::texture:
+            return read<texture_handle>(*this);
+        case parameter_type::vec3:
+            return read<glm::vec3>(*this);
+        case parameter_type::vec4:
+            return read<glm::vec4>(*this);
+        case parameter_type::mat3:
+            return read<glm::mat3>(*this);
+        case parameter_type::mat4:
+            return read<glm::mat4>(*this);
+        case parameter_type::float32:
+            return read<float>(*this);
+        default:
+            return {};
+        }
+    }
+
+    bool material_parameter_record::set_data(const parameter& data)
+    {
+        if (get_type(data) != type)
+        {
+            return false;
+        }
+
+        std::visit(
+            [this](const auto& value) { std::memcpy(reinterpret_cast<std::byte*>(this + 1), &value, sizeof(value)); }, data);
+
+        return true;
+    }
+
+    material_parameter_record* material_parameter_record::next()
+    {
+        return reinterpret_cast<material_parameter_record*>(reinterpret_cast<std::byte*>(this) + size());
+    }
+
+    const material_parameter_record* material_parameter_record::next() const
+    {
+        return reinterpret_cast<const material_parameter_record*>(reinterpret_cast<const std::byte*>(this) + size());
+    }
+
+    material_parameter_record* set_material_parameters_command::get_parameters()
+    {
+        return reinterpret_cast<material_parameter_record*>(this + 1);
+    }
+
+    const material_parameter_record* set_material_parameters_command::get_parameters() const
+    {
+        return reinterpret_cast<const material_parameter_record*>(this + 1);
+    }
+
+    set_material_parameters_builder::set_material_parameters_builder(command_buffer& buffer, const uint32_t offset)
+        : buffer_(buffer), offset_(offset), size_(sizeof(command_record<set_material_parameters_command>))
+    {
+    }
+
+    set_material_parameters_command& set_material_parameters_builder::get_command()
+    {
+        return command_record<set_material_parameters_command>::from_header(
+            *reinterpret_cast<command_header*>(buffer_.data_ + offset_));
+    }
+
+    template <typename T>
+    set_material_parameters_builder& set_material_parameters_builder::append(
+        const uint16_t index, const parameter_type type, const T& data)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        constexpr auto size = sizeof(material_parameter_record) + sizeof(T);
+
+        auto* destination = buffer_.grow_record(offset_, size_, size);
+
+        if (!destination)
+        {
+            log_.error("Material parameter {} was set after another command was added to the command buffer", index);
+            return *this;
+        }
+
+        const material_parameter_record record{index, type};
+        std::memcpy(destination, &record, sizeof(record));
+        std::memcpy(destination + sizeof(record), &data, sizeof(T));
+
+        size_ += static_cast<uint32_t>(size);
+        ++get_command().count;
+
         return *this;
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
-        const std::string& name, float data)
+    int32_t set_material_parameters_builder::find_index(const std::string& name)
     {
-        parameters.emplace_back(material_parameter{name, data});
+        const auto handle = get_command().material;
+        const auto* materials = buffer_.materials_;
+
+        // names are only read here, so an unknown one is dropped rather than added to a material the render thread may be drawing
+        const auto* material =
+            materials && handle.id < materials->size() ? materials->get_material(handle) : nullptr;
+
+        if (!material)
+        {
+            log_.error("Material parameter {} can't be set by name without a material and a material cache", name);
+            return -1;
+        }
+
+        const auto index = material->find_index(name);
+
+        if (index == -1)
+        {
+            log_.error("Material {} has no parameter named {}", handle.id, name);
+        }
+
+        return index;
+    }
+
+    template <typename T>
+    set_material_parameters_builder& set_material_parameters_builder::set_named_parameter(
+        const std::string& name, const T& data)
+    {
+        const auto index = find_index(name);
+        return index == -1 ? *this : set_parameter(static_cast<uint16_t>(index), data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_material(const material_handle material)
+    {
+        get_command().material = material;
         return *this;
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(const uint16_t index, const float data)
+    {
+        return append(index, parameter_type::float32, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const glm::vec3& data)
+    {
+        return append(index, parameter_type::vec3, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const glm::vec4& data)
+    {
+        return append(index, parameter_type::vec4, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const glm::mat3& data)
+    {
+        return append(index, parameter_type::mat3, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const glm::mat4& data)
+    {
+        return append(index, parameter_type::mat4, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const texture_handle data)
+    {
+        return append(index, parameter_type::texture, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const uint16_t index, const parameter& data)
+    {
+        return std::visit([this, index](const auto& value) -> set_material_parameters_builder& { return set_parameter(index, value); }, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const std::string& name, const float data)
+    {
+        return set_named_parameter(name, data);
+    }
+
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
         const std::string& name, const glm::vec3& data)
     {
-        parameters.emplace_back(material_parameter{name, data});
-        return *this;
+        return set_named_parameter(name, data);
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
         const std::string& name, const glm::vec4& data)
     {
-        parameters.emplace_back(material_parameter{name, data});
-        return *this;
+        return set_named_parameter(name, data);
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
         const std::string& name, const glm::mat3& data)
     {
-        parameters.emplace_back(material_parameter{name, data});
-        return *this;
+        return set_named_parameter(name, data);
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
         const std::string& name, const glm::mat4& data)
     {
-        parameters.emplace_back(material_parameter{name, data});
-        return *this;
+        return set_named_parameter(name, data);
     }
 
-    set_material_parameters_command& set_material_parameters_command::set_parameter(
-        const std::string& name, texture_handle data)
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const std::string& name, const texture_handle data)
     {
-        parameters.emplace_back(material_parameter{name, data});
-        return *this;
+        return set_named_parameter(name, data);
     }
 
-    void set_material_parameters_command::accept(graphics_visitor& visitor)
+    set_material_parameters_builder& set_material_parameters_builder::set_parameter(
+        const std::string& name, const parameter& data)
     {
-        visitor.visit(*this);
+        return set_named_parameter(name, data);
     }
 } // namespace moka
@@ -0,0 +1,112 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <algorithm>
+#include <cstring>
+#include <graphics/command/sort_key.hpp>
+
+namespace moka
+{
+    uint32_t sort_key_builder::quantize_depth(const float depth)
+    {
+        // http://aras-p.info/blog/2014/01/16/rough-sorting-by-depth/
+        // the bits of a non-negative float sort in the same order as the float itself
+        uint32_t bits = 0;
+        std::memcpy(&bits, &depth, sizeof(bits));
+
+        // the sign bit is always zero, keep the highest bits after it
+        constexpr auto width = sort_key_layout::opaque::depth.width;
+        return (bits >> (31 - width)) & static_cast<uint32_t>(sort_key_layout::opaque::depth.max());
+    }
+
+    sort_key_builder& sort_key_builder::set_depth(const float depth)
+    {
+        depth_ = quantize_depth(depth > 0.0f ? depth : 0.0f);
+        return *this;
+    }
+
+    void radix_sort(sort_entry* entries, sort_entry* scratch, const size_t count)
+    {
+        // fewer than two entries are already sorted, and the pass skipping below reads the first entry
+        if (count < 2)
+        {
+            return;
+        }
+
+        constexpr size_t passes = sizeof(sort_key);
+        constexpr size_t radix = 256;
+
+        size_t histograms[passes][radix] = {};
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto key = entries[i].key;
+            for (size_t pass = 0; pass < passes; ++pass)
+            {
+                ++histograms[pass][key & 0xff];
+                key >>= 8;
+            }
+        }
+
+        auto* source = entries;
+        auto* destination = scratch;
+
+        for (size_t pass = 0; pass < passes; ++pass)
+        {
+            const auto shift = pass * 8;
+            auto& histogram = histograms[pass];
+
+            if (histogram[(source[0].key >> shift) & 0xff] == count)
+            {
+                continue;
+            }
+
+            size_t offset = 0;
+            for (auto& bucket : histogram)
+            {
+                const auto bucket_size = bucket;
+                bucket = offset;
+                offset += bucket_size;
+            }
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto bucket = (source[i].key >> shift) & 0xff;
+                destination[histogram[bucket]++] = source[i];
+            }
+
+            std::swap(source, destination);
+        }
+
+        if (source != entries)
+        {
+            std::copy(source, source + count, entries);
+        }
+    }
+} // namespace moka
@@ -31,13 +31,6 @@ SOFTWARE.
 
 namespace moka
 {
-    viewport_command::~viewport_command() = default;
-
-    void viewport_command::accept(graphics_visitor& visitor)
-    {
-        visitor.visit(*this);
-    }
-
     viewport_command& viewport_command::set_rectangle(
         const int x, const int y, const int width, const int height)
     {
@@ -0,0 +1,1236 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <algorithm>
+#include <application/logger.hpp>
+#include <cstring>
+#include <iterator>
+#include <graphics/device/command_trace.hpp>
+#include <graphics/device/graphics_device.hpp>
+#include <limits>
+#include <type_traits>
+
+namespace moka
+{
+    namespace
+    {
+        logger log_("command_trace");
+
+        constexpr uint8_t end_of_buffer = std::numeric_limits<uint8_t>::max();
+
+        constexpr uint32_t no_blob = std::numeric_limits<uint32_t>::max();
+
+        // the size of a chunk header: its type followed by the size of its payload
+        constexpr size_t chunk_header_size = sizeof(uint8_t) + sizeof(uint64_t);
+
+        uint64_t hash_bytes(const void* data, const size_t size)
+        {
+            // FNV-1a, seeded with the size so that buffers sharing a prefix don't collide
+            auto hash = 14695981039346656037ull ^ static_cast<uint64_t>(size);
+
+            const auto* bytes = static_cast<const unsigned char*>(data);
+
+            for (size_t i = 0; i < size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+    } // namespace
+
+    /**
+     * \brief Encodes commands, resources and materials into the current chunk of a command_trace_writer.
+     */
+    struct command_trace_writer::encoder final
+    {
+        command_trace_writer& writer;
+
+        template <typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be written directly!");
+
+            if constexpr (std::is_enum_v<T>)
+            {
+                write(static_cast<uint8_t>(value));
+            }
+            else
+            {
+                const auto* bytes = reinterpret_cast<const std::byte*>(&value);
+                writer.chunk_.insert(writer.chunk_.end(), bytes, bytes + sizeof(T));
+            }
+        }
+
+        void write_size(const size_t size)
+        {
+            write(static_cast<uint64_t>(size));
+        }
+
+        void write_string(const std::string& value)
+        {
+            write_size(value.size());
+            const auto* bytes = reinterpret_cast<const std::byte*>(value.data());
+            writer.chunk_.insert(writer.chunk_.end(), bytes, bytes + value.size());
+        }
+
+        void write_blob(const void* data, const size_t size)
+        {
+            write(data && size > 0 ? writer.write_blob(data, size) : no_blob);
+            write_size(data ? size : 0);
+        }
+
+        void write_parameter(const material_parameter& parameter)
+        {
+            write_string(parameter.name);
+            write(parameter.type);
+            write_size(parameter.count);
+            write(static_cast<uint8_t>(parameter.data.index()));
+
+            std::visit(
+                [this](const auto& data) {
+                    using type = std::decay_t<decltype(data)>;
+
+                    if constexpr (std::is_same_v<type, texture_handle>)
+                    {
+                        write(data.id);
+                    }
+                    else
+                    {
+                        write(data);
+                    }
+                },
+                parameter.data);
+        }
+
+        void visit(clear_command& cmd)
+        {
+            write(cmd.color);
+            write(cmd.clear_depth);
+            write(cmd.clear_color);
+        }
+
+        void visit(draw_command& cmd)
+        {
+            write(cmd.material.id);
+            write(cmd.vertex_buffer.id);
+            write(cmd.vertex_count);
+            write(cmd.first_vertex);
+            write(cmd.index_buffer.id);
+            write(cmd.index_count);
+            write(cmd.idx_type);
+            write(cmd.index_buffer_offset);
+            write(cmd.prim_type);
+            write(cmd.base_vertex);
+            write(cmd.streamed);
+            write(cmd.instance_buffer.id);
+            write(cmd.instance_count);
+            write(cmd.first_instance);
+        }
+
+        void visit(viewport_command& cmd)
+        {
+            write(cmd.x);
+            write(cmd.y);
+            write(cmd.width);
+            write(cmd.height);
+        }
+
+        void visit(scissor_command& cmd)
+        {
+            write(cmd.x);
+            write(cmd.y);
+            write(cmd.width);
+            write(cmd.height);
+        }
+
+        void visit(fill_vertex_buffer_command& cmd)
+        {
+            write(cmd.handle.id);
+            write_blob(cmd.data, cmd.size);
+        }
+
+        void visit(fill_index_buffer_command& cmd)
+        {
+            write(cmd.handle.id);
+            write_blob(cmd.data, cmd.size);
+        }
+
+        void visit(fill_uniform_buffer_command& cmd)
+        {
+            write(cmd.handle.id);
+            write_blob(cmd.data, cmd.size);
+        }
+
+        void visit(fill_stream_buffer_command& cmd)
+        {
+            // ranges are relative to their frame's part of the stream buffer, so replaying frame by frame reproduces them
+            write(cmd.range.offset);
+            write_blob(cmd.data, cmd.range.size);
+        }
+
+        void visit(frame_buffer_command& cmd)
+        {
+            write(cmd.buffer.id);
+        }
+
+        void visit(frame_buffer_texture_command& cmd)
+        {
+            write(cmd.texture.id);
+            write(cmd.attachment);
+            write(cmd.target);
+            write(cmd.level);
+        }
+
+        void visit(generate_mipmaps_command& cmd)
+        {
+            write(cmd.texture.id);
+        }
+
+        void visit(gpu_timer_command& cmd)
+        {
+            write(cmd.event);
+            write(cmd.name);
+        }
+
+        void visit(read_pixels_command& cmd)
+        {
+            write(cmd.tag);
+            write(cmd.x);
+            write(cmd.y);
+            write(cmd.width);
+            write(cmd.height);
+            write(cmd.format);
+            write(cmd.pixel);
+        }
+
+        void visit(set_material_parameters_command& cmd)
+        {
+            write(cmd.material.id);
+            write(cmd.count);
+
+            cmd.for_each_parameter([this](const material_parameter_record& record) {
+                write(record.index);
+                write(record.type);
+
+                std::visit(
+                    [this](const auto& data) {
+                        using type = std::decay_t<decltype(data)>;
+
+                        if constexpr (std::is_same_v<type, texture_handle>)
+                        {
+                            write(data.id);
+                        }
+                        else
+                        {
+                            write(data);
+                        }
+                    },
+                    record.get_data());
+            });
+        }
+    };
+
+    /**
+     * \brief Decodes the chunks of a command_trace, remapping the captured handles to the ones created on replay.
+     */
+    struct command_trace::decoder final
+    {
+        command_trace& trace;
+        const std::byte* cursor;
+        const std::byte* end;
+
+        template <typename T>
+        T read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "Only trivially copyable values can be read directly!");
+
+            if constexpr (std::is_enum_v<T>)
+            {
+                return static_cast<T>(read<uint8_t>());
+            }
+            else
+            {
+                T value{};
+
+                if (static_cast<size_t>(end - cursor) < sizeof(T))
+                {
+                    throw std::runtime_error("Unexpected end of command trace");
+                }
+
+                std::memcpy(&value, cursor, sizeof(T));
+                cursor += sizeof(T);
+                return value;
+            }
+        }
+
+        size_t read_size()
+        {
+            return static_cast<size_t>(read<uint64_t>());
+        }
+
+        std::string read_string()
+        {
+            const auto size = read_size();
+
+            if (static_cast<size_t>(end - cursor) < size)
+            {
+                throw std::runtime_error("Unexpected end of command trace");
+            }
+
+            std::string value(reinterpret_cast<const char*>(cursor), size);
+            cursor += size;
+            return value;
+        }
+
+        const void* read_blob(size_t& size)
+        {
+            const auto id = read<uint32_t>();
+            size = read_size();
+
+            if (id == no_blob)
+            {
+                return nullptr;
+            }
+
+            if (id >= trace.blobs_.size() || trace.blobs_[id].size() != size)
+            {
+                throw std::runtime_error("Invalid blob in command trace");
+            }
+
+            return trace.blobs_[id].data();
+        }
+
+        template <typename Id>
+        Id remap(const std::unordered_map<Id, Id>& handles, const Id id)
+        {
+            constexpr auto invalid_id = std::numeric_limits<Id>::max();
+
+            if (id == invalid_id)
+            {
+                return invalid_id;
+            }
+
+            const auto it = handles.find(id);
+
+            if (it == handles.end())
+            {
+                ++trace.unresolved_handles_;
+                return invalid_id;
+            }
+
+            return it->second;
+        }
+
+        material_parameter read_parameter()
+        {
+            material_parameter parameter;
+            parameter.name = read_string();
+            parameter.type = read<parameter_type>();
+            parameter.count = read_size();
+
+            switch (read<uint8_t>())
+            {
+            case 0:
+                parameter.data = read<float>();
+                break;
+            case 1:
+                parameter.data = read<glm::vec3>();
+                break;
+            case 2:
+                parameter.data = read<glm::vec4>();
+                break;
+            case 3:
+                parameter.data = read<glm::mat3>();
+                break;
+            case 4:
+                parameter.data = read<glm::mat4>();
+                break;
+            case 5:
+                parameter.data = texture_handle{remap(trace.textures_, read<uint32_t>())};
+                break;
+            default:
+                throw std::runtime_error("Invalid material parameter in command trace");
+            }
+
+            return parameter;
+        }
+
+        void read_command(const command_type type, command_buffer& buffer)
+        {
+            switch (type)
+            {
+            case command_type::clear:
+            {
+                auto& cmd = buffer.clear();
+                cmd.color = read<glm::vec4>();
+                cmd.clear_depth = read<bool>();
+                cmd.clear_color = read<bool>();
+                break;
+            }
+            case command_type::draw:
+            {
+                auto& cmd = buffer.draw();
+                cmd.material.id = remap(trace.materials_, read<uint16_t>());
+                cmd.vertex_buffer.id = remap(trace.vertex_buffers_, read<uint32_t>());
+                cmd.vertex_count = read<uint32_t>();
+                cmd.first_vertex = read<uint32_t>();
+                cmd.index_buffer.id = remap(trace.index_buffers_, read<uint32_t>());
+                cmd.index_count = read<uint32_t>();
+                cmd.idx_type = read<index_type>();
+                cmd.index_buffer_offset = read<uint32_t>();
+                cmd.prim_type = read<primitive_type>();
+                cmd.base_vertex = read<int32_t>();
+                cmd.streamed = read<bool>();
+                cmd.instance_buffer.id = remap(trace.vertex_buffers_, read<uint32_t>());
+                cmd.instance_count = read<uint32_t>();
+                cmd.first_instance = read<uint32_t>();
+                break;
+            }
+            case command_type::viewport:
+            {
+                auto& cmd = buffer.viewport();
+                cmd.x = read<int>();
+                cmd.y = read<int>();
+                cmd.width = read<int>();
+                cmd.height = read<int>();
+                break;
+            }
+            case command_type::scissor:
+            {
+                auto& cmd = buffer.scissor();
+                cmd.x = read<int>();
+                cmd.y = read<int>();
+                cmd.width = read<int>();
+                cmd.height = read<int>();
+                break;
+            }
+            case command_type::fill_vertex_buffer:
+            {
+                auto& cmd = buffer.fill_vertex_buffer();
+                cmd.handle.id = remap(trace.vertex_buffers_, read<uint32_t>());
+                cmd.data = read_blob(cmd.size);
+                break;
+            }
+            case command_type::fill_index_buffer:
+            {
+                auto& cmd = buffer.fill_index_buffer();
+                cmd.handle.id = remap(trace.index_buffers_, read<uint32_t>());
+                cmd.data = read_blob(cmd.size);
+                break;
+            }
+            case command_type::fill_uniform_buffer:
+            {
+                auto& cmd = buffer.fill_uniform_buffer();
+                cmd.handle.id = remap(trace.uniform_buffers_, read<uint32_t>());
+                cmd.data = read_blob(cmd.size);
+                break;
+            }
+            case command_type::fill_stream_buffer:
+            {
+                auto& cmd = buffer.fill_stream_buffer();
+                cmd.range.offset = read<uint32_t>();
+
+                size_t size;
+                cmd.data = read_blob(size);
+                cmd.range.size = static_cast<uint32_t>(size);
+                break;
+            }
+            case command_type::frame_buffer:
+            {
+                auto& cmd = buffer.frame_buffer();
+
+                // the default frame buffer isn't created by the trace, and keeps its id
+                const auto id = read<uint32_t>();
+                cmd.buffer.id = id == 0 ? 0 : remap(trace.frame_buffers_, id);
+                break;
+            }
+            case command_type::frame_buffer_texture:
+            {
+                auto& cmd = buffer.frame_buffer_texture();
+                cmd.texture.id = remap(trace.textures_, read<uint32_t>());
+                cmd.attachment = read<frame_attachment>();
+                cmd.target = read<image_target>();
+                cmd.level = read<int>();
+                break;
+            }
+            case command_type::generate_mipmaps:
+            {
+                auto& cmd = buffer.generate_mipmaps();
+                cmd.texture.id = remap(trace.textures_, read<uint32_t>());
+                break;
+            }
+            case command_type::gpu_timer:
+            {
+                auto& cmd = buffer.gpu_timer();
+                cmd.event = read<gpu_timer_event>();
+                cmd.name = read<decltype(cmd.name)>();
+                break;
+            }
+            case command_type::read_pixels:
+            {
+                auto& cmd = buffer.read_pixels();
+                cmd.tag = read<uint64_t>();
+                cmd.x = read<int>();
+                cmd.y = read<int>();
+                cmd.width = read<int>();
+                cmd.height = read<int>();
+                cmd.format = read<host_format>();
+                cmd.pixel = read<pixel_type>();
+                break;
+            }
+            case command_type::set_material_parameters:
+            {
+                auto parameters = buffer.set_material_parameters();
+                parameters.set_material({remap(trace.materials_, read<uint16_t>())});
+
+                const auto count = read<uint16_t>();
+
+                for (uint16_t i = 0; i < count; ++i)
+                {
+                    const auto index = read<uint16_t>();
+
+                    switch (read<parameter_type>())
+                    {
+                    case parameter_type::float32:
+                        parameters.set_parameter(index, read<float>());
+                        break;
+                    case parameter_type::vec3:
+                        parameters.set_parameter(index, read<glm::vec3>());
+                        break;
+                    case parameter_type::vec4:
+                        parameters.set_parameter(index, read<glm::vec4>());
+                        break;
+                    case parameter_type::mat3:
+                        parameters.set_parameter(index, read<glm::mat3>());
+                        break;
+                    case parameter_type::mat4:
+                        parameters.set_parameter(index, read<glm::mat4>());
+                        break;
+                    case parameter_type::texture:
+                        parameters.set_parameter(index, texture_handle{remap(trace.textures_, read<uint32_t>())});
+                        break;
+                    default:
+                        throw std::runtime_error("Invalid material parameter in command trace");
+                    }
+                }
+                break;
+            }
+            default:
+                throw std::runtime_error("Invalid command in command trace");
+            }
+        }
+
+        command_list read_commands()
+        {
+            command_list list;
+
+            const auto buffer_count = read_size();
+
+            for (size_t i = 0; i < buffer_count; ++i)
+            {
+                auto& buffer = list.make_command_buffer(read<sort_key>());
+
+                for (auto type = read<uint8_t>(); type != end_of_buffer; type = read<uint8_t>())
+                {
+                    read_command(static_cast<command_type>(type), buffer);
+                }
+            }
+
+            return list;
+        }
+
+        void read_vertex_buffer(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+            const auto use = read<buffer_usage>();
+
+            const auto attribute_count = read_size();
+
+            std::vector<vertex_attribute> attributes;
+            attributes.reserve(attribute_count);
+
+            for (size_t i = 0; i < attribute_count; ++i)
+            {
+                const auto index = read_size();
+                const auto type = read<attribute_type>();
+                const auto size = read_size();
+                const auto normalized = read<bool>();
+                const auto stride = read_size();
+                const auto offset = read_size();
+                const auto divisor = read_size();
+                attributes.emplace_back(index, type, size, normalized, stride, offset, divisor);
+            }
+
+            size_t size = 0;
+            const auto* vertices = read_blob(size);
+
+            trace.vertex_buffers_[id] =
+                device.make_vertex_buffer(vertices, size, vertex_layout{std::move(attributes)}, use).id;
+        }
+
+        void read_index_buffer(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+            const auto type = read<index_type>();
+            const auto use = read<buffer_usage>();
+
+            size_t size = 0;
+            const auto* indices = read_blob(size);
+
+            trace.index_buffers_[id] = device.make_index_buffer(indices, size, type, use).id;
+        }
+
+        void read_shader(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+            const auto type = read<shader_type>();
+            const auto source = read_string();
+
+            trace.shaders_[id] = device.make_shader(type, source).id;
+        }
+
+        void read_program(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+            const shader_handle vertex_handle{remap(trace.shaders_, read<uint32_t>())};
+            const shader_handle fragment_handle{remap(trace.shaders_, read<uint32_t>())};
+
+            trace.programs_[id] = device.make_program(vertex_handle, fragment_handle).id;
+        }
+
+        void read_texture(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+
+            texture_metadata metadata;
+            metadata.target = read<texture_target>();
+            metadata.wrap_mode.s = read<wrap_mode>();
+            metadata.wrap_mode.t = read<wrap_mode>();
+            metadata.wrap_mode.r = read<wrap_mode>();
+            metadata.filter_mode.mag = read<mag_filter>();
+            metadata.filter_mode.min = read<min_filter>();
+            metadata.generate_mipmaps = read<bool>();
+
+            metadata.data.resize(read_size());
+
+            std::vector<const void*> data(metadata.data.size());
+
+            for (size_t i = 0; i < metadata.data.size(); ++i)
+            {
+                auto& image = metadata.data[i];
+                image.target = read<image_target>();
+                image.mip_level = read<int>();
+                image.type = read<pixel_type>();
+                image.internal_format = read<device_format>();
+                image.width = read<int>();
+                image.height = read<int>();
+                image.border = read<int>();
+                image.base_format = read<host_format>();
+
+                size_t size = 0;
+                data[i] = read_blob(size);
+            }
+
+            trace.textures_[id] = device.make_texture(data.data(), std::move(metadata), false).id;
+        }
+
+        void read_uniform_buffer(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+            const auto block = read<uniform_block>();
+            const auto size = read_size();
+
+            trace.uniform_buffers_[id] = device.make_uniform_buffer(block, size).id;
+        }
+
+        void read_frame_buffer(graphics_device& device)
+        {
+            const auto id = read<uint32_t>();
+
+            std::vector<render_texture_data> render_textures(read_size());
+
+            for (auto& render_texture : render_textures)
+            {
+                render_texture.attachment = read<frame_attachment>();
+                render_texture.format = read<frame_format>();
+                render_texture.width = read<int>();
+                render_texture.height = read<int>();
+            }
+
+            trace.frame_buffers_[id] =
+                device.make_frame_buffer(render_textures.data(), render_textures.size()).id;
+        }
+
+        void read_material(graphics_device& device)
+        {
+            const auto id = read<uint16_t>();
+            const program_handle program{remap(trace.programs_, read<uint32_t>())};
+            const auto alpha = read<alpha_mode>();
+
+            pipeline_state state;
+            state.blend.enabled = read<bool>();
+            state.blend.equation = read<blend_equation>();
+            state.blend.source = read<blend_function_factor>();
+            state.blend.destination = read<blend_function_factor>();
+            state.culling.enabled = read<bool>();
+            state.culling.faces = read<face>();
+            state.polygon_mode.mode = read<polygon_draw_mode>();
+            state.polygon_mode.faces = read<face>();
+            state.depth_test = read<bool>();
+            state.scissor_test = read<bool>();
+
+            parameter_collection parameters;
+            const auto parameter_count = read_size();
+
+            for (size_t i = 0; i < parameter_count; ++i)
+            {
+                auto parameter = read_parameter();
+                parameters[parameter.name] = std::move(parameter);
+            }
+
+            material restored{
+                {program}, std::move(parameters), alpha, device.get_pipeline_state_cache().add_pipeline_state(state)};
+
+            auto& materials = device.get_material_cache();
+
+            const auto it = trace.materials_.find(id);
+
+            if (it != trace.materials_.end())
+            {
+                *materials.get_material(material_handle{it->second}) = std::move(restored);
+            }
+            else
+            {
+                trace.materials_[id] = materials.add_material(std::move(restored)).id;
+            }
+        }
+    };
+
+    command_trace::command_trace(const std::filesystem::path& path)
+    {
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+
+        if (!file)
+        {
+            log_.error("Unable to open command trace {}", path.string());
+            return;
+        }
+
+        data_.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+
+        try
+        {
+            decoder header{*this, data_.data(), data_.data() + data_.size()};
+
+            if (header.read<uint32_t>() != trace_magic)
+            {
+                log_.error("{} is not a command trace", path.string());
+                return;
+            }
+
+            if (const auto version = header.read<uint32_t>(); version != trace_version)
+            {
+                log_.error("Command trace {} has version {}, expected {}", path.string(), version, trace_version);
+                return;
+            }
+
+            auto first_chunk = chunks_.size();
+
+            while (header.cursor != header.end)
+            {
+                const auto type = header.read<trace_chunk>();
+                const auto size = header.read_size();
+                const auto offset = static_cast<size_t>(header.cursor - data_.data());
+
+                if (size > static_cast<size_t>(header.end - header.cursor))
+                {
+                    // the application was closed while the chunk was being written
+                    log_.warn("Command trace {} is truncated", path.string());
+                    break;
+                }
+
+                if (type == trace_chunk::blob)
+                {
+                    decoder blob{*this, header.cursor, header.cursor + size};
+
+                    if (blob.read<uint32_t>() != blobs_.size())
+                    {
+                        throw std::runtime_error("Blobs in command trace are out of order");
+                    }
+
+                    blobs_.emplace_back(blob.cursor, blob.end);
+                }
+                else
+                {
+                    chunks_.push_back({type, offset, size});
+
+                    if (type == trace_chunk::submit_and_swap)
+                    {
+                        frames_.push_back({first_chunk, chunks_.size()});
+                        first_chunk = chunks_.size();
+                    }
+                }
+
+                header.cursor += size;
+            }
+
+            created_.resize(chunks_.size(), 0);
+
+            valid_ = !frames_.empty();
+
+            if (!valid_)
+            {
+                log_.error("Command trace {} doesn't contain a complete frame", path.string());
+            }
+        }
+        catch (const std::exception& e)
+        {
+            log_.error("Invalid command trace {}: {}", path.string(), e.what());
+            valid_ = false;
+        }
+    }
+
+    command_trace::~command_trace() = default;
+
+    bool command_trace::is_valid() const
+    {
+        return valid_;
+    }
+
+    size_t command_trace::get_frame_count() const
+    {
+        return frames_.size();
+    }
+
+    size_t command_trace::get_unresolved_handle_count() const
+    {
+        return unresolved_handles_;
+    }
+
+    void command_trace::load_frame(graphics_device& device, const size_t index)
+    {
+        submissions_.clear();
+
+        const auto& frame = frames_[index];
+
+        for (auto i = frame.first_chunk; i < frame.last_chunk; ++i)
+        {
+            const auto& chunk = chunks_[i];
+
+            decoder chunk_decoder{*this, data_.data() + chunk.offset, data_.data() + chunk.offset + chunk.size};
+
+            const auto is_resource = chunk.type != trace_chunk::material && chunk.type != trace_chunk::submit &&
+                                     chunk.type != trace_chunk::submit_and_swap;
+
+            // resources are created once, the first time their frame is replayed
+            if (is_resource && created_[i])
+            {
+                continue;
+            }
+
+            created_[i] = 1;
+
+            switch (chunk.type)
+            {
+            case trace_chunk::vertex_buffer:
+                chunk_decoder.read_vertex_buffer(device);
+                break;
+            case trace_chunk::index_buffer:
+                chunk_decoder.read_index_buffer(device);
+                break;
+            case trace_chunk::uniform_buffer:
+                chunk_decoder.read_uniform_buffer(device);
+                break;
+            case trace_chunk::shader:
+                chunk_decoder.read_shader(device);
+                break;
+            case trace_chunk::program:
+                chunk_decoder.read_program(device);
+                break;
+            case trace_chunk::texture:
+                chunk_decoder.read_texture(device);
+                break;
+            case trace_chunk::frame_buffer:
+                chunk_decoder.read_frame_buffer(device);
+                break;
+            case trace_chunk::material:
+                chunk_decoder.read_material(device);
+                break;
+            case trace_chunk::submit:
+            case trace_chunk::submit_and_swap:
+                submissions_.emplace_back(
+                    chunk_decoder.read_commands(), chunk.type == trace_chunk::submit_and_swap);
+                break;
+            default:
+                break;
+            }
+        }
+    }
+
+    void command_trace::play_frame(graphics_device& device, const char* timer)
+    {
+        if (timer)
+        {
+            auto begin = device.make_command_list();
+            begin.gpu_timer().begin_scope(timer);
+            device.submit(std::move(begin), false);
+        }
+
+        // the command lists were sorted and optimized before they were captured
+        for (auto& [commands, swap] : submissions_)
+        {
+            if (swap)
+            {
+                // a scope must be closed in the frame it was opened in, so it ends with the last list of the frame
+                if (timer)
+                {
+                    commands.gpu_timer().end_scope();
+                    timer = nullptr;
+                }
+
+                device.submit_and_swap(std::move(commands), false);
+            }
+            else
+            {
+                device.submit(std::move(commands), false);
+            }
+        }
+
+        if (timer)
+        {
+            auto end = device.make_command_list();
+            end.gpu_timer().end_scope();
+            device.submit(std::move(end), false);
+        }
+
+        submissions_.clear();
+    }
+
+    command_trace_writer::command_trace_writer(const std::filesystem::path& path)
+        : path_(path), file_(path, std::ios::binary | std::ios::trunc)
+    {
+        if (!file_)
+        {
+            log_.error("Unable to create command trace {}", path.string());
+            return;
+        }
+
+        file_.write(reinterpret_cast<const char*>(&trace_magic), sizeof trace_magic);
+        file_.write(reinterpret_cast<const char*>(&trace_version), sizeof trace_version);
+        bytes_written_ = sizeof trace_magic + sizeof trace_version;
+
+        log_.info("Capturing commands to {}", path.string());
+    }
+
+    command_trace_writer::~command_trace_writer()
+    {
+        if (file_)
+        {
+            file_.flush();
+            log_.info(
+                "Captured {} frames ({} bytes) to {}", frames_, bytes_written_, path_.string());
+        }
+    }
+
+    bool command_trace_writer::is_open() const
+    {
+        return static_cast<bool>(file_);
+    }
+
+    size_t command_trace_writer::get_frame_count() const
+    {
+        return frames_;
+    }
+
+    size_t command_trace_writer::get_bytes_written() const
+    {
+        return bytes_written_;
+    }
+
+    void command_trace_writer::begin_chunk()
+    {
+        chunk_.clear();
+    }
+
+    void command_trace_writer::end_chunk(const trace_chunk type)
+    {
+        const auto tag = static_cast<uint8_t>(type);
+        const auto size = static_cast<uint64_t>(chunk_.size());
+
+        file_.write(reinterpret_cast<const char*>(&tag), sizeof tag);
+        file_.write(reinterpret_cast<const char*>(&size), sizeof size);
+        file_.write(reinterpret_cast<const char*>(chunk_.data()), static_cast<std::streamsize>(chunk_.size()));
+
+        bytes_written_ += chunk_header_size + chunk_.size();
+    }
+
+    uint32_t command_trace_writer::write_blob(const void* data, const size_t size)
+    {
+        const auto hash = hash_bytes(data, size);
+        const auto* bytes = static_cast<const std::byte*>(data);
+
+        // the hash only finds the candidates, a collision must not replay one blob with the bytes of another
+        for (auto [it, last] = blobs_.equal_range(hash); it != last; ++it)
+        {
+            const auto& blob = blob_data_[it->second];
+
+            if (std::equal(blob.begin(), blob.end(), bytes, bytes + size))
+            {
+                return it->second;
+            }
+        }
+
+        // blobs are written straight to the file, ahead of the chunk that references them
+        const auto id = static_cast<uint32_t>(blob_data_.size());
+        const auto tag = static_cast<uint8_t>(trace_chunk::blob);
+        const auto chunk_size = static_cast<uint64_t>(sizeof id + size);
+
+        file_.write(reinterpret_cast<const char*>(&tag), sizeof tag);
+        file_.write(reinterpret_cast<const char*>(&chunk_size), sizeof chunk_size);
+        file_.write(reinterpret_cast<const char*>(&id), sizeof id);
+        file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+
+        bytes_written_ += chunk_header_size + chunk_size;
+
+        blobs_.emplace(hash, id);
+        blob_data_.emplace_back(bytes, bytes + size);
+
+        return id;
+    }
+
+    void command_trace_writer::write_vertex_buffer(
+        const vertex_buffer_handle handle,
+        const void* vertices,
+        const size_t size,
+        const vertex_layout& layout,
+        const buffer_usage use)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(use);
+        out.write_size(static_cast<size_t>(std::distance(layout.begin(), layout.end())));
+
+        for (const auto& attribute : layout)
+        {
+            out.write_size(attribute.index);
+            out.write(attribute.type);
+            out.write_size(attribute.size);
+            out.write(attribute.normalized);
+            out.write_size(attribute.stride);
+            out.write_size(attribute.offset);
+            out.write_size(attribute.divisor);
+        }
+
+        out.write_blob(vertices, size);
+        end_chunk(trace_chunk::vertex_buffer);
+    }
+
+    void command_trace_writer::write_index_buffer(
+        const index_buffer_handle handle, const void* indices, const size_t size, const index_type type, const buffer_usage use)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(type);
+        out.write(use);
+        out.write_blob(indices, size);
+        end_chunk(trace_chunk::index_buffer);
+    }
+
+    void command_trace_writer::write_uniform_buffer(
+        const uniform_buffer_handle handle, const uniform_block block, const size_t size)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(block);
+        out.write_size(size);
+        end_chunk(trace_chunk::uniform_buffer);
+    }
+
+    void command_trace_writer::write_shader(const shader_handle handle, const shader_type type, const std::string& source)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(type);
+        out.write_string(source);
+        end_chunk(trace_chunk::shader);
+    }
+
+    void command_trace_writer::write_program(
+        const program_handle handle, const shader_handle vertex_handle, const shader_handle fragment_handle)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(vertex_handle.id);
+        out.write(fragment_handle.id);
+        end_chunk(trace_chunk::program);
+    }
+
+    void command_trace_writer::write_texture(const texture_handle handle, const void** data, const texture_metadata& metadata)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write(metadata.target);
+        out.write(metadata.wrap_mode.s);
+        out.write(metadata.wrap_mode.t);
+        out.write(metadata.wrap_mode.r);
+        out.write(metadata.filter_mode.mag);
+        out.write(metadata.filter_mode.min);
+        out.write(metadata.generate_mipmaps);
+        out.write_size(metadata.data.size());
+
+        for (size_t i = 0; i < metadata.data.size(); ++i)
+        {
+            const auto& image = metadata.data[i];
+            out.write(image.target);
+            out.write(image.mip_level);
+            out.write(image.type);
+            out.write(image.internal_format);
+            out.write(image.width);
+            out.write(image.height);
+            out.write(image.border);
+            out.write(image.base_format);
+            out.write_blob(data ? data[i] : nullptr, image_size(image));
+        }
+
+        end_chunk(trace_chunk::texture);
+    }
+
+    void command_trace_writer::write_frame_buffer(
+        const frame_buffer_handle handle, const render_texture_data* render_textures, const size_t render_texture_count)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write(handle.id);
+        out.write_size(render_texture_count);
+
+        for (size_t i = 0; i < render_texture_count; ++i)
+        {
+            out.write(render_textures[i].attachment);
+            out.write(render_textures[i].format);
+            out.write(render_textures[i].width);
+            out.write(render_textures[i].height);
+        }
+
+        end_chunk(trace_chunk::frame_buffer);
+    }
+
+    void command_trace_writer::write_materials(const material_cache& materials, const pipeline_state_cache& pipeline_states)
+    {
+        encoder out{*this};
+
+        material_hashes_.resize(materials.size(), 0);
+
+        for (size_t i = 0; i < materials.size(); ++i)
+        {
+            const auto handle = material_handle{static_cast<uint16_t>(i)};
+            const auto& material = *materials.get_material(handle);
+
+            begin_chunk();
+            out.write(handle.id);
+            out.write(material.get_program().id);
+            out.write(material.get_alpha_mode());
+
+            // pipeline states are written inline, so that the trace doesn't depend on their ids
+            const auto& state = pipeline_states.get_pipeline_state(material.get_pipeline_state());
+            out.write(state.blend.enabled);
+            out.write(state.blend.equation);
+            out.write(state.blend.source);
+            out.write(state.blend.destination);
+            out.write(state.culling.enabled);
+            out.write(state.culling.faces);
+            out.write(state.polygon_mode.mode);
+            out.write(state.polygon_mode.faces);
+            out.write(state.depth_test);
+            out.write(state.scissor_test);
+
+            out.write_size(material.size());
+
+            for (const auto& parameter : material)
+            {
+                out.write_parameter(parameter);
+            }
+
+            // only write the materials that changed since they were last written
+            const auto hash = hash_bytes(chunk_.data(), chunk_.size());
+
+            if (material_hashes_[i] != hash)
+            {
+                material_hashes_[i] = hash;
+                end_chunk(trace_chunk::material);
+            }
+        }
+    }
+
+    void command_trace_writer::write_commands(command_list& commands, const bool swap)
+    {
+        encoder out{*this};
+
+        begin_chunk();
+        out.write_size(static_cast<size_t>(std::distance(commands.begin(), commands.end())));
+
+        for (auto& buffer : commands)
+        {
+            out.write(buffer.get_key());
+
+            for (auto& header : buffer)
+            {
+                out.write(header.type);
+                dispatch(header, out);
+            }
+
+            out.write(end_of_buffer);
+        }
+
+        end_chunk(swap ? trace_chunk::submit_and_swap : trace_chunk::submit);
+
+        if (swap)
+        {
+            ++frames_;
+            file_.flush();
+        }
+    }
+} // namespace moka
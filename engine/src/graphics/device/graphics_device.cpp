@@ -28,12 +28,120 @@ SOFTWARE.
 ===========================================================================
 */
 
+#include <algorithm>
 #include <application/window.hpp>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <graphics/api/gl_graphics_api.hpp>
+#include <graphics/api/null_graphics_api.hpp>
 #include <graphics/device/graphics_device.hpp>
+#include <iterator>
+#include <utility>
 
 namespace moka
 {
+    namespace
+    {
+        /**
+         * \brief Copies the host memory referenced by fill commands into the storage of their command list.
+         */
+        struct host_data_retainer final
+        {
+            command_list& list;
+
+            void visit(fill_vertex_buffer_command& cmd)
+            {
+                cmd.data = list.store(cmd.data, cmd.size);
+            }
+
+            void visit(fill_index_buffer_command& cmd)
+            {
+                cmd.data = list.store(cmd.data, cmd.size);
+            }
+
+            void visit(fill_uniform_buffer_command& cmd)
+            {
+                cmd.data = list.store(cmd.data, cmd.size);
+            }
+
+            void visit(fill_stream_buffer_command& cmd)
+            {
+                cmd.data = list.store(cmd.data, cmd.range.size);
+            }
+
+            template <typename T>
+            void visit(T&)
+            {
+            }
+        };
+
+        void retain_host_data(command_list& list)
+        {
+            // the caller may reuse its buffers as soon as submit returns, long before the render thread executes the fill
+            host_data_retainer retainer{list};
+            list.accept(retainer);
+        }
+
+        constexpr uint32_t program_binary_magic = 0x42504B4D; // "MKPB" in little endian
+        constexpr uint32_t program_binary_version = 1;
+
+        /**
+         * \brief Hash a sequence of strings with 64 bit FNV-1a. Every string is terminated, so moving characters from
+         * one string to the next changes the hash.
+         */
+        uint64_t hash_sources(std::initializer_list<const std::string*> sources)
+        {
+            auto hash = 14695981039346656037ull;
+
+            for (const auto* source : sources)
+            {
+                for (const auto c : *source)
+                {
+                    hash ^= static_cast<uint8_t>(c);
+                    hash *= 1099511628211ull;
+                }
+
+                hash ^= 0xFF;
+                hash *= 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        template <typename T>
+        void write_value(std::ofstream& stream, const T& value)
+        {
+            stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        void write_string(std::ofstream& stream, const std::string& value)
+        {
+            write_value(stream, static_cast<uint64_t>(value.size()));
+            stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+        }
+
+        template <typename T>
+        bool read_value(std::ifstream& stream, T& value)
+        {
+            return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+        }
+
+        bool read_matching_string(std::ifstream& stream, const std::string& expected)
+        {
+            uint64_t size = 0;
+
+            if (!read_value(stream, size) || size != expected.size())
+            {
+                return false;
+            }
+
+            std::string value(static_cast<size_t>(size), '\0');
+
+            return stream.read(value.data(), static_cast<std::streamsize>(size)) && value == expected;
+        }
+    } // namespace
+
     texture_cache::texture_cache(graphics_device& device, const size_t initial_capacity)
         : device_(device)
     {
@@ -61,6 +169,13 @@ namespace moka
         : device_(device)
     {
         shaders_.reserve(initial_capacity);
+
+        std::error_code error;
+
+        if (const auto temporary = std::filesystem::temp_directory_path(error); !error)
+        {
+            directory_ = temporary / "moka" / "program_cache";
+        }
     }
 
     void program_cache::add_program(program_handle handle, const program_id& id)
@@ -80,6 +195,207 @@ namespace moka
         return shaders_[shader_lookup_.at(id)];
     }
 
+    const std::string& program_cache::get_driver_id()
+    {
+        if (!driver_id_)
+        {
+            driver_id_ = device_.get_driver_id();
+        }
+
+        return *driver_id_;
+    }
+
+    program_handle program_cache::load_binary(
+        const std::filesystem::path& path, const std::string& vertex_source, const std::string& fragment_source)
+    {
+        std::ifstream stream(path, std::ios::binary);
+
+        if (!stream)
+        {
+            return program_handle{};
+        }
+
+        uint32_t magic = 0;
+        uint32_t version = 0;
+
+        if (!read_value(stream, magic) || magic != program_binary_magic || !read_value(stream, version) ||
+            version != program_binary_version)
+        {
+            return program_handle{};
+        }
+
+        // the sources are stored in full, so a hash collision or a driver update can never load the wrong program
+        if (!read_matching_string(stream, get_driver_id()) || !read_matching_string(stream, vertex_source) ||
+            !read_matching_string(stream, fragment_source))
+        {
+            return program_handle{};
+        }
+
+        program_binary binary;
+        uint64_t size = 0;
+
+        if (!read_value(stream, binary.format) || !read_value(stream, size))
+        {
+            return program_handle{};
+        }
+
+        binary.data.resize(static_cast<size_t>(size));
+
+        if (!stream.read(reinterpret_cast<char*>(binary.data.data()), static_cast<std::streamsize>(size)))
+        {
+            return program_handle{};
+        }
+
+        return device_.make_program(binary);
+    }
+
+    void program_cache::store_binary(const pending_binary& pending)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory_, error);
+
+        if (error)
+        {
+            return;
+        }
+
+        // write next to the destination and rename, so that an interrupted write never leaves a truncated binary behind
+        auto temporary = pending.path;
+        temporary += ".tmp";
+
+        {
+            std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+
+            if (!stream)
+            {
+                return;
+            }
+
+            write_value(stream, program_binary_magic);
+            write_value(stream, program_binary_version);
+            write_string(stream, get_driver_id());
+            write_string(stream, pending.vertex_source);
+            write_string(stream, pending.fragment_source);
+            write_value(stream, pending.binary.format);
+            write_value(stream, static_cast<uint64_t>(pending.binary.data.size()));
+            stream.write(
+                reinterpret_cast<const char*>(pending.binary.data.data()),
+                static_cast<std::streamsize>(pending.binary.data.size()));
+
+            if (!stream)
+            {
+                stream.close();
+                std::filesystem::remove(temporary, error);
+                return;
+            }
+        }
+
+        std::filesystem::rename(temporary, pending.path, error);
+    }
+
+    program_handle program_cache::make_program(const std::string& vertex_source, const std::string& fragment_source)
+    {
+        const auto& driver_id = get_driver_id();
+        const auto key = static_cast<program_id>(hash_sources({&driver_id, &vertex_source, &fragment_source}));
+
+        if (exists(key))
+        {
+            ++stats_.memory_hits;
+            return get_program(key);
+        }
+
+        // a trace replays programs from their source, so don't load binaries while capturing
+        const auto use_binaries = !directory_.empty() && !driver_id.empty() && !device_.is_capturing();
+
+        std::filesystem::path path;
+
+        if (use_binaries)
+        {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+            path = directory_ / name;
+
+            if (const auto handle = load_binary(path, vertex_source, fragment_source);
+                handle.id != std::numeric_limits<uint32_t>::max())
+            {
+                ++stats_.binary_hits;
+                add_program(handle, key);
+                return handle;
+            }
+        }
+
+        ++stats_.misses;
+
+        const auto vertex_shader = device_.make_shader(shader_type::vertex, vertex_source);
+        const auto fragment_shader = device_.make_shader(shader_type::fragment, fragment_source);
+        const auto handle = device_.make_program(vertex_shader, fragment_shader);
+
+        if (use_binaries)
+        {
+            std::lock_guard<std::mutex> lock(binaries_mutex_);
+            pending_binaries_.push_back({handle, std::move(path), vertex_source, fragment_source, {}});
+        }
+
+        add_program(handle, key);
+
+        return handle;
+    }
+
+    void program_cache::collect_binaries(graphics_api& api)
+    {
+        std::lock_guard<std::mutex> lock(binaries_mutex_);
+
+        const auto is_failed = [&api](pending_binary& pending) {
+            if (!pending.binary.data.empty() || !api.is_program_linked(pending.program))
+            {
+                return false;
+            }
+
+            // a program that failed to link has no binary to store
+            return !api.get_program_binary(pending.program, pending.binary);
+        };
+
+        pending_binaries_.erase(
+            std::remove_if(pending_binaries_.begin(), pending_binaries_.end(), is_failed), pending_binaries_.end());
+    }
+
+    void program_cache::store_binaries()
+    {
+        std::vector<pending_binary> ready;
+
+        {
+            std::lock_guard<std::mutex> lock(binaries_mutex_);
+
+            const auto is_ready = [](const pending_binary& pending) { return !pending.binary.data.empty(); };
+            const auto first_ready =
+                std::stable_partition(pending_binaries_.begin(), pending_binaries_.end(), std::not_fn(is_ready));
+
+            ready.insert(ready.end(), std::make_move_iterator(first_ready), std::make_move_iterator(pending_binaries_.end()));
+            pending_binaries_.erase(first_ready, pending_binaries_.end());
+        }
+
+        // writing the files doesn't need the graphics context, so the render thread isn't kept waiting
+        for (const auto& pending : ready)
+        {
+            store_binary(pending);
+        }
+    }
+
+    void program_cache::set_directory(const std::filesystem::path& directory)
+    {
+        directory_ = directory;
+    }
+
+    const std::filesystem::path& program_cache::get_directory() const
+    {
+        return directory_;
+    }
+
+    const program_cache_stats& program_cache::get_stats() const
+    {
+        return stats_;
+    }
+
     material_cache::material_cache(graphics_device& device, const size_t initial_capacity)
         : device_(device)
     {
@@ -88,6 +404,9 @@ namespace moka
 
     material_handle material_cache::add_material(material&& material)
     {
+        // adding a material can move the others, which the render thread may be reading
+        device_.wait_idle();
+
         const auto index = materials_.size();
         materials_.emplace_back(std::move(material));
         return material_handle{static_cast<uint16_t>(index)};
@@ -111,6 +430,49 @@ namespace moka
         return &materials_[handle.id];
     }
 
+    size_t material_cache::size() const
+    {
+        return materials_.size();
+    }
+
+    pipeline_state_cache::pipeline_state_cache(graphics_device& device)
+        : device_(device)
+    {
+        const pipeline_state default_state;
+        states_.emplace_back(default_state);
+        state_lookup_[default_state.key()] = 0;
+    }
+
+    pipeline_state_handle pipeline_state_cache::add_pipeline_state(const pipeline_state& state)
+    {
+        const auto key = state.key();
+
+        const auto it = state_lookup_.find(key);
+
+        if (it != state_lookup_.end())
+        {
+            return pipeline_state_handle{it->second};
+        }
+
+        // adding a pipeline state can move the others, which the render thread may be reading
+        device_.wait_idle();
+
+        const auto index = static_cast<uint16_t>(states_.size());
+        states_.emplace_back(state);
+        state_lookup_[key] = index;
+        return pipeline_state_handle{index};
+    }
+
+    const pipeline_state& pipeline_state_cache::get_pipeline_state(const pipeline_state_handle handle) const
+    {
+        return states_[handle.id];
+    }
+
+    size_t pipeline_state_cache::size() const
+    {
+        return states_.size();
+    }
+
     texture_cache& graphics_device::get_texture_cache()
     {
         return textures_;
@@ -141,8 +503,40 @@ namespace moka
         return materials_;
     }
 
+    pipeline_state_cache& graphics_device::get_pipeline_state_cache()
+    {
+        return pipeline_states_;
+    }
+
+    const pipeline_state_cache& graphics_device::get_pipeline_state_cache() const
+    {
+        return pipeline_states_;
+    }
+
+    const command_allocator& graphics_device::get_frame_allocator() const
+    {
+        return frames_[(first_frame_ + frame_) % frames_.size()].allocator;
+    }
+
+    void graphics_device::frame_storage::reset()
+    {
+        allocator.reset();
+
+        for (size_t i = 0; i < recording_allocators_used; ++i)
+        {
+            recording_allocators[i]->reset();
+        }
+
+        recording_allocators_used = 0;
+    }
+
+    graphics_device::frame_storage& graphics_device::current_frame()
+    {
+        return frames_[(first_frame_ + frame_) % frames_.size()];
+    }
+
     graphics_device::graphics_device(window& window, const graphics_backend graphics_backend)
-        : textures_(*this), shaders_(*this), materials_(*this)
+        : window_(window), textures_(*this), shaders_(*this), materials_(*this), pipeline_states_(*this), optimizer_(materials_)
     {
         // auto context = window.make_context();
 
@@ -174,55 +568,506 @@ namespace moka
             graphics_api_ = std::make_unique<gl_graphics_api>(window, *this);
             break;
         case graphics_backend::null:
-            graphics_api_ = nullptr;
+        {
+            auto api = std::make_unique<null_graphics_api>(*this);
+            null_api_ = api.get();
+            graphics_api_ = std::move(api);
             break;
+        }
         default:
             graphics_api_ = nullptr;
         }
     }
 
-    void graphics_device::submit(command_list&& command_list, bool sort) const
+    graphics_device::~graphics_device()
+    {
+        // the render thread uses the api, so it has to stop first
+        stop_render_thread();
+    }
+
+    void graphics_device::start_render_thread(const size_t frames_in_flight)
+    {
+        if (render_thread_)
+        {
+            return;
+        }
+
+        // every frame in flight records into its own storage, which is recycled once the render thread has executed it.
+        // the render thread counts frames from zero, so the ring starts at the current storage to keep lists that are
+        // already recording valid
+        first_frame_ = (first_frame_ + frame_) % frames_.size();
+        frames_in_flight_ = std::clamp<size_t>(frames_in_flight, 1, max_frames_in_flight);
+        frame_ = 0;
+
+        constexpr size_t items_per_frame = 32;
+
+        render_thread_ = std::make_unique<render_thread>(
+            window_, items_per_frame * frames_in_flight_, [this](render_item& item) { execute(item); });
+    }
+
+    void graphics_device::stop_render_thread()
+    {
+        render_thread_.reset();
+    }
+
+    bool graphics_device::has_render_thread() const
+    {
+        return render_thread_ != nullptr;
+    }
+
+    void graphics_device::wait_idle() const
+    {
+        if (render_thread_)
+        {
+            render_thread_->wait_idle();
+        }
+    }
+
+    void graphics_device::set_optimize_commands(const bool enabled)
+    {
+        optimize_commands_ = enabled;
+    }
+
+    bool graphics_device::get_optimize_commands() const
+    {
+        return optimize_commands_;
+    }
+
+    command_optimizer_stats graphics_device::get_optimizer_stats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return frame_optimizer_stats_;
+    }
+
+    state_change_stats graphics_device::get_state_change_stats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return frame_state_stats_;
+    }
+
+    draw_stats graphics_device::get_draw_stats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return frame_draw_stats_;
+    }
+
+    std::vector<gpu_timer_result> graphics_device::get_gpu_timers() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return gpu_timers_;
+    }
+
+    texture_upload_stats graphics_device::get_texture_upload_stats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return frame_upload_stats_;
+    }
+
+    void graphics_device::set_texture_upload_budget(const size_t bytes)
+    {
+        invoke([&]() { graphics_api_->set_texture_upload_budget(bytes); });
+    }
+
+    null_call_stats graphics_device::get_null_call_stats() const
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return frame_null_stats_;
+    }
+
+    void graphics_device::set_record_null_calls(const bool enabled)
+    {
+        if (null_api_)
+        {
+            invoke([&]() { null_api_->set_recording(enabled); });
+        }
+    }
+
+    std::vector<null_call> graphics_device::take_recorded_null_calls()
+    {
+        if (!null_api_)
+        {
+            return {};
+        }
+
+        return invoke([&]() { return null_api_->take_recorded_calls(); });
+    }
+
+    std::vector<readback_result> graphics_device::poll_readbacks()
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        return std::exchange(readbacks_, {});
+    }
+
+    std::vector<readback_result> graphics_device::drain_readbacks()
+    {
+        // the render thread runs this after every command submitted so far
+        auto remaining = invoke([&]() { return graphics_api_->take_readbacks(true); });
+
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+
+        auto readbacks = std::exchange(readbacks_, {});
+        readbacks.insert(
+            readbacks.end(), std::make_move_iterator(remaining.begin()), std::make_move_iterator(remaining.end()));
+
+        return readbacks;
+    }
+
+    bool graphics_device::start_capture(const std::filesystem::path& path)
+    {
+        // the capture is written on the thread that executes the commands
+        wait_idle();
+
+        capture_ = std::make_unique<command_trace_writer>(path);
+
+        if (!capture_->is_open())
+        {
+            capture_.reset();
+            return false;
+        }
+
+        return true;
+    }
+
+    void graphics_device::stop_capture()
+    {
+        wait_idle();
+
+        capture_.reset();
+    }
+
+    bool graphics_device::is_capturing() const
+    {
+        return capture_ != nullptr;
+    }
+
+    void graphics_device::optimize(command_list& command_list)
+    {
+        if (!optimize_commands_)
+        {
+            return;
+        }
+
+        const auto stats = optimizer_.optimize(command_list);
+        optimizer_stats_.commands_removed += stats.commands_removed;
+        optimizer_stats_.parameters_removed += stats.parameters_removed;
+    }
+
+    void graphics_device::execute(command_list& command_list, const bool swap)
+    {
+        optimize(command_list);
+
+        if (capture_)
+        {
+            capture_->write_materials(materials_, pipeline_states_);
+            capture_->write_commands(command_list, swap);
+        }
+
+        if (swap)
+        {
+            graphics_api_->submit_and_swap(std::move(command_list));
+        }
+        else
+        {
+            graphics_api_->submit(std::move(command_list));
+        }
+
+        // the commands have been executed, release them while their storage is still valid
+        command_list.destroy();
+
+        if (swap)
+        {
+            // the frame has resolved the programs it linked, so their binaries can be retrieved without waiting
+            shaders_.collect_binaries(*graphics_api_);
+        }
+
+        if (swap)
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex_);
+            frame_optimizer_stats_ = optimizer_stats_;
+            optimizer_stats_ = {};
+            frame_state_stats_ = graphics_api_->get_state_change_stats();
+            frame_draw_stats_ = graphics_api_->get_draw_stats();
+            frame_upload_stats_ = graphics_api_->get_texture_upload_stats();
+
+            if (null_api_)
+            {
+                frame_null_stats_ = null_api_->get_call_stats();
+            }
+
+            for (auto& readback : graphics_api_->take_readbacks(false))
+            {
+                readbacks_.emplace_back(std::move(readback));
+            }
+
+            for (auto& timer : graphics_api_->get_gpu_timers())
+            {
+                const auto existing = std::find_if(gpu_timers_.begin(), gpu_timers_.end(), [&](const gpu_timer_result& result) {
+                    return result.name == timer.name && result.depth == timer.depth;
+                });
+
+                if (existing != gpu_timers_.end())
+                {
+                    *existing = std::move(timer);
+                }
+                else
+                {
+                    gpu_timers_.emplace_back(std::move(timer));
+                }
+            }
+        }
+    }
+
+    void graphics_device::execute(command_bundle& bundle, const std::vector<bundle_patch>& patches) const
+    {
+        bundle.apply_patches(patches);
+
+        if (capture_)
+        {
+            capture_->write_materials(materials_, pipeline_states_);
+            capture_->write_commands(bundle.get_commands(), false);
+        }
+
+        graphics_api_->submit(bundle);
+    }
+
+    void graphics_device::execute(render_item& item)
+    {
+        switch (item.type)
+        {
+        case render_item::kind::commands:
+            execute(item.commands, item.swap);
+            break;
+        case render_item::kind::bundle:
+            execute(*item.bundle, item.patches);
+            break;
+        case render_item::kind::task:
+            item.task();
+            break;
+        default:
+            break;
+        }
+    }
+
+    void graphics_device::end_frame()
+    {
+        ++frame_;
+
+        stream_.reset();
+
+        // wait until the render thread has finished the frame that last used the next frame's storage
+        if (render_thread_ && frame_ >= frames_in_flight_)
+        {
+            render_thread_->wait_for_frames(frame_ - frames_in_flight_ + 1);
+        }
+
+        current_frame().reset();
+    }
+
+    void graphics_device::submit(command_list&& command_list, const bool sort)
     {
         if (sort && !command_list.is_sorted())
         {
             command_list.sort();
         }
 
-        graphics_api_->submit(std::move(command_list));
+        if (!render_thread_)
+        {
+            execute(command_list, false);
+            return;
+        }
+
+        retain_host_data(command_list);
+
+        render_item item;
+        item.type = render_item::kind::commands;
+        item.commands = std::move(command_list);
+        render_thread_->push(std::move(item));
     }
 
-    void graphics_device::submit_and_swap(command_list&& command_list, bool sort) const
+    void graphics_device::submit(command_bundle& bundle) const
+    {
+        if (!render_thread_)
+        {
+            execute(bundle, bundle.take_patches());
+            return;
+        }
+
+        render_item item;
+        item.type = render_item::kind::bundle;
+        item.bundle = &bundle;
+        item.patches = bundle.take_patches();
+        render_thread_->push(std::move(item));
+    }
+
+    void graphics_device::submit_and_swap(command_list&& command_list, const bool sort)
     {
         if (sort && !command_list.is_sorted())
         {
             command_list.sort();
         }
 
-        graphics_api_->submit_and_swap(std::move(command_list));
+        if (render_thread_)
+        {
+            retain_host_data(command_list);
+
+            render_item item;
+            item.type = render_item::kind::commands;
+            item.commands = std::move(command_list);
+            item.swap = true;
+            render_thread_->push(std::move(item));
+        }
+        else
+        {
+            execute(command_list, true);
+        }
+
+        end_frame();
+
+        shaders_.store_binaries();
+    }
+
+    command_list graphics_device::make_command_list()
+    {
+        return command_list{current_frame().allocator, materials_};
+    }
+
+    std::vector<command_list> graphics_device::make_command_lists(const size_t count)
+    {
+        auto& frame = current_frame();
+
+        // hand out allocators that haven't been used this frame, so no two threads ever share one
+        while (frame.recording_allocators.size() < frame.recording_allocators_used + count)
+        {
+            frame.recording_allocators.emplace_back(std::make_unique<command_allocator>());
+        }
+
+        std::vector<command_list> lists;
+        lists.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            lists.emplace_back(*frame.recording_allocators[frame.recording_allocators_used++], materials_);
+        }
+
+        return lists;
     }
 
     vertex_buffer_handle graphics_device::make_vertex_buffer(
         const void* cube_vertices, const size_t size, vertex_layout&& layout, const buffer_usage use) const
     {
-        return graphics_api_->make_vertex_buffer(
-            cube_vertices, size, std::move(layout), use);
+        return invoke([&]() {
+            if (!capture_)
+            {
+                return graphics_api_->make_vertex_buffer(cube_vertices, size, std::move(layout), use);
+            }
+
+            // the layout is consumed by the api, so keep a copy for the trace
+            const auto captured_layout = layout;
+
+            const auto handle = graphics_api_->make_vertex_buffer(cube_vertices, size, std::move(layout), use);
+
+            capture_->write_vertex_buffer(handle, cube_vertices, size, captured_layout, use);
+
+            return handle;
+        });
     }
 
     index_buffer_handle graphics_device::make_index_buffer(
         const void* indices, const size_t size, const index_type type, const buffer_usage use) const
     {
-        return graphics_api_->make_index_buffer(indices, size, type, use);
+        return invoke([&]() {
+            const auto handle = graphics_api_->make_index_buffer(indices, size, type, use);
+
+            if (capture_)
+            {
+                capture_->write_index_buffer(handle, indices, size, type, use);
+            }
+
+            return handle;
+        });
+    }
+
+    uniform_buffer_handle graphics_device::make_uniform_buffer(const uniform_block block, const size_t size) const
+    {
+        return invoke([&]() {
+            const auto handle = graphics_api_->make_uniform_buffer(block, size);
+
+            if (capture_)
+            {
+                capture_->write_uniform_buffer(handle, block, size);
+            }
+
+            return handle;
+        });
+    }
+
+    stream_range graphics_device::allocate_stream(const size_t size, const size_t alignment)
+    {
+        return stream_.allocate(size, alignment);
     }
 
     shader_handle graphics_device::make_shader(const shader_type type, const std::string& source) const
     {
-        return graphics_api_->make_shader(type, source);
+        return invoke([&]() {
+            const auto handle = graphics_api_->make_shader(type, source);
+
+            if (capture_)
+            {
+                capture_->write_shader(handle, type, source);
+            }
+
+            return handle;
+        });
     }
 
     program_handle graphics_device::make_program(
         const shader_handle vertex_handle, const shader_handle fragment_handle) const
     {
-        return graphics_api_->make_program(vertex_handle, fragment_handle);
+        return invoke([&]() {
+            const auto handle = graphics_api_->make_program(vertex_handle, fragment_handle);
+
+            if (capture_)
+            {
+                capture_->write_program(handle, vertex_handle, fragment_handle);
+            }
+
+            return handle;
+        });
+    }
+
+    program_handle graphics_device::make_program(const program_binary& binary) const
+    {
+        return invoke([&]() { return graphics_api_->make_program(binary); });
+    }
+
+    bool graphics_device::get_program_binary(const program_handle program, program_binary& binary) const
+    {
+        return invoke([&]() { return graphics_api_->get_program_binary(program, binary); });
+    }
+
+    std::string graphics_device::get_driver_id() const
+    {
+        return invoke([&]() { return graphics_api_->get_driver_id(); });
+    }
+
+    int32_t graphics_device::find_uniform(const program_handle program, const std::string& name) const
+    {
+        // the first lookup may have to wait for the program to link, which has to happen on the render thread
+        return invoke([&]() { return graphics_api_->find_uniform(program, name); });
+    }
+
+    uint16_t graphics_device::find_parameter_index(const material_handle material, const std::string& name) const
+    {
+        // materials are only added while the render thread is idle, and their parameters are never added after, so this
+        // can read them from the calling thread
+        if (material.id >= materials_.size())
+        {
+            return std::numeric_limits<uint16_t>::max();
+        }
+
+        const auto index = materials_.get_material(material)->find_index(name);
+
+        return index == -1 ? std::numeric_limits<uint16_t>::max() : static_cast<uint16_t>(index);
     }
 
     texture_handle graphics_device::make_texture(
@@ -230,8 +1075,20 @@ namespace moka
     {
         const auto size = metadata.data.size();
 
-        const auto handle =
-            graphics_api_->make_texture(data, std::move(metadata), free_host_data);
+        const auto handle = invoke([&]() {
+            // the metadata is consumed by the api, so keep a copy for the trace
+            const auto captured_metadata = capture_ ? metadata : texture_metadata{};
+
+            const auto texture =
+                graphics_api_->make_texture(data, std::move(metadata), free_host_data);
+
+            if (capture_)
+            {
+                capture_->write_texture(texture, data, captured_metadata);
+            }
+
+            return texture;
+        });
 
         // this does not seem very safe at all! what if make_texture throws! Leak city!
         if (free_host_data)
@@ -253,7 +1110,16 @@ namespace moka
     frame_buffer_handle graphics_device::make_frame_buffer(
         render_texture_data* render_textures, const size_t render_texture_count) const
     {
-        return graphics_api_->make_frame_buffer(render_textures, render_texture_count);
+        return invoke([&]() {
+            const auto handle = graphics_api_->make_frame_buffer(render_textures, render_texture_count);
+
+            if (capture_)
+            {
+                capture_->write_frame_buffer(handle, render_textures, render_texture_count);
+            }
+
+            return handle;
+        });
     }
 
     frame_buffer_builder graphics_device::build_frame_buffer()
@@ -268,22 +1134,26 @@ namespace moka
 
     void graphics_device::destroy(program_handle handle)
     {
+        invoke([&]() { graphics_api_->destroy(handle); });
     }
 
     void graphics_device::destroy(vertex_buffer_handle handle)
     {
+        invoke([&]() { graphics_api_->destroy(handle); });
     }
 
     void graphics_device::destroy(index_buffer_handle handle)
     {
+        invoke([&]() { graphics_api_->destroy(handle); });
     }
 
     void graphics_device::destroy(shader_handle handle)
     {
+        invoke([&]() { graphics_api_->destroy(handle); });
     }
 
     void graphics_device::destroy(frame_buffer_handle handle)
     {
-        graphics_api_->destroy(handle);
+        invoke([&]() { graphics_api_->destroy(handle); });
     }
 } // namespace moka
@@ -0,0 +1,158 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <application/logger.hpp>
+#include <application/window.hpp>
+#include <graphics/device/render_thread.hpp>
+
+namespace moka
+{
+    namespace
+    {
+        logger log_("render_thread");
+    }
+
+    render_thread::render_thread(
+        const window& window, const size_t queue_capacity, std::function<void(render_item&)> execute)
+        : window_(window), execute_(std::move(execute)), queue_(queue_capacity)
+    {
+        window_.release_context();
+
+        thread_ = std::thread(&render_thread::run, this);
+    }
+
+    render_thread::~render_thread()
+    {
+        push(render_item{});
+
+        thread_.join();
+
+        window_.acquire_context();
+    }
+
+    void render_thread::notify(std::condition_variable& condition)
+    {
+        // take the lock so that the waiting thread can't miss the notification between checking and sleeping
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+        }
+
+        condition.notify_all();
+    }
+
+    void render_thread::run()
+    {
+        window_.acquire_context();
+
+        render_item item;
+
+        while (true)
+        {
+            if (!queue_.try_pop(item))
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_available_.wait(lock, [this] { return !queue_.empty(); });
+                continue;
+            }
+
+            if (item.type == render_item::kind::stop)
+            {
+                break;
+            }
+
+            const auto ends_frame = item.type == render_item::kind::commands && item.swap;
+
+            try
+            {
+                execute_(item);
+            }
+            catch (const std::exception& e)
+            {
+                log_.error(e.what());
+            }
+
+            // release the commands and their storage on this thread, before the producer can recycle it
+            item = render_item{};
+
+            if (ends_frame)
+            {
+                completed_frames_.fetch_add(1, std::memory_order_release);
+            }
+
+            executed_items_.fetch_add(1, std::memory_order_release);
+
+            notify(work_done_);
+        }
+
+        window_.release_context();
+    }
+
+    void render_thread::push(render_item&& item)
+    {
+        while (!queue_.try_push(std::move(item)))
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_done_.wait(lock, [this] { return !queue_.full(); });
+        }
+
+        ++pushed_items_;
+
+        notify(work_available_);
+    }
+
+    void render_thread::run_and_wait(std::function<void()> task)
+    {
+        render_item item;
+        item.type = render_item::kind::task;
+        item.task = std::move(task);
+
+        push(std::move(item));
+
+        wait_idle();
+    }
+
+    void render_thread::wait_for_frames(const size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_done_.wait(lock, [this, count] { return completed_frames_.load(std::memory_order_acquire) >= count; });
+    }
+
+    void render_thread::wait_idle()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_done_.wait(
+            lock, [this] { return executed_items_.load(std::memory_order_acquire) == pushed_items_; });
+    }
+
+    size_t render_thread::get_completed_frames() const
+    {
+        return completed_frames_.load(std::memory_order_acquire);
+    }
+} // namespace moka
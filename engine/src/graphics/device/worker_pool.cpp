@@ -0,0 +1,173 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <graphics/device/worker_pool.hpp>
+#include <utility>
+
+namespace moka
+{
+    worker_pool::worker_pool(const size_t thread_count)
+    {
+        threads_.reserve(thread_count);
+
+        for (size_t i = 0; i < thread_count; ++i)
+        {
+            threads_.emplace_back(&worker_pool::work, this);
+        }
+    }
+
+    worker_pool::~worker_pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+
+        work_available_.notify_all();
+
+        for (auto& thread : threads_)
+        {
+            thread.join();
+        }
+    }
+
+    void worker_pool::run_jobs(const std::function<void(size_t)>& job, const size_t count)
+    {
+        // jobs are claimed one at a time, so threads that finish early take more of them
+        for (auto i = next_job_.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next_job_.fetch_add(1, std::memory_order_relaxed))
+        {
+            try
+            {
+                job(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void worker_pool::work()
+    {
+        size_t generation = 0;
+
+        while (true)
+        {
+            const std::function<void(size_t)>* job;
+            size_t count;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                work_available_.wait(lock, [this, generation] { return stop_ || generation_ != generation; });
+
+                if (stop_)
+                {
+                    return;
+                }
+
+                generation = generation_;
+
+                // the other threads finished every job before this one woke up
+                if (!job_)
+                {
+                    continue;
+                }
+
+                job = job_;
+                count = job_count_;
+                ++busy_workers_;
+            }
+
+            run_jobs(*job, count);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                --busy_workers_;
+            }
+
+            work_done_.notify_one();
+        }
+    }
+
+    void worker_pool::run(const size_t count, const std::function<void(size_t)>& job)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // a single job isn't worth waking the workers for
+        if (count > 1 && !threads_.empty())
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                job_ = &job;
+                job_count_ = count;
+                next_job_.store(0, std::memory_order_relaxed);
+                ++generation_;
+            }
+
+            work_available_.notify_all();
+        }
+        else
+        {
+            next_job_.store(0, std::memory_order_relaxed);
+        }
+
+        run_jobs(job, count);
+
+        std::exception_ptr error;
+
+        {
+            // every job has been claimed, wait for the workers that are still running theirs
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+
+            job_ = nullptr;
+            job_count_ = 0;
+            error = std::exchange(error_, nullptr);
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    size_t worker_pool::size() const
+    {
+        return threads_.size();
+    }
+} // namespace moka
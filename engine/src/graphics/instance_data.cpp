@@ -0,0 +1,48 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <cstddef>
+#include <graphics/instance_data.hpp>
+
+namespace moka
+{
+    vertex_layout instance_data::layout()
+    {
+        constexpr auto stride = sizeof(instance_data);
+        constexpr auto column = sizeof(glm::vec4);
+
+        // a mat4 attribute occupies four consecutive locations, one per column
+        return vertex_layout{
+            {model_attribute + 0, attribute_type::float32, 4, false, stride, offsetof(instance_data, model) + 0 * column, 1},
+            {model_attribute + 1, attribute_type::float32, 4, false, stride, offsetof(instance_data, model) + 1 * column, 1},
+            {model_attribute + 2, attribute_type::float32, 4, false, stride, offsetof(instance_data, model) + 2 * column, 1},
+            {model_attribute + 3, attribute_type::float32, 4, false, stride, offsetof(instance_data, model) + 3 * column, 1},
+            {material_index_attribute, attribute_type::float32, 1, false, stride, offsetof(instance_data, material_index), 1}};
+    }
+} // namespace moka
@@ -40,11 +40,8 @@ namespace moka
         : alpha_mode_(rhs.alpha_mode_),
           programs_(std::move(rhs.programs_)),
           parameters_(std::move(rhs.parameters_)),
-          blend_(rhs.blend_),
-          culling_(rhs.culling_),
-          polygon_mode_(rhs.polygon_mode_),
-          depth_test_(rhs.depth_test_),
-          scissor_test_(rhs.scissor_test_)
+          pipeline_state_(rhs.pipeline_state_),
+          uniform_locations_(std::move(rhs.uniform_locations_))
     {
     }
 
@@ -53,11 +50,8 @@ namespace moka
         alpha_mode_ = rhs.alpha_mode_;
         programs_ = std::move(rhs.programs_);
         parameters_ = std::move(rhs.parameters_);
-        blend_ = rhs.blend_;
-        culling_ = rhs.culling_;
-        polygon_mode_ = rhs.polygon_mode_;
-        depth_test_ = rhs.depth_test_;
-        scissor_test_ = rhs.scissor_test_;
+        pipeline_state_ = rhs.pipeline_state_;
+        uniform_locations_ = std::move(rhs.uniform_locations_);
         return *this;
     }
 
@@ -65,19 +59,11 @@ namespace moka
         std::vector<program_handle>&& programs,
         parameter_collection&& parameters,
         alpha_mode alpha_mode,
-        const blend& blend,
-        const culling& culling,
-        const polygon_mode& polygon_mode,
-        bool depth_test,
-        bool scissor_test)
+        const pipeline_state_handle pipeline_state)
         : alpha_mode_(alpha_mode),
           programs_(std::move(programs)),
           parameters_(std::move(parameters)),
-          blend_(blend),
-          culling_(culling),
-          polygon_mode_(polygon_mode),
-          depth_test_(depth_test),
-          scissor_test_(scissor_test)
+          pipeline_state_(pipeline_state)
     {
     }
 
@@ -96,19 +82,36 @@ namespace moka
         return programs_[active_program_];
     }
 
-    size_t material::size() const
+    program_handle material::get_program(const size_t index) const
     {
-        return parameters_.size();
+        return programs_[index];
+    }
+
+    size_t material::get_program_count() const
+    {
+        return programs_.size();
+    }
+
+    void material::set_uniform_locations(const size_t index, std::vector<int32_t>&& locations)
+    {
+        uniform_locations_.resize(programs_.size());
+        uniform_locations_[index] = std::move(locations);
     }
 
-    bool material::get_scissor_test() const
+    std::vector<int32_t>& material::get_uniform_locations()
     {
-        return scissor_test_;
+        uniform_locations_.resize(programs_.size());
+        return uniform_locations_[active_program_];
     }
 
-    bool material::get_depth_test() const
+    size_t material::size() const
+    {
+        return parameters_.size();
+    }
+
+    pipeline_state_handle material::get_pipeline_state() const
     {
-        return depth_test_;
+        return pipeline_state_;
     }
 
     material::const_iterator material::begin() const
@@ -146,19 +149,15 @@ namespace moka
         return parameters_[name];
     }
 
-    const blend& material::get_blend() const
-    {
-        return blend_;
-    }
-
-    const culling& material::get_culling() const
+    const material_parameter* material::find(const std::string& name) const
     {
-        return culling_;
+        return parameters_.find(name);
     }
 
-    const polygon_mode& material::get_polygon_mode() const
+    int32_t material::find_index(const std::string& name) const
     {
-        return polygon_mode_;
+        const auto* parameter = parameters_.find(name);
+        return parameter ? static_cast<int32_t>(parameter - &parameters_[0]) : -1;
     }
 
     void material::set_active_program(size_t active_program)
@@ -97,45 +97,45 @@ namespace moka
 
     material_builder& material_builder::set_blend_equation(const blend_equation equation)
     {
-        blend_.equation = equation;
+        pipeline_state_.blend.equation = equation;
         return *this;
     }
 
     material_builder& material_builder::set_blend_function(
         const blend_function_factor source, const blend_function_factor destination)
     {
-        blend_.source = source;
-        blend_.destination = destination;
+        pipeline_state_.blend.source = source;
+        pipeline_state_.blend.destination = destination;
         return *this;
     }
 
     material_builder& material_builder::set_blend_enabled(const bool enabled)
     {
-        blend_.enabled = enabled;
+        pipeline_state_.blend.enabled = enabled;
         return *this;
     }
 
     material_builder& material_builder::set_culling_enabled(const bool enabled)
     {
-        culling_.enabled = enabled;
+        pipeline_state_.culling.enabled = enabled;
         return *this;
     }
 
     material_builder& material_builder::set_depth_test_enabled(const bool enabled)
     {
-        depth_test_ = enabled;
+        pipeline_state_.depth_test = enabled;
         return *this;
     }
 
     material_builder& material_builder::set_scissor_test_enabled(const bool enabled)
     {
-        scissor_test_ = enabled;
+        pipeline_state_.scissor_test = enabled;
         return *this;
     }
 
     material_builder& material_builder::set_culling_faces(const face faces)
     {
-        culling_.faces = faces;
+        pipeline_state_.culling.faces = faces;
         return *this;
     }
 
@@ -151,10 +151,16 @@ namespace moka
         return *this;
     }
 
+    material_builder& material_builder::set_instanced(const bool instanced)
+    {
+        instanced_ = instanced;
+        return *this;
+    }
+
     material_builder& material_builder::set_polygon_mode(const face faces, const polygon_draw_mode mode)
     {
-        polygon_mode_.faces = faces;
-        polygon_mode_.mode = mode;
+        pipeline_state_.polygon_mode.faces = faces;
+        pipeline_state_.polygon_mode.mode = mode;
         return *this;
     }
 
@@ -232,6 +238,11 @@ namespace moka
             compiler_flags.append("#define MASK_ALPHA\n");
         }
 
+        if (instanced_)
+        {
+            compiler_flags.append("#define INSTANCED\n");
+        }
+
         for (const auto& property : texture_maps_)
         {
             switch (property)
@@ -271,44 +282,21 @@ namespace moka
     {
         build_shader_source();
 
-        std::hash<std::string> hash;
-
         std::vector<program_handle> programs;
 
         for (size_t i = 0; i < vertex_shaders_src_.size(); ++i)
         {
-            const auto key = hash(vertex_shaders_src_[i] + fragment_shaders_src_[i]);
-
-            auto& cache = graphics_device_.get_program_cache();
-
-            if (cache.exists(key))
-            {
-                programs.emplace_back(cache.get_program(key));
-            }
-            else
-            {
-                const auto vertex_shader = graphics_device_.make_shader(
-                    shader_type::vertex, vertex_shaders_src_[i]);
-
-                const auto fragment_shader = graphics_device_.make_shader(
-                    shader_type::fragment, fragment_shaders_src_[i]);
-
-                auto& handle = programs.emplace_back(
-                    graphics_device_.make_program(vertex_shader, fragment_shader));
-
-                cache.add_program(handle, key);
-            }
+            programs.emplace_back(
+                graphics_device_.get_program_cache().make_program(vertex_shaders_src_[i], fragment_shaders_src_[i]));
         }
 
         material mat = {std::move(programs),
                         std::move(parameters_),
                         alpha_mode_,
-                        blend_,
-                        culling_,
-                        polygon_mode_,
-                        depth_test_,
-                        scissor_test_};
+                        graphics_device_.get_pipeline_state_cache().add_pipeline_state(pipeline_state_)};
 
+        // parameters are bound to their uniforms the first time the material is drawn, so that building many materials
+        // doesn't wait for each of their programs to link before the next is queued. unused parameters are reported then
         return graphics_device_.get_material_cache().add_material(std::move(mat));
     }
 } // namespace moka
@@ -111,22 +111,40 @@ namespace moka
     }
 
     material_parameter& parameter_collection::operator[](const std::string& name)
+    {
+        return parameters_[get_index(name)];
+    }
+
+    size_t parameter_collection::get_index(const std::string& name)
     {
         const auto param = index_lookup_.find(name);
 
         if (param != index_lookup_.end())
         {
-            const auto position = param->second;
-            return parameters_[position];
+            return param->second;
         }
 
-        index_lookup_[name] = parameters_.size();
+        const auto position = parameters_.size();
+
+        index_lookup_[name] = position;
 
         auto& e = parameters_.emplace_back();
 
         e.name = name;
 
-        return e;
+        return position;
+    }
+
+    const material_parameter* parameter_collection::find(const std::string& name) const
+    {
+        const auto param = index_lookup_.find(name);
+
+        if (param != index_lookup_.end())
+        {
+            return &parameters_[param->second];
+        }
+
+        return nullptr;
     }
 
     size_t parameter_collection::size() const
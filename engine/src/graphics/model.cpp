@@ -82,6 +82,23 @@ namespace moka
             .set_primitive_type(type_)
             .set_index_count(index_count_)
             .set_index_buffer_offset(index_buffer_offset_)
+            .set_base_vertex(base_vertex_)
+            .set_material(material_);
+    }
+
+    void primitive::draw_instances(
+        command_buffer& cmd, const vertex_buffer_handle instance_buffer, const uint32_t count, const uint32_t first) const
+    {
+        cmd.draw()
+            .set_vertex_buffer(vertex_buffer_)
+            .set_vertex_count(vertex_count_)
+            .set_index_buffer(index_buffer_)
+            .set_index_type(index_type_)
+            .set_primitive_type(type_)
+            .set_index_count(index_count_)
+            .set_index_buffer_offset(index_buffer_offset_)
+            .set_base_vertex(base_vertex_)
+            .set_instances(instance_buffer, count, first)
             .set_material(material_);
     }
 
@@ -92,13 +109,15 @@ namespace moka
         const index_type index_type,
         const uint32_t index_count,
         const uint32_t index_buffer_offset,
-        const material_handle material)
+        const material_handle material,
+        const int32_t base_vertex)
         : vertex_buffer_(vertex_buffer),
           vertex_count_(vertex_count),
           index_buffer_(index_buffer),
           index_type_(index_type),
           index_count_(index_count),
           index_buffer_offset_(index_buffer_offset),
+          base_vertex_(base_vertex),
           material_(material)
     {
     }
@@ -99,8 +99,6 @@ namespace moka
             device_.build_material()
                 .add_vertex_shader(shaders::shade_cubemap::vert)
                 .add_fragment_shader(shaders::shade_cubemap::frag)
-                .add_material_parameter("projection", parameter_type::mat4)
-                .add_material_parameter("view", parameter_type::mat4)
                 .add_material_parameter("environment_map", cubemap)
                 .set_culling_enabled(false)
                 .build();
@@ -133,8 +131,7 @@ namespace moka
     {
         for (auto i = 0; i < 6; i++)
         {
-            list.set_material_parameters().set_material(material).set_parameter(
-                "view", constants::capture_views[i]);
+            list.set_material_parameters().set_material(material).set_parameter("view", constants::capture_views[i]);
 
             const auto image_target = constants::image_targets[i];
 
@@ -162,7 +159,7 @@ namespace moka
         draw_callback&& pre,
         draw_callback&& post) const
     {
-        command_list list;
+        command_list list{device_.get_material_cache()};
 
         const auto hdr_frame_buffer =
             device_.build_frame_buffer()
@@ -237,10 +234,11 @@ namespace moka
             0, // mip level being drawn to
             hdr_cubemap,
             hdr_material,
-            {}, // submit optional pre-draw commands here
+            [](command_list& list) { list.gpu_timer().begin_scope("equirectangular to cubemap"); },
             [&](command_list& list) {
                 // we want to generate mips after drawing
                 list.generate_mipmaps().set_texture(hdr_cubemap);
+                list.gpu_timer().end_scope();
             });
 
         return hdr_cubemap;
@@ -263,7 +261,13 @@ namespace moka
         const auto irradiance_cubemap =
             make_empty_hdr_cubemap(irradiance_size, min_filter::linear, false);
 
-        draw_to_cubemap(irradiance_size, 0, irradiance_cubemap, irradiance_material);
+        draw_to_cubemap(
+            irradiance_size,
+            0,
+            irradiance_cubemap,
+            irradiance_material,
+            [](command_list& list) { list.gpu_timer().begin_scope("irradiance map"); },
+            [](command_list& list) { list.gpu_timer().end_scope(); });
 
         return irradiance_cubemap;
     }
@@ -291,14 +295,30 @@ namespace moka
         {
             const auto mip_size = static_cast<uint32_t>(prefilter_size * std::pow(0.5, mip));
 
+            // one scope covers every mip level, even though each is drawn by a list of its own
             draw_to_cubemap(
-                mip_size, mip, prefilter_cubemap, prefilter_material, [&](command_list& list) {
+                mip_size,
+                mip,
+                prefilter_cubemap,
+                prefilter_material,
+                [&](command_list& list) {
+                    if (mip == 0)
+                    {
+                        list.gpu_timer().begin_scope("specular map");
+                    }
+
                     const auto roughness = static_cast<float>(mip) /
                                            static_cast<float>(max_mip_levels - 1);
 
                     list.set_material_parameters()
                         .set_material(prefilter_material)
                         .set_parameter("roughness", roughness);
+                },
+                [&](command_list& list) {
+                    if (mip == max_mip_levels - 1)
+                    {
+                        list.gpu_timer().end_scope();
+                    }
                 });
         }
 
@@ -342,6 +362,8 @@ namespace moka
                 .add_depth_attachment(frame_format::depth_component24, brdf_size, brdf_size)
                 .build();
 
+        brdf_list.gpu_timer().begin_scope("brdf map");
+
         brdf_list.frame_buffer().set_frame_buffer(brdf_frame_buffer);
 
         brdf_list.viewport().set_rectangle(0, 0, brdf_size, brdf_size);
@@ -362,6 +384,8 @@ namespace moka
 
         brdf_list.frame_buffer().set_frame_buffer({0});
 
+        brdf_list.gpu_timer().end_scope();
+
         device_.submit(std::move(brdf_list), false);
 
         device_.destroy(brdf_frame_buffer);
@@ -62,6 +62,48 @@ namespace moka
         return id <= rhs.id;
     }
 
+    namespace
+    {
+        size_t channel_count(const host_format format)
+        {
+            switch (format)
+            {
+            case host_format::r:
+                return 1;
+            case host_format::rg:
+                return 2;
+            case host_format::rgb:
+            case host_format::bgr:
+                return 3;
+            default:
+                return 4;
+            }
+        }
+
+        size_t pixel_size(const pixel_type type)
+        {
+            switch (type)
+            {
+            case pixel_type::int8:
+            case pixel_type::uint8:
+                return 1;
+            case pixel_type::int16:
+            case pixel_type::uint16:
+            case pixel_type::float16:
+                return 2;
+            default:
+                return 4;
+            }
+        }
+    } // namespace
+
+    size_t image_size(const image_metadata& image)
+    {
+        const auto row = static_cast<size_t>(image.width) * channel_count(image.base_format) * pixel_size(image.type);
+
+        return ((row + 3) & ~size_t{3}) * static_cast<size_t>(image.height);
+    }
+
     texture_builder::texture_builder(graphics_device& device) : device_(device)
     {
     }
@@ -114,6 +156,12 @@ namespace moka
         return *this;
     }
 
+    texture_builder& texture_builder::set_streamed(const bool streamed)
+    {
+        metadata_.streamed = streamed;
+        return *this;
+    }
+
     texture_handle texture_builder::build()
     {
         return device_.make_texture(host_data_.data(), std::move(metadata_), free_host_data_);
@@ -0,0 +1,177 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <allocation_counter.hpp>
+#include <catch2/catch.hpp>
+#include <graphics/command/command_list.hpp>
+#include <graphics/pbr_scene.hpp>
+#include <legacy_commands.hpp>
+#include <null_device.hpp>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    constexpr size_t frame_buffer_count = 10000;
+
+    void record_frame(command_list& list)
+    {
+        for (size_t i = 0; i < frame_buffer_count; ++i)
+        {
+            record_primitive(list.make_command_buffer(i), i);
+        }
+    }
+
+    void record_frame(std::vector<legacy_buffer>& list)
+    {
+        for (size_t i = 0; i < frame_buffer_count; ++i)
+        {
+            auto& buffer = list.emplace_back();
+            buffer.key = i;
+            record_primitive(buffer, i);
+        }
+    }
+} // namespace
+
+TEST_CASE("command_allocator keeps its blocks after a reset", "[command_allocator]")
+{
+    command_allocator allocator{1024};
+
+    for (auto i = 0; i < 100; ++i)
+    {
+        allocator.allocate(64, 16);
+    }
+
+    const auto heap_allocations = allocator.heap_allocations();
+    const auto capacity = allocator.capacity();
+
+    REQUIRE(allocator.size() >= 100 * 64);
+
+    allocator.reset();
+
+    REQUIRE(allocator.size() == 0);
+
+    for (auto i = 0; i < 100; ++i)
+    {
+        allocator.allocate(64, 16);
+    }
+
+    REQUIRE(allocator.heap_allocations() == heap_allocations);
+    REQUIRE(allocator.capacity() == capacity);
+}
+
+TEST_CASE("command_allocator aligns its allocations", "[command_allocator]")
+{
+    command_allocator allocator{256};
+
+    for (const size_t alignment : {1, 2, 4, 8, 16, 32, 64})
+    {
+        allocator.allocate(3, 1);
+
+        const auto address = reinterpret_cast<std::uintptr_t>(allocator.allocate(24, alignment));
+
+        REQUIRE(address % alignment == 0);
+    }
+
+    // allocations larger than a block get a block of their own
+    REQUIRE(allocator.allocate(4096, 16) != nullptr);
+}
+
+TEST_CASE("A warm frame allocator records a frame with fewer heap allocations", "[command_allocator]")
+{
+    command_allocator allocator;
+
+    {
+        command_list list{allocator};
+        record_frame(list);
+    }
+
+    allocator.reset();
+
+    const auto allocator_heap_allocations = allocator.heap_allocations();
+
+    const allocation_counter frame_counter;
+
+    {
+        command_list list{allocator};
+        record_frame(list);
+    }
+
+    const auto frame_allocations = frame_counter.count();
+
+    const allocation_counter legacy_counter;
+
+    {
+        std::vector<legacy_buffer> list;
+        record_frame(list);
+    }
+
+    const auto legacy_allocations = legacy_counter.count();
+
+    CAPTURE(frame_allocations, legacy_allocations);
+
+    // command storage never touches the heap once the allocator has warmed up, so only the list of buffers allocates
+    REQUIRE(allocator.heap_allocations() == allocator_heap_allocations);
+    REQUIRE(frame_allocations < frame_buffer_count / 100);
+    REQUIRE(frame_allocations < legacy_allocations);
+}
+
+TEST_CASE("Command recording", "[command_allocator][!benchmark]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    // the default model, the only sample with translucent meshes, which are recorded again each frame
+    pbr_scene scene(device, MOKA_ASSET_PATH, "Models/FlightHelmet/FlightHelmet.gltf");
+
+    const basic_camera camera({}, glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+    const auto draw_frame = [&] {
+        scene.draw(camera, {0, 0, 1280, 720});
+        device.submit_and_swap(device.make_command_list());
+    };
+
+    // the first frames record the static bundle and warm the frame allocators up
+    for (auto frame = 0; frame < 3; ++frame)
+    {
+        draw_frame();
+    }
+
+    const allocation_counter counter;
+
+    draw_frame();
+
+    WARN("pbr_scene::draw on FlightHelmet: " << counter.count() << " heap allocations per frame");
+
+    BENCHMARK("Draw FlightHelmet with pbr_scene through the null backend")
+    {
+        draw_frame();
+    };
+}
@@ -0,0 +1,336 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/command/command_list.hpp>
+#include <legacy_commands.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    constexpr size_t frame_buffer_count = 10000;
+
+    constexpr size_t material_count = 64;
+
+    /**
+     * \brief Replays a command stream, writing each parameter into its material the way the backends do.
+     */
+    struct stream_replayer final
+    {
+        std::vector<std::vector<material_parameter>>& materials;
+        size_t indices = 0;
+
+        void visit(set_material_parameters_command& cmd)
+        {
+            auto& material = materials[cmd.material.id];
+
+            cmd.for_each_parameter([&material](const material_parameter_record& record) {
+                auto& parameter = material[record.index];
+                parameter.type = record.type;
+                parameter.data = record.get_data();
+            });
+        }
+
+        void visit(draw_command& cmd)
+        {
+            indices += cmd.index_count;
+        }
+
+        template <typename T>
+        void visit(T&)
+        {
+        }
+    };
+
+    /**
+     * \brief Replays legacy commands, looking each parameter up by name the way the backends used to.
+     */
+    struct legacy_replayer final : legacy_visitor
+    {
+        std::vector<std::vector<material_parameter>>& materials;
+        std::unordered_map<std::string, size_t>& lookup;
+        size_t indices = 0;
+
+        legacy_replayer(std::vector<std::vector<material_parameter>>& materials, std::unordered_map<std::string, size_t>& lookup)
+            : materials(materials), lookup(lookup)
+        {
+        }
+
+        void visit(legacy_parameters& parameters) override
+        {
+            auto& material = materials[parameters.material.id];
+
+            for (const auto& parameter : parameters.parameters)
+            {
+                material[lookup.at(parameter.name)] = parameter;
+            }
+        }
+
+        void visit(draw_command& draw) override
+        {
+            indices += draw.index_count;
+        }
+    };
+
+    std::vector<std::vector<material_parameter>> make_materials()
+    {
+        return std::vector<std::vector<material_parameter>>(
+            material_count, std::vector<material_parameter>{material_parameter{"model", glm::mat4{1.0f}}});
+    }
+
+    /**
+     * \brief Counts the commands of each type in a command buffer.
+     */
+    struct command_counter final
+    {
+        size_t parameters = 0;
+        size_t draws = 0;
+        size_t others = 0;
+
+        void visit(set_material_parameters_command&)
+        {
+            ++parameters;
+        }
+
+        void visit(draw_command&)
+        {
+            ++draws;
+        }
+
+        template <typename T>
+        void visit(T&)
+        {
+            ++others;
+        }
+    };
+} // namespace
+
+TEST_CASE("Material parameters are stored inline after their command", "[command_buffer]")
+{
+    command_list list;
+    auto& buffer = list.make_command_buffer(0);
+
+    const texture_handle texture{7};
+
+    buffer.set_material_parameters()
+        .set_material(material_handle{3})
+        .set_parameter(0, 0.5f)
+        .set_parameter(1, glm::vec3{1.0f, 2.0f, 3.0f})
+        .set_parameter(2, texture)
+        .set_parameter(3, glm::mat4{2.0f});
+
+    buffer.draw().set_index_count(36);
+
+    std::vector<std::pair<uint16_t, parameter_type>> records;
+    size_t commands = 0;
+
+    for (auto& header : buffer)
+    {
+        ++commands;
+
+        if (header.type != command_type::set_material_parameters)
+        {
+            continue;
+        }
+
+        auto& cmd = command_record<set_material_parameters_command>::from_header(header);
+
+        REQUIRE(cmd.material.id == 3);
+        REQUIRE(cmd.count == 4);
+
+        cmd.for_each_parameter([&records](const material_parameter_record& record) {
+            records.emplace_back(record.index, record.type);
+        });
+
+        const auto* parameter = cmd.get_parameters();
+        REQUIRE(std::get<float>(parameter->get_data()) == 0.5f);
+
+        parameter = parameter->next();
+        REQUIRE(std::get<glm::vec3>(parameter->get_data()) == glm::vec3{1.0f, 2.0f, 3.0f});
+
+        parameter = parameter->next();
+        REQUIRE(std::get<texture_handle>(parameter->get_data()).id == texture.id);
+
+        parameter = parameter->next();
+        REQUIRE(std::get<glm::mat4>(parameter->get_data()) == glm::mat4{2.0f});
+    }
+
+    REQUIRE(commands == 2);
+    REQUIRE(
+        records == std::vector<std::pair<uint16_t, parameter_type>>{
+                       {0, parameter_type::float32},
+                       {1, parameter_type::vec3},
+                       {2, parameter_type::texture},
+                       {3, parameter_type::mat4}});
+
+    // the records and the draw that follows them are laid out back to back
+    REQUIRE(buffer.size() % command_alignment == 0);
+}
+
+TEST_CASE("Material parameter records only accept values of their own type", "[command_buffer]")
+{
+    command_list list;
+    auto& buffer = list.make_command_buffer(0);
+
+    buffer.set_material_parameters().set_material(material_handle{0}).set_parameter(0, glm::vec4{1.0f});
+
+    auto& cmd = command_record<set_material_parameters_command>::from_header(*buffer.begin());
+    auto& record = *cmd.get_parameters();
+
+    REQUIRE(record.set_data(glm::vec4{2.0f}));
+    REQUIRE(std::get<glm::vec4>(record.get_data()) == glm::vec4{2.0f});
+
+    REQUIRE_FALSE(record.set_data(1.0f));
+    REQUIRE(std::get<glm::vec4>(record.get_data()) == glm::vec4{2.0f});
+}
+
+TEST_CASE("Material parameters can't be set by name without a material cache", "[command_buffer]")
+{
+    command_list list;
+    auto& buffer = list.make_command_buffer(0);
+
+    buffer.set_material_parameters().set_material(material_handle{0}).set_parameter("roughness", 0.5f);
+
+    auto& cmd = command_record<set_material_parameters_command>::from_header(*buffer.begin());
+
+    REQUIRE(cmd.count == 0);
+}
+
+TEST_CASE("command_buffer grows its stream past the first block", "[command_buffer]")
+{
+    command_allocator allocator{256};
+
+    // interleaved buffers can't grow in place, so their records are moved to new memory
+    command_buffer first{allocator, 0};
+    command_buffer second{allocator, 1};
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        record_primitive(first, i);
+        record_primitive(second, i);
+    }
+
+    for (auto* buffer : {&first, &second})
+    {
+        command_counter counter;
+        buffer->accept(counter);
+
+        REQUIRE(counter.parameters == 100);
+        REQUIRE(counter.draws == 100);
+        REQUIRE(counter.others == 0);
+    }
+}
+
+TEST_CASE("command_buffer::remove_if compacts the stream", "[command_buffer]")
+{
+    command_list list;
+    auto& buffer = list.make_command_buffer(0);
+
+    for (size_t i = 0; i < 10; ++i)
+    {
+        record_primitive(buffer, i);
+    }
+
+    const auto size = buffer.size();
+
+    const auto removed = buffer.remove_if(
+        [](const command_header& header) { return header.type == command_type::set_material_parameters; });
+
+    REQUIRE(removed == 10);
+    REQUIRE(buffer.size() < size);
+
+    command_counter counter;
+    buffer.accept(counter);
+
+    REQUIRE(counter.parameters == 0);
+    REQUIRE(counter.draws == 10);
+
+    // the draws that were slid down keep their contents
+    uint32_t vertex_buffer = 0;
+
+    for (auto& header : buffer)
+    {
+        REQUIRE(command_record<draw_command>::from_header(header).vertex_buffer.id == vertex_buffer++);
+    }
+}
+
+TEST_CASE("Command record and replay", "[command_buffer][!benchmark]")
+{
+    auto materials = make_materials();
+    std::unordered_map<std::string, size_t> lookup{{"model", 0}};
+
+    BENCHMARK_ADVANCED("Record and replay 10k command buffers as a command stream")(Catch::Benchmark::Chronometer meter)
+    {
+        command_allocator allocator;
+
+        meter.measure([&allocator, &materials] {
+            allocator.reset();
+            command_list list{allocator};
+
+            for (size_t i = 0; i < frame_buffer_count; ++i)
+            {
+                record_primitive(list.make_command_buffer(i), i);
+            }
+
+            stream_replayer replayer{materials};
+
+            for (auto& buffer : list)
+            {
+                buffer.accept(replayer);
+            }
+
+            return replayer.indices;
+        });
+    };
+
+    BENCHMARK("Record and replay 10k command buffers with a heap allocation per command")
+    {
+        std::vector<legacy_buffer> list;
+
+        for (size_t i = 0; i < frame_buffer_count; ++i)
+        {
+            auto& buffer = list.emplace_back();
+            buffer.key = i;
+            record_primitive(buffer, i);
+        }
+
+        legacy_replayer replayer{materials, lookup};
+
+        for (auto& buffer : list)
+        {
+            buffer.accept(replayer);
+        }
+
+        return replayer.indices;
+    };
+}
@@ -0,0 +1,70 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/command/command_bundle.hpp>
+#include <null_device.hpp>
+
+using namespace moka;
+
+TEST_CASE("command_bundle patches parameters when it is submitted", "[command_bundle]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const auto material = device.build_material()
+                              .add_vertex_shader(std::string{"void main() {}"})
+                              .add_fragment_shader(std::string{"void main() {}"})
+                              .add_material_parameter("color", glm::vec4{1.0f})
+                              .build();
+
+    // the bundle outlives the frame, so it must not use the frame allocator
+    command_list list{device.get_material_cache()};
+    list.set_material_parameters().set_material(material).set_parameter("color", glm::vec4{0.5f});
+
+    command_bundle bundle{std::move(list)};
+    bundle.add_patch(device.get_material_cache(), "color");
+
+    // a patch can't be registered twice, patches that are pending point at its locations
+    bundle.add_patch(device.get_material_cache(), "color");
+
+    bundle.set_parameter("color", glm::vec4{0.25f});
+    device.submit(bundle);
+    device.submit_and_swap(device.make_command_list());
+
+    const auto* color = device.get_material_cache().get_material(material)->find("color");
+    REQUIRE(std::get<glm::vec4>(color->data) == glm::vec4{0.25f});
+
+    // the patched value is kept by the bundle for the frames that follow
+    device.submit(bundle);
+    device.submit_and_swap(device.make_command_list());
+
+    REQUIRE(std::get<glm::vec4>(color->data) == glm::vec4{0.25f});
+    REQUIRE(count(device.get_null_call_stats(), command_type::set_material_parameters) == 1);
+}
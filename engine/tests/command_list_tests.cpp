@@ -0,0 +1,163 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <graphics/command/command_list.hpp>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    // keys laid out like the ones pbr_scene builds: a few programs, pipeline states and texture sets, and any depth
+    std::vector<sort_entry> make_scene_entries(const size_t count)
+    {
+        std::mt19937 random{1234};
+        std::uniform_int_distribution<uint32_t> state{0, 7};
+        std::uniform_int_distribution<uint32_t> texture_set{0, 63};
+        std::uniform_real_distribution<float> depth{0.0f, 1000.0f};
+
+        std::vector<sort_entry> entries;
+        entries.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto key = sort_key_builder{}
+                                 .set_translucency(i % 8 == 0 ? translucency::translucent : translucency::opaque)
+                                 .set_pipeline_state(state(random))
+                                 .set_program(state(random))
+                                 .set_texture_set(texture_set(random))
+                                 .set_depth(depth(random))
+                                 .build();
+
+            entries.push_back({key, static_cast<uint32_t>(i)});
+        }
+
+        return entries;
+    }
+
+    // the comparison sort that command_list uses below its radix sort threshold
+    void comparison_sort(std::vector<sort_entry>& entries)
+    {
+        std::sort(entries.begin(), entries.end(), [](const sort_entry& left, const sort_entry& right) {
+            return left.key < right.key || (left.key == right.key && left.index < right.index);
+        });
+    }
+} // namespace
+
+TEST_CASE("radix_sort is a stable sort", "[command_list]")
+{
+    for (const size_t count : {2, 100, 5000})
+    {
+        auto entries = make_scene_entries(count);
+
+        // repeat some keys so that stability matters
+        for (size_t i = 1; i < count; i += 3)
+        {
+            entries[i].key = entries[i - 1].key;
+        }
+
+        auto expected = entries;
+        comparison_sort(expected);
+
+        std::vector<sort_entry> scratch(count);
+        radix_sort(entries.data(), scratch.data(), count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            REQUIRE(entries[i].key == expected[i].key);
+            REQUIRE(entries[i].index == expected[i].index);
+        }
+    }
+}
+
+TEST_CASE("radix_sort accepts empty and single entry ranges", "[command_list]")
+{
+    radix_sort(nullptr, nullptr, 0);
+
+    sort_entry entry{42, 7};
+    sort_entry scratch{};
+    radix_sort(&entry, &scratch, 1);
+
+    REQUIRE(entry.key == 42);
+    REQUIRE(entry.index == 7);
+}
+
+TEST_CASE("command_list sorts its command buffers by key", "[command_list]")
+{
+    for (const size_t count : {command_list::radix_sort_threshold / 2, command_list::radix_sort_threshold * 2})
+    {
+        const auto entries = make_scene_entries(count);
+
+        command_list list;
+
+        for (const auto& entry : entries)
+        {
+            list.make_command_buffer(entry.key);
+        }
+
+        list.sort();
+
+        REQUIRE(list.is_sorted());
+        REQUIRE(std::is_sorted(list.begin(), list.end(), [](const command_buffer& left, const command_buffer& right) {
+            return left.get_key() < right.get_key();
+        }));
+    }
+}
+
+TEST_CASE("Sorting sort entries", "[command_list][!benchmark]")
+{
+    for (const size_t count : {64, 256, 512, 1024, 2048, 4096, 16384})
+    {
+        const auto entries = make_scene_entries(count);
+        const auto name = std::to_string(count) + " entries";
+
+        BENCHMARK_ADVANCED("std::sort " + name)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::vector<sort_entry>> runs(meter.runs(), entries);
+            meter.measure([&runs](const int run) {
+                comparison_sort(runs[run]);
+                return runs[run].front().index;
+            });
+        };
+
+        BENCHMARK_ADVANCED("radix_sort " + name)(Catch::Benchmark::Chronometer meter)
+        {
+            std::vector<std::vector<sort_entry>> runs(meter.runs(), entries);
+            std::vector<sort_entry> scratch(count);
+            meter.measure([&runs, &scratch, count](const int run) {
+                radix_sort(runs[run].data(), scratch.data(), count);
+                return runs[run].front().index;
+            });
+        };
+    }
+}
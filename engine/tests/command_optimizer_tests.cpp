@@ -0,0 +1,161 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/command/command_optimizer.hpp>
+#include <null_device.hpp>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    /**
+     * \brief Get the types of the commands left in a command_buffer, in order.
+     */
+    std::vector<command_type> command_types(command_buffer& buffer)
+    {
+        std::vector<command_type> types;
+
+        for (auto& header : buffer)
+        {
+            types.emplace_back(header.type);
+        }
+
+        return types;
+    }
+
+    material_handle make_material(graphics_device& device)
+    {
+        return device.build_material()
+            .add_vertex_shader(std::string{"void main() {}"})
+            .add_fragment_shader(std::string{"void main() {}"})
+            .add_material_parameter("color", glm::vec4{1.0f})
+            .add_material_parameter("roughness", 0.5f)
+            .build();
+    }
+} // namespace
+
+TEST_CASE("command_optimizer drops viewports and scissors that repeat the current state", "[command_optimizer]")
+{
+    null_device null;
+    command_optimizer optimizer{null.device.get_material_cache()};
+
+    auto list = null.device.make_command_list();
+    auto& buffer = list.make_command_buffer(0);
+
+    buffer.viewport().set_rectangle(0, 0, 1280, 720);
+    buffer.scissor().set_rectangle(0, 0, 640, 360);
+    buffer.viewport().set_rectangle(0, 0, 1280, 720); // duplicate
+    buffer.scissor().set_rectangle(0, 0, 640, 360);   // duplicate
+    buffer.viewport().set_rectangle(0, 0, 640, 360);  // changed
+    buffer.scissor().set_rectangle(10, 0, 640, 360);  // changed
+
+    const auto stats = optimizer.optimize(list);
+
+    REQUIRE(stats.commands_removed == 2);
+    REQUIRE(stats.parameters_removed == 0);
+    REQUIRE(
+        command_types(buffer) == std::vector<command_type>{
+                                     command_type::viewport,
+                                     command_type::scissor,
+                                     command_type::viewport,
+                                     command_type::scissor});
+
+    // the viewport that was kept is the changed one
+    auto header = buffer.begin();
+    ++header;
+    ++header;
+    REQUIRE(command_record<viewport_command>::from_header(*header).width == 640);
+}
+
+TEST_CASE("command_optimizer removes parameter writes that don't change the material", "[command_optimizer]")
+{
+    null_device null;
+    auto& device = null.device;
+    command_optimizer optimizer{device.get_material_cache()};
+
+    const auto material = make_material(device);
+    const auto color = device.find_parameter_index(material, "color");
+    const auto roughness = device.find_parameter_index(material, "roughness");
+
+    auto list = device.make_command_list();
+    auto& buffer = list.make_command_buffer(0);
+
+    // the color is what the material already holds, the roughness changes
+    buffer.set_material_parameters()
+        .set_material(material)
+        .set_parameter(color, glm::vec4{1.0f})
+        .set_parameter(roughness, 0.25f);
+
+    // writes the value the previous command left, so the whole command is empty once it's removed
+    buffer.set_material_parameters().set_material(material).set_parameter(roughness, 0.25f);
+
+    // a command that was recorded without any parameters
+    buffer.set_material_parameters().set_material(material);
+
+    const auto stats = optimizer.optimize(list);
+
+    REQUIRE(stats.parameters_removed == 2);
+    REQUIRE(stats.commands_removed == 2);
+    REQUIRE(command_types(buffer) == std::vector<command_type>{command_type::set_material_parameters});
+
+    auto& cmd = command_record<set_material_parameters_command>::from_header(*buffer.begin());
+    REQUIRE(cmd.count == 1);
+    REQUIRE(cmd.get_parameters()->index == roughness);
+    REQUIRE(std::get<float>(cmd.get_parameters()->get_data()) == 0.25f);
+}
+
+TEST_CASE("command_optimizer reports what it removed through the device", "[command_optimizer]")
+{
+    null_device null;
+    auto& device = null.device;
+    device.set_optimize_commands(true);
+
+    const auto material = make_material(device);
+
+    auto list = device.make_command_list();
+    auto& buffer = list.make_command_buffer(0);
+
+    buffer.viewport().set_rectangle(0, 0, 1280, 720);
+    buffer.viewport().set_rectangle(0, 0, 1280, 720);
+    buffer.set_material_parameters().set_material(material).set_parameter("roughness", 0.5f);
+
+    device.submit_and_swap(std::move(list));
+
+    const auto stats = device.get_optimizer_stats();
+
+    REQUIRE(stats.commands_removed == 2);
+    REQUIRE(stats.parameters_removed == 1);
+
+    // only the first viewport reached the backend
+    const auto calls = device.get_null_call_stats();
+    REQUIRE(count(calls, command_type::viewport) == 1);
+    REQUIRE(count(calls, command_type::set_material_parameters) == 0);
+}
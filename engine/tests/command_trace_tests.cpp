@@ -0,0 +1,123 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <array>
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <graphics/device/command_trace.hpp>
+#include <null_device.hpp>
+
+using namespace moka;
+
+namespace
+{
+    using vertices = std::array<float, 9>;
+
+    /**
+     * \brief Capture a frame that creates a vertex buffer for each array of vertices, and draws the first of them.
+     * \param path The path of the command trace.
+     * \param buffers The vertices of each buffer.
+     * \return The size of the command trace, in bytes.
+     */
+    uintmax_t capture(const std::filesystem::path& path, const std::vector<vertices>& buffers)
+    {
+        null_device null;
+        auto& device = null.device;
+
+        REQUIRE(device.start_capture(path));
+
+        std::vector<vertex_buffer_handle> handles;
+
+        for (const auto& buffer : buffers)
+        {
+            auto layout = vertex_layout::builder{}.add_attribute(0, 3, attribute_type::float32, false, 0, 0).build();
+            handles.emplace_back(
+                device.make_vertex_buffer(buffer.data(), sizeof(vertices), std::move(layout), buffer_usage::static_draw));
+        }
+
+        const auto material = device.build_material()
+                                  .add_vertex_shader(std::string{"void main() {}"})
+                                  .add_fragment_shader(std::string{"void main() {}"})
+                                  .build();
+
+        auto list = device.make_command_list();
+        list.draw().set_vertex_buffer(handles.front()).set_vertex_count(3).set_material(material);
+        device.submit_and_swap(std::move(list));
+
+        device.stop_capture();
+
+        return std::filesystem::file_size(path);
+    }
+} // namespace
+
+TEST_CASE("command_trace_writer writes host memory it has already written only once", "[command_trace]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "moka_command_trace_tests.mokatrace";
+
+    const vertices first{-1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+    const vertices second{-1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f};
+    const vertices third{0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+
+    // the repeated buffer refers to the blob written for the first, a buffer with new contents writes its own
+    const auto repeated = capture(path, {first, second, first});
+    const auto distinct = capture(path, {first, second, third});
+
+    // a blob chunk holds its type, its size and its id ahead of its bytes
+    REQUIRE(distinct - repeated == sizeof(uint8_t) + sizeof(uint64_t) + sizeof(uint32_t) + sizeof(vertices));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("command_trace replays a frame inside a gpu timer scope", "[command_trace]")
+{
+    const auto path = std::filesystem::temp_directory_path() / "moka_command_trace_tests.mokatrace";
+
+    const vertices triangle{-1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+    capture(path, {triangle});
+
+    null_device null;
+    auto& device = null.device;
+
+    command_trace trace{path};
+
+    REQUIRE(trace.is_valid());
+    REQUIRE(trace.get_frame_count() == 1);
+
+    trace.load_frame(device, 0);
+    trace.play_frame(device, "replay");
+
+    // the scope is closed before the swap that ends the frame
+    const auto stats = device.get_null_call_stats();
+
+    REQUIRE(count(stats, command_type::draw) == 1);
+    REQUIRE(count(stats, command_type::gpu_timer) == 2);
+    REQUIRE(stats.invalid_commands == 0);
+
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,177 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/pbr_scene.hpp>
+#include <null_device.hpp>
+
+using namespace moka;
+
+namespace
+{
+    /**
+     * \brief Two triangles packed into one vertex buffer and one index buffer, drawn from a base vertex each.
+     */
+    struct triangles final
+    {
+        vertex_buffer_handle vertices;
+        index_buffer_handle indices;
+
+        explicit triangles(graphics_device& device)
+        {
+            const float positions[] = {
+                -1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f, -1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, -1.0f, 0.0f};
+            const uint16_t elements[] = {0, 1, 2, 0, 1, 2};
+
+            auto layout = vertex_layout::builder{}.add_attribute(0, 3, attribute_type::float32, false, 0, 0).build();
+
+            vertices = device.make_vertex_buffer(positions, sizeof positions, std::move(layout), buffer_usage::static_draw);
+            indices = device.make_index_buffer(elements, sizeof elements, index_type::uint16, buffer_usage::static_draw);
+        }
+
+        draw_command& draw(command_list& list, const material_handle material, const int32_t triangle) const
+        {
+            return list.draw()
+                .set_vertex_buffer(vertices)
+                .set_index_buffer(indices)
+                .set_index_type(index_type::uint16)
+                .set_index_count(3)
+                .set_index_buffer_offset(static_cast<uint32_t>(triangle * 3 * sizeof(uint16_t)))
+                .set_base_vertex(triangle * 3)
+                .set_material(material);
+        }
+    };
+
+    material_handle make_material(graphics_device& device, const glm::vec4& color)
+    {
+        return device.build_material()
+            .add_vertex_shader(std::string{"void main() {}"})
+            .add_fragment_shader(std::string{"void main() {}"})
+            .add_material_parameter("color", color)
+            .build();
+    }
+} // namespace
+
+TEST_CASE("Draws that read one vertex array with the same material state share a draw call", "[draw_batch]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangles shape(device);
+
+    // the first two materials are separate, but bind the same state
+    const auto first = make_material(device, glm::vec4{1.0f});
+    const auto second = make_material(device, glm::vec4{1.0f});
+    const auto third = make_material(device, glm::vec4{0.5f});
+
+    auto list = device.make_command_list();
+    shape.draw(list, first, 0);
+    shape.draw(list, second, 1);
+    shape.draw(list, third, 0);
+    device.submit_and_swap(std::move(list));
+
+    const auto stats = device.get_draw_stats();
+
+    REQUIRE(device.get_null_call_stats().invalid_commands == 0);
+    REQUIRE(stats.draws == 3);
+    REQUIRE(stats.draw_calls == 2);
+}
+
+TEST_CASE("A parameter write only ends a run of draws if it changes the run's material", "[draw_batch]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangles shape(device);
+    const auto material = make_material(device, glm::vec4{1.0f});
+
+    // the run was bound with the value written, so the write doesn't end it
+    auto list = device.make_command_list();
+    shape.draw(list, material, 0);
+    list.set_material_parameters().set_material(material).set_parameter("color", glm::vec4{1.0f});
+    shape.draw(list, material, 1);
+    device.submit_and_swap(std::move(list));
+
+    REQUIRE(device.get_draw_stats().draw_calls == 1);
+
+    // the draws before a new value keep the value they were recorded with, the ones after it need a new call
+    list = device.make_command_list();
+    shape.draw(list, material, 0);
+    list.set_material_parameters().set_material(material).set_parameter("color", glm::vec4{0.5f});
+    shape.draw(list, material, 1);
+    shape.draw(list, material, 0);
+    device.submit_and_swap(std::move(list));
+
+    REQUIRE(device.get_draw_stats().draws == 3);
+    REQUIRE(device.get_draw_stats().draw_calls == 2);
+}
+
+TEST_CASE("Commands other than draws and parameter writes end a run of draws", "[draw_batch]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangles shape(device);
+    const auto material = make_material(device, glm::vec4{1.0f});
+
+    auto list = device.make_command_list();
+    shape.draw(list, material, 0);
+    list.viewport().set_rectangle({0, 0, 640, 360});
+    shape.draw(list, material, 1);
+    device.submit_and_swap(std::move(list));
+
+    REQUIRE(device.get_draw_stats().draw_calls == 2);
+}
+
+TEST_CASE("pbr_scene draws the primitives of a sample model that share a material in one call", "[draw_batch]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    // the lantern's three meshes share one glTF material, and their primitives share a vertex layout
+    pbr_scene scene(device, MOKA_ASSET_PATH, "Models/Lantern/Lantern.gltf");
+    scene.draw_environment = false;
+
+    const basic_camera camera({}, glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+    // the first frame records the static bundle, the second replays it
+    for (auto frame = 0; frame < 2; ++frame)
+    {
+        scene.draw(camera, {0, 0, 1280, 720});
+        device.submit_and_swap(device.make_command_list());
+    }
+
+    const auto stats = device.get_draw_stats();
+
+    REQUIRE(device.get_null_call_stats().invalid_commands == 0);
+    REQUIRE(stats.draws == 3);
+    REQUIRE(stats.draw_calls == 1);
+
+    WARN("Lantern.gltf: " << stats.draws << " draws in " << stats.draw_calls << " draw call");
+}
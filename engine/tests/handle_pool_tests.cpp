@@ -0,0 +1,104 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/api/handle_pool.hpp>
+#include <graphics/buffer/vertex_buffer_handle.hpp>
+#include <limits>
+
+using namespace moka;
+
+namespace
+{
+    using pool = handle_pool<vertex_buffer_handle, int>;
+} // namespace
+
+TEST_CASE("handle_pool finds the objects it holds", "[handle_pool]")
+{
+    pool objects;
+
+    const auto first = objects.allocate(1);
+    const auto second = objects.allocate(2);
+
+    REQUIRE(objects.size() == 2);
+    REQUIRE(*objects.get(first) == 1);
+    REQUIRE(*objects.get(second) == 2);
+
+    // no live handle is the invalid handle or has an id of 0
+    REQUIRE(first.id != 0);
+    REQUIRE(objects.get(vertex_buffer_handle{}) == nullptr);
+}
+
+TEST_CASE("handle_pool rejects stale handles", "[handle_pool]")
+{
+    pool objects;
+
+    const auto stale = objects.allocate(1);
+
+    REQUIRE(objects.release(stale));
+    REQUIRE(objects.get(stale) == nullptr);
+    REQUIRE_FALSE(objects.release(stale));
+    REQUIRE(objects.size() == 0);
+
+    // the slot is reused, but the stale handle doesn't alias the new object
+    const auto reused = objects.allocate(2);
+
+    REQUIRE(pool::index(reused) == pool::index(stale));
+    REQUIRE(reused != stale);
+    REQUIRE(objects.get(stale) == nullptr);
+    REQUIRE_FALSE(objects.release(stale));
+    REQUIRE(*objects.get(reused) == 2);
+}
+
+TEST_CASE("handle_pool wraps the generation of a slot", "[handle_pool]")
+{
+    pool objects;
+
+    const auto first = objects.allocate(0);
+    auto handle = first;
+
+    for (uint32_t generation = 1; generation < pool::max_generation; ++generation)
+    {
+        REQUIRE(objects.release(handle));
+        handle = objects.allocate(0);
+    }
+
+    // the last generation before the wrap never makes the invalid handle
+    REQUIRE(handle.id >> pool::index_bits == pool::max_generation);
+    REQUIRE(handle.id != std::numeric_limits<uint32_t>::max());
+
+    REQUIRE(objects.release(handle));
+    const auto wrapped = objects.allocate(0);
+
+    // generation 0 is skipped, so the slot is back where it started
+    REQUIRE(wrapped.id >> pool::index_bits == 1);
+    REQUIRE(wrapped == first);
+    REQUIRE(objects.get(handle) == nullptr);
+    REQUIRE(objects.get(wrapped) != nullptr);
+}
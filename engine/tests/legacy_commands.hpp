@@ -0,0 +1,142 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <graphics/command/command_list.hpp>
+#include <memory>
+#include <vector>
+
+namespace moka
+{
+    /**
+     * \brief The per-draw parameters as set_material_parameters_command stored them before they were inlined into the
+     * command stream: a vector of named parameters that the backend looks up by name.
+     */
+    struct legacy_parameters final
+    {
+        material_handle material{};
+        std::vector<material_parameter> parameters;
+    };
+
+    /**
+     * \brief Visits the commands of a legacy_buffer through virtual calls, as graphics_visitor used to.
+     */
+    struct legacy_visitor
+    {
+        virtual ~legacy_visitor() = default;
+        virtual void visit(legacy_parameters& parameters) = 0;
+        virtual void visit(draw_command& draw) = 0;
+    };
+
+    /**
+     * \brief The command storage that the command stream replaced: every command is a separate heap allocation owned by its buffer.
+     */
+    struct legacy_command
+    {
+        virtual ~legacy_command() = default;
+        virtual void accept(legacy_visitor& visitor) = 0;
+    };
+
+    template <typename T>
+    struct legacy_record final : legacy_command
+    {
+        T command;
+
+        void accept(legacy_visitor& visitor) override
+        {
+            visitor.visit(command);
+        }
+    };
+
+    struct legacy_buffer final
+    {
+        sort_key key = 0;
+        std::vector<std::unique_ptr<legacy_command>> commands;
+
+        template <typename T>
+        T& emplace_back()
+        {
+            auto record = std::make_unique<legacy_record<T>>();
+            auto& command = record->command;
+            commands.emplace_back(std::move(record));
+            return command;
+        }
+
+        void accept(legacy_visitor& visitor)
+        {
+            for (auto& command : commands)
+            {
+                command->accept(visitor);
+            }
+        }
+    };
+
+    /**
+     * \brief Record the commands pbr_scene records for a primitive: its per-draw parameters, followed by the draw.
+     * \param buffer The command_buffer to record into.
+     * \param i The number of the primitive, which picks its material and buffers.
+     */
+    inline void record_primitive(command_buffer& buffer, const size_t i)
+    {
+        const material_handle material{static_cast<uint16_t>(i % 64)};
+
+        buffer.set_material_parameters().set_material(material).set_parameter(0, glm::mat4{1.0f});
+
+        buffer.draw()
+            .set_material(material)
+            .set_vertex_buffer(vertex_buffer_handle{static_cast<uint32_t>(i % 256)})
+            .set_index_buffer(index_buffer_handle{static_cast<uint32_t>(i % 256)})
+            .set_index_type(index_type::uint16)
+            .set_index_count(36)
+            .set_primitive_type(primitive_type::triangles);
+    }
+
+    /**
+     * \brief Record the commands pbr_scene records for a primitive the way they were stored before the command stream.
+     * \param buffer The legacy_buffer to record into.
+     * \param i The number of the primitive, which picks its material and buffers.
+     */
+    inline void record_primitive(legacy_buffer& buffer, const size_t i)
+    {
+        const material_handle material{static_cast<uint16_t>(i % 64)};
+
+        auto& parameters = buffer.emplace_back<legacy_parameters>();
+        parameters.material = material;
+        parameters.parameters.emplace_back("model", glm::mat4{1.0f});
+
+        buffer.emplace_back<draw_command>()
+            .set_material(material)
+            .set_vertex_buffer(vertex_buffer_handle{static_cast<uint32_t>(i % 256)})
+            .set_index_buffer(index_buffer_handle{static_cast<uint32_t>(i % 256)})
+            .set_index_type(index_type::uint16)
+            .set_index_count(36)
+            .set_primitive_type(primitive_type::triangles);
+    }
+} // namespace moka
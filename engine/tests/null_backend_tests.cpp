@@ -0,0 +1,233 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/pbr_scene.hpp>
+#include <null_device.hpp>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    /**
+     * \brief A triangle and a material to draw it with.
+     */
+    struct triangle final
+    {
+        vertex_buffer_handle vertices;
+        index_buffer_handle indices;
+        material_handle material;
+
+        explicit triangle(graphics_device& device)
+        {
+            const float positions[] = {-1.0f, -1.0f, 0.0f, 1.0f, -1.0f, 0.0f, 0.0f, 1.0f, 0.0f};
+            const uint16_t elements[] = {0, 1, 2};
+
+            auto layout = vertex_layout::builder{}.add_attribute(0, 3, attribute_type::float32, false, 0, 0).build();
+
+            vertices = device.make_vertex_buffer(positions, sizeof positions, std::move(layout), buffer_usage::static_draw);
+            indices = device.make_index_buffer(elements, sizeof elements, index_type::uint16, buffer_usage::static_draw);
+            material = device.build_material()
+                           .add_vertex_shader(std::string{"void main() {}"})
+                           .add_fragment_shader(std::string{"void main() {}"})
+                           .add_material_parameter("color", glm::vec4{1.0f})
+                           .build();
+        }
+
+        draw_command& draw(command_list& list) const
+        {
+            return list.draw()
+                .set_vertex_buffer(vertices)
+                .set_index_buffer(indices)
+                .set_index_type(index_type::uint16)
+                .set_index_count(3)
+                .set_material(material);
+        }
+    };
+} // namespace
+
+TEST_CASE("The null backend draws without a window or a graphics context", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangle shape(device);
+
+    auto list = device.make_command_list();
+    list.set_material_parameters().set_material(shape.material).set_parameter("color", glm::vec4{0.5f});
+    shape.draw(list);
+    device.submit_and_swap(std::move(list));
+
+    const auto stats = device.get_null_call_stats();
+
+    REQUIRE(count(stats, command_type::draw) == 1);
+    REQUIRE(count(stats, command_type::set_material_parameters) == 1);
+    REQUIRE(stats.invalid_commands == 0);
+    REQUIRE(stats.submits == 1);
+
+    // parameters are still written to the material
+    const auto* material = device.get_material_cache().get_material(shape.material);
+    REQUIRE(std::get<glm::vec4>(material->find("color")->data) == glm::vec4{0.5f});
+}
+
+TEST_CASE("The null backend rejects stale handles", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangle shape(device);
+
+    device.destroy(shape.vertices);
+
+    // the slot is reused, but the new buffer's handle has another generation
+    const float positions[9] = {};
+    const auto reused = device.make_vertex_buffer(positions, sizeof positions, vertex_layout{}, buffer_usage::static_draw);
+    REQUIRE(reused != shape.vertices);
+
+    auto list = device.make_command_list();
+    shape.draw(list);
+    device.submit_and_swap(std::move(list));
+
+    const auto stats = device.get_null_call_stats();
+
+    REQUIRE(count(stats, command_type::draw) == 1);
+    REQUIRE(stats.invalid_commands == 1);
+}
+
+TEST_CASE("The null backend rejects draws that read past the end of their buffers", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangle shape(device);
+
+    auto list = device.make_command_list();
+
+    // six indices from a buffer of three
+    shape.draw(list).set_index_count(6);
+
+    // a base vertex past the last vertex
+    shape.draw(list).set_base_vertex(3);
+
+    // vertices 2 to 5 from a buffer of three
+    list.draw().set_vertex_buffer(shape.vertices).set_vertex_count(3).set_first_vertex(2).set_material(shape.material);
+
+    // the same ranges, inside the buffers
+    shape.draw(list).set_base_vertex(2).set_index_count(1);
+    list.draw().set_vertex_buffer(shape.vertices).set_vertex_count(2).set_first_vertex(1).set_material(shape.material);
+
+    device.submit_and_swap(std::move(list));
+
+    const auto stats = device.get_null_call_stats();
+
+    REQUIRE(count(stats, command_type::draw) == 5);
+    REQUIRE(stats.invalid_commands == 3);
+}
+
+TEST_CASE("The null backend records the commands it executes", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangle shape(device);
+
+    device.set_record_null_calls(true);
+
+    for (auto frame = 0; frame < 2; ++frame)
+    {
+        auto list = device.make_command_list();
+        list.clear().set_clear_color(true);
+        shape.draw(list);
+        device.submit_and_swap(std::move(list), false);
+    }
+
+    device.set_record_null_calls(false);
+
+    const auto calls = device.take_recorded_null_calls();
+
+    REQUIRE(calls.size() == 4);
+
+    for (size_t i = 0; i < calls.size(); ++i)
+    {
+        REQUIRE(calls[i].frame == i / 2);
+        REQUIRE(calls[i].type == (i % 2 == 0 ? command_type::clear : command_type::draw));
+        REQUIRE(calls[i].valid);
+    }
+
+    REQUIRE(device.take_recorded_null_calls().empty());
+}
+
+TEST_CASE("The null backend runs on a render thread", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    const triangle shape(device);
+
+    device.start_render_thread(2);
+
+    for (auto frame = 0; frame < 8; ++frame)
+    {
+        auto list = device.make_command_list();
+        shape.draw(list);
+        device.submit_and_swap(std::move(list));
+    }
+
+    device.wait_idle();
+
+    const auto stats = device.get_null_call_stats();
+
+    REQUIRE(count(stats, command_type::draw) == 1);
+    REQUIRE(stats.invalid_commands == 0);
+
+    device.stop_render_thread();
+}
+
+TEST_CASE("pbr_scene draws the sample model through the null backend", "[null_backend]")
+{
+    null_device null;
+    auto& device = null.device;
+
+    pbr_scene scene(device, MOKA_ASSET_PATH);
+
+    const basic_camera camera({}, glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+    // the first frame records the static bundle, the second replays it
+    for (auto frame = 0; frame < 2; ++frame)
+    {
+        scene.draw(camera, {0, 0, 1280, 720});
+        device.submit_and_swap(device.make_command_list());
+
+        const auto stats = device.get_null_call_stats();
+
+        REQUIRE(count(stats, command_type::draw) > 0);
+        REQUIRE(stats.invalid_commands == 0);
+    }
+}
@@ -0,0 +1,67 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#pragma once
+
+#include <application/window.hpp>
+#include <graphics/device/graphics_device.hpp>
+
+namespace moka
+{
+    /**
+     * \brief A window without a graphics context, and a device on the null backend that renders to it.
+     */
+    struct null_device final
+    {
+        window window_;
+        graphics_device device;
+
+        null_device() : window_(make_settings()), device(window_, graphics_backend::null)
+        {
+        }
+
+        static window_settings make_settings()
+        {
+            window_settings settings;
+            settings.null_context = true;
+            return settings;
+        }
+    };
+
+    /**
+     * \brief Get the number of commands of a type that the null backend executed.
+     * \param stats The call stats of a frame.
+     * \param type The type of command.
+     * \return The number of commands of that type.
+     */
+    inline size_t count(const null_call_stats& stats, const command_type type)
+    {
+        return stats.commands[static_cast<size_t>(type)];
+    }
+} // namespace moka
@@ -0,0 +1,399 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <graphics/instance_data.hpp>
+#include <graphics/pbr.hpp>
+#include <graphics/pbr_scene.hpp>
+#include <map>
+#include <null_device.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    /**
+     * \brief The draws, draw calls and state changes of one frame of a model.
+     */
+    struct frame_stats final
+    {
+        size_t draws = 0;
+        size_t draw_calls = 0;
+        state_change_stats state_changes;
+    };
+
+    const basic_camera camera({}, glm::perspective(glm::radians(70.0f), 16.0f / 9.0f, 0.1f, 100.0f));
+
+    /**
+     * \brief Draw a model with pbr_scene, which orders its draws with sort_key_builder keys.
+     * \param model The glTF asset, relative to the asset folder.
+     * \return The stats of the second frame, which replays the static bundle recorded by the first.
+     */
+    frame_stats draw_sorted(const std::filesystem::path& model)
+    {
+        null_device null;
+        auto& device = null.device;
+
+        pbr_scene scene(device, MOKA_ASSET_PATH, model);
+        scene.draw_environment = false;
+
+        for (auto frame = 0; frame < 2; ++frame)
+        {
+            scene.draw(camera, {0, 0, 1280, 720});
+            device.submit_and_swap(device.make_command_list());
+        }
+
+        return {device.get_draw_stats().draws, device.get_draw_stats().draw_calls, device.get_state_change_stats()};
+    }
+
+    /**
+     * \brief Draw every primitive of a model in the order the importer created them, without sorting.
+     * Primitives are drawn as pbr_scene draws them, one instance each, so only the order of the draws differs.
+     * \param model The glTF asset, relative to the asset folder.
+     * \return The stats of the second frame, so that both frames start from the state the previous one left bound.
+     */
+    frame_stats draw_unsorted(const std::filesystem::path& model)
+    {
+        null_device null;
+        auto& device = null.device;
+
+        const pbr_util util(device, MOKA_ASSET_PATH);
+        auto imported = util.load_model(model, "Materials/pbr_instanced.material");
+
+        std::vector<instance_data> instances;
+
+        for (auto& mesh : imported.get_meshes())
+        {
+            instances.insert(instances.end(), std::distance(mesh.begin(), mesh.end()), {mesh.get_transform().to_matrix()});
+        }
+
+        const auto instance_buffer = device.make_vertex_buffer(
+            instances.data(), instances.size() * sizeof(instance_data), instance_data::layout(), buffer_usage::static_draw);
+
+        for (auto frame = 0; frame < 2; ++frame)
+        {
+            auto list = device.make_command_list();
+
+            uint32_t instance = 0;
+
+            for (auto& mesh : imported.get_meshes())
+            {
+                for (auto& primitive : mesh)
+                {
+                    primitive.draw_instances(list.make_command_buffer(), instance_buffer, 1, instance++);
+                }
+            }
+
+            device.submit_and_swap(std::move(list), false);
+        }
+
+        return {device.get_draw_stats().draws, device.get_draw_stats().draw_calls, device.get_state_change_stats()};
+    }
+
+    /**
+     * \brief Draw the primitives of several models in one frame, taking turns between the models.
+     * Each draw gets the key pbr_scene would give it, so sorting the frame orders it as pbr_scene orders a scene.
+     * \param models The glTF assets, relative to the asset folder.
+     * \param sort Sort the frame by the keys, rather than submit the draws in the order they were recorded.
+     * \return The stats of the second frame, so that both frames start from the state the previous one left bound.
+     */
+    frame_stats draw_interleaved(const std::vector<std::filesystem::path>& models, const bool sort)
+    {
+        null_device null;
+        auto& device = null.device;
+
+        const pbr_util util(device, MOKA_ASSET_PATH);
+
+        std::vector<model> imported;
+
+        for (const auto& path : models)
+        {
+            imported.emplace_back(util.load_model(path, "Materials/pbr_instanced.material"));
+        }
+
+        struct draw final
+        {
+            primitive* target = nullptr;
+            uint32_t instance = 0;
+            uint64_t sort_key = 0;
+        };
+
+        std::vector<std::vector<draw>> draws(imported.size());
+        std::vector<instance_data> instances;
+        std::map<std::vector<uint32_t>, uint16_t> texture_sets;
+
+        for (size_t i = 0; i < imported.size(); ++i)
+        {
+            for (auto& mesh : imported[i].get_meshes())
+            {
+                for (auto& primitive : mesh)
+                {
+                    const auto instance = static_cast<uint32_t>(instances.size());
+
+                    instances.push_back({mesh.get_transform().to_matrix()});
+
+                    const auto* mat = device.get_material_cache().get_material(primitive.get_material());
+
+                    if (!mat)
+                    {
+                        continue;
+                    }
+
+                    std::vector<uint32_t> textures;
+
+                    for (const auto& parameter : *mat)
+                    {
+                        if (const auto* texture = std::get_if<texture_handle>(&parameter.data))
+                        {
+                            textures.emplace_back(texture->id);
+                        }
+                    }
+
+                    const auto texture_set =
+                        texture_sets.try_emplace(std::move(textures), static_cast<uint16_t>(texture_sets.size())).first->second;
+
+                    // there's no camera to take a depth from, translucent draws still go last
+                    const auto sort_key = sort_key_builder{}
+                                              .set_view_layer(1)
+                                              .set_translucency(mat->get_alpha_mode())
+                                              .set_pipeline_state(mat->get_pipeline_state().id)
+                                              .set_program(mat->get_program().id)
+                                              .set_texture_set(texture_set)
+                                              .build();
+
+                    draws[i].push_back({&primitive, instance, sort_key});
+                }
+            }
+        }
+
+        const auto instance_buffer = device.make_vertex_buffer(
+            instances.data(), instances.size() * sizeof(instance_data), instance_data::layout(), buffer_usage::static_draw);
+
+        for (auto frame = 0; frame < 2; ++frame)
+        {
+            auto list = device.make_command_list();
+
+            for (size_t turn = 0, recorded = 1; recorded != 0; ++turn)
+            {
+                recorded = 0;
+
+                for (const auto& model_draws : draws)
+                {
+                    if (turn < model_draws.size())
+                    {
+                        const auto& next = model_draws[turn];
+                        next.target->draw_instances(list.make_command_buffer(next.sort_key), instance_buffer, 1, next.instance);
+                        ++recorded;
+                    }
+                }
+            }
+
+            device.submit_and_swap(std::move(list), sort);
+        }
+
+        return {device.get_draw_stats().draws, device.get_draw_stats().draw_calls, device.get_state_change_stats()};
+    }
+} // namespace
+
+TEST_CASE("sort_key_builder orders by view layer, then translucency, then state", "[sort_key]")
+{
+    const auto make_key = [](const uint8_t layer, const translucency translucency, const uint64_t state) {
+        return sort_key_builder{}
+            .set_view_layer(layer)
+            .set_translucency(translucency)
+            .set_pipeline_state(state)
+            .set_program(state)
+            .set_texture_set(state)
+            .set_depth(1000.0f)
+            .build();
+    };
+
+    // a lower view layer wins over everything below it
+    REQUIRE(make_key(0, translucency::translucent, 4095) < make_key(1, translucency::opaque, 0));
+
+    // within a layer, opaque geometry is drawn first and translucent geometry last, whatever its state
+    REQUIRE(make_key(1, translucency::opaque, 4095) < make_key(1, translucency::masked, 0));
+    REQUIRE(make_key(1, translucency::masked, 4095) < make_key(1, translucency::background, 0));
+    REQUIRE(make_key(1, translucency::background, 4095) < make_key(1, translucency::translucent, 0));
+
+    // alpha modes map to translucency classes
+    REQUIRE(
+        sort_key_builder{}.set_translucency(alpha_mode::mask).build() ==
+        sort_key_builder{}.set_translucency(translucency::masked).build());
+    REQUIRE(
+        sort_key_builder{}.set_translucency(alpha_mode::blend).build() ==
+        sort_key_builder{}.set_translucency(translucency::translucent).build());
+}
+
+TEST_CASE("Opaque keys order by state first and front to back last", "[sort_key]")
+{
+    const auto make_key = [](const uint64_t pipeline_state, const uint64_t program, const uint64_t texture_set, const float depth) {
+        return sort_key_builder{}
+            .set_pipeline_state(pipeline_state)
+            .set_program(program)
+            .set_texture_set(texture_set)
+            .set_depth(depth)
+            .build();
+    };
+
+    REQUIRE(make_key(0, 9, 9, 1000.0f) < make_key(1, 0, 0, 0.0f));
+    REQUIRE(make_key(0, 0, 9, 1000.0f) < make_key(0, 1, 0, 0.0f));
+    REQUIRE(make_key(0, 0, 0, 1000.0f) < make_key(0, 0, 1, 0.0f));
+
+    // with equal state, nearer geometry is drawn first
+    REQUIRE(make_key(0, 0, 0, 1.0f) < make_key(0, 0, 0, 2.0f));
+    REQUIRE(make_key(0, 0, 0, 0.0f) < make_key(0, 0, 0, 0.001f));
+}
+
+TEST_CASE("Translucent keys order back to front first", "[sort_key]")
+{
+    const auto make_key = [](const uint64_t state, const float depth) {
+        return sort_key_builder{}
+            .set_translucency(translucency::translucent)
+            .set_pipeline_state(state)
+            .set_program(state)
+            .set_texture_set(state)
+            .set_depth(depth)
+            .build();
+    };
+
+    // distant geometry is drawn first, whatever its state
+    REQUIRE(make_key(4095, 100.0f) < make_key(0, 10.0f));
+    REQUIRE(make_key(0, 2.0f) < make_key(0, 1.0f));
+
+    // state only breaks ties between equal depths
+    REQUIRE(make_key(0, 5.0f) < make_key(1, 5.0f));
+
+    // the inverted depth fills the depth field
+    const auto depth = sort_key_layout::translucent::depth.decode(make_key(0, 0.0f));
+    REQUIRE(depth == sort_key_layout::translucent::depth.max());
+}
+
+TEST_CASE("Ids wider than their fields are truncated without touching other fields", "[sort_key]")
+{
+    using layout = sort_key_layout::opaque;
+
+    const auto key = sort_key_builder{}
+                         .set_view_layer(1)
+                         .set_pipeline_state(4096 + 3)
+                         .set_program(0xffff)
+                         .set_texture_set(4096 * 3 + 5)
+                         .build();
+
+    REQUIRE(sort_key_layout::view_layer.decode(key) == 1);
+    REQUIRE(sort_key_layout::translucency.decode(key) == static_cast<uint64_t>(translucency::opaque));
+    REQUIRE(layout::pipeline_state.decode(key) == 3);
+    REQUIRE(layout::program.decode(key) == 4095);
+    REQUIRE(layout::texture_set.decode(key) == 5);
+    REQUIRE(layout::depth.decode(key) == 0);
+
+    // only the low 12 bits take part in the order
+    REQUIRE(key == sort_key_builder{}.set_view_layer(1).set_pipeline_state(3).set_program(4095).set_texture_set(5).build());
+
+    // so does the view layer, which has 4 bits
+    REQUIRE(sort_key_layout::view_layer.decode(sort_key_builder{}.set_view_layer(17).build()) == 1);
+}
+
+TEST_CASE("sort_key_builder keys reduce state changes on the sample models", "[sort_key]")
+{
+    const std::filesystem::path models{"Models"};
+    std::vector<std::filesystem::path> measured;
+    size_t reduced = 0;
+
+    for (const auto& entry : std::filesystem::directory_iterator{std::filesystem::path{MOKA_ASSET_PATH} / models})
+    {
+        const auto model = models / entry.path().filename() / (entry.path().filename().string() + ".gltf");
+
+        if (!std::filesystem::exists(std::filesystem::path{MOKA_ASSET_PATH} / model))
+        {
+            continue;
+        }
+
+        frame_stats sorted;
+        frame_stats unsorted;
+
+        // the importer throws on assets it can't make sense of...
+        try
+        {
+            sorted = draw_sorted(model);
+            unsorted = draw_unsorted(model);
+        }
+        catch (const std::runtime_error& error)
+        {
+            WARN(model.string() << " skipped: " << error.what());
+            continue;
+        }
+
+        // nor draw a model whose buffers are missing, which it imports without any meshes
+        if (unsorted.draws == 0)
+        {
+            WARN(model.string() << " skipped: no primitives were imported");
+            continue;
+        }
+
+        measured.emplace_back(model);
+
+        CAPTURE(model.string(), sorted.draws, sorted.state_changes.calls_issued, unsorted.state_changes.calls_issued);
+
+        // a material is bound once for each run of draws, so sorting reduces the binds as well as what they change
+        REQUIRE(sorted.draws == unsorted.draws);
+        REQUIRE(sorted.state_changes.calls_issued <= unsorted.state_changes.calls_issued);
+
+        if (sorted.state_changes.calls_issued < unsorted.state_changes.calls_issued)
+        {
+            ++reduced;
+        }
+
+        WARN(model.filename().string() << ": " << sorted.draws << " draws in " << sorted.draw_calls << " calls, "
+                                       << sorted.state_changes.calls_issued << " state changes sorted, "
+                                       << unsorted.draw_calls << " calls and " << unsorted.state_changes.calls_issued
+                                       << " state changes unsorted");
+    }
+
+    // a single model is imported mostly in material order already, drawing them together interleaves their state.
+    // without at least two of them there's nothing to show, which fails rather than passes vacuously
+    REQUIRE(measured.size() > 1);
+
+    const auto sorted = draw_interleaved(measured, true);
+    const auto unsorted = draw_interleaved(measured, false);
+
+    CAPTURE(sorted.draws, sorted.state_changes.calls_issued, unsorted.state_changes.calls_issued);
+
+    REQUIRE(sorted.draws == unsorted.draws);
+    REQUIRE(sorted.state_changes.calls_issued < unsorted.state_changes.calls_issued);
+
+    WARN(reduced << " of " << measured.size() << " models reduced on their own, interleaved: " << sorted.draws << " draws in " << sorted.draw_calls << " calls, "
+                         << sorted.state_changes.calls_issued << " state changes sorted, " << unsorted.draw_calls
+                         << " calls and " << unsorted.state_changes.calls_issued << " state changes unsorted");
+
+}
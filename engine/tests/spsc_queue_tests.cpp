@@ -0,0 +1,132 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <catch2/catch.hpp>
+#include <graphics/device/spsc_queue.hpp>
+#include <memory>
+#include <thread>
+
+using namespace moka;
+
+TEST_CASE("spsc_queue rounds its capacity up to a power of two", "[spsc_queue]")
+{
+    REQUIRE(spsc_queue<int>{1}.capacity() == 1);
+    REQUIRE(spsc_queue<int>{5}.capacity() == 8);
+    REQUIRE(spsc_queue<int>{64}.capacity() == 64);
+}
+
+TEST_CASE("spsc_queue pops values in the order they were pushed", "[spsc_queue]")
+{
+    spsc_queue<int> queue{4};
+
+    REQUIRE(queue.empty());
+
+    int value = 0;
+    REQUIRE_FALSE(queue.try_pop(value));
+
+    // wrap the indices around the slots a few times
+    for (auto round = 0; round < 3; ++round)
+    {
+        for (auto i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.try_push(round * 4 + i));
+        }
+
+        REQUIRE(queue.full());
+        REQUIRE_FALSE(queue.try_push(-1));
+
+        for (auto i = 0; i < 4; ++i)
+        {
+            REQUIRE(queue.try_pop(value));
+            REQUIRE(value == round * 4 + i);
+        }
+
+        REQUIRE(queue.empty());
+    }
+}
+
+TEST_CASE("spsc_queue only moves from values it accepts", "[spsc_queue]")
+{
+    spsc_queue<std::unique_ptr<int>> queue{1};
+
+    REQUIRE(queue.try_push(std::make_unique<int>(1)));
+
+    auto rejected = std::make_unique<int>(2);
+    REQUIRE_FALSE(queue.try_push(std::move(rejected)));
+    REQUIRE(rejected);
+
+    std::unique_ptr<int> value;
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(*value == 1);
+}
+
+TEST_CASE("spsc_queue hands values from one thread to another", "[spsc_queue]")
+{
+    constexpr size_t count = 1 << 20;
+
+    spsc_queue<size_t> queue{64};
+
+    std::thread producer([&queue] {
+        for (size_t i = 0; i < count;)
+        {
+            if (queue.try_push(size_t{i}))
+            {
+                ++i;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    // every value arrives exactly once and in order
+    size_t expected = 0;
+    size_t out_of_order = 0;
+
+    while (expected < count)
+    {
+        size_t value;
+
+        if (queue.try_pop(value))
+        {
+            out_of_order += value != expected;
+            ++expected;
+        }
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+
+    REQUIRE(out_of_order == 0);
+    REQUIRE(queue.empty());
+}
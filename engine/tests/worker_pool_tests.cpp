@@ -0,0 +1,183 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <future>
+#include <graphics/command/command_list.hpp>
+#include <graphics/device/worker_pool.hpp>
+#include <legacy_commands.hpp>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace moka;
+
+namespace
+{
+    constexpr size_t recording_threads = 4;
+
+    // about as many blended primitives as a detailed scene has, so each frame's share of work is small
+    constexpr size_t translucent_primitives = 512;
+
+    /**
+     * \brief Record an even share of the translucent primitives into one of a frame's command lists.
+     */
+    void record_share(command_list& list, const size_t i, const size_t count)
+    {
+        const auto per_list = translucent_primitives / count;
+
+        for (auto primitive = i * per_list; primitive < (i + 1) * per_list; ++primitive)
+        {
+            record_primitive(list.make_command_buffer(primitive), primitive);
+        }
+
+        list.sort();
+    }
+} // namespace
+
+TEST_CASE("worker_pool runs every job once", "[worker_pool]")
+{
+    worker_pool workers{3};
+
+    REQUIRE(workers.size() == 3);
+
+    std::vector<std::atomic<size_t>> calls(64);
+
+    // the same threads are reused for every run
+    for (auto run = 0; run < 100; ++run)
+    {
+        workers.run(calls.size(), [&calls](const size_t i) { calls[i].fetch_add(1, std::memory_order_relaxed); });
+    }
+
+    for (auto& count : calls)
+    {
+        REQUIRE(count.load() == 100);
+    }
+}
+
+TEST_CASE("worker_pool without worker threads runs jobs on the calling thread", "[worker_pool]")
+{
+    worker_pool workers{0};
+
+    const auto caller = std::this_thread::get_id();
+    size_t calls = 0;
+
+    workers.run(8, [&calls, caller](size_t) {
+        REQUIRE(std::this_thread::get_id() == caller);
+        ++calls;
+    });
+
+    REQUIRE(calls == 8);
+}
+
+TEST_CASE("worker_pool rethrows the exception of a job", "[worker_pool]")
+{
+    worker_pool workers{2};
+
+    std::atomic<size_t> calls{0};
+
+    REQUIRE_THROWS_AS(
+        workers.run(
+            16,
+            [&calls](const size_t i) {
+                calls.fetch_add(1, std::memory_order_relaxed);
+
+                if (i == 5)
+                {
+                    throw std::runtime_error("job failed");
+                }
+            }),
+        std::runtime_error);
+
+    // the other jobs still ran, and the pool can be used again
+    REQUIRE(calls.load() == 16);
+
+    calls = 0;
+    workers.run(16, [&calls](size_t) { calls.fetch_add(1, std::memory_order_relaxed); });
+    REQUIRE(calls.load() == 16);
+}
+
+TEST_CASE("Translucent recording", "[worker_pool][!benchmark]")
+{
+    std::vector<command_allocator> allocators(recording_threads);
+
+    const auto make_lists = [&allocators](const size_t count) {
+        std::vector<command_list> lists;
+        lists.reserve(count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            allocators[i].reset();
+            lists.emplace_back(allocators[i]);
+        }
+
+        return lists;
+    };
+
+    BENCHMARK("Record 512 translucent primitives on one thread")
+    {
+        auto lists = make_lists(1);
+        record_share(lists.front(), 0, 1);
+        return command_list::merge(std::move(lists)).is_empty();
+    };
+
+    BENCHMARK("Record 512 translucent primitives on 4 threads started every frame")
+    {
+        auto lists = make_lists(recording_threads);
+
+        std::vector<std::future<void>> recordings;
+
+        for (size_t i = 1; i < recording_threads; ++i)
+        {
+            recordings.emplace_back(
+                std::async(std::launch::async, [&lists, i] { record_share(lists[i], i, recording_threads); }));
+        }
+
+        record_share(lists.front(), 0, recording_threads);
+
+        for (auto& recording : recordings)
+        {
+            recording.get();
+        }
+
+        return command_list::merge(std::move(lists)).is_empty();
+    };
+
+    worker_pool workers{recording_threads - 1};
+
+    BENCHMARK("Record 512 translucent primitives on 4 threads of a worker_pool")
+    {
+        auto lists = make_lists(recording_threads);
+
+        workers.run(recording_threads, [&lists](const size_t i) { record_share(lists[i], i, recording_threads); });
+
+        return command_list::merge(std::move(lists)).is_empty();
+    };
+}
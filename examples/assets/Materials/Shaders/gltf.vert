@@ -40,12 +40,28 @@ out vec2 in_texture_coord;
     out mat3 tbn_matrix;
 #endif
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#ifdef INSTANCED
+    layout (location = 4) in mat4 instance_model;
+    layout (location = 8) in float instance_material;
+
+    flat out uint in_material_index;
+#else
+    uniform mat4 model;
+#endif
+
+layout (std140) uniform view_block {
+    mat4 view;
+    mat4 projection;
+    vec3 view_pos;
+};
 
 void main()
 {
+    #ifdef INSTANCED
+    mat4 model = instance_model;
+    in_material_index = uint(instance_material + 0.5);
+    #endif
+
     in_frag_pos = vec3(model * vec4(aPos, 1.0));
     in_normal = mat3(transpose(inverse(model))) * aNormal;  
     in_texture_coord = aTexCoords;
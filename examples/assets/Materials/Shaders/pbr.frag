@@ -75,16 +75,24 @@ struct directional_light {
 	vec3 ambient;
 };
 
+layout (std140) uniform frame_block {
+    directional_light light;
+    float gamma;
+    float exposure;
+    bool use_ibl;
+    bool use_directional_light;
+};
+
+layout (std140) uniform view_block {
+    mat4 view;
+    mat4 projection;
+    vec3 view_pos;
+};
+
 uniform samplerCube irradiance_map;
 uniform samplerCube prefilter_map;
 uniform sampler2D brdf_lut;
-uniform float gamma;
-uniform float exposure;
-uniform vec3 view_pos;
 uniform pbr_material material;
-uniform directional_light light;
-uniform bool use_ibl;
-uniform bool use_directional_light;
 
 in vec3 in_frag_pos;  
 in vec3 in_normal;  
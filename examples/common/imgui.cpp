@@ -152,6 +152,8 @@ namespace moka
                 .set_polygon_mode(face::front_and_back, polygon_draw_mode::fill)
                 .set_depth_test_enabled(false)
                 .set_scissor_test_enabled(true)
+                .add_material_parameter("u_projection", glm::mat4(1.0f))
+                .add_material_parameter("u_tex0", texture_handle{})
                 .build();
 
         unsigned char* pixels;
@@ -235,7 +237,7 @@ namespace moka
 
     command_list imgui::draw() const
     {
-        command_list list;
+        auto list = graphics_device_.make_command_list();
 
         ImGui::Render();
 
@@ -263,6 +265,8 @@ namespace moka
 
         draw_data->ScaleClipRects(io.DisplayFramebufferScale);
 
+        buff.gpu_timer().begin_scope("imgui");
+
         buff.viewport().set_rectangle(0, 0, fb_width, fb_height);
 
         const auto l = draw_data->DisplayPos.x;
@@ -287,8 +291,7 @@ namespace moka
                                 0.0f,
                                 1.0f};
 
-        buff.set_material_parameters().set_material(material_).set_parameter(
-            "u_projection", proj);
+        buff.set_material_parameters().set_material(material_).set_parameter("u_projection", proj);
 
         const auto pos = draw_data->DisplayPos;
         for (auto n = 0; n < draw_data->CmdListsCount; ++n)
@@ -296,15 +299,31 @@ namespace moka
             const ImDrawList* cmd_list = draw_data->CmdLists[n];
             uint32_t idx_buffer_offset = 0;
 
-            buff.fill_vertex_buffer().set_buffer(
-                vertex_buffer_,
-                cmd_list->VtxBuffer.Data,
-                static_cast<size_t>(cmd_list->VtxBuffer.Size) * sizeof(ImDrawVert));
+            const auto vertex_size = static_cast<size_t>(cmd_list->VtxBuffer.Size) * sizeof(ImDrawVert);
+            const auto index_size = static_cast<size_t>(cmd_list->IdxBuffer.Size) * sizeof(ImDrawIdx);
+
+            // ui geometry changes every frame, so write it into the stream buffer rather than reallocating a buffer per list
+            const auto vertices = graphics_device_.allocate_stream(vertex_size, sizeof(ImDrawVert));
+            const auto indices = graphics_device_.allocate_stream(index_size, sizeof(ImDrawIdx));
+
+            const auto streamed = vertices.is_valid() && indices.is_valid();
 
-            buff.fill_index_buffer().set_buffer(
-                index_buffer_,
-                cmd_list->IdxBuffer.Data,
-                static_cast<size_t>(cmd_list->IdxBuffer.Size) * sizeof(ImDrawIdx));
+            uint32_t index_base = 0;
+            int32_t base_vertex = 0;
+
+            if (streamed)
+            {
+                buff.fill_stream_buffer().set_buffer(vertices, cmd_list->VtxBuffer.Data);
+                buff.fill_stream_buffer().set_buffer(indices, cmd_list->IdxBuffer.Data);
+
+                index_base = indices.offset;
+                base_vertex = static_cast<int32_t>(vertices.offset / sizeof(ImDrawVert));
+            }
+            else
+            {
+                buff.fill_vertex_buffer().set_buffer(vertex_buffer_, cmd_list->VtxBuffer.Data, vertex_size);
+                buff.fill_index_buffer().set_buffer(index_buffer_, cmd_list->IdxBuffer.Data, index_size);
+            }
 
             for (auto cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; cmd_i++)
             {
@@ -332,11 +351,10 @@ namespace moka
 
                     if (cmd->TextureId)
                     {
-                        const texture_handle handle{static_cast<uint16_t>(
+                        const texture_handle handle{static_cast<uint32_t>(
                             reinterpret_cast<intptr_t>(cmd->TextureId))};
 
-                        buff.set_material_parameters().set_material(material_).set_parameter(
-                            "u_tex0", handle);
+                        buff.set_material_parameters().set_material(material_).set_parameter("u_tex0", handle);
                     }
 
                     buff.clear().set_clear_depth(true);
@@ -346,13 +364,29 @@ namespace moka
                         .set_index_count(cmd->ElemCount)
                         .set_index_buffer(index_buffer_)
                         .set_index_type(index_type::uint16)
-                        .set_index_buffer_offset(sizeof(ImDrawIdx) * idx_buffer_offset)
+                        .set_index_buffer_offset(index_base + sizeof(ImDrawIdx) * idx_buffer_offset)
+                        .set_base_vertex(base_vertex)
+                        .set_streamed(streamed)
                         .set_material(material_);
                 }
                 idx_buffer_offset += cmd->ElemCount;
             }
         }
 
+        buff.gpu_timer().end_scope();
+
         return list;
     }
+
+    void imgui::draw_gpu_timers() const
+    {
+        if (ImGui::Begin("GPU Timers"))
+        {
+            for (const auto& timer : graphics_device_.get_gpu_timers())
+            {
+                ImGui::Text("%*s%s: %.3f ms", static_cast<int>(timer.depth * 2), "", timer.name.c_str(), timer.milliseconds);
+            }
+        }
+        ImGui::End();
+    }
 } // namespace moka
@@ -63,5 +63,7 @@ namespace moka
         void new_frame(float delta_time) const;
 
         command_list draw() const;
+
+        void draw_gpu_timers() const;
     };
 } // namespace moka
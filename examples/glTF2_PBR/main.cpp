@@ -53,6 +53,8 @@ class app final : public application
 
     bool pbr_ = true;
 
+    bool show_gpu_timers_ = false;
+
 public:
     explicit app(const app_settings& settings)
         : application(settings),
@@ -131,10 +133,56 @@ public:
             ImGui::SliderFloat(
                 "Exposure", &scene_.exposure, 0.0f, 10.0f, "%.3f");
 
+            ImGui::Separator();
+
+            auto optimize_commands = graphics_.get_optimize_commands();
+            if (ImGui::Checkbox("Remove Redundant Commands", &optimize_commands))
+            {
+                graphics_.set_optimize_commands(optimize_commands);
+            }
+
+            if (optimize_commands)
+            {
+                const auto& stats = graphics_.get_optimizer_stats();
+                ImGui::Text(
+                    "Commands removed: %zu\nParameter writes removed: %zu",
+                    stats.commands_removed,
+                    stats.parameters_removed);
+            }
+
+            const auto state_stats = graphics_.get_state_change_stats();
+            ImGui::Text(
+                "State changes issued: %zu\nState changes elided: %zu",
+                state_stats.calls_issued,
+                state_stats.calls_elided);
+
+            const auto draw_stats = graphics_.get_draw_stats();
+            ImGui::Text("Draws: %zu\nDraw calls: %zu", draw_stats.draws, draw_stats.draw_calls);
+
+            const auto upload_stats = graphics_.get_texture_upload_stats();
+            ImGui::Text(
+                "Texture bytes uploaded: %zu\nTextures streaming: %zu",
+                upload_stats.bytes_uploaded,
+                upload_stats.textures_pending);
+
+            const auto& program_stats = graphics_.get_program_cache().get_stats();
+            ImGui::Text(
+                "Programs in memory: %zu\nPrograms from binary: %zu\nPrograms compiled: %zu",
+                program_stats.memory_hits,
+                program_stats.binary_hits,
+                program_stats.misses);
+
+            ImGui::Checkbox("GPU Timers", &show_gpu_timers_);
+
             scene_.active_program = pbr_ ? 0 : 1;
         }
         ImGui::End();
 
+        if (show_gpu_timers_)
+        {
+            imgui_.draw_gpu_timers();
+        }
+
         graphics_.submit_and_swap(imgui_.draw());
     }
 
@@ -160,11 +208,26 @@ public:
     }
 };
 
-int main()
+int main(const int argc, char* argv[])
 {
     app_settings settings{};
     settings.window.resolution = {1600, 900};
     settings.window.fullscreen = false;
 
+    for (auto i = 1; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+
+        // --capture <file> records a command trace that moka_replay can play back
+        if (arg == "--capture" && i + 1 < argc)
+        {
+            settings.capture_path = argv[++i];
+        }
+        else if (arg == "--render-thread")
+        {
+            settings.render_thread = true;
+        }
+    }
+
     return app{settings}.run();
 }
@@ -118,7 +118,9 @@ public:
                 .build();
 
         material_ = graphics_.build_material()
-                        .add_material_parameter("transform", parameter_type::mat4)
+                        .add_material_parameter("transform", glm::mat4(1.0f))
+                        .add_material_parameter("tile_texture", texture_handle{})
+                        .add_material_parameter("test_texture", texture_handle{})
                         .add_vertex_shader(vertex_source_)
                         .add_fragment_shader(fragment_source_)
                         .set_culling_enabled(false)
@@ -131,7 +133,7 @@ public:
     {
         const auto current_time = seconds_elapsed();
 
-        command_list list;
+        command_list list{graphics_.get_material_cache()};
 
         list.clear().set_color(color::cornflower_blue()).set_clear_color(true).set_clear_depth(true);
 
@@ -139,6 +141,7 @@ public:
         trans = glm::rotate(trans, current_time, glm::vec3(0.0f, 0.0f, 1.0f));
 
         list.set_material_parameters()
+            .set_material(material_)
             .set_parameter("transform", trans)
             .set_parameter("tile_texture", tile_texture_)
             .set_parameter("test_texture", test_texture_);
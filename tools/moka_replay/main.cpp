@@ -0,0 +1,248 @@
+/*
+===========================================================================
+Moka Source Code
+Copyright 2019 Stuart Adams. All rights reserved.
+https://github.com/stuartdadams/moka
+stuartdadams | linkedin.com/in/stuartdadams
+
+This file is part of the Moka Real-Time Physically-Based Rendering Project.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+===========================================================================
+*/
+
+#include <algorithm>
+#include <application/application.hpp>
+#include <chrono>
+#include <graphics/device/command_trace.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace moka;
+
+/**
+ * \brief Replays a command trace in a loop and reports the CPU and GPU time of every frame.
+ * The CPU time covers submitting the frame's command lists and swapping; decoding the trace is excluded.
+ * The GPU time is measured by a gpu timer scope around the same work, on backends that measure it.
+ */
+class replay_application final : public application
+{
+    static constexpr size_t max_drain_frames = 8; /**< Empty frames presented after the last loop, for its timers to resolve. */
+
+    command_trace trace_;
+    size_t loops_;
+
+    size_t loop_ = 0;
+    size_t frame_ = 0;
+    size_t frames_played_ = 0;
+    size_t frames_drained_ = 0;
+
+    std::vector<double> cpu_times_;
+
+    // every frame played gets a scope of its own, so each measurement is only counted once
+    static std::string timer_name(const size_t played)
+    {
+        return "replay " + std::to_string(played);
+    }
+
+    std::unordered_map<std::string, double> get_gpu_times() const
+    {
+        std::unordered_map<std::string, double> times;
+
+        for (const auto& timer : graphics_.get_gpu_timers())
+        {
+            times[timer.name] = timer.milliseconds;
+        }
+
+        return times;
+    }
+
+    void report()
+    {
+        const auto frame_count = trace_.get_frame_count();
+        const auto loops = static_cast<double>(loops_);
+        const auto gpu_times = get_gpu_times();
+
+        std::vector<double> gpu_frame_times(frame_count, 0.0);
+        std::vector<size_t> gpu_frames_measured(frame_count, 0);
+
+        for (size_t played = 0; played < frames_played_; ++played)
+        {
+            if (const auto time = gpu_times.find(timer_name(played)); time != gpu_times.end())
+            {
+                gpu_frame_times[played % frame_count] += time->second;
+                ++gpu_frames_measured[played % frame_count];
+            }
+        }
+
+        double cpu_total = 0.0;
+        double gpu_total = 0.0;
+
+        for (size_t i = 0; i < frame_count; ++i)
+        {
+            const auto cpu = cpu_times_[i] / loops;
+            const auto gpu = gpu_frames_measured[i] > 0 ? gpu_frame_times[i] / gpu_frames_measured[i] : 0.0;
+
+            log_.info("frame {}: cpu {:.3f} ms, gpu {:.3f} ms", i, cpu, gpu);
+
+            cpu_total += cpu;
+            gpu_total += gpu;
+        }
+
+        log_.info(
+            "{} frames x {} loops: mean cpu {:.3f} ms, mean gpu {:.3f} ms",
+            frame_count,
+            loops_,
+            cpu_total / frame_count,
+            gpu_total / frame_count);
+
+        if (const auto measured = gpu_times.size(); measured < frames_played_)
+        {
+            log_.warn("{} of {} frames have no gpu time, the backend didn't measure them", frames_played_ - measured, frames_played_);
+        }
+
+        if (const auto unresolved = trace_.get_unresolved_handle_count(); unresolved > 0)
+        {
+            log_.warn("{} handles referenced resources created before the capture started", unresolved);
+        }
+    }
+
+public:
+    replay_application(const app_settings& settings, const std::filesystem::path& trace, const size_t loops)
+        : application(settings), trace_(trace), loops_(std::max<size_t>(loops, 1))
+    {
+        cpu_times_.resize(trace_.get_frame_count(), 0.0);
+    }
+
+    void draw(const game_time delta_time) override
+    {
+        if (!trace_.is_valid())
+        {
+            window_.exit();
+            return;
+        }
+
+        // timers are read back a few frames late, so the last loop's are waited for before reporting
+        if (loop_ == loops_)
+        {
+            if (get_gpu_times().size() < frames_played_ && frames_drained_ < max_drain_frames)
+            {
+                graphics_.submit_and_swap(graphics_.make_command_list());
+                ++frames_drained_;
+                return;
+            }
+
+            report();
+            window_.exit();
+            return;
+        }
+
+        trace_.load_frame(graphics_, frame_);
+
+        const auto timer = timer_name(frames_played_);
+
+        const auto start = std::chrono::steady_clock::now();
+
+        trace_.play_frame(graphics_, timer.c_str());
+
+        const auto end = std::chrono::steady_clock::now();
+
+        cpu_times_[frame_] += std::chrono::duration<double, std::milli>(end - start).count();
+
+        ++frames_played_;
+
+        if (++frame_ == trace_.get_frame_count())
+        {
+            frame_ = 0;
+            ++loop_;
+        }
+    }
+
+    void update(const game_time delta_time) override
+    {
+    }
+
+    std::filesystem::path data_path() override
+    {
+        return std::filesystem::current_path();
+    }
+};
+
+int main(const int argc, char* argv[])
+{
+    logger log{"moka_replay"};
+
+    std::vector<std::string> args;
+    bool headless = false;
+    auto backend = graphics_backend::opengl;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg{argv[i]};
+
+        if (arg == "--headless")
+        {
+            headless = true;
+        }
+        else if (arg == "--backend" && i + 1 < argc)
+        {
+            const std::string name{argv[++i]};
+
+            if (name == "opengl")
+            {
+                backend = graphics_backend::opengl;
+            }
+            else if (name == "null")
+            {
+                backend = graphics_backend::null;
+            }
+            else
+            {
+                log.error("unknown backend \"{}\", expected opengl or null", name);
+                return 1;
+            }
+        }
+        else
+        {
+            args.emplace_back(arg);
+        }
+    }
+
+    if (args.empty())
+    {
+        log.error("usage: moka_replay [--headless] [--backend opengl|null] <trace> [loops]");
+        return 1;
+    }
+
+    app_settings settings{};
+    settings.window.name = "moka_replay";
+    settings.window.resolution = {1600, 900};
+    settings.window.fullscreen = false;
+    settings.window.headless = headless;
+    settings.graphics = backend;
+
+    // the null backend executes nothing, so it needs neither a window nor a context
+    settings.window.null_context = backend == graphics_backend::null;
+
+    const auto loops = args.size() > 1 ? static_cast<size_t>(std::stoul(args[1])) : size_t{10};
+
+    return replay_application{settings, args[0], loops}.run();
+}